@@ -0,0 +1,119 @@
+#include "../../src/AtMostFiveConsecutiveDays.h"
+#include "../../src/AtMostFiveNightShiftsPerMonth.h"
+#include "../../src/AtMostOneShiftPerDay.h"
+#include "../../src/NoSingleDaysOff.h"
+
+#include <QSharedPointer>
+#include <QTest>
+
+typedef QSharedPointer<Cogent::ConstraintInterface> ConstraintPointer;
+
+// Returns a new instance of the constraint class named \a name.
+ConstraintPointer makeConstraint(const QString &name)
+{
+    if (name == QStringLiteral("AtMostFiveConsecutiveDays"))
+        return ConstraintPointer(new Cogent::AtMostFiveConsecutiveDays());
+    if (name == QStringLiteral("AtMostFiveNightShiftsPerMonth"))
+        return ConstraintPointer(new Cogent::AtMostFiveNightShiftsPerMonth());
+    if (name == QStringLiteral("AtMostOneShiftPerDay"))
+        return ConstraintPointer(new Cogent::AtMostOneShiftPerDay());
+    if (name == QStringLiteral("NoSingleDaysOff"))
+        return ConstraintPointer(new Cogent::NoSingleDaysOff());
+    return ConstraintPointer();
+}
+
+// Returns a roster of \a days complete days, with five of \a nurseCount nurses per shift assigned
+// round-robin, followed by a current day with only its night shift filled.
+Cogent::Roster makeRoster(const int nurseCount, const int days)
+{
+    Cogent::Roster roster;
+    Cogent::NurseId nurse = 0;
+    for (int day = 0; day <= days; ++day) {
+        roster.appendDay();
+        const int shifts = (day < days) ? roster.shiftCount() : 1;
+        for (int shift = 0; shift < shifts; ++shift) {
+            for (int slot = 0; slot < 5; ++slot) {
+                roster.assign(day, shift, nurse);
+                nurse = (nurse + 1) % nurseCount;
+            }
+        }
+    }
+    return roster;
+}
+
+class bench_Constraints : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void constrain_data();
+    void constrain();
+    void commitDay_data();
+    void commitDay();
+};
+
+void bench_Constraints::constrain_data()
+{
+    QTest::addColumn<QString>("constraintName");
+    QTest::addColumn<int>("nurseCount");
+
+    const QStringList constraintNames{
+        QStringLiteral("AtMostFiveConsecutiveDays"),
+        QStringLiteral("AtMostFiveNightShiftsPerMonth"),
+        QStringLiteral("AtMostOneShiftPerDay"),
+        QStringLiteral("NoSingleDaysOff"),
+    };
+    const QVector<int> nurseCounts{ 100, 1000, 10000 };
+    foreach (const QString &constraintName, constraintNames) {
+        foreach (const int nurseCount, nurseCounts) {
+            const QString name = QStringLiteral("%1-%2-nurses").arg(constraintName).arg(nurseCount);
+            QTest::newRow(qPrintable(name)) << constraintName << nurseCount;
+        }
+    }
+}
+
+void bench_Constraints::constrain()
+{
+    QFETCH(QString, constraintName);
+    QFETCH(int, nurseCount);
+
+    const ConstraintPointer constraint = makeConstraint(constraintName);
+    QVERIFY(constraint);
+    const Cogent::Roster roster = makeRoster(nurseCount, 10);
+    constraint->replay(roster, nurseCount);
+    const Cogent::NurseSet allNurses(nurseCount, true);
+
+    // Constrain the candidates for every shift of the current day, as the generator would.
+    QBENCHMARK {
+        for (int shift = 0; shift < roster.shiftCount(); ++shift) {
+            Cogent::NurseSet candidates = allNurses;
+            constraint->constrain(candidates, shift, roster);
+        }
+    }
+}
+
+void bench_Constraints::commitDay_data()
+{
+    constrain_data();
+}
+
+void bench_Constraints::commitDay()
+{
+    QFETCH(QString, constraintName);
+    QFETCH(int, nurseCount);
+
+    const ConstraintPointer constraint = makeConstraint(constraintName);
+    QVERIFY(constraint);
+    const Cogent::Roster roster = makeRoster(nurseCount, 10);
+    constraint->replay(roster, nurseCount);
+
+    // Uncommit, then recommit, the last complete day, as the backtracking engine would.
+    const int day = roster.size() - 2;
+    QBENCHMARK {
+        constraint->onDayUncommitted(roster, day);
+        constraint->onDayCommitted(roster, day);
+    }
+}
+
+QTEST_APPLESS_MAIN(bench_Constraints)
+#include "bench_Constraints.moc"
@@ -0,0 +1 @@
+include(../bench.pri)
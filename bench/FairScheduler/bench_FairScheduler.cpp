@@ -0,0 +1,83 @@
+#include "../../src/FairScheduler.h"
+
+#include <QTest>
+
+// Has \a scheduler pick every one of \a nurseCount nurses once, so that all are registered, then
+// returns the nurses available with every third nurse removed, as if already rostered that day.
+// Or if \a newestOnly, returns just the five most recently picked nurses, so that each pick must
+// skip almost every nurse.
+Cogent::NurseSet warmUp(Cogent::FairScheduler &scheduler, const int nurseCount,
+                        const bool newestOnly)
+{
+    Cogent::NurseSet available(nurseCount, true);
+    for (int index = 0; index < nurseCount; ++index) {
+        scheduler.onShift(QDate(2018, 6, 1).addDays(index / 15), (index / 5) % 3);
+        scheduler.chooseNextNurse(available);
+    }
+    for (Cogent::NurseId nurse = 0; nurse < nurseCount; ++nurse) {
+        if ((newestOnly) ? (nurse < nurseCount - 5) : (nurse % 3 == 0)) {
+            available.remove(nurse);
+        }
+    }
+    return available;
+}
+
+class bench_FairScheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void chooseNextNurse_data();
+    void chooseNextNurse();
+    void chooseNextNurses_data();
+    void chooseNextNurses();
+};
+
+void bench_FairScheduler::chooseNextNurse_data()
+{
+    QTest::addColumn<int>("nurseCount");
+    QTest::addColumn<bool>("newestOnly");
+
+    const QVector<int> nurseCounts{ 100, 1000, 10000 };
+    foreach (const int nurseCount, nurseCounts) {
+        QTest::newRow(qPrintable(QStringLiteral("%1-nurses").arg(nurseCount)))
+            << nurseCount << false;
+        QTest::newRow(qPrintable(QStringLiteral("%1-nurses-newest-only").arg(nurseCount)))
+            << nurseCount << true;
+    }
+}
+
+void bench_FairScheduler::chooseNextNurse()
+{
+    QFETCH(int, nurseCount);
+    QFETCH(bool, newestOnly);
+
+    Cogent::FairScheduler scheduler;
+    const Cogent::NurseSet available = warmUp(scheduler, nurseCount, newestOnly);
+    scheduler.onShift(QDate(2018, 6, 2), Cogent::Roster::NightShift);
+    QBENCHMARK {
+        scheduler.chooseNextNurse(available);
+    }
+}
+
+void bench_FairScheduler::chooseNextNurses_data()
+{
+    chooseNextNurse_data();
+}
+
+void bench_FairScheduler::chooseNextNurses()
+{
+    QFETCH(int, nurseCount);
+    QFETCH(bool, newestOnly);
+
+    // Fill one (five slot) shift per iteration.
+    Cogent::FairScheduler scheduler;
+    const Cogent::NurseSet available = warmUp(scheduler, nurseCount, newestOnly);
+    scheduler.onShift(QDate(2018, 6, 2), Cogent::Roster::NightShift);
+    QBENCHMARK {
+        scheduler.chooseNextNurses(available, 5);
+    }
+}
+
+QTEST_APPLESS_MAIN(bench_FairScheduler)
+#include "bench_FairScheduler.moc"
@@ -0,0 +1,85 @@
+#include "../../src/LeastRecentScheduler.h"
+
+#include <QTest>
+
+// Has \a scheduler pick every one of \a nurseCount nurses once, so that none remain unseen, then
+// returns the nurses available with every third nurse removed, as if already rostered that day.
+// Or if \a newestOnly, returns just the five most recently picked nurses, so that each pick must
+// skip almost every nurse (the worst case for any recency ordering).
+Cogent::NurseSet warmUp(Cogent::LeastRecentScheduler &scheduler, const int nurseCount,
+                        const bool newestOnly)
+{
+    Cogent::NurseSet available(nurseCount, true);
+    for (int index = 0; index < nurseCount; ++index) {
+        scheduler.chooseNextNurse(available);
+    }
+    for (Cogent::NurseId nurse = 0; nurse < nurseCount; ++nurse) {
+        if ((newestOnly) ? (nurse < nurseCount - 5) : (nurse % 3 == 0)) {
+            available.remove(nurse);
+        }
+    }
+    return available;
+}
+
+class bench_LeastRecentScheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void chooseNextNurse_data();
+    void chooseNextNurse();
+    void chooseNextNurses_data();
+    void chooseNextNurses();
+};
+
+void bench_LeastRecentScheduler::chooseNextNurse_data()
+{
+    QTest::addColumn<int>("nurseCount");
+    QTest::addColumn<quint64>("seed");
+    QTest::addColumn<bool>("newestOnly");
+
+    const QVector<int> nurseCounts{ 100, 1000, 10000 };
+    foreach (const int nurseCount, nurseCounts) {
+        QTest::newRow(qPrintable(QStringLiteral("%1-nurses").arg(nurseCount)))
+            << nurseCount << quint64(0) << false;
+        QTest::newRow(qPrintable(QStringLiteral("%1-nurses-seeded").arg(nurseCount)))
+            << nurseCount << quint64(1) << false;
+        QTest::newRow(qPrintable(QStringLiteral("%1-nurses-newest-only").arg(nurseCount)))
+            << nurseCount << quint64(0) << true;
+    }
+}
+
+void bench_LeastRecentScheduler::chooseNextNurse()
+{
+    QFETCH(int, nurseCount);
+    QFETCH(quint64, seed);
+    QFETCH(bool, newestOnly);
+
+    Cogent::LeastRecentScheduler scheduler(seed);
+    const Cogent::NurseSet available = warmUp(scheduler, nurseCount, newestOnly);
+    QBENCHMARK {
+        scheduler.chooseNextNurse(available);
+    }
+}
+
+void bench_LeastRecentScheduler::chooseNextNurses_data()
+{
+    chooseNextNurse_data();
+}
+
+void bench_LeastRecentScheduler::chooseNextNurses()
+{
+    QFETCH(int, nurseCount);
+    QFETCH(quint64, seed);
+    QFETCH(bool, newestOnly);
+
+    // Fill one (five slot) shift per iteration.
+    Cogent::LeastRecentScheduler scheduler(seed);
+    const Cogent::NurseSet available = warmUp(scheduler, nurseCount, newestOnly);
+    QBENCHMARK {
+        scheduler.chooseNextNurses(available, 5);
+    }
+}
+
+QTEST_APPLESS_MAIN(bench_LeastRecentScheduler)
+#include "bench_LeastRecentScheduler.moc"
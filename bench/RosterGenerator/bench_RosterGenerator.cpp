@@ -0,0 +1,123 @@
+#include "../../src/AtMostFiveConsecutiveDays.h"
+#include "../../src/AtMostFiveNightShiftsPerMonth.h"
+#include "../../src/AtMostOneShiftPerDay.h"
+#include "../../src/NoSingleDaysOff.h"
+#include "../../src/RosterGenerator.h"
+#include "../../src/StaticRosterGenerator.h"
+#include "../../test/TestNurses.h"
+
+#include <QTest>
+
+class bench_RosterGenerator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void generate_data();
+    void generate();
+    void generateStatic_data();
+    void generateStatic();
+    void repair_data();
+    void repair();
+};
+
+void bench_RosterGenerator::generate_data()
+{
+    QTest::addColumn<int>("nurseCount");
+    QTest::addColumn<int>("firstMonth");
+    QTest::addColumn<int>("lastMonth");
+
+    // Either February 2018 (28 days), or all of 2018 (365 days), one month after another.
+    const QVector<int> nurseCounts{ 100, 1000, 10000 };
+    foreach (const int nurseCount, nurseCounts) {
+        QTest::newRow(qPrintable(QStringLiteral("%1-nurses-28-days").arg(nurseCount)))
+            << nurseCount << 2 << 2;
+        QTest::newRow(qPrintable(QStringLiteral("%1-nurses-365-days").arg(nurseCount)))
+            << nurseCount << 1 << 12;
+    }
+}
+
+void bench_RosterGenerator::generate()
+{
+    QFETCH(int, nurseCount);
+    QFETCH(int, firstMonth);
+    QFETCH(int, lastMonth);
+    const QStringList nurses = makeNurses(nurseCount);
+
+    Cogent::RosterGenerator generator;
+    generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+
+    QBENCHMARK {
+        Cogent::CarryIn carryIn;
+        for (int month = firstMonth; month <= lastMonth; ++month) {
+            const QVariantMap roster = generator.generate(2018, month, nurses, carryIn);
+            QVERIFY(!roster.isEmpty());
+            carryIn = Cogent::CarryIn::fromRoster(roster, carryIn);
+        }
+    }
+}
+
+void bench_RosterGenerator::generateStatic_data()
+{
+    generate_data();
+}
+
+void bench_RosterGenerator::generateStatic()
+{
+    QFETCH(int, nurseCount);
+    QFETCH(int, firstMonth);
+    QFETCH(int, lastMonth);
+    const QStringList nurses = makeNurses(nurseCount);
+
+    // The same constraints as generate(), but fixed at compile time.
+    Cogent::StandardRosterGenerator generator;
+
+    QBENCHMARK {
+        Cogent::CarryIn carryIn;
+        for (int month = firstMonth; month <= lastMonth; ++month) {
+            const QVariantMap roster = generator.generate(2018, month, nurses, carryIn);
+            QVERIFY(!roster.isEmpty());
+            carryIn = Cogent::CarryIn::fromRoster(roster, carryIn);
+        }
+    }
+}
+
+void bench_RosterGenerator::repair_data()
+{
+    QTest::addColumn<int>("nurseCount");
+
+    const QVector<int> nurseCounts{ 100, 1000, 10000 };
+    foreach (const int nurseCount, nurseCounts) {
+        QTest::newRow(qPrintable(QStringLiteral("%1-nurses").arg(nurseCount))) << nurseCount;
+    }
+}
+
+void bench_RosterGenerator::repair()
+{
+    QFETCH(int, nurseCount);
+    const QStringList nurses = makeNurses(nurseCount);
+
+    Cogent::RosterGenerator generator;
+    generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+    const QVariantList days =
+        generator.generate(2018, 6, nurses).value(QStringLiteral("2018-06")).toList();
+
+    // A sick call for the first nurse on the 15th's night shift.
+    Cogent::RosterGenerator::Changes changes;
+    changes.blockedDays.append(qMakePair(
+        days.at(14).toMap().value(QStringLiteral("night")).toStringList().first(),
+        QDate(2018, 6, 15)));
+
+    QBENCHMARK {
+        QVERIFY(!generator.repair(2018, 6, days, nurses, changes).isEmpty());
+    }
+}
+
+QTEST_APPLESS_MAIN(bench_RosterGenerator)
+#include "bench_RosterGenerator.moc"
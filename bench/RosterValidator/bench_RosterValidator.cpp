@@ -0,0 +1,103 @@
+#include "../../src/AtMostConsecutiveDays.h"
+#include "../../src/AtMostOneShiftPerDay.h"
+#include "../../src/AtMostShiftsPerMonth.h"
+#include "../../src/NoSingleDaysOff.h"
+#include "../../src/RosterGenerator.h"
+#include "../../src/RosterValidator.h"
+#include "../../test/TestNurses.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+// Adds the standard constraints (as per Rules::defaults) to \a target.
+template<class Target>
+void addConstraints(Target &target)
+{
+    target.addConstraint(new Cogent::AtMostConsecutiveDays(5));
+    target.addConstraint(new Cogent::AtMostShiftsPerMonth(Cogent::Roster::NightShift, 5));
+    target.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    target.addConstraint(new Cogent::NoSingleDaysOff());
+}
+
+class bench_RosterValidator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void validate_data();
+    void validate();
+    void validateBinary_data();
+    void validateBinary();
+
+protected:
+    QTemporaryDir dir;
+
+    // Returns all of 2018's rosters for \a nurseCount nurses, with \a nursesPerShift on each shift.
+    static QVariantMap makeYear(const int nurseCount, const int nursesPerShift)
+    {
+        const QStringList nurses = makeNurses(nurseCount);
+        Cogent::RosterGenerator generator;
+        generator.setShifts(Cogent::Roster::defaultShiftNames(),
+                            Cogent::Demand(QVector<int>(3, nursesPerShift)));
+        addConstraints(generator);
+        QVariantMap rosters;
+        Cogent::CarryIn carryIn;
+        for (int month = 1; month <= 12; ++month) {
+            const QVariantMap roster = generator.generate(2018, month, nurses, carryIn);
+            const QString key = QStringLiteral("2018-%1").arg(month, 2, 10, QLatin1Char('0'));
+            rosters.insert(key, roster.value(key));
+            carryIn = Cogent::CarryIn::fromRoster(roster, carryIn);
+        }
+        return rosters;
+    }
+};
+
+void bench_RosterValidator::validate_data()
+{
+    QTest::addColumn<int>("nurseCount");
+    QTest::addColumn<int>("nursesPerShift");
+
+    // A year of rosters, with either the default five nurses per shift, or most nurses working.
+    QTest::newRow("2000-nurses-5-per-shift") << 2000 << 5;
+    QTest::newRow("2000-nurses-200-per-shift") << 2000 << 200;
+}
+
+void bench_RosterValidator::validate()
+{
+    QFETCH(int, nurseCount);
+    QFETCH(int, nursesPerShift);
+    const QVariantMap rosters = makeYear(nurseCount, nursesPerShift);
+    QCOMPARE(rosters.size(), 12);
+
+    Cogent::RosterValidator validator;
+    addConstraints(validator);
+    QBENCHMARK {
+        QVERIFY(validator.validate(rosters).isEmpty());
+    }
+}
+
+void bench_RosterValidator::validateBinary_data()
+{
+    validate_data();
+}
+
+void bench_RosterValidator::validateBinary()
+{
+    QFETCH(int, nurseCount);
+    QFETCH(int, nursesPerShift);
+    QFile file(dir.filePath(QString::fromLatin1(QTest::currentDataTag())));
+    QVERIFY(file.open(QFile::WriteOnly));
+    QVERIFY(Cogent::BinaryRoster::write(&file, makeYear(nurseCount, nursesPerShift)));
+    file.close();
+
+    Cogent::RosterValidator validator;
+    addConstraints(validator);
+    QBENCHMARK {
+        Cogent::BinaryRoster binary;
+        QVERIFY(binary.open(file.fileName()));
+        QVERIFY(validator.validate(binary).isEmpty());
+    }
+}
+
+QTEST_APPLESS_MAIN(bench_RosterValidator)
+#include "bench_RosterValidator.moc"
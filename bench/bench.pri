@@ -0,0 +1,30 @@
+TARGET = bench_$$basename(_PRO_FILE_PWD_)
+CONFIG += console
+CONFIG -= app_bundle
+QT += testlib
+QT -= gui
+
+DEFINES += QT_NO_CAST_FROM_ASCII QT_NO_CAST_TO_ASCII
+CONFIG += C++11 warn_on
+win32-msvc*:QMAKE_CXXFLAGS_WARN_ON += /WX
+else:       QMAKE_CXXFLAGS_WARN_ON += -Werror
+
+# Use AVX2 instructions (such as in NurseSet's bulk operations), if configured with CONFIG+=avx2.
+avx2 {
+  win32-msvc*:QMAKE_CXXFLAGS += /arch:AVX2
+  else:       QMAKE_CXXFLAGS += -mavx2
+}
+
+# Always benchmark optimised code, without any debug (trace) output.
+CONFIG -= debug debug_and_release
+CONFIG += release
+DEFINES += QT_NO_DEBUG_OUTPUT
+
+SOURCES += $${TARGET}.cpp
+HEADERS += $$PWD/../test/TestNurses.h
+
+# Run via 'make benchmark', writing machine-readable results (in QTest's XML format, one
+# BenchmarkResult element per data row) to $${TARGET}.xml, as well as plain text to stdout.
+benchmark.commands = $$shell_path(./$${TARGET}) -o $${TARGET}.xml,xml -o -,txt
+benchmark.depends = $(TARGET)
+QMAKE_EXTRA_TARGETS += benchmark
@@ -0,0 +1,12 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+  Constraints \
+  FairScheduler \
+  LeastRecentScheduler \
+  RosterGenerator \
+  RosterValidator \
+
+# Run all benchmarks via 'make benchmark' (see bench.pri).
+benchmark.CONFIG = recursive
+QMAKE_EXTRA_TARGETS += benchmark
@@ -1,5 +1,10 @@
 TEMPLATE = subdirs
-SUBDIRS += src test
+SUBDIRS += src test bench
+
+# Run all benchmarks (see bench/bench.pri).
+benchmark.CONFIG = recursive
+benchmark.recurse = bench
+QMAKE_EXTRA_TARGETS += benchmark
 
 $$(ENABLE_COVERAGE) {
   message(Enabling test coverage reporting [$$basename(_PRO_FILE_)])
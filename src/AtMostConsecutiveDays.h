@@ -0,0 +1,180 @@
+#ifndef __AT_MOST_CONSECUTIVE_DAYS_H__
+#define __AT_MOST_CONSECUTIVE_DAYS_H__
+
+#include "ConstraintInterface.h"
+#include "Logging.h"
+
+#include <QDebug>
+
+namespace Cogent {
+
+/*!
+ * \brief Ensures that a nurse does not work more than a given number of days in a row.
+ */
+class AtMostConsecutiveDays : public ConstraintInterface
+{
+
+public:
+    /*!
+     * \brief Constructs a constraint allowing at most \a maxDays (which must be positive)
+     * consecutive days of work.
+     */
+    explicit AtMostConsecutiveDays(const int maxDays) : maxDays(maxDays)
+    {
+        Q_ASSERT(maxDays > 0);
+    }
+
+    /*!
+     * \brief Removes from \a nurses any nurse that would fail this constraint if thery were to be
+     * included in \a shift of the last day of \a daysSoFar.
+     *
+     * Returns the number of nurses removed, if any, otherwise 0.
+     */
+    int constrain(NurseSet &nurses, const int shift, const Roster &daysSoFar) override
+    {
+        // Remove nurses that have been rostered on every day for the past maxDays days.
+        const NurseSet * const mask = eligibleFor(shift, daysSoFar);
+        if (!mask) {
+            qCDebug(lcConstraint) << "removed 0 of" << nurses.count() << "nurses";
+            return 0;
+        }
+        const int originalCount = nurses.count();
+        const int removedCount = originalCount - nurses.intersect(*mask).count();
+        qCDebug(lcConstraint) << "removed" << removedCount << "of" << originalCount << "nurses";
+        return removedCount;
+    }
+
+    /*!
+     * \brief Returns the mask of nurses that would pass this constraint on \a shift of the last
+     * day of \a daysSoFar, or \c nullptr if every nurse would.
+     */
+    const NurseSet *eligibleFor(const int shift, const Roster &daysSoFar) const
+    {
+        Q_UNUSED(shift);
+
+        // If we don't have maxDays of history yet (including any carried in), then no need to
+        // exclude anyone. Note, daysSoFar includes the current day too.
+        return (daysSoFar.size() + carriedDays <= maxDays) ? nullptr : &eligible;
+    }
+
+    QString name() const override
+    {
+        return QStringLiteral("AtMostConsecutiveDays");
+    }
+
+    int maxDaysWorked(const int days) const override
+    {
+        // At best, every streak of maxDays is followed by a single day off.
+        return days - days / (maxDays + 1);
+    }
+
+    void reset(const int nurseCount) override
+    {
+        lastDayWorked.fill(-1, nurseCount);
+        firstDayOfStreak.fill(0, nurseCount);
+        undoLog.clear();
+        undoLogSizes.clear();
+        eligible = NurseSet(nurseCount, true);
+        carriedDays = 0;
+    }
+
+    void onCarryIn(const QVector<CarryIn::Streak> &streaks) override
+    {
+        // Carried-in streaks end on day -1, so are simply streaks that started before day 0.
+        for (NurseId nurse = 0; nurse < streaks.size(); ++nurse) {
+            if (streaks.at(nurse).daysWorked > 0) {
+                lastDayWorked[nurse] = -1;
+                firstDayOfStreak[nurse] = -streaks.at(nurse).daysWorked;
+                carriedDays = qMax(carriedDays, streaks.at(nurse).daysWorked);
+            }
+        }
+        updateEligible(Roster(), -1);
+    }
+
+    void onDayCommitted(const Roster &roster, const int day) override
+    {
+        undoLogSizes.append(undoLog.size());
+        for (int shift = 0; shift < roster.shiftCount(); ++shift) {
+            for (int slot = 0; slot < roster.count(day, shift); ++slot) {
+                const NurseId nurse = roster.at(day, shift, slot);
+                if (lastDayWorked.at(nurse) == day) {
+                    continue; // Already counted this nurse (on an earlier shift) today.
+                }
+                undoLog.append(UndoEntry{ nurse, lastDayWorked.at(nurse), firstDayOfStreak.at(nurse) });
+                if (lastDayWorked.at(nurse) != day-1) {
+                    firstDayOfStreak[nurse] = day; // Starting a new streak.
+                }
+                lastDayWorked[nurse] = day;
+            }
+        }
+        updateEligible(roster, day);
+    }
+
+    void onDayUncommitted(const Roster &roster, const int day) override
+    {
+        const int undoLogSize = undoLogSizes.takeLast();
+        while (undoLog.size() > undoLogSize) {
+            const UndoEntry entry = undoLog.takeLast();
+            lastDayWorked[entry.nurse] = entry.lastDayWorked;
+            firstDayOfStreak[entry.nurse] = entry.firstDayOfStreak;
+        }
+        updateEligible(roster, day-1);
+    }
+
+protected:
+    const int maxDays;
+
+    struct UndoEntry {
+        NurseId nurse;
+        int lastDayWorked;
+        int firstDayOfStreak;
+    };
+
+    QVector<int> lastDayWorked;    // Last committed day each nurse worked, indexed by NurseId.
+    QVector<int> firstDayOfStreak; // First day of each nurse's latest streak, indexed by NurseId.
+    QVector<UndoEntry> undoLog;    // Previous values of the above, for onDayUncommitted.
+    QVector<int> undoLogSizes;     // Size of undoLog before each committed day.
+    NurseSet eligible;             // Nurses not on a streak of maxDays (or more) to yesterday.
+    int carriedDays;               // Longest streak carried in from before the roster began.
+
+    /*!
+     * \brief Returns the number of consecutive days \a nurse has worked, up to and including \a day.
+     */
+    int consecutiveDaysTo(const NurseId nurse, const int day) const
+    {
+        return (lastDayWorked.at(nurse) == day) ? (day - firstDayOfStreak.at(nurse) + 1) : 0;
+    }
+
+    /*!
+     * \brief Rebuilds the eligible mask, given that \a yesterday is the last committed day of
+     * \a roster (or -1 if no days have been committed).
+     *
+     * Only nurses rostered on \a yesterday can be on a streak to \a yesterday, so this need only
+     * visit that day's assignments. Before the roster began, only carried-in streaks count.
+     */
+    void updateEligible(const Roster &roster, const int yesterday)
+    {
+        eligible.fill(true);
+        if (yesterday < 0) {
+            for (NurseId nurse = 0; (carriedDays >= maxDays) && (nurse < lastDayWorked.size()); ++nurse) {
+                if (consecutiveDaysTo(nurse, -1) >= maxDays) {
+                    eligible.remove(nurse);
+                }
+            }
+            return;
+        }
+        for (int shift = 0; shift < roster.shiftCount(); ++shift) {
+            for (int slot = 0; slot < roster.count(yesterday, shift); ++slot) {
+                const NurseId nurse = roster.at(yesterday, shift, slot);
+                if (consecutiveDaysTo(nurse, yesterday) >= maxDays) {
+                    eligible.remove(nurse);
+                }
+            }
+        }
+    }
+
+};
+
+} // end Cogent namespace
+
+#endif // __AT_MOST_CONSECUTIVE_DAYS_H__
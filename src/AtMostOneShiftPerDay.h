@@ -2,6 +2,7 @@
 #define __AT_MOST_ONE_SHIFT_PER_DAY_H__
 
 #include "ConstraintInterface.h"
+#include "Logging.h"
 
 #include <QDebug>
 
@@ -16,28 +17,42 @@ class AtMostOneShiftPerDay : public ConstraintInterface
 public:
     /*!
      * \brief Removes from \a nurses any nurse that would fail this constraint if thery were to be
-     * included in \a shift of the day after \a daysSoFar.
+     * included in \a shift of the last day of \a daysSoFar.
      *
      * Returns the number of nurses removed, if any, otherwise 0.
      */
-    int constrain(QStringSet &nurses, const QString &shift, const QVariantList &daysSoFar) override
+    int constrain(NurseSet &nurses, const int shift, const Roster &daysSoFar) override
     {
         Q_ASSERT(!daysSoFar.isEmpty()); // Days so far includes today, even if empty.
         Q_UNUSED(shift);
 
-        // Remove any nurses that are already rostered today.
+        // Remove any nurses that are already rostered today. Note, this only needs to visit today's
+        // (few) assignments, so unlike other constraints, there's no benefit in tracking state.
+        const int today = daysSoFar.size()-1;
         int removedCount = 0;
-        foreach (const QVariant &shift, daysSoFar.last().toMap()) {
-            foreach (const QVariant &nurse, shift.toList()) {
-                if (nurses.remove(nurse.toString())) {
+        for (int shift = 0; shift < daysSoFar.shiftCount(); ++shift) {
+            for (int slot = 0; slot < daysSoFar.count(today, shift); ++slot) {
+                if (nurses.remove(daysSoFar.at(today, shift, slot))) {
                     removedCount++;
                 }
             }
         }
-        qDebug() << "removed" << removedCount << "of" << nurses.size()+removedCount << "nurses";
+        qCDebug(lcConstraint) << "removed" << removedCount << "of" << nurses.count()+removedCount
+                              << "nurses";
         return removedCount;
     }
 
+    QString name() const override
+    {
+        return QStringLiteral("AtMostOneShiftPerDay");
+    }
+
+    int maxShiftsPerDay(const int shiftCount) const override
+    {
+        Q_UNUSED(shiftCount);
+        return 1;
+    }
+
 };
 
 } // end Cogent namespace
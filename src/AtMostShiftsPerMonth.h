@@ -0,0 +1,108 @@
+#ifndef __AT_MOST_SHIFTS_PER_MONTH_H__
+#define __AT_MOST_SHIFTS_PER_MONTH_H__
+
+#include "ConstraintInterface.h"
+#include "Logging.h"
+
+#include <QDebug>
+
+namespace Cogent {
+
+/*!
+ * \brief Ensures that a nurse does not work more than a given number of a given shift per month.
+ */
+class AtMostShiftsPerMonth : public ConstraintInterface
+{
+
+public:
+    /*!
+     * \brief Constructs a constraint allowing each nurse at most \a maxShifts (which must be
+     * positive) of \a shift per month.
+     */
+    AtMostShiftsPerMonth(const int shift, const int maxShifts)
+        : limitedShift(shift), maxShifts(maxShifts)
+    {
+        Q_ASSERT(maxShifts > 0);
+    }
+
+    /*!
+     * \brief Removes from \a nurses any nurse that would fail this constraint if thery were to be
+     * included in \a shift of the last day of \a daysSoFar.
+     *
+     * Returns the number of nurses removed, if any, otherwise 0.
+     */
+    int constrain(NurseSet &nurses, const int shift, const Roster &daysSoFar) override
+    {
+        // Remove all nurses that have maxShifts (or more) of this shift already.
+        const NurseSet * const mask = eligibleFor(shift, daysSoFar);
+        if (!mask) {
+            qCDebug(lcConstraint) << "removed 0 of" << nurses.count() << "nurses";
+            return 0;
+        }
+        const int originalCount = nurses.count();
+        const int removedCount = originalCount - nurses.intersect(*mask).count();
+        qCDebug(lcConstraint) << "removed" << removedCount << "of" << originalCount << "nurses";
+        return removedCount;
+    }
+
+    /*!
+     * \brief Returns the mask of nurses that would pass this constraint on \a shift of the last
+     * day of \a daysSoFar, or \c nullptr if every nurse would.
+     */
+    const NurseSet *eligibleFor(const int shift, const Roster &daysSoFar) const
+    {
+        Q_UNUSED(daysSoFar);
+        return (shift == limitedShift) ? &eligible : nullptr; // Other shifts are not limited.
+    }
+
+    QString name() const override
+    {
+        return QStringLiteral("AtMostShiftsPerMonth");
+    }
+
+    int maxShiftsPerMonth(const int shift, const int days) const override
+    {
+        return (shift == limitedShift) ? qMin(maxShifts, days) : days;
+    }
+
+    void reset(const int nurseCount) override
+    {
+        shiftsPerNurse.fill(0, nurseCount);
+        eligible = NurseSet(nurseCount, true);
+    }
+
+    void onAssigned(const NurseId nurse, const int day, const int shift) override
+    {
+        Q_UNUSED(day);
+        if (shift == limitedShift) {
+            const int shiftsCount = ++shiftsPerNurse[nurse];
+            if (shiftsCount >= maxShifts) {
+                if (shiftsCount > maxShifts) {
+                    qCWarning(lcConstraint)
+                        << "roster already violates AtMostShiftsPerMonth constraint for"
+                        << nurse << "with" << shiftsCount << "shifts of" << limitedShift;
+                }
+                eligible.remove(nurse);
+            }
+        }
+    }
+
+    void onUnassigned(const NurseId nurse, const int day, const int shift) override
+    {
+        Q_UNUSED(day);
+        if ((shift == limitedShift) && (--shiftsPerNurse[nurse] < maxShifts)) {
+            eligible.insert(nurse);
+        }
+    }
+
+protected:
+    const int limitedShift;
+    const int maxShifts;
+    QVector<int> shiftsPerNurse; // Indexed by NurseId.
+    NurseSet eligible;           // Nurses with fewer than maxShifts of limitedShift so far.
+
+};
+
+} // end Cogent namespace
+
+#endif // __AT_MOST_SHIFTS_PER_MONTH_H__
@@ -0,0 +1,170 @@
+#ifndef __AVAILABILITY_H__
+#define __AVAILABILITY_H__
+
+#include "NurseRecord.h"
+#include "NurseSet.h"
+#include "NurseTable.h"
+
+#include <QDate>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+namespace Cogent {
+
+/*!
+ * \brief Precomputed masks of the nurses available for each shift of each day of a month.
+ *
+ * This is built once per month, from the nurses' records (leave, shifts, and skills versus each
+ * shift's required skills), so the roster generator can start each shift's candidates from a
+ * single word-wise copy of that shift's mask, before applying any constraints. It also tracks each
+ * nurse's shifts against any part-time cap (maxShifts), removing nurses from all masks once
+ * they reach their cap, and restoring them if those assignments are undone.
+ */
+class Availability
+{
+
+public:
+    /*!
+     * \brief Constructs an availability that does not restrict any nurses.
+     */
+    Availability() : shiftCount(0) { }
+
+    /*!
+     * \brief Constructs the availability of \a nurses for the \a days days from \a firstDay, each
+     * of the given \a shiftNames, according to their \a records, and \a shiftSkills (the skills
+     * required of every nurse on each shift, indexed by shift).
+     *
+     * Nurses without a record have no skills, but are otherwise available for every shift of
+     * every day.
+     */
+    Availability(const QHash<QString, NurseRecord> &records, const NurseTable &nurses,
+                 const QStringList &shiftNames, const QVector<QSet<QString>> &shiftSkills,
+                 const QDate &firstDay, const int days)
+        : shiftCount(shiftNames.size()), remaining(nurses.size(), -1), capped(nurses.size())
+    {
+        // Start each shift from the nurses able (and skilled enough) to work it on any day.
+        const QDate lastDay = firstDay.addDays(days - 1);
+        QVector<NurseSet> shiftMasks(shiftCount, NurseSet(nurses.size(), true));
+        QVector<NurseSet> leave;
+        for (NurseId nurse = 0; nurse < nurses.size(); ++nurse) {
+            const NurseRecord record = records.value(nurses.name(nurse));
+            for (int shift = 0; shift < shiftCount; ++shift) {
+                if (!record.canWork(shiftNames.at(shift), shiftSkills.value(shift))) {
+                    shiftMasks[shift].remove(nurse);
+                }
+            }
+            remaining[nurse] = record.maxShifts;
+            if (record.maxShifts == 0) {
+                capped.insert(nurse);
+            }
+
+            // Mark any leave that overlaps this month.
+            foreach (const auto &range, record.leave) {
+                if ((range.second < firstDay) || (range.first > lastDay)) {
+                    continue;
+                }
+                if (leave.isEmpty()) {
+                    leave.fill(NurseSet(nurses.size()), days);
+                }
+                const int from = int(firstDay.daysTo(qMax(range.first, firstDay)));
+                const int to = int(firstDay.daysTo(qMin(range.second, lastDay)));
+                for (int day = from; day <= to; ++day) {
+                    leave[day].insert(nurse);
+                }
+            }
+        }
+
+        // Then remove each day's nurses on leave. Note, days without leave share (rather than
+        // copy) their shifts' masks.
+        masks.reserve(days * shiftCount);
+        for (int day = 0; day < days; ++day) {
+            for (int shift = 0; shift < shiftCount; ++shift) {
+                masks.append(shiftMasks.at(shift));
+                if ((!leave.isEmpty()) && (!leave.at(day).isEmpty())) {
+                    masks.last().subtract(leave.at(day));
+                }
+            }
+        }
+    }
+
+    /*!
+     * \brief Returns \c true if this availability does not restrict any nurses; \c false
+     * otherwise.
+     */
+    bool isEmpty() const
+    {
+        return masks.isEmpty();
+    }
+
+    /*!
+     * \brief Returns the nurses available for \a shift of \a day, ignoring part-time caps.
+     */
+    const NurseSet &mask(const int day, const int shift) const
+    {
+        return masks.at(day * shiftCount + shift);
+    }
+
+    /*!
+     * \brief Returns the nurses available for any shift of \a day, ignoring part-time caps.
+     */
+    NurseSet nurses(const int day) const
+    {
+        NurseSet nurses = mask(day, 0);
+        for (int shift = 1; shift < shiftCount; ++shift) {
+            nurses.unite(mask(day, shift));
+        }
+        return nurses;
+    }
+
+    /*!
+     * \brief Returns the nurses available for \a shift of \a day, and not yet at their cap.
+     */
+    NurseSet candidates(const int day, const int shift) const
+    {
+        NurseSet nurses = mask(day, shift);
+        return nurses.subtract(capped);
+    }
+
+    /*!
+     * \brief Sets \a nurses to the nurses available for \a shift of \a day, and not yet at their
+     * cap, reusing \a nurses' storage (see NurseSet::assign).
+     *
+     * Returns a reference to \a nurses.
+     */
+    NurseSet &candidates(const int day, const int shift, NurseSet &nurses) const
+    {
+        return nurses.assign(mask(day, shift)).subtract(capped);
+    }
+
+    /*!
+     * \brief Notes that \a nurse has been assigned to a shift.
+     */
+    void onAssigned(const NurseId nurse)
+    {
+        if ((!isEmpty()) && (remaining.at(nurse) > 0) && (--remaining[nurse] == 0)) {
+            capped.insert(nurse);
+        }
+    }
+
+    /*!
+     * \brief Notes that the most recent assignment of \a nurse has been undone.
+     */
+    void onUnassigned(const NurseId nurse)
+    {
+        if ((!isEmpty()) && (remaining.at(nurse) >= 0) && (remaining[nurse]++ == 0)) {
+            capped.remove(nurse);
+        }
+    }
+
+protected:
+    int shiftCount;
+    QVector<NurseSet> masks; // Available nurses, indexed by day * shiftCount + shift.
+    QVector<int> remaining;  // Shifts each nurse may still work, or -1 for no limit.
+    NurseSet capped;         // Nurses who have reached their cap.
+
+};
+
+} // end Cogent namespace
+
+#endif // __AVAILABILITY_H__
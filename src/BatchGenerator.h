@@ -0,0 +1,186 @@
+#ifndef __BATCH_GENERATOR_H__
+#define __BATCH_GENERATOR_H__
+
+#include "Logging.h"
+#include "RosterGenerator.h"
+
+#include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+namespace Cogent {
+
+/*!
+ * \brief Generates rosters for many wards, and many months per ward, concurrently.
+ *
+ * Each ward is generated by its own RosterGenerator instance, on a thread pool. A ward's months
+ * are generated in order, by the same RosterGenerator instance, so that history (such as the
+ * scheduler's record of which nurses were least-recently rostered) carries over from one month to
+ * the next. Each month's CarryIn is also rolled forward into the next month, so that constraints
+ * hold across month boundaries. Different wards share nothing, so run in parallel.
+ */
+class BatchGenerator
+{
+
+public:
+    /*!
+     * \brief A (year, month) pair, with month in the range [1, 12].
+     */
+    typedef QPair<int, int> Month;
+
+    /*!
+     * \brief A single ward's roster generation job.
+     */
+    struct WardJob {
+        QString ward;          // Name of the ward; used as the key for this job's results.
+        QStringList nurses;    // The nurses available to the ward.
+        QVector<Month> months; // The months to generate; consecutive, and in order.
+        CarryIn carryIn;       // State carried in to the first month, if any.
+    };
+
+    /*!
+     * \brief Function to configure (eg add constraints to) each ward's RosterGenerator.
+     */
+    typedef RosterGenerator::Configurator Configurator;
+
+    /*!
+     * \brief Constructs a batch generator that applies \a configure to each new RosterGenerator, and
+     * generates rosters with \a nursesPerShift nurses per shift.
+     */
+    explicit BatchGenerator(const Configurator &configure = Configurator(), const int nursesPerShift = 5)
+        : configure(configure), nursesPerShift(nursesPerShift), maxThreads(QThread::idealThreadCount())
+    { }
+
+    /*!
+     * \brief Sets the maximum number of wards to generate concurrently.
+     *
+     * The default is QThread::idealThreadCount().
+     */
+    void setMaxThreadCount(const int maxThreads)
+    {
+        this->maxThreads = maxThreads;
+    }
+
+    /*!
+     * \brief Generates a roster for each of \a jobs, returning a map of ward names to rosters.
+     *
+     * Each ward's roster is a map in the same form as RosterGenerator::generate returns, but with
+     * one entry for each of the ward's months. If any of a ward's months could not be generated,
+     * then that ward's roster will be an empty map.
+     *
+     * This function blocks until all jobs have completed. The wards' generator metrics are added to
+     * this batch's; see metrics().
+     */
+    QVariantMap generate(const QVector<WardJob> &jobs)
+    {
+        QVariantMap rosters;
+        QMutex mutex;
+        QThreadPool pool;
+        pool.setMaxThreadCount(maxThreads);
+        foreach (const WardJob &job, jobs) {
+            pool.start(new WardRunnable(job, *this, rosters, totals, mutex));
+        }
+        pool.waitForDone();
+        return rosters;
+    }
+
+    /*!
+     * \brief Generates all months of \a job, in order, returning the ward's combined roster, or an
+     * empty map if any month could not be generated.
+     *
+     * If \a metrics is not \c nullptr, the ward's generator metrics are added to it.
+     *
+     * This is thread-safe, so may be called concurrently for different jobs (with different
+     * \a metrics, if any).
+     */
+    QVariantMap generate(const WardJob &job, GeneratorMetrics * const metrics = nullptr) const
+    {
+        RosterGenerator generator(nursesPerShift);
+        if (configure) {
+            configure(generator);
+        }
+        const QVariantMap wardRoster = generateWard(job, generator);
+        if (metrics) {
+            metrics->merge(generator.metrics());
+        }
+        return wardRoster;
+    }
+
+    /*!
+     * \brief Returns the combined metrics of every ward generated by generate() so far.
+     */
+    GeneratorMetrics metrics() const
+    {
+        return totals;
+    }
+
+protected:
+    const Configurator configure;
+    const int nursesPerShift;
+    int maxThreads;
+    GeneratorMetrics totals;
+
+    /*!
+     * \brief Generates all months of \a job, in order, via \a generator, as per generate().
+     */
+    QVariantMap generateWard(const WardJob &job, RosterGenerator &generator) const
+    {
+        QVariantMap wardRoster;
+        CarryIn carryIn = job.carryIn;
+        foreach (const Month &month, job.months) {
+            qCDebug(lcGenerator) << "generating" << job.ward << month.first << month.second;
+            const QVariantMap monthRoster =
+                generator.generate(month.first, month.second, job.nurses, carryIn);
+            if (monthRoster.isEmpty()) {
+                qCWarning(lcGenerator) << "failed to generate roster for ward" << job.ward
+                                       << "month" << month.first << month.second;
+                return QVariantMap();
+            }
+            carryIn = CarryIn::fromRoster(monthRoster, carryIn);
+            for (auto iter = monthRoster.constBegin(); iter != monthRoster.constEnd(); ++iter) {
+                wardRoster.insert(iter.key(), iter.value());
+            }
+        }
+        return wardRoster;
+    }
+
+    /*!
+     * \brief Runs a single ward's job on a thread pool, storing the result in a shared map, and
+     * adding its metrics to shared totals.
+     */
+    class WardRunnable : public QRunnable
+    {
+
+    public:
+        WardRunnable(const WardJob &job, const BatchGenerator &batch, QVariantMap &rosters,
+                     GeneratorMetrics &totals, QMutex &mutex)
+            : job(job), batch(batch), rosters(rosters), totals(totals), mutex(mutex)
+        { }
+
+        void run() override
+        {
+            GeneratorMetrics metrics;
+            const QVariantMap roster = batch.generate(job, &metrics);
+            QMutexLocker locker(&mutex);
+            rosters.insert(job.ward, roster);
+            totals.merge(metrics);
+        }
+
+    protected:
+        const WardJob job;
+        const BatchGenerator &batch;
+        QVariantMap &rosters;
+        GeneratorMetrics &totals;
+        QMutex &mutex;
+
+    };
+
+};
+
+} // end Cogent namespace
+
+#endif // __BATCH_GENERATOR_H__
@@ -0,0 +1,594 @@
+#ifndef __BINARY_ROSTER_H__
+#define __BINARY_ROSTER_H__
+
+#include "Logging.h"
+#include "NurseTable.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QIODevice>
+#include <QStringList>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QVector>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace Cogent {
+
+/*!
+ * \brief Compact binary roster file, read via a memory mapping.
+ *
+ * This is an alternative to the JSON output, for jobs that re-read the same rosters many times:
+ * opening a file only maps it and checks its header, indexes and nurse IDs, after which any shift
+ * of any day (or all of a nurse's shifts) can be looked up directly in the mapped file, without
+ * parsing.
+ *
+ * A file holds one or more rosters (one per ward and month), with all integers being 32-bit
+ * little-endian, laid out as:
+ *
+ *  - a header of eight integers: the "CGRB" magic, format version, shift count, nurse count, roster
+ *    count, slots per shift, roster index offset, and file size;
+ *  - a string index of (offset, length) pairs for the shift names, then the nurse names (sorted by
+ *    their UTF-8 bytes, so nurseId() can binary search them), then each roster's ward and month;
+ *  - the UTF-8 string data, padded to a multiple of four bytes;
+ *  - a roster index of (days, slots offset) pairs;
+ *  - each roster's slots: a fixed-width days x shifts x slots-per-shift array of nurse IDs (indexes
+ *    into the nurse names), with any unfilled slots set to -1.
+ *
+ * Metadata, such as the JSON output's "created" time, is not included.
+ */
+class BinaryRoster
+{
+
+public:
+    /*!
+     * \brief A single shift worked by a nurse, as returned by assignments().
+     */
+    struct Assignment {
+        int roster;
+        int day;
+        int shift;
+    };
+
+    BinaryRoster()
+        : data(nullptr), fileSize(0), shiftsPerDay(0), nurseTotal(0), rosterTotal(0),
+          slotsPerShift(0)
+    {
+
+    }
+
+    ~BinaryRoster()
+    {
+        close();
+    }
+
+    /*!
+     * \brief Writes \a rosters to \a device in binary roster format.
+     *
+     * \a rosters may be either a single ward's roster (month names mapped to lists of days, as per
+     * RosterGenerator::generate), or a batch of rosters (ward names mapped to single ward rosters,
+     * as per BatchGenerator::generate). Other entries, such as "created", are skipped.
+     *
+     * Returns \c true on success, or \c false if \a rosters is too large for the format, or the
+     * device could not be written to.
+     */
+    static bool write(QIODevice * const device, const QVariantMap &rosters)
+    {
+        // Flatten the rosters into a single list of ward months.
+        struct WardMonth {
+            QString ward;
+            QString month;
+            QVariantList days;
+        };
+        QVector<WardMonth> months;
+        for (auto iter = rosters.constBegin(); iter != rosters.constEnd(); ++iter) {
+            if (iter.value().type() == QVariant::List) {
+                months.append(WardMonth{ QString(), iter.key(), iter.value().toList() });
+            } else if (iter.value().type() == QVariant::Map) {
+                const QVariantMap ward = iter.value().toMap();
+                for (auto month = ward.constBegin(); month != ward.constEnd(); ++month) {
+                    if (month.value().type() == QVariant::List) {
+                        months.append(WardMonth{ iter.key(), month.key(), month.value().toList() });
+                    }
+                }
+            }
+        }
+
+        // Collect the shift names (in order of first appearance), nurse names and widest shift.
+        QStringList shiftNames;
+        QHash<QByteArray, NurseId> nurseIds;
+        int width = 0;
+        foreach (const WardMonth &month, months) {
+            foreach (const QVariant &day, month.days) {
+                const QVariantMap shifts = day.toMap();
+                for (auto shift = shifts.constBegin(); shift != shifts.constEnd(); ++shift) {
+                    if (!shiftNames.contains(shift.key())) {
+                        shiftNames.append(shift.key());
+                    }
+                    const QStringList nurses = shift.value().toStringList();
+                    width = qMax(width, nurses.size());
+                    foreach (const QString &nurse, nurses) {
+                        nurseIds.insert(nurse.toUtf8(), -1);
+                    }
+                }
+            }
+        }
+        QList<QByteArray> nurseNames = nurseIds.keys();
+        std::sort(nurseNames.begin(), nurseNames.end(), lessThan);
+        for (int index = 0; index < nurseNames.size(); ++index) {
+            nurseIds[nurseNames.at(index)] = index;
+        }
+
+        // Lay out the string table, and roster index, behind the header.
+        QList<QByteArray> strings;
+        foreach (const QString &shift, shiftNames) {
+            strings.append(shift.toUtf8());
+        }
+        strings.append(nurseNames);
+        foreach (const WardMonth &month, months) {
+            strings.append(month.ward.toUtf8());
+            strings.append(month.month.toUtf8());
+        }
+        quint64 stringsSize = 0;
+        foreach (const QByteArray &string, strings) {
+            stringsSize += string.size();
+        }
+        const quint64 stringsOffset = headerSize() + quint64(strings.size()) * 8;
+        const quint64 rosterIndexOffset = stringsOffset + ((stringsSize + 3) & ~quint64(3));
+        quint64 offset = rosterIndexOffset + quint64(months.size()) * 8;
+        QVector<quint64> slotsOffsets;
+        foreach (const WardMonth &month, months) {
+            slotsOffsets.append(offset);
+            offset += quint64(month.days.size()) * shiftNames.size() * width * 4;
+        }
+        if (offset > std::numeric_limits<quint32>::max()) {
+            qCWarning(lcRoster) << "rosters are too large for the binary roster format";
+            return false;
+        }
+
+        // Write the header, string table, and roster index.
+        QByteArray buffer;
+        bool ok = true;
+        const auto append = [&buffer](const quint64 value) {
+            char bytes[4];
+            qToLittleEndian(static_cast<quint32>(value), bytes);
+            buffer.append(bytes, 4);
+        };
+        const auto flush = [&buffer, &ok, device]() {
+            ok &= (device->write(buffer) == buffer.size());
+            buffer.resize(0);
+        };
+        buffer.append(magic(), 4);
+        append(version());
+        append(shiftNames.size());
+        append(nurseNames.size());
+        append(months.size());
+        append(width);
+        append(rosterIndexOffset);
+        append(offset);
+        quint64 stringOffset = stringsOffset;
+        foreach (const QByteArray &string, strings) {
+            append(stringOffset);
+            append(string.size());
+            stringOffset += string.size();
+        }
+        foreach (const QByteArray &string, strings) {
+            buffer.append(string);
+        }
+        buffer.append(QByteArray(int(rosterIndexOffset - stringOffset), '\0'));
+        for (int roster = 0; roster < months.size(); ++roster) {
+            append(months.at(roster).days.size());
+            append(slotsOffsets.at(roster));
+        }
+        flush();
+
+        // Write each roster's slots.
+        foreach (const WardMonth &month, months) {
+            foreach (const QVariant &day, month.days) {
+                const QVariantMap shifts = day.toMap();
+                foreach (const QString &shift, shiftNames) {
+                    const QStringList nurses = shifts.value(shift).toStringList();
+                    for (int slot = 0; slot < width; ++slot) {
+                        append(quint32((slot < nurses.size())
+                            ? nurseIds.value(nurses.at(slot).toUtf8()) : -1));
+                    }
+                }
+            }
+            flush();
+        }
+        return ok;
+    }
+
+    /*!
+     * \brief Maps the binary roster file \a fileName for reading, closing any previous file.
+     *
+     * Returns \c true on success, or \c false if the file could not be mapped, or is not a valid
+     * binary roster file.
+     */
+    bool open(const QString &fileName)
+    {
+        close();
+        file.setFileName(fileName);
+        if (!file.open(QFile::ReadOnly)) {
+            qCWarning(lcRoster) << "failed to open" << fileName << "for reading";
+            return false;
+        }
+        fileSize = file.size();
+        if (fileSize < headerSize()) {
+            qCWarning(lcRoster) << fileName << "is not a binary roster file";
+            close();
+            return false;
+        }
+        data = file.map(0, fileSize);
+        if (data == nullptr) {
+            qCWarning(lcRoster) << "failed to map" << fileName;
+            close();
+            return false;
+        }
+        if (!isValid()) {
+            qCWarning(lcRoster) << fileName << "is not a valid binary roster file";
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    /*!
+     * \brief Unmaps the current file, if any.
+     */
+    void close()
+    {
+        if (data != nullptr) {
+            file.unmap(data);
+            data = nullptr;
+        }
+        file.close();
+        fileSize = 0;
+        shiftsPerDay = nurseTotal = rosterTotal = slotsPerShift = 0;
+    }
+
+    /*!
+     * \brief Returns \c true if a valid binary roster file is open; \c false otherwise.
+     */
+    bool isOpen() const
+    {
+        return data != nullptr;
+    }
+
+    /*!
+     * \brief Returns the number of shifts per day.
+     */
+    int shiftCount() const
+    {
+        return shiftsPerDay;
+    }
+
+    /*!
+     * \brief Returns the name of \a shift, or a null string if \a shift is not valid.
+     */
+    QString shiftName(const int shift) const
+    {
+        return ((shift >= 0) && (shift < shiftsPerDay)) ? string(shift) : QString();
+    }
+
+    /*!
+     * \brief Returns the index of the shift named \a name, or -1 if there is no such shift.
+     */
+    int shiftIndex(const QString &name) const
+    {
+        for (int shift = 0; shift < shiftsPerDay; ++shift) {
+            if (string(shift) == name) {
+                return shift;
+            }
+        }
+        return -1;
+    }
+
+    /*!
+     * \brief Returns the number of distinct nurses across all rosters.
+     */
+    int nurseCount() const
+    {
+        return nurseTotal;
+    }
+
+    /*!
+     * \brief Returns the name of \a nurse, or a null string if \a nurse is not valid.
+     */
+    QString nurseName(const NurseId nurse) const
+    {
+        return ((nurse >= 0) && (nurse < nurseTotal)) ? string(shiftsPerDay + nurse) : QString();
+    }
+
+    /*!
+     * \brief Returns the identifier of the nurse named \a name, or -1 if there is no such nurse.
+     */
+    NurseId nurseId(const QString &name) const
+    {
+        const QByteArray utf8 = name.toUtf8();
+        int low = 0, high = nurseTotal;
+        while (low < high) {
+            const int mid = low + (high - low) / 2;
+            const int index = shiftsPerDay + mid;
+            const int comparison = compare(bytes(index), int(word(stringIndex(index) + 4)),
+                                           utf8.constData(), utf8.size());
+            if (comparison == 0) {
+                return mid;
+            }
+            if (comparison < 0) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return -1;
+    }
+
+    /*!
+     * \brief Returns the number of rosters (ward months) in the file.
+     */
+    int rosterCount() const
+    {
+        return rosterTotal;
+    }
+
+    /*!
+     * \brief Returns the ward name of \a roster, which is empty for single-ward files.
+     */
+    QString ward(const int roster) const
+    {
+        return string(shiftsPerDay + nurseTotal + roster * 2);
+    }
+
+    /*!
+     * \brief Returns the month name (such as "2018-06") of \a roster.
+     */
+    QString month(const int roster) const
+    {
+        return string(shiftsPerDay + nurseTotal + roster * 2 + 1);
+    }
+
+    /*!
+     * \brief Returns the index of the roster for \a month of \a ward, or -1 if there is none.
+     */
+    int rosterIndex(const QString &ward, const QString &month) const
+    {
+        for (int roster = 0; roster < rosterTotal; ++roster) {
+            if ((this->month(roster) == month) && (this->ward(roster) == ward)) {
+                return roster;
+            }
+        }
+        return -1;
+    }
+
+    /*!
+     * \brief Returns the number of days in \a roster.
+     */
+    int days(const int roster) const
+    {
+        Q_ASSERT((roster >= 0) && (roster < rosterTotal));
+        return int(word(rosterIndexOffset() + quint64(roster) * 8));
+    }
+
+    /*!
+     * \brief Returns the nurses working \a shift on \a day of \a roster.
+     */
+    QVector<NurseId> nurses(const int roster, const int day, const int shift) const
+    {
+        Q_ASSERT((day >= 0) && (day < days(roster)));
+        Q_ASSERT((shift >= 0) && (shift < shiftsPerDay));
+        QVector<NurseId> result;
+        result.reserve(slotsPerShift);
+        const quint64 offset =
+            slotsOffset(roster) + (quint64(day) * shiftsPerDay + shift) * slotsPerShift * 4;
+        for (int slot = 0; slot < slotsPerShift; ++slot) {
+            const NurseId nurse = NurseId(word(offset + slot * 4));
+            if (nurse < 0) {
+                break;
+            }
+            result.append(nurse);
+        }
+        return result;
+    }
+
+    /*!
+     * \brief Returns every shift worked by \a nurse, in roster, day and shift order.
+     */
+    QVector<Assignment> assignments(const NurseId nurse) const
+    {
+        QVector<Assignment> result;
+        for (int roster = 0; roster < rosterTotal; ++roster) {
+            const uchar *cell = data + slotsOffset(roster);
+            for (int day = 0; day < days(roster); ++day) {
+                for (int shift = 0; shift < shiftsPerDay;
+                     ++shift, cell += quint64(slotsPerShift) * 4) {
+                    for (int slot = 0; slot < slotsPerShift; ++slot) {
+                        const uchar * const slotData = cell + quint64(slot) * 4;
+                        if (NurseId(qFromLittleEndian<quint32>(slotData)) == nurse) {
+                            result.append(Assignment{ roster, day, shift });
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    /*!
+     * \brief Returns the rosters in the same form as they were written (see write()).
+     */
+    QVariantMap toVariantMap() const
+    {
+        QVariantMap result;
+        for (int roster = 0; roster < rosterTotal; ++roster) {
+            QVariantList rosterDays;
+            rosterDays.reserve(days(roster));
+            for (int day = 0; day < days(roster); ++day) {
+                QVariantMap shiftNurses;
+                for (int shift = 0; shift < shiftsPerDay; ++shift) {
+                    QStringList names;
+                    foreach (const NurseId nurse, nurses(roster, day, shift)) {
+                        names.append(nurseName(nurse));
+                    }
+                    shiftNurses.insert(shiftName(shift), names);
+                }
+                rosterDays.append(shiftNurses);
+            }
+            if (ward(roster).isEmpty()) {
+                result.insert(month(roster), rosterDays);
+            } else {
+                QVariantMap wardRoster = result.value(ward(roster)).toMap();
+                wardRoster.insert(month(roster), rosterDays);
+                result.insert(ward(roster), wardRoster);
+            }
+        }
+        return result;
+    }
+
+protected:
+    QFile file;
+    uchar *data;       // The mapped file, or nullptr if no file is open.
+    qint64 fileSize;
+    int shiftsPerDay;  // Header fields, cached once validated.
+    int nurseTotal;
+    int rosterTotal;
+    int slotsPerShift;
+
+    static const char *magic()
+    {
+        return "CGRB";
+    }
+
+    static quint32 version()
+    {
+        return 1;
+    }
+
+    static qint64 headerSize()
+    {
+        return 32;
+    }
+
+    /*!
+     * \brief Returns the 32-bit integer at byte \a offset of the mapped file.
+     */
+    quint32 word(const quint64 offset) const
+    {
+        return qFromLittleEndian<quint32>(data + offset);
+    }
+
+    quint64 rosterIndexOffset() const
+    {
+        return word(24);
+    }
+
+    quint64 slotsOffset(const int roster) const
+    {
+        return word(rosterIndexOffset() + quint64(roster) * 8 + 4);
+    }
+
+    /*!
+     * \brief Returns the offset of \a index's entry in the string index.
+     */
+    static quint64 stringIndex(const int index)
+    {
+        return headerSize() + quint64(index) * 8;
+    }
+
+    const char *bytes(const int index) const
+    {
+        return reinterpret_cast<const char *>(data + word(stringIndex(index)));
+    }
+
+    QString string(const int index) const
+    {
+        return QString::fromUtf8(bytes(index), int(word(stringIndex(index) + 4)));
+    }
+
+    /*!
+     * \brief Compares two UTF-8 strings byte-wise, returning a negative, zero, or positive value
+     * if \a first sorts before, the same as, or after \a second.
+     */
+    static int compare(const char * const first, const int firstSize,
+                       const char * const second, const int secondSize)
+    {
+        const int comparison = std::memcmp(first, second, size_t(qMin(firstSize, secondSize)));
+        return (comparison != 0) ? comparison : (firstSize - secondSize);
+    }
+
+    static bool lessThan(const QByteArray &first, const QByteArray &second)
+    {
+        return compare(first.constData(), first.size(), second.constData(), second.size()) < 0;
+    }
+
+    /*!
+     * \brief Checks that the mapped file's header and indexes are consistent with its size, and
+     * that every slot is either unfilled or a valid nurse ID, then caches the header fields.
+     *
+     * Checking the slots here (a single sequential pass) means lookups never return an ID beyond
+     * nurseCount(), however corrupt the file.
+     */
+    bool isValid()
+    {
+        if ((std::memcmp(data, magic(), 4) != 0) || (word(4) != version()) ||
+            (word(28) != quint64(fileSize))) {
+            return false;
+        }
+        // Every count is a 32-bit word, so sums of a few (times small sizes) cannot overflow 64
+        // bits, but products of them can; and each must fit in an int, as they are cached as ints.
+        const quint64 intMax = quint64(std::numeric_limits<int>::max());
+        const quint64 shiftWords = word(8), nurseWords = word(12), rosterWords = word(16);
+        const quint64 slotWords = word(20);
+        const quint64 stringCount = shiftWords + nurseWords + rosterWords * 2;
+        const quint64 maxSlots = quint64(fileSize) / 4; // No more than would fit in the file.
+        if ((stringCount > intMax) || (slotWords > intMax) || (slotWords > maxSlots) ||
+            (stringIndex(0) + stringCount * 8 > quint64(fileSize)) ||
+            (rosterIndexOffset() + rosterWords * 8 > quint64(fileSize))) {
+            return false;
+        }
+        for (quint64 index = 0; index < stringCount; ++index) {
+            const quint64 size = word(stringIndex(int(index)) + 4);
+            if ((size > intMax) || (word(stringIndex(int(index))) + size > quint64(fileSize))) {
+                return false;
+            }
+        }
+        for (quint64 roster = 0; roster < rosterWords; ++roster) {
+            const quint64 days = word(rosterIndexOffset() + roster * 8);
+            if ((days > intMax) || (days > maxSlots) ||
+                ((shiftWords != 0) && (days > maxSlots / shiftWords))) {
+                return false;
+            }
+            const quint64 shiftCount = days * shiftWords;
+            if ((slotWords != 0) && (shiftCount > maxSlots / slotWords)) {
+                return false;
+            }
+            const quint64 slotCount = shiftCount * slotWords;
+            const quint64 offset = word(rosterIndexOffset() + roster * 8 + 4);
+            if (offset + slotCount * 4 > quint64(fileSize)) {
+                return false;
+            }
+            for (quint64 slot = 0; slot < slotCount; ++slot) {
+                const quint32 nurse = word(offset + slot * 4);
+                if ((nurse >= nurseWords) && (nurse != quint32(-1))) {
+                    return false;
+                }
+            }
+        }
+        shiftsPerDay = int(shiftWords);
+        nurseTotal = int(nurseWords);
+        rosterTotal = int(rosterWords);
+        slotsPerShift = int(slotWords);
+        return true;
+    }
+
+};
+
+} // end Cogent namespace
+
+#endif // __BINARY_ROSTER_H__
@@ -0,0 +1,253 @@
+#ifndef __CARRY_IN_H__
+#define __CARRY_IN_H__
+
+#include "Logging.h"
+#include "NurseTable.h"
+#include "Roster.h"
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QDate>
+#include <QDebug>
+#include <QSet>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QVector>
+
+#include <algorithm>
+
+namespace Cogent {
+
+/*!
+ * \brief Compact state carried in to a roster from the roster(s) before it.
+ *
+ * Constraints such as AtMostFiveConsecutiveDays and NoSingleDaysOff span month boundaries, but
+ * each month is generated separately. Rather than re-reading the entire history, a CarryIn holds
+ * just the last few days of assignments (in the same form as RosterGenerator's output), plus each
+ * nurse's current streak of days worked or days off, which is all those constraints need.
+ *
+ * A CarryIn can be built from a previous month's generated roster (see fromRoster), rolled forward
+ * by each new month (see advanced), and saved to and loaded from a binary snapshot (see
+ * toByteArray and fromByteArray).
+ */
+class CarryIn
+{
+
+public:
+    /*!
+     * \brief A nurse's streak as at the end of the carried-in days.
+     *
+     * At most one of the counts is non-zero. Both are zero for nurses with no known history.
+     */
+    struct Streak {
+        int daysWorked; // Consecutive days worked, up to and including the last carried-in day.
+        int daysOff;    // Consecutive days off, since the nurse last worked.
+    };
+
+    /*!
+     * \brief Default number of days of assignments kept by fromRoster and advanced.
+     */
+    static int defaultTailDays()
+    {
+        return 7;
+    }
+
+    /*!
+     * \brief Constructs an empty state, as if no roster came before.
+     */
+    CarryIn() { }
+
+    /*!
+     * \brief Returns \c true if this state carries nothing in; \c false otherwise.
+     */
+    bool isEmpty() const
+    {
+        return streakByNurse.isEmpty();
+    }
+
+    /*!
+     * \brief Returns the carried-in days of assignments, oldest first, where each day is a map of
+     * shift names to lists of nurse names.
+     */
+    QVariantList tail() const
+    {
+        return lastDays;
+    }
+
+    /*!
+     * \brief Returns \a nurse's streak as at the end of the carried-in days.
+     */
+    Streak streak(const QString &nurse) const
+    {
+        return streakByNurse.value(nurse, Streak{ 0, 0 });
+    }
+
+    /*!
+     * \brief Returns the streaks of all of \a nurses, indexed by NurseId.
+     *
+     * Carried-in nurses not in \a nurses are ignored.
+     */
+    QVector<Streak> streaks(const NurseTable &nurses) const
+    {
+        QVector<Streak> result(nurses.size(), Streak{ 0, 0 });
+        for (auto iter = streakByNurse.constBegin(); iter != streakByNurse.constEnd(); ++iter) {
+            const NurseId nurse = nurses.id(iter.key());
+            if (nurse >= 0) {
+                result[nurse] = iter.value();
+            }
+        }
+        return result;
+    }
+
+    /*!
+     * \brief Returns this state rolled forward by \a days (in the same form as tail()), keeping at
+     * most \a tailDays days of assignments.
+     *
+     * This costs O(days * nurses), regardless of how much history this state represents.
+     */
+    CarryIn advanced(const QVariantList &days, const int tailDays = defaultTailDays()) const
+    {
+        CarryIn state(*this);
+        foreach (const QVariant &day, days) {
+            state.advanceDay(day.toMap());
+        }
+        state.lastDays.append(days);
+        state.lastDays = state.lastDays.mid(qMax(0, state.lastDays.size() - tailDays));
+        return state;
+    }
+
+    /*!
+     * \brief Returns this state rolled forward by \a days (with nurses named as per \a nurses),
+     * keeping at most \a tailDays days of assignments.
+     *
+     * This is equivalent to advanced(days.toVariantList(nurses), tailDays), but only ever converts
+     * one day at a time, so does not build the whole month's QVariantList.
+     */
+    CarryIn advanced(const Roster &days, const NurseTable &nurses,
+                     const int tailDays = defaultTailDays()) const
+    {
+        CarryIn state(*this);
+        const int firstTailDay = days.size() - tailDays;
+        for (int day = 0; day < days.size(); ++day) {
+            const QVariantMap shifts = days.dayToVariantMap(day, nurses);
+            state.advanceDay(shifts);
+            if (day >= firstTailDay) {
+                state.lastDays.append(shifts);
+            }
+        }
+        state.lastDays = state.lastDays.mid(qMax(0, state.lastDays.size() - tailDays));
+        return state;
+    }
+
+    /*!
+     * \brief Returns \a previous rolled forward by every month of \a roster (as generated by
+     * RosterGenerator or BatchGenerator), in chronological order, keeping at most \a tailDays days
+     * of assignments.
+     *
+     * Entries of \a roster that are not months (such as "created") are ignored.
+     */
+    static CarryIn fromRoster(const QVariantMap &roster, const CarryIn &previous = CarryIn(),
+                              const int tailDays = defaultTailDays())
+    {
+        CarryIn state(previous);
+        for (auto iter = roster.constBegin(); iter != roster.constEnd(); ++iter) {
+            // Note, QVariantMap keys are sorted, and 'yyyy-MM' keys sort chronologically.
+            if (QDate::fromString(iter.key(), QStringLiteral("yyyy-MM")).isValid()) {
+                state = state.advanced(iter.value().toList(), tailDays);
+            }
+        }
+        return state;
+    }
+
+    /*!
+     * \brief Returns this state as a binary snapshot, suitable for fromByteArray.
+     */
+    QByteArray toByteArray() const
+    {
+        QByteArray data;
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_5_0);
+        stream << magic() << version() << lastDays << qint32(streakByNurse.size());
+        // Write the streaks in name order, so that equal states always give identical snapshots.
+        QStringList nurses = streakByNurse.keys();
+        std::sort(nurses.begin(), nurses.end());
+        foreach (const QString &nurse, nurses) {
+            const Streak streak = streakByNurse.value(nurse);
+            stream << nurse << qint32(streak.daysWorked) << qint32(streak.daysOff);
+        }
+        return data;
+    }
+
+    /*!
+     * \brief Returns the state saved in the binary snapshot \a data.
+     *
+     * If \a data is not a valid snapshot, returns an empty state, and (if not \c nullptr) sets
+     * \a ok to \c false.
+     */
+    static CarryIn fromByteArray(const QByteArray &data, bool * const ok = nullptr)
+    {
+        QDataStream stream(data);
+        stream.setVersion(QDataStream::Qt_5_0);
+        quint32 fileMagic = 0, fileVersion = 0;
+        qint32 count = 0;
+        CarryIn state;
+        stream >> fileMagic >> fileVersion >> state.lastDays >> count;
+        for (qint32 index = 0; (index < count) && (stream.status() == QDataStream::Ok); ++index) {
+            QString nurse;
+            qint32 daysWorked = 0, daysOff = 0;
+            stream >> nurse >> daysWorked >> daysOff;
+            state.streakByNurse.insert(nurse, Streak{ daysWorked, daysOff });
+        }
+        const bool valid = (fileMagic == magic()) && (fileVersion == version()) &&
+                           (count >= 0) && (stream.status() == QDataStream::Ok);
+        if (ok) {
+            *ok = valid;
+        }
+        if (!valid) {
+            qCWarning(lcRoster) << "invalid carry-in snapshot";
+            return CarryIn();
+        }
+        return state;
+    }
+
+protected:
+    QVariantList lastDays;                // The last few days of assignments, oldest first.
+    QHash<QString, Streak> streakByNurse; // Every nurse with known history.
+
+    static quint32 magic()
+    {
+        return 0x43524349; // "CRCI"
+    }
+
+    static quint32 version()
+    {
+        return 1;
+    }
+
+    /*!
+     * \brief Updates all streaks for one more \a day of assignments.
+     */
+    void advanceDay(const QVariantMap &day)
+    {
+        QSet<QString> worked;
+        foreach (const QVariant &shift, day) {
+            foreach (const QString &nurse, shift.toStringList()) {
+                worked.insert(nurse);
+            }
+        }
+        for (auto iter = streakByNurse.begin(); iter != streakByNurse.end(); ++iter) {
+            if (!worked.contains(iter.key())) {
+                iter.value() = Streak{ 0, iter.value().daysOff + 1 };
+            }
+        }
+        foreach (const QString &nurse, worked) {
+            Streak &streak = streakByNurse[nurse];
+            streak = Streak{ streak.daysWorked + 1, 0 };
+        }
+    }
+
+};
+
+} // end Cogent namespace
+
+#endif // __CARRY_IN_H__
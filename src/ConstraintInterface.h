@@ -1,28 +1,168 @@
 #ifndef __CONSTRAINT_INTERFACE_H__
 #define __CONSTRAINT_INTERFACE_H__
 
-#include <QSet>
-#include <QString>
-#include <QVariantList>
+#include "CarryIn.h"
+#include "NurseSet.h"
+#include "Roster.h"
 
 namespace Cogent {
 
 /*!
  * \brief Interface class for all constraint classes to implement.
+ *
+ * Constraints are incremental: rather than rescanning the roster on every constrain() call, each
+ * constraint is notified of every change to the roster as it is made, and keeps whatever running
+ * state (counters, streaks, etc) it needs to answer constrain() cheaply. Typically, that state
+ * includes a NurseSet mask of eligible nurses, so that constrain() is a single word-wise AND of
+ * that mask into the candidate nurses. The notifications are:
+ *
+ *  - reset() before a new roster is started;
+ *  - onCarryIn(), straight after reset(), if the roster continues on from an earlier roster;
+ *  - onAssigned() each time a nurse is assigned to a shift of the current day;
+ *  - onDayCommitted() once all shifts of the current day have been filled; and
+ *  - onUnassigned() and onDayUncommitted(), which undo the above.
+ *
+ * Undo notifications must be made in the exact reverse order of the notifications they undo (ie
+ * the notifications form a stack), which allows constraints to keep simple undo logs.
  */
 class ConstraintInterface
 {
 
 public:
-    typedef QSet<QString> QStringSet;
-
     /*!
      * \brief Removes from \a nurses any nurse that would fail this constraint if thery were to be
-     * included in \a shift of the day after \a daysSoFar.
+     * included in \a shift of the last day of \a daysSoFar.
+     *
+     * Note, \a daysSoFar always includes the current day (ie the day being rostered), even if
+     * none of its shifts have been filled yet. This constraint must have already been notified of
+     * every assignment in \a daysSoFar (see replay()).
      *
      * Returns the number of nurses removed, if any, otherwise 0.
      */
-    virtual int constrain(QStringSet &nurses, const QString &shift, const QVariantList &daysSoFar) = 0;
+    virtual int constrain(NurseSet &nurses, const int shift, const Roster &daysSoFar) = 0;
+
+    /*!
+     * \brief Returns the name of this constraint's type, as used in rules files (see Rules), such
+     * as "AtMostOneShiftPerDay", for reporting violations (see RosterValidator).
+     */
+    virtual QString name() const = 0;
+
+    /*!
+     * \brief Discards all state, ready to start a new roster of \a nurseCount nurses.
+     */
+    virtual void reset(const int nurseCount) { Q_UNUSED(nurseCount); }
+
+    /*!
+     * \brief Notifies this constraint of each nurse's streak (indexed by NurseId) as at the end of
+     * the roster(s) before this one, such that day -1 is the last day before this roster.
+     *
+     * Only called straight after reset(), and never undone (other than by the next reset()).
+     */
+    virtual void onCarryIn(const QVector<CarryIn::Streak> &streaks) { Q_UNUSED(streaks); }
+
+    /*!
+     * \brief Notifies this constraint that \a nurse has been assigned to \a shift of \a day.
+     */
+    virtual void onAssigned(const NurseId nurse, const int day, const int shift)
+    {
+        Q_UNUSED(nurse); Q_UNUSED(day); Q_UNUSED(shift);
+    }
+
+    /*!
+     * \brief Notifies this constraint that the assignment of \a nurse to \a shift of \a day has
+     * been undone.
+     */
+    virtual void onUnassigned(const NurseId nurse, const int day, const int shift)
+    {
+        Q_UNUSED(nurse); Q_UNUSED(day); Q_UNUSED(shift);
+    }
+
+    /*!
+     * \brief Notifies this constraint that \a day of \a roster is complete, and that subsequent
+     * assignments will be for the following day.
+     */
+    virtual void onDayCommitted(const Roster &roster, const int day)
+    {
+        Q_UNUSED(roster); Q_UNUSED(day);
+    }
+
+    /*!
+     * \brief Notifies this constraint that the commit of \a day of \a roster has been undone, such
+     * that \a day is once again the current day.
+     */
+    virtual void onDayUncommitted(const Roster &roster, const int day)
+    {
+        Q_UNUSED(roster); Q_UNUSED(day);
+    }
+
+    /*!
+     * \brief Returns the most days that any one nurse could work out of \a days consecutive days,
+     * according to this constraint alone.
+     *
+     * This, and the other bounds below, let RosterGenerator reject months that cannot possibly be
+     * filled before doing any work. So they must never be lower than what is actually achievable,
+     * but need not be tight; the defaults impose no bound at all.
+     */
+    virtual int maxDaysWorked(const int days) const { return days; }
+
+    /*!
+     * \brief Returns the most shifts, of \a shiftCount shifts per day, that any one nurse could
+     * work on a single day, according to this constraint alone.
+     */
+    virtual int maxShiftsPerDay(const int shiftCount) const { return shiftCount; }
+
+    /*!
+     * \brief Returns the most of \a shift that any one nurse could work in a month of \a days days,
+     * according to this constraint alone.
+     */
+    virtual int maxShiftsPerMonth(const int shift, const int days) const
+    {
+        Q_UNUSED(shift);
+        return days;
+    }
+
+    /*!
+     * \brief Resets this constraint, then notifies it of the carried-in \a streaks (if any), and
+     * every assignment in \a roster.
+     *
+     * All days but the last are committed; the last day of \a roster is left as the current day.
+     */
+    void replay(const Roster &roster, const int nurseCount,
+                const QVector<CarryIn::Streak> &streaks = QVector<CarryIn::Streak>())
+    {
+        reset(nurseCount);
+        if (!streaks.isEmpty()) {
+            onCarryIn(streaks);
+        }
+        for (int day = 0; day < roster.size(); ++day) {
+            if (day > 0) {
+                onDayCommitted(roster, day-1);
+            }
+            for (int shift = 0; shift < roster.shiftCount(); ++shift) {
+                for (int slot = 0; slot < roster.count(day, shift); ++slot) {
+                    onAssigned(roster.at(day, shift, slot), day, shift);
+                }
+            }
+        }
+    }
+
+    /*!
+     * \brief Undoes the notifications of every assignment in \a roster after \a day, such that
+     * \a day is once again the current day (with its assignments intact).
+     *
+     * This constraint must currently reflect all of \a roster, as per replay().
+     */
+    void rewind(const Roster &roster, const int day)
+    {
+        for (int laterDay = roster.size()-1; laterDay > day; --laterDay) {
+            for (int shift = roster.shiftCount()-1; shift >= 0; --shift) {
+                for (int slot = roster.count(laterDay, shift)-1; slot >= 0; --slot) {
+                    onUnassigned(roster.at(laterDay, shift, slot), laterDay, shift);
+                }
+            }
+            onDayUncommitted(roster, laterDay-1);
+        }
+    }
 
     /*!
      * \brief Virtual destructor for safe polymorphic destruction.
@@ -0,0 +1,95 @@
+#ifndef __DEMAND_H__
+#define __DEMAND_H__
+
+#include <QDate>
+#include <QMap>
+#include <QVector>
+
+namespace Cogent {
+
+/*!
+ * \brief Number of nurses required on each shift of each day (ie the demand curve).
+ *
+ * Each shift has a base headcount, which may be overridden for particular days of the week (such
+ * as weekends), and again for particular dates (such as public holidays).
+ */
+class Demand
+{
+
+public:
+    /*!
+     * \brief Constructs a demand of \a nursesPerShift (indexed by shift) nurses on every day.
+     */
+    explicit Demand(const QVector<int> &nursesPerShift = QVector<int>())
+    {
+        for (int dayOfWeek = Qt::Monday; dayOfWeek <= Qt::Sunday; ++dayOfWeek) {
+            byWeekday.append(nursesPerShift);
+        }
+    }
+
+    /*!
+     * \brief Returns the number of shifts per day.
+     */
+    int shiftCount() const
+    {
+        return byWeekday.first().size();
+    }
+
+    /*!
+     * \brief Sets the number of \a nurses required on \a shift of every \a dayOfWeek (a
+     * Qt::DayOfWeek), other than any dates set explicitly.
+     */
+    void setNurses(const Qt::DayOfWeek dayOfWeek, const int shift, const int nurses)
+    {
+        Q_ASSERT((dayOfWeek >= Qt::Monday) && (dayOfWeek <= Qt::Sunday));
+        byWeekday[dayOfWeek - Qt::Monday][shift] = nurses;
+    }
+
+    /*!
+     * \brief Sets the number of \a nurses required on \a shift of \a date (such as a holiday),
+     * overriding its day of the week.
+     */
+    void setNurses(const QDate &date, const int shift, const int nurses)
+    {
+        if (!byDate.contains(date)) {
+            byDate.insert(date, byWeekday.at(date.dayOfWeek() - Qt::Monday));
+        }
+        byDate[date][shift] = nurses;
+    }
+
+    /*!
+     * \brief Returns the number of nurses required on \a shift of \a date.
+     */
+    int nurses(const QDate &date, const int shift) const
+    {
+        const auto iter = byDate.constFind(date);
+        return (iter == byDate.constEnd())
+            ? byWeekday.at(date.dayOfWeek() - Qt::Monday).at(shift) : iter.value().at(shift);
+    }
+
+    /*!
+     * \brief Returns the number of nurses required on each shift of \a days days, starting from
+     * \a firstDay, indexed by day * shiftCount() + shift.
+     */
+    QVector<int> headcounts(const QDate &firstDay, const int days) const
+    {
+        QVector<int> result;
+        result.reserve(days * shiftCount());
+        for (int day = 0; day < days; ++day) {
+            const QDate date = firstDay.addDays(day);
+            for (int shift = 0; shift < shiftCount(); ++shift) {
+                result.append(nurses(date, shift));
+            }
+        }
+        return result;
+    }
+
+protected:
+    QVector<QVector<int>> byWeekday;  // Headcounts by shift, by day of the week from Monday.
+    QMap<QDate, QVector<int>> byDate; // Headcounts by shift, for explicitly set dates.
+
+};
+
+} // end Cogent namespace
+
+#endif // __DEMAND_H__
@@ -0,0 +1,383 @@
+#ifndef __FAIR_SCHEDULER_H__
+#define __FAIR_SCHEDULER_H__
+
+#include "Logging.h"
+#include "Roster.h"
+#include "SchedulerInterface.h"
+
+#include <QDebug>
+#include <QMap>
+#include <QPair>
+
+namespace Cogent {
+
+/*!
+ * \brief Schedules nurses so as to balance their total, night and weekend shifts, as well as
+ * their rest.
+ *
+ * Each nurse is scored on a weighted mix of how recently they last worked, and how many shifts,
+ * night shifts and weekend shifts they have worked, and the lowest scoring available nurses are
+ * chosen. Night and weekend shifts are only weighed when choosing nurses for a night or weekend
+ * shift (see onShift), so those shifts are shared out evenly too, rather than falling to whoever
+ * happens to be available. All counts accumulate over the scheduler's lifetime, so shifts also
+ * even out across months.
+ *
+ * Unlike LeastRecentScheduler, a nurse's score can depend on the shift being filled, so this
+ * scheduler keeps the nurses ordered by score for each kind of shift (weekday or weekend, night or
+ * not). Recording a nurse as chosen (or undoing it) changes only that nurse's scores, so costs
+ * O(log n) per ordering. Choosing nurses walks the shift's ordering from the lowest score,
+ * stopping once enough available nurses are found, so costs O(k), where k is the number of nurses
+ * walked: just those chosen if the lowest scoring nurses are all available, but up to all n
+ * nurses if most of them are not. Either way, there's no re-sort of all nurses' scores. (Instead
+ * scanning every available nurse is faster only when the lowest scoring nurses are mostly
+ * unavailable; when generating whole months, the ordering wins from around a thousand nurses.)
+ */
+class FairScheduler : public SchedulerInterface
+{
+
+public:
+    /*!
+     * \brief The weights of each part of a nurse's score; lower scoring nurses are chosen first.
+     *
+     * Weights must not be negative. Recency is counted in days, so with the default weights, a
+     * nurse who has worked one more shift than another is chosen after them, unless the other
+     * worked more than four days more recently.
+     */
+    struct Weights {
+        double recency;  // Per day, from a fixed epoch, of the nurse's last shift (if any).
+        double shifts;   // Per shift worked.
+        double nights;   // Per night shift worked, when choosing nurses for a night shift.
+        double weekends; // Per weekend shift worked, when choosing nurses for a weekend shift.
+    };
+
+    /*!
+     * \brief Returns the default weights; see Weights.
+     */
+    static Weights defaultWeights()
+    {
+        return Weights{ 1.0, 4.0, 4.0, 4.0 };
+    }
+
+    /*!
+     * \brief Constructs a scheduler that scores nurses with \a weights, counting \a nightShift (an
+     * index into the roster's shifts) as the night shift.
+     */
+    explicit FairScheduler(const Weights &weights = defaultWeights(),
+                           const int nightShift = Roster::NightShift)
+        : weights(weights), nightShift(nightShift), seed(0), day(0), context(DayContext),
+          undoable(false)
+    {
+        Q_ASSERT((weights.recency >= 0.0) && (weights.shifts >= 0.0) && (weights.nights >= 0.0) &&
+                 (weights.weekends >= 0.0));
+    }
+
+    /*!
+     * \brief Returns the lowest scoring of \a availableNurses, for the current shift.
+     *
+     * Ties are broken in ascending NurseId order, unless seeded (see setSeed).
+     */
+    virtual NurseId chooseNextNurse(const NurseSet &availableNurses) override
+    {
+        Q_ASSERT(!availableNurses.isEmpty()); // Must have at least one nurse available.
+        chosen.resize(0); // Keeps its capacity, for the next choice.
+        rank(availableNurses, 1, chosen);
+        const NurseId nurse = chosen.first();
+        qCDebug(lcScheduler) << "Chose nurse" << nurse;
+        allocate(nurse);
+        return nurse;
+    }
+
+    virtual QVector<NurseId> chooseNextNurses(const NurseSet &availableNurses,
+                                              const int count) override
+    {
+        QVector<NurseId> nurses;
+        appendNextNurses(availableNurses, count, nurses);
+        return nurses;
+    }
+
+    /*!
+     * \brief Appends the \a count lowest scoring of \a availableNurses to \a nurses, in order.
+     *
+     * The nurses are all ranked by their scores before any are recorded as chosen, since they are
+     * all chosen for the same shift.
+     */
+    virtual void appendNextNurses(const NurseSet &availableNurses, const int count,
+                                  QVector<NurseId> &nurses) override
+    {
+        const int firstChosen = nurses.size();
+        rank(availableNurses, count, nurses);
+        for (int index = firstChosen; index < nurses.size(); ++index) {
+            allocate(nurses.at(index));
+        }
+        qCDebug(lcScheduler) << "Chose" << nurses.size() - firstChosen << "of" << count << "nurses";
+    }
+
+    virtual QVector<NurseId> rankNurses(const NurseSet &availableNurses) const override
+    {
+        QVector<NurseId> nurses;
+        appendRankedNurses(availableNurses, nurses);
+        return nurses;
+    }
+
+    virtual void appendRankedNurses(const NurseSet &availableNurses,
+                                    QVector<NurseId> &nurses) const override
+    {
+        rank(availableNurses, availableNurses.count(), nurses);
+    }
+
+    /*!
+     * \brief Notes that the following choices are for \a shift of \a date, so whether to weigh
+     * night and weekend shifts.
+     *
+     * Until this is called, choices are for a weekday shift that is not a night shift, on day 0.
+     */
+    virtual void onShift(const QDate &date, const int shift) override
+    {
+        day = date.isValid() ? date.toJulianDay() : 0;
+        context = ((shift == nightShift) ? NightContext : DayContext) |
+            (((date.isValid()) && (date.dayOfWeek() >= Qt::Saturday)) ? WeekendContext : 0);
+    }
+
+    virtual void onAssigned(const NurseId nurse) override
+    {
+        allocate(nurse);
+    }
+
+    /*!
+     * \brief Breaks subsequent ties pseudo-randomly according to \a seed (or in ascending NurseId
+     * order if 0), keeping every nurse's counts.
+     *
+     * This reorders every registered nurse, so costs O(n log n).
+     */
+    virtual void setSeed(const quint64 seed) override
+    {
+        if (seed == this->seed) {
+            return;
+        }
+        this->seed = seed;
+        for (int kind = 0; kind < ContextCount; ++kind) {
+            ranks[kind].clear();
+        }
+        for (NurseId nurse = registeredNurses.first(); nurse >= 0;
+             nurse = registeredNurses.next(nurse)) {
+            rerank(nurse);
+        }
+    }
+
+    virtual SchedulerInterface *clone() const override
+    {
+        return new FairScheduler(*this);
+    }
+
+    virtual void onUnassigned(const NurseId nurse) override
+    {
+        Q_ASSERT(undoable);
+        Q_ASSERT(!undoLog.isEmpty());
+        const UndoEntry entry = undoLog.takeLast();
+        Q_ASSERT(entry.nurse == nurse); // Undos must be in reverse order of allocations.
+        Q_UNUSED(nurse);
+        unrank(entry.nurse);
+        counts[entry.nurse] = entry.counts;
+        rerank(entry.nurse);
+    }
+
+    virtual void setUndoable(const bool undoable) override
+    {
+        this->undoable = undoable;
+        undoLog.resize(0); // Keeps its capacity, for the next search.
+    }
+
+    /*!
+     * \brief Returns the number of shifts \a nurse has been recorded as working.
+     */
+    int shiftsWorked(const NurseId nurse) const
+    {
+        return (nurse < counts.size()) ? counts.at(nurse).shifts : 0;
+    }
+
+    /*!
+     * \brief Returns the number of night shifts \a nurse has been recorded as working.
+     */
+    int nightsWorked(const NurseId nurse) const
+    {
+        return (nurse < counts.size()) ? counts.at(nurse).nights : 0;
+    }
+
+    /*!
+     * \brief Returns the number of weekend shifts \a nurse has been recorded as working.
+     */
+    int weekendsWorked(const NurseId nurse) const
+    {
+        return (nurse < counts.size()) ? counts.at(nurse).weekends : 0;
+    }
+
+protected:
+    /*!
+     * \brief Kinds of shift, each with their own ordering of nurses; combined as bit flags.
+     */
+    enum Context {
+        DayContext     = 0x0,
+        NightContext   = 0x1,
+        WeekendContext = 0x2,
+        ContextCount   = 0x4
+    };
+
+    /*!
+     * \brief A nurse's shift counts, from which their scores are calculated.
+     */
+    struct Counts {
+        qint64 lastDay; // Julian day of the nurse's last shift, or 0 if none (or no dates given).
+        int shifts;
+        int nights;
+        int weekends;
+    };
+
+    struct UndoEntry {
+        NurseId nurse;
+        Counts counts; // The nurse's counts before the allocation.
+    };
+
+    /*!
+     * \brief A nurse's position in an ordering: their score, then their tieBreakKey.
+     */
+    typedef QPair<double, quint64> Rank;
+
+    const Weights weights;
+    const int nightShift;
+    quint64 seed;               // Tie-breaking seed; 0 for NurseId order.
+    qint64 day;                 // Julian day of the current shift, or 0 if none given.
+    int context;                // The current shift's Context flags.
+    bool undoable;              // Whether to log allocations in undoLog; see setUndoable.
+    QVector<UndoEntry> undoLog; // Previous counts of each undoable allocation.
+    QVector<NurseId> chosen;    // Scratch list, reused by every chooseNextNurse call.
+
+    // Every nurse seen so far is registered, with no shifts, the first time they are available,
+    // so these are mutable for rank(); registering a nurse does not change anyone's rank.
+    mutable QVector<Counts> counts;                  // By NurseId.
+    mutable NurseSet registeredNurses;               // All nurses with counts.
+    mutable QMap<Rank, NurseId> ranks[ContextCount]; // Registered nurses, by score, per Context.
+    mutable NurseSet unregisteredNurses;             // Scratch set, reused by every ranking.
+
+    /*!
+     * \brief Appends (up to) \a count of \a availableNurses to \a nurses, lowest scoring first.
+     */
+    void rank(const NurseSet &availableNurses, const int count, QVector<NurseId> &nurses) const
+    {
+        registerNurses(availableNurses);
+        const int end = nurses.size() + count;
+        nurses.reserve(end);
+        const QMap<Rank, NurseId> &ranked = ranks[context];
+        for (auto iter = ranked.constBegin(); (iter != ranked.constEnd()) && (nurses.size() < end);
+             ++iter) {
+            if (availableNurses.contains(iter.value())) {
+                nurses.append(iter.value());
+            }
+        }
+    }
+
+    /*!
+     * \brief Registers any of \a availableNurses not already registered, with no shifts.
+     */
+    void registerNurses(const NurseSet &availableNurses) const
+    {
+        unregisteredNurses.assign(availableNurses).subtract(registeredNurses);
+        for (NurseId nurse = unregisteredNurses.first(); nurse >= 0;
+             nurse = unregisteredNurses.next(nurse)) {
+            registerNurse(nurse);
+        }
+    }
+
+    /*!
+     * \brief Registers \a nurse (not already registered), with no shifts.
+     */
+    void registerNurse(const NurseId nurse) const
+    {
+        if (nurse >= counts.size()) {
+            counts.resize(nurse+1);
+        }
+        counts[nurse] = Counts{ 0, 0, 0, 0 };
+        registeredNurses.insert(nurse);
+        rerank(nurse);
+    }
+
+    /*!
+     * \brief Records \a nurse as working the current shift.
+     */
+    void allocate(const NurseId nurse)
+    {
+        if (!registeredNurses.contains(nurse)) {
+            registerNurse(nurse);
+        }
+        if (undoable) {
+            undoLog.append(UndoEntry{ nurse, counts.at(nurse) });
+        }
+        unrank(nurse);
+        Counts &nurseCounts = counts[nurse];
+        nurseCounts.lastDay = day;
+        ++nurseCounts.shifts;
+        if (context & NightContext) {
+            ++nurseCounts.nights;
+        }
+        if (context & WeekendContext) {
+            ++nurseCounts.weekends;
+        }
+        rerank(nurse);
+    }
+
+    /*!
+     * \brief Returns \a nurse's score for shifts of the given \a kind (of Context flags).
+     */
+    double score(const NurseId nurse, const int kind) const
+    {
+        const Counts &nurseCounts = counts.at(nurse);
+        double score = weights.recency * nurseCounts.lastDay + weights.shifts * nurseCounts.shifts;
+        if (kind & NightContext) {
+            score += weights.nights * nurseCounts.nights;
+        }
+        if (kind & WeekendContext) {
+            score += weights.weekends * nurseCounts.weekends;
+        }
+        return score;
+    }
+
+    /*!
+     * \brief Returns \a nurse's position among equally scored nurses, for this seed.
+     *
+     * The low 32 bits are always the NurseId, so every nurse's key is unique.
+     */
+    quint64 tieBreakKey(const NurseId nurse) const
+    {
+        if (seed == 0) {
+            return quint64(nurse);
+        }
+        const quint64 key = mix(seed + (quint64(nurse) + 1) * Q_UINT64_C(0x9E3779B97F4A7C15));
+        return (key & Q_UINT64_C(0xFFFFFFFF00000000)) | quint64(quint32(nurse));
+    }
+
+    /*!
+     * \brief Adds \a nurse to every ordering, according to their current counts.
+     */
+    void rerank(const NurseId nurse) const
+    {
+        const quint64 key = tieBreakKey(nurse);
+        for (int kind = 0; kind < ContextCount; ++kind) {
+            ranks[kind].insert(Rank(score(nurse, kind), key), nurse);
+        }
+    }
+
+    /*!
+     * \brief Removes \a nurse from every ordering, according to their current counts.
+     */
+    void unrank(const NurseId nurse) const
+    {
+        const quint64 key = tieBreakKey(nurse);
+        for (int kind = 0; kind < ContextCount; ++kind) {
+            ranks[kind].remove(Rank(score(nurse, kind), key));
+        }
+    }
+
+};
+
+} // end Cogent namespace
+
+#endif // __FAIR_SCHEDULER_H__
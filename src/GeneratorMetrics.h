@@ -0,0 +1,274 @@
+#ifndef __GENERATOR_METRICS_H__
+#define __GENERATOR_METRICS_H__
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QVector>
+
+namespace Cogent {
+
+/*!
+ * \brief Counters and timers of roster generation's hot paths, for monitoring.
+ *
+ * Each RosterGenerator keeps its own counters, as plain integers (a generator is only ever used by
+ * one thread at a time, so there's no need for atomics or locks in its inner loops). The metrics
+ * of generators run on other threads (such as BatchGenerator's wards, or RestartGenerator's
+ * passes) are combined via merge() once they are done.
+ *
+ * All times are in nanoseconds, as measured by QElapsedTimer. Constraint and scheduler times are
+ * zero unless the generator is timed (see RosterGenerator::setTimed).
+ */
+class GeneratorMetrics
+{
+
+public:
+    /*!
+     * \brief Statistics of a constraint's constrain() calls.
+     */
+    struct ConstraintStats {
+        QString name;       // The constraint's name (see ConstraintInterface::name).
+        qint64 calls;       // Number of constrain() calls.
+        qint64 candidates;  // Total candidates passed to those calls.
+        qint64 removed;     // Total candidates removed by those calls (as they reported).
+        qint64 nanoseconds; // Total time spent in those calls.
+        qint64 skipped;     // Calls skipped, as too few candidates remained to fill the shift.
+
+        /*!
+         * \brief Adds \a other's statistics to these.
+         */
+        void merge(const ConstraintStats &other)
+        {
+            calls += other.calls;
+            candidates += other.candidates;
+            removed += other.removed;
+            nanoseconds += other.nanoseconds;
+            skipped += other.skipped;
+        }
+    };
+
+    qint64 rosters;              // Rosters attempted, via generate() or repair().
+    qint64 failures;             // Rosters that could not be generated (or repaired).
+    qint64 infeasible;           // Of those, months rejected up front (see isFeasible).
+    qint64 cancelled;            // Rosters abandoned on being cancelled (so not failures).
+    qint64 nanoseconds;          // Total time spent generating (or repairing) rosters.
+    qint64 schedulerCalls;       // Calls to choose (or rank) nurses.
+    qint64 schedulerNanoseconds; // Total time spent in those calls.
+    qint64 searchNodes;          // Shifts visited by the backtracking engine.
+    qint64 searchesExhausted;    // Searches that reached their limits (so fell back to greedy).
+    QMap<QString, qint64> backtracks;   // Backtracks from each shift, by shift name.
+    QMap<QString, qint64> failedShifts; // Shifts that could not be filled, by shift name.
+    QVector<ConstraintStats> constraints; // At most one per constraint name.
+
+    GeneratorMetrics()
+        : rosters(0), failures(0), infeasible(0), cancelled(0), nanoseconds(0), schedulerCalls(0),
+          schedulerNanoseconds(0), searchNodes(0), searchesExhausted(0)
+    { }
+
+    /*!
+     * \brief Adds \a stats to those of the constraint of the same name, if any, otherwise appends
+     * them.
+     */
+    void addConstraint(const ConstraintStats &stats)
+    {
+        for (int index = 0; index < constraints.size(); ++index) {
+            if (constraints.at(index).name == stats.name) {
+                constraints[index].merge(stats);
+                return;
+            }
+        }
+        constraints.append(stats);
+    }
+
+    /*!
+     * \brief Adds all of \a other's metrics to these.
+     */
+    void merge(const GeneratorMetrics &other)
+    {
+        rosters += other.rosters;
+        failures += other.failures;
+        infeasible += other.infeasible;
+        cancelled += other.cancelled;
+        nanoseconds += other.nanoseconds;
+        schedulerCalls += other.schedulerCalls;
+        schedulerNanoseconds += other.schedulerNanoseconds;
+        searchNodes += other.searchNodes;
+        searchesExhausted += other.searchesExhausted;
+        for (auto iter = other.backtracks.constBegin(); iter != other.backtracks.constEnd();
+             ++iter) {
+            backtracks[iter.key()] += iter.value();
+        }
+        for (auto iter = other.failedShifts.constBegin(); iter != other.failedShifts.constEnd();
+             ++iter) {
+            failedShifts[iter.key()] += iter.value();
+        }
+        foreach (const ConstraintStats &stats, other.constraints) {
+            addConstraint(stats);
+        }
+    }
+
+    /*!
+     * \brief Returns these metrics as a map, suitable for JSON output (see JsonWriter).
+     */
+    QVariantMap toVariantMap() const
+    {
+        QVariantList constraintList;
+        foreach (const ConstraintStats &stats, constraints) {
+            constraintList.append(QVariantMap{
+                { QStringLiteral("name"), stats.name },
+                { QStringLiteral("calls"), stats.calls },
+                { QStringLiteral("candidates"), stats.candidates },
+                { QStringLiteral("removed"), stats.removed },
+                { QStringLiteral("skipped"), stats.skipped },
+                { QStringLiteral("nanoseconds"), stats.nanoseconds },
+            });
+        }
+        return QVariantMap{
+            { QStringLiteral("rosters"), rosters },
+            { QStringLiteral("failures"), failures },
+            { QStringLiteral("infeasible"), infeasible },
+            { QStringLiteral("cancelled"), cancelled },
+            { QStringLiteral("nanoseconds"), nanoseconds },
+            { QStringLiteral("scheduler"), QVariantMap{
+                { QStringLiteral("calls"), schedulerCalls },
+                { QStringLiteral("nanoseconds"), schedulerNanoseconds },
+            }},
+            { QStringLiteral("search"), QVariantMap{
+                { QStringLiteral("nodes"), searchNodes },
+                { QStringLiteral("exhausted"), searchesExhausted },
+                { QStringLiteral("backtracks"), toVariantMap(backtracks) },
+            }},
+            { QStringLiteral("failedShifts"), toVariantMap(failedShifts) },
+            { QStringLiteral("constraints"), constraintList },
+        };
+    }
+
+    /*!
+     * \brief Returns these metrics in the Prometheus text exposition format, with each metric's
+     * name prefixed by \a prefix.
+     *
+     * Counts are exported as counters, and times as counters of seconds, as per Prometheus
+     * conventions. Per-constraint and per-shift metrics are labelled by constraint or shift name.
+     */
+    QString toPrometheus(const QString &prefix = QStringLiteral("cogent_")) const
+    {
+        QStringList lines;
+        const auto counter = [&lines, &prefix](const QString &name, const QString &help) {
+            lines.append(QStringLiteral("# HELP %1%2 %3").arg(prefix, name, help));
+            lines.append(QStringLiteral("# TYPE %1%2 counter").arg(prefix, name));
+        };
+        const auto sample = [&lines, &prefix](const QString &name, const QString &labels,
+                                              const QString &value) {
+            lines.append(QStringLiteral("%1%2%3 %4").arg(prefix, name, labels, value));
+        };
+
+        counter(QStringLiteral("rosters_total"), QStringLiteral("Rosters generated or repaired."));
+        sample(QStringLiteral("rosters_total"), QString(), QString::number(rosters));
+        counter(QStringLiteral("roster_failures_total"),
+                QStringLiteral("Rosters that could not be generated or repaired."));
+        sample(QStringLiteral("roster_failures_total"), QString(), QString::number(failures));
+        counter(QStringLiteral("rosters_infeasible_total"),
+                QStringLiteral("Rosters rejected up front as infeasible."));
+        sample(QStringLiteral("rosters_infeasible_total"), QString(), QString::number(infeasible));
+        counter(QStringLiteral("rosters_cancelled_total"),
+                QStringLiteral("Rosters abandoned on being cancelled."));
+        sample(QStringLiteral("rosters_cancelled_total"), QString(), QString::number(cancelled));
+        counter(QStringLiteral("roster_seconds_total"),
+                QStringLiteral("Time spent generating or repairing rosters."));
+        sample(QStringLiteral("roster_seconds_total"), QString(), seconds(nanoseconds));
+
+        counter(QStringLiteral("scheduler_calls_total"),
+                QStringLiteral("Calls to the scheduler to choose or rank nurses."));
+        sample(QStringLiteral("scheduler_calls_total"), QString(), QString::number(schedulerCalls));
+        counter(QStringLiteral("scheduler_seconds_total"),
+                QStringLiteral("Time spent in the scheduler."));
+        sample(QStringLiteral("scheduler_seconds_total"), QString(),
+               seconds(schedulerNanoseconds));
+
+        counter(QStringLiteral("search_nodes_total"),
+                QStringLiteral("Shifts visited by the backtracking search."));
+        sample(QStringLiteral("search_nodes_total"), QString(), QString::number(searchNodes));
+        counter(QStringLiteral("searches_exhausted_total"),
+                QStringLiteral("Backtracking searches that reached their limits."));
+        sample(QStringLiteral("searches_exhausted_total"), QString(),
+               QString::number(searchesExhausted));
+        counter(QStringLiteral("search_backtracks_total"),
+                QStringLiteral("Backtracks by the search, by shift."));
+        for (auto iter = backtracks.constBegin(); iter != backtracks.constEnd(); ++iter) {
+            sample(QStringLiteral("search_backtracks_total"), label(QStringLiteral("shift"),
+                   iter.key()), QString::number(iter.value()));
+        }
+        counter(QStringLiteral("failed_shifts_total"),
+                QStringLiteral("Shifts that could not be filled, by shift."));
+        for (auto iter = failedShifts.constBegin(); iter != failedShifts.constEnd(); ++iter) {
+            sample(QStringLiteral("failed_shifts_total"), label(QStringLiteral("shift"),
+                   iter.key()), QString::number(iter.value()));
+        }
+
+        const struct {
+            const char *name;
+            const char *help;
+            qint64 ConstraintStats::*value;
+        } constraintCounters[] = {
+            { "constraint_calls_total", "Calls to each constraint.", &ConstraintStats::calls },
+            { "constraint_candidates_total", "Candidate nurses passed to each constraint.",
+              &ConstraintStats::candidates },
+            { "constraint_removed_total", "Candidate nurses removed by each constraint.",
+              &ConstraintStats::removed },
+            { "constraint_skipped_total", "Calls skipped, as the shift could not be filled.",
+              &ConstraintStats::skipped },
+            { "constraint_seconds_total", "Time spent in each constraint.",
+              &ConstraintStats::nanoseconds },
+        };
+        for (const auto &metric : constraintCounters) {
+            const QString name = QLatin1String(metric.name);
+            counter(name, QLatin1String(metric.help));
+            foreach (const ConstraintStats &stats, constraints) {
+                const qint64 value = stats.*metric.value;
+                sample(name, label(QStringLiteral("constraint"), stats.name),
+                       (metric.value == &ConstraintStats::nanoseconds)
+                           ? seconds(value) : QString::number(value));
+            }
+        }
+        return lines.join(QLatin1Char('\n')) + QLatin1Char('\n');
+    }
+
+protected:
+    /*!
+     * \brief Returns \a counts as a map of variants.
+     */
+    static QVariantMap toVariantMap(const QMap<QString, qint64> &counts)
+    {
+        QVariantMap map;
+        for (auto iter = counts.constBegin(); iter != counts.constEnd(); ++iter) {
+            map.insert(iter.key(), iter.value());
+        }
+        return map;
+    }
+
+    /*!
+     * \brief Returns \a nanoseconds as a number of seconds, in Prometheus text format.
+     */
+    static QString seconds(const qint64 nanoseconds)
+    {
+        return QString::number(nanoseconds / 1e9, 'g', 12);
+    }
+
+    /*!
+     * \brief Returns a Prometheus label set of \a name with \a value, escaped as required.
+     */
+    static QString label(const QString &name, QString value)
+    {
+        value.replace(QStringLiteral("\\"), QStringLiteral("\\\\"));
+        value.replace(QStringLiteral("\""), QStringLiteral("\\\""));
+        value.replace(QStringLiteral("\n"), QStringLiteral("\\n"));
+        return QStringLiteral("{%1=\"%2\"}").arg(name, value);
+    }
+
+};
+
+} // end Cogent namespace
+
+#endif // __GENERATOR_METRICS_H__
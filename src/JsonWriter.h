@@ -0,0 +1,375 @@
+#ifndef __JSON_WRITER_H__
+#define __JSON_WRITER_H__
+
+#include "NurseTable.h"
+#include "Roster.h"
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QJsonDocument>
+#include <QLocale>
+#include <QStringList>
+#include <QVariantHash>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace Cogent {
+
+/*!
+ * \brief Writes QVariant trees (such as generated rosters) as JSON, straight to a QIODevice.
+ *
+ * The output is byte-for-byte identical to QJsonDocument::fromVariant(value).toJson(format),
+ * but without building the intermediate QJsonDocument, or the complete QByteArray, both of which
+ * are as large as the roster itself. Instead, output is written to the device in chunks of at most
+ * a few kilobytes, so peak memory no longer grows with the length of the roster being written.
+ */
+class JsonWriter
+{
+
+public:
+    /*!
+     * \brief Constructs a writer that writes to \a device, which must already be open for writing,
+     * in the given \a format.
+     */
+    explicit JsonWriter(QIODevice * const device,
+                        const QJsonDocument::JsonFormat format = QJsonDocument::Indented)
+        : device(device), compact(format == QJsonDocument::Compact), failed(false)
+    {
+        buffer.reserve(bufferSize() + 1024);
+    }
+
+    /*!
+     * \brief Writes \a object as a complete JSON document.
+     *
+     * Returns \c true on success, or \c false if the device could not be written to.
+     */
+    bool write(const QVariantMap &object)
+    {
+        writeObject(object, 0);
+        return finish();
+    }
+
+    /*!
+     * \brief Writes \a array as a complete JSON document.
+     *
+     * Returns \c true on success, or \c false if the device could not be written to.
+     */
+    bool write(const QVariantList &array)
+    {
+        writeArray(array, 0);
+        return finish();
+    }
+
+    /*!
+     * \brief Writes a roster map, as returned by RosterGenerator::generate, as a complete JSON
+     * document, straight from the roster's \a days (with nurses named as per \a nurses), keyed by
+     * \a monthKey, along with the given \a metadata.
+     *
+     * The output is identical to that of write(QVariantMap) for the equivalent roster map, but
+     * without building that map; only one shift's nurse names are converted at a time.
+     *
+     * Returns \c true on success, or \c false if the device could not be written to.
+     */
+    bool write(const QString &monthKey, const Roster &days, const NurseTable &nurses,
+               const QVariantMap &metadata)
+    {
+        // Write the roster's days amongst the metadata, in key order, as per QVariantMap.
+        buffer.append(compact ? "{" : "{\n");
+        bool written = false;
+        int remaining = metadata.size() + (metadata.contains(monthKey) ? 0 : 1);
+        for (auto iter = metadata.constBegin(); iter != metadata.constEnd(); ++iter) {
+            if ((!written) && (monthKey <= iter.key())) {
+                writeRoster(monthKey, days, nurses, --remaining == 0);
+                written = true;
+            }
+            if (iter.key() != monthKey) {
+                writeMember(iter.key(), iter.value(), 1, --remaining == 0);
+            }
+        }
+        if (!written) {
+            writeRoster(monthKey, days, nurses, true);
+        }
+        endContainer('}', 0);
+        return finish();
+    }
+
+protected:
+    QIODevice * const device;
+    const bool compact;
+    QByteArray buffer; // Output not yet written to the device.
+    bool failed;       // Whether any write to the device has failed.
+
+    /*!
+     * \brief Returns the number of bytes to buffer before writing them to the device.
+     */
+    static int bufferSize()
+    {
+        return 16 * 1024;
+    }
+
+    /*!
+     * \brief Writes the buffered output to the device, if at least bufferSize() bytes (or if
+     * \a force, any bytes) are buffered.
+     */
+    void flush(const bool force = false)
+    {
+        if ((buffer.size() >= bufferSize()) || ((force) && (!buffer.isEmpty()))) {
+            failed |= (device->write(buffer) != buffer.size());
+            buffer.resize(0); // Note, this keeps the buffer's capacity.
+        }
+    }
+
+    /*!
+     * \brief Completes the current document, returning \c true if all output was written.
+     */
+    bool finish()
+    {
+        if (!compact) {
+            buffer.append('\n');
+        }
+        flush(true);
+        return !failed;
+    }
+
+    void writeIndent(const int indent)
+    {
+        buffer.append(QByteArray(4 * indent, ' '));
+    }
+
+    /*!
+     * \brief Writes \a value, nested \a indent levels deep, converting it as per
+     * QJsonValue::fromVariant.
+     */
+    void writeValue(const QVariant &value, const int indent)
+    {
+        switch (int(value.type())) {
+        case QVariant::Map:
+            writeObject(value.toMap(), indent);
+            break;
+        case QVariant::Hash:
+            writeObject(value.toHash(), indent);
+            break;
+        case QVariant::List:
+            writeArray(value.toList(), indent);
+            break;
+        case QVariant::StringList:
+            writeArray(value.toStringList(), indent);
+            break;
+        case QVariant::String:
+            writeString(value.toString());
+            break;
+        case QVariant::Bool:
+            buffer.append(value.toBool() ? "true" : "false");
+            break;
+        case QVariant::Int:
+        case QVariant::UInt:
+        case QVariant::LongLong:
+        case QVariant::ULongLong:
+        case QMetaType::Float:
+        case QVariant::Double:
+            writeNumber(value.toDouble());
+            break;
+        case QVariant::Invalid:
+            buffer.append("null");
+            break;
+        default: {
+            const QString string = value.toString();
+            if (string.isEmpty()) {
+                buffer.append("null");
+            } else {
+                writeString(string);
+            }
+        }
+        }
+    }
+
+    /*!
+     * \brief Writes \a object's members, in key order, nested \a indent levels deep.
+     */
+    void writeObject(const QVariantMap &object, const int indent)
+    {
+        buffer.append(compact ? "{" : "{\n");
+        int remaining = object.size();
+        for (auto iter = object.constBegin(); iter != object.constEnd(); ++iter) {
+            writeMember(iter.key(), iter.value(), indent + 1, --remaining == 0);
+        }
+        endContainer('}', indent);
+    }
+
+    /*!
+     * \brief Writes \a object's members, in key order (as per QJsonObject), nested \a indent levels
+     * deep.
+     */
+    void writeObject(const QVariantHash &object, const int indent)
+    {
+        QStringList keys = object.keys();
+        std::sort(keys.begin(), keys.end());
+        buffer.append(compact ? "{" : "{\n");
+        for (int index = 0; index < keys.size(); ++index) {
+            writeMember(keys.at(index), object.value(keys.at(index)), indent + 1,
+                        index + 1 == keys.size());
+        }
+        endContainer('}', indent);
+    }
+
+    void writeMember(const QString &key, const QVariant &value, const int indent, const bool last)
+    {
+        if (!compact) {
+            writeIndent(indent);
+        }
+        writeString(key);
+        buffer.append(compact ? ":" : ": ");
+        writeValue(value, indent);
+        endElement(last);
+    }
+
+    /*!
+     * \brief Writes \a days as the \a monthKey member of the top-level object, which may be the
+     * \a last member; see write(const QString &, const Roster &, const NurseTable &, ...).
+     */
+    void writeRoster(const QString &monthKey, const Roster &days, const NurseTable &nurses,
+                     const bool last)
+    {
+        // Shifts are written in name order, as per QVariantMap, rather than allocation order.
+        QVector<int> shifts(days.shiftCount());
+        std::iota(shifts.begin(), shifts.end(), 0);
+        std::sort(shifts.begin(), shifts.end(), [&days](const int lhs, const int rhs) {
+            return days.shiftName(lhs) < days.shiftName(rhs);
+        });
+
+        if (!compact) {
+            writeIndent(1);
+        }
+        writeString(monthKey);
+        buffer.append(compact ? ":[" : ": [\n");
+        QStringList shiftNurses;
+        for (int day = 0; day < days.size(); ++day) {
+            if (!compact) {
+                writeIndent(2);
+            }
+            buffer.append(compact ? "{" : "{\n");
+            for (int index = 0; index < shifts.size(); ++index) {
+                const int shift = shifts.at(index);
+                shiftNurses.clear();
+                for (int slot = 0; slot < days.count(day, shift); ++slot) {
+                    shiftNurses.append(nurses.name(days.at(day, shift, slot)));
+                }
+                if (!compact) {
+                    writeIndent(3);
+                }
+                writeString(days.shiftName(shift));
+                buffer.append(compact ? ":" : ": ");
+                writeArray(shiftNurses, 3);
+                endElement(index + 1 == shifts.size());
+            }
+            endContainer('}', 2);
+            endElement(day + 1 == days.size());
+        }
+        endContainer(']', 1);
+        endElement(last);
+    }
+
+    /*!
+     * \brief Writes \a array's elements nested \a indent levels deep.
+     */
+    template <typename List>
+    void writeArray(const List &array, const int indent)
+    {
+        buffer.append(compact ? "[" : "[\n");
+        for (int index = 0; index < array.size(); ++index) {
+            if (!compact) {
+                writeIndent(indent + 1);
+            }
+            writeValue(QVariant(array.at(index)), indent + 1);
+            endElement(index + 1 == array.size());
+        }
+        endContainer(']', indent);
+    }
+
+    /*!
+     * \brief Ends an array element or object member, which may be the \a last in its container,
+     * flushing the buffer if it is full.
+     */
+    void endElement(const bool last)
+    {
+        if (!last) {
+            buffer.append(',');
+        }
+        if (!compact) {
+            buffer.append('\n');
+        }
+        flush();
+    }
+
+    /*!
+     * \brief Closes an array or object (according to \a bracket) nested \a indent levels deep.
+     *
+     * Note, like QJsonDocument, an empty container's brackets are still on separate lines
+     * when indented.
+     */
+    void endContainer(const char bracket, const int indent)
+    {
+        if (!compact) {
+            writeIndent(indent);
+        }
+        buffer.append(bracket);
+    }
+
+    void writeNumber(const double number)
+    {
+        if (!std::isfinite(number)) {
+            buffer.append("null"); // As per RFC 4627 section 2.4.
+            return;
+        }
+        // Integers are written in full, as per QJsonDocument, if they fit in a quint64; note the
+        // range must be checked before converting, since converting any larger value is undefined.
+        const double magnitude = std::fabs(number);
+        const double supremum = 18446744073709551616.0; // 2^64, which is exactly representable.
+        const bool integral = (magnitude < supremum) &&
+            (magnitude == static_cast<double>(static_cast<quint64>(magnitude)));
+        buffer.append(QByteArray::number(number, integral ? 'f' : 'g',
+                                         QLocale::FloatingPointShortest));
+    }
+
+    /*!
+     * \brief Writes \a string as a quoted, escaped, UTF-8 JSON string.
+     */
+    void writeString(const QString &string)
+    {
+        static const char hexDigits[] = "0123456789abcdef";
+        const QByteArray utf8 = string.toUtf8();
+        buffer.append('"');
+        for (const char c : utf8) {
+            const uchar code = static_cast<uchar>(c);
+            if ((code >= 0x20) && (code != '"') && (code != '\\')) {
+                buffer.append(c); // Including all bytes of multi-byte characters.
+                continue;
+            }
+            buffer.append('\\');
+            switch (code) {
+            case '"':  buffer.append('"');  break;
+            case '\\': buffer.append('\\'); break;
+            case '\b': buffer.append('b');  break;
+            case '\f': buffer.append('f');  break;
+            case '\n': buffer.append('n');  break;
+            case '\r': buffer.append('r');  break;
+            case '\t': buffer.append('t');  break;
+            default:
+                buffer.append("u00");
+                buffer.append(hexDigits[code >> 4]);
+                buffer.append(hexDigits[code & 0xf]);
+            }
+        }
+        buffer.append('"');
+    }
+
+};
+
+} // end Cogent namespace
+
+#endif // __JSON_WRITER_H__
@@ -1,10 +1,13 @@
 #ifndef __LEAST_RECENT_SCHEDULER_H__
 #define __LEAST_RECENT_SCHEDULER_H__
 
+#include "Logging.h"
 #include "SchedulerInterface.h"
 
 #include <QDebug>
 
+#include <algorithm>
+
 namespace Cogent {
 
 /*!
@@ -14,6 +17,22 @@ class LeastRecentScheduler : public SchedulerInterface
 {
 
 public:
+    /*!
+     * \brief Constructs a scheduler that breaks ties according to \a seed.
+     *
+     * With the default \a seed of 0, ties between never-seen nurses are broken in ascending NurseId
+     * order, and nurses allocated by a single chooseNextNurses call are ranked in the order they
+     * were returned.
+     *
+     * Any other \a seed breaks ties between never-seen nurses in a pseudo-random (but repeatable)
+     * order. It also treats nurses allocated by a single chooseNextNurses call (ie the same shift)
+     * as equally recent, ranking them in a pseudo-random order too. Without the latter, a seed
+     * would merely relabel the nurses, so differently seeded schedulers would all produce
+     * equivalent rosters.
+     */
+    explicit LeastRecentScheduler(const quint64 seed = 0)
+        : seed(seed), batch(0), batchSize(0), oldestNurse(-1), newestNurse(-1), undoable(false)
+    { }
 
     /*!
      * \brief Returns the next nurse to fill a roster position given a list of \a availableNurses.
@@ -25,51 +44,329 @@ public:
      * doing so unnecessarily limits our ability to optimise the code to meet other businees needs
      * should they arise.
      *
-     * This implementation is O(n).
+     * This implementation keeps each nurse's last allocation time, plus a list of the seen nurses
+     * in order of those times, so rather than rebuilding sets or scanning the whole allocation
+     * history, it visits the least-recently allocated nurses in order, stopping at the first that
+     * is available. Moving the chosen nurse to the most recent end of that list is O(1) (or, if
+     * seeded, O(nurses already chosen for the same shift)), and allocates no memory, as the list is
+     * linked via vectors indexed by NurseId.
+     *
+     * So each call is O(k + n/64), where k is the number of unavailable nurses allocated less
+     * recently than the nurse chosen (each skipped with a single bit test), and n/64 is the cost of
+     * checking for never-seen nurses. Note, k is not otherwise bounded: in the worst case (such as
+     * when only the most recently allocated nurse is available) it is O(n). In practice though,
+     * the nurses least recently allocated are the ones the constraints are least likely to have
+     * excluded (having rested longest), so k is typically close to zero.
+     *
+     * A heap ordered by allocation time would not improve on this, as it too must visit each of
+     * the k skipped nurses (being ordered by time, not availability), at O(log n) apiece rather
+     * than a single bit test, and must also restore them afterwards.
      */
-    virtual QString chooseNextNurse(const QStringSet &availableNurses) override
+    virtual NurseId chooseNextNurse(const NurseSet &availableNurses) override
     {
         Q_ASSERT(!availableNurses.isEmpty()); // Must have at least one nurse available.
 
         // First check if there's any available nurses never seen before; if so, we are ffee to
-        // return any one of them.
-        const QStringSet unseenNurses =
-            QStringSet(availableNurses).subtract(QStringSet::fromList(allocationHistory));
-        if (!unseenNurses.isEmpty()) {
-            const QString nurse = *unseenNurses.constBegin();
-            qDebug() << "Chose previously-unseen nurse" << nurse;
-            allocationHistory.append(nurse);
-            return nurse;
-        }
-
-        // Since unseenNurses was empty (else we would have returned above), availableNurses is a
-        // subset of allocationHistory (ie allocationHistory wholy contains availableNurses).
-        Q_ASSERT(allocationHistory.toSet().contains(availableNurses));
-
-        // Further, since availableNurses is non-empty, an allocationHistory is a superset, then
-        // allocationHistory cannot now be empty.
-        Q_ASSERT(!allocationHistory.isEmpty());
-
-        // Return the first (oldest allocated) nurse from the allocation history that is also in the
-        // available nurses list. This is guaranteed to find, and thus return, a valid nurse, based
-        // on the above two assertions.
-        foreach (const QString &nurse, allocationHistory)
-        {
+        // return any one of them (bar the first in tie-break order, if seeded).
+        unseenNurses.assign(availableNurses).subtract(seenNurses);
+        NurseId unseenNurse = unseenNurses.first();
+        for (NurseId nurse = unseenNurse; (seed != 0) && (nurse >= 0);
+             nurse = unseenNurses.next(nurse)) {
+            if (tieBreakKey(nurse, 0) < tieBreakKey(unseenNurse, 0)) {
+                unseenNurse = nurse;
+            }
+        }
+        startBatch();
+        if (unseenNurse >= 0) {
+            qCDebug(lcScheduler) << "Chose previously-unseen nurse" << unseenNurse;
+            allocate(unseenNurse);
+            return unseenNurse;
+        }
+
+        // Since there were no unseen nurses (else we would have returned above), availableNurses is
+        // a subset of the seen nurses, all of which are in the allocation order list.
+        Q_ASSERT(oldestNurse >= 0);
+
+        // Return the first (oldest allocated) nurse that is also in the available nurses set. This
+        // is guaranteed to find, and thus return, a valid nurse, based on the assertion above.
+        for (NurseId nurse = oldestNurse; nurse >= 0; nurse = newerNurse.at(nurse)) {
             if (availableNurses.contains(nurse)) {
-                qDebug() << "Chose previously-seen nurse" << nurse;
-                const int removeCount = allocationHistory.removeAll(nurse);
-                Q_ASSERT(removeCount == 1); // We maintain unique nurse entries in the history.
-                allocationHistory.append(nurse);
+                qCDebug(lcScheduler) << "Chose previously-seen nurse" << nurse;
+                allocate(nurse);
                 return nurse;
             }
         }
 
         Q_ASSERT(false); // Arriving here should be impossible (see the assertions above).
-        return QString();
+        return -1;
+    }
+
+    /*!
+     * \brief Returns the next \a count nurses to fill roster positions given a set of
+     * \a availableNurses.
+     *
+     * This implementation ranks all \a count nurses in a single pass (see rank()), rather than
+     * restarting the search for every nurse chosen.
+     */
+    virtual QVector<NurseId> chooseNextNurses(const NurseSet &availableNurses, const int count) override
+    {
+        QVector<NurseId> nurses;
+        appendNextNurses(availableNurses, count, nurses);
+        return nurses;
+    }
+
+    virtual void appendNextNurses(const NurseSet &availableNurses, const int count,
+                                  QVector<NurseId> &nurses) override
+    {
+        const int firstChosen = nurses.size();
+        rank(availableNurses, count, nurses);
+
+        // Record the allocations, in the order chosen. This is deferred until now, since allocate()
+        // moves each nurse to the most recently allocated end of the list.
+        startBatch();
+        for (int index = firstChosen; index < nurses.size(); ++index) {
+            allocate(nurses.at(index));
+        }
+        qCDebug(lcScheduler) << "Chose" << nurses.size() - firstChosen << "of" << count << "nurses";
+    }
+
+    virtual QVector<NurseId> rankNurses(const NurseSet &availableNurses) const override
+    {
+        QVector<NurseId> nurses;
+        appendRankedNurses(availableNurses, nurses);
+        return nurses;
+    }
+
+    virtual void appendRankedNurses(const NurseSet &availableNurses,
+                                    QVector<NurseId> &nurses) const override
+    {
+        rank(availableNurses, availableNurses.count(), nurses);
+    }
+
+    virtual void onAssigned(const NurseId nurse) override
+    {
+        startBatch();
+        allocate(nurse);
+    }
+
+    /*!
+     * \brief Records \a nurses as allocated in a single batch, exactly as appendNextNurses does.
+     */
+    virtual void onShiftAssigned(const QVector<NurseId> &nurses) override
+    {
+        startBatch();
+        foreach (const NurseId nurse, nurses) {
+            allocate(nurse);
+        }
+    }
+
+    /*!
+     * \brief Breaks subsequent ties according to \a seed, as per the constructor, keeping every
+     * nurse's last allocation time.
+     */
+    virtual void setSeed(const quint64 seed) override
+    {
+        this->seed = seed;
+    }
+
+    virtual SchedulerInterface *clone() const override
+    {
+        return new LeastRecentScheduler(*this);
+    }
+
+    virtual void onUnassigned(const NurseId nurse) override
+    {
+        Q_ASSERT(undoable);
+        Q_ASSERT(!undoLog.isEmpty());
+        const UndoEntry entry = undoLog.takeLast();
+        Q_ASSERT(entry.nurse == nurse); // Undos must be in reverse order of allocations.
+        Q_UNUSED(nurse);
+        unlink(entry.nurse);
+        if (entry.wasSeen) {
+            // Every later allocation has been undone, so entry.olderNurse is back in place.
+            lastAllocated[entry.nurse] = entry.lastAllocated;
+            link(entry.nurse, entry.olderNurse);
+        } else {
+            seenNurses.remove(entry.nurse);
+        }
+    }
+
+    virtual void setUndoable(const bool undoable) override
+    {
+        this->undoable = undoable;
+        undoLog.resize(0); // Keeps its capacity, for the next search.
     }
 
 protected:
-    QStringList allocationHistory; // From oldest allocated, to most recent.
+    struct UndoEntry {
+        NurseId nurse;
+        bool wasSeen;
+        quint64 lastAllocated;
+        NurseId olderNurse; // The nurse allocated just before this one, if any.
+    };
+
+    quint64 seed;                   // Tie-breaking seed; 0 for NurseId (and allocation) order.
+    quint64 batch;                  // Incremented on every choice (of one or more nurses).
+    int batchSize;                  // Number of nurses allocated in the current batch.
+    QVector<quint64> lastAllocated; // Allocation time of each seen nurse, by NurseId.
+    QVector<NurseId> olderNurse;    // The next older allocated seen nurse, by NurseId, or -1.
+    QVector<NurseId> newerNurse;    // The next more recently allocated seen nurse, or -1.
+    NurseId oldestNurse;            // The least recently allocated seen nurse, or -1 if none.
+    NurseId newestNurse;            // The most recently allocated seen nurse, or -1 if none.
+    NurseSet seenNurses;            // All nurses ever allocated.
+    bool undoable;                  // Whether to log allocations in undoLog; see setUndoable.
+    QVector<UndoEntry> undoLog;     // Previous allocation state of each undoable allocation.
+    mutable NurseSet unseenNurses;  // Scratch set, reused by every choice and ranking.
+
+    /*!
+     * \brief Appends (up to) \a count of \a availableNurses to \a nurses, in the order they
+     * would be allocated.
+     *
+     * This makes a single pass over the never-seen nurses, and then (only if more nurses are still
+     * needed) a single pass over the least-recently allocated nurses, stopping once \a count are
+     * found; so as per chooseNextNurse, it costs O(count + k + n/64), for the k unavailable nurses
+     * skipped along the way.
+     */
+    void rank(const NurseSet &availableNurses, const int count, QVector<NurseId> &nurses) const
+    {
+        const int firstRanked = nurses.size();
+        const int end = firstRanked + count;
+        nurses.reserve(end);
+
+        // Take any never-seen nurses first, as per chooseNextNurse.
+        unseenNurses.assign(availableNurses).subtract(seenNurses);
+        if (seed == 0) {
+            for (NurseId nurse = unseenNurses.first(); (nurse >= 0) && (nurses.size() < end);
+                 nurse = unseenNurses.next(nurse)) {
+                nurses.append(nurse);
+            }
+        } else {
+            for (NurseId nurse = unseenNurses.first(); nurse >= 0;
+                 nurse = unseenNurses.next(nurse)) {
+                nurses.append(nurse);
+            }
+            std::sort(nurses.begin() + firstRanked, nurses.end(),
+                      [this](const NurseId a, const NurseId b) {
+                return tieBreakKey(a, 0) < tieBreakKey(b, 0);
+            });
+            nurses.resize(qMin(nurses.size(), end));
+        }
+
+        // Then the least-recently allocated nurses that are available.
+        for (NurseId nurse = oldestNurse; (nurse >= 0) && (nurses.size() < end);
+             nurse = newerNurse.at(nurse)) {
+            if (availableNurses.contains(nurse)) {
+                nurses.append(nurse);
+            }
+        }
+    }
+
+    /*!
+     * \brief Returns \a nurse's pseudo-random position among tied nurses, for this seed and
+     * \a salt (such as the batch number).
+     */
+    quint64 tieBreakKey(const NurseId nurse, const quint64 salt) const
+    {
+        return mix((seed ^ (salt << 32)) + (quint64(nurse) + 1) * Q_UINT64_C(0x9E3779B97F4A7C15));
+    }
+
+    /*!
+     * \brief Records \a nurse as the most recently allocated nurse.
+     */
+    void allocate(const NurseId nurse)
+    {
+        const bool wasSeen = seenNurses.contains(nurse);
+        if (undoable) {
+            undoLog.append(wasSeen
+                ? UndoEntry{ nurse, true, lastAllocated.at(nurse), olderNurse.at(nurse) }
+                : UndoEntry{ nurse, false, 0, -1 });
+        }
+        if (wasSeen) {
+            unlink(nurse);
+        } else {
+            seenNurses.insert(nurse);
+            if (nurse >= lastAllocated.size()) {
+                lastAllocated.resize(nurse+1);
+                olderNurse.resize(nurse+1);
+                newerNurse.resize(nurse+1);
+            }
+        }
+        const quint64 time = nextAllocationTime(nurse);
+        lastAllocated[nurse] = time;
+
+        // Each batch's times are later than all earlier batches', so the nurse goes at the newest
+        // end of the list, bar any nurses of the same batch with later times (if seeded).
+        NurseId older = newestNurse;
+        while ((older >= 0) && (lastAllocated.at(older) > time)) {
+            older = olderNurse.at(older);
+        }
+        link(nurse, older);
+    }
+
+    /*!
+     * \brief Inserts \a nurse into the allocation order list, straight after \a older (or at the
+     * oldest end, if \a older is -1).
+     */
+    void link(const NurseId nurse, const NurseId older)
+    {
+        const NurseId newer = (older < 0) ? oldestNurse : newerNurse.at(older);
+        olderNurse[nurse] = older;
+        newerNurse[nurse] = newer;
+        if (older < 0) {
+            oldestNurse = nurse;
+        } else {
+            newerNurse[older] = nurse;
+        }
+        if (newer < 0) {
+            newestNurse = nurse;
+        } else {
+            olderNurse[newer] = nurse;
+        }
+    }
+
+    /*!
+     * \brief Removes \a nurse from the allocation order list.
+     */
+    void unlink(const NurseId nurse)
+    {
+        const NurseId older = olderNurse.at(nurse);
+        const NurseId newer = newerNurse.at(nurse);
+        if (older < 0) {
+            oldestNurse = newer;
+        } else {
+            newerNurse[older] = newer;
+        }
+        if (newer < 0) {
+            newestNurse = older;
+        } else {
+            olderNurse[newer] = older;
+        }
+    }
+
+    /*!
+     * \brief Begins a new batch of allocations; see the constructor.
+     */
+    void startBatch()
+    {
+        ++batch;
+        batchSize = 0;
+    }
+
+    /*!
+     * \brief Returns a new, unique allocation time for \a nurse, later than all previous batches.
+     *
+     * The time's high 32 bits are the batch number, and its low 32 bits order the batch's nurses:
+     * in allocation order if unseeded, otherwise pseudo-randomly (with the batch index only there
+     * to keep times unique). So times keep increasing from batch to batch, even if reseeded.
+     */
+    quint64 nextAllocationTime(const NurseId nurse)
+    {
+        if (seed == 0) {
+            return (batch << 32) | quint64(quint32(batchSize++));
+        }
+        const quint64 order = (tieBreakKey(nurse, batch) & Q_UINT64_C(0xFFFF)) << 16;
+        return (batch << 32) | order | (quint64(batchSize++) & Q_UINT64_C(0xFFFF));
+    }
 
 };
 
@@ -0,0 +1,71 @@
+#ifndef __LOGGING_H__
+#define __LOGGING_H__
+
+#include <QLoggingCategory>
+
+namespace Cogent {
+
+/*!
+ * \file
+ * \brief Logging categories for roster generation.
+ *
+ * All debug (trace) output goes via qCDebug with one of these categories. Each category has its
+ * debug messages disabled by default, and qCDebug checks that before evaluating any of its
+ * arguments, so a disabled call site costs just a single flag check. Defining QT_NO_DEBUG_OUTPUT
+ * (as release builds do, unless qmake is run with CONFIG+=trace) removes the call sites entirely.
+ *
+ * Categories are enabled at runtime via QLoggingCategory::setFilterRules (see configureLogging in
+ * main.cpp), or the QT_LOGGING_RULES environment variable, such as "cogent.constraint.debug=true".
+ *
+ * Note, these are defined inline (rather than via Q_LOGGING_CATEGORY) since all of our code is
+ * header-only.
+ */
+
+/*!
+ * \brief Category for constraint decisions.
+ */
+inline const QLoggingCategory &lcConstraint()
+{
+    static const QLoggingCategory category("cogent.constraint", QtWarningMsg);
+    return category;
+}
+
+/*!
+ * \brief Category for roster generators (including batch and restart generators).
+ */
+inline const QLoggingCategory &lcGenerator()
+{
+    static const QLoggingCategory category("cogent.generator", QtWarningMsg);
+    return category;
+}
+
+/*!
+ * \brief Category for roster data handling (such as conversions and carried-in state).
+ */
+inline const QLoggingCategory &lcRoster()
+{
+    static const QLoggingCategory category("cogent.roster", QtWarningMsg);
+    return category;
+}
+
+/*!
+ * \brief Category for the roster server (see RosterServer).
+ */
+inline const QLoggingCategory &lcServer()
+{
+    static const QLoggingCategory category("cogent.server", QtWarningMsg);
+    return category;
+}
+
+/*!
+ * \brief Category for scheduler decisions.
+ */
+inline const QLoggingCategory &lcScheduler()
+{
+    static const QLoggingCategory category("cogent.scheduler", QtWarningMsg);
+    return category;
+}
+
+} // end Cogent namespace
+
+#endif // __LOGGING_H__
@@ -2,16 +2,20 @@
 #define __NO_SINGLE_DAYS_OFF_H__
 
 #include "ConstraintInterface.h"
+#include "Logging.h"
 
 #include <QDebug>
+#include <QPair>
+
+#include <limits>
 
 namespace Cogent {
 
 /*!
  * \brief Ensures that a nurse's days off occur in groups of two or more.
  *
- * Note, a nurse could still have just one day off a month bounday. This can be covered quite easily
- * if we supported loading previous-month data (ot least the last day).
+ * Days before the roster began are treated as days off, unless the previous month's state has been
+ * carried in (see CarryIn), in which case days off are grouped across the month boundary too.
  */
 class NoSingleDaysOff : public ConstraintInterface
 {
@@ -19,46 +23,128 @@ class NoSingleDaysOff : public ConstraintInterface
 public:
     /*!
      * \brief Removes from \a nurses any nurse that would fail this constraint if thery were to be
-     * included in \a shift of the day after \a daysSoFar.
+     * included in \a shift of the last day of \a daysSoFar.
      *
      * Returns the number of nurses removed, if any, otherwise 0.
      */
-    int constrain(QStringSet &nurses, const QString &shift, const QVariantList &daysSoFar) override
+    int constrain(NurseSet &nurses, const int shift, const Roster &daysSoFar) override
     {
-        Q_UNUSED(shift);
-
-        // If we don't have 1 day of history yet, then no need to exclude anyone.
-        if (daysSoFar.size() < 2) { // 2 because daysSoFar always include the current day too.
-            qDebug() << "removed 0 of" << nurses.size() << "nurses";
+        // Remove all nurses with yesterday off, but not two (or more) days off yet (they need to
+        // have today off to allow for their days off to be grouped in two or more days). That is,
+        // nurses whose last day worked was the day before yesterday.
+        const NurseSet * const mask = eligibleFor(shift, daysSoFar);
+        if (!mask) {
+            qCDebug(lcConstraint) << "removed 0 of" << nurses.count() << "nurses";
             return 0;
         }
+        const int originalCount = nurses.count();
+        const int removedCount = originalCount - nurses.intersect(*mask).count();
+        qCDebug(lcConstraint) << "removed" << removedCount << "of" << originalCount << "nurses";
+        return removedCount;
+    }
+
+    /*!
+     * \brief Returns the mask of nurses that would pass this constraint on \a shift of the last
+     * day of \a daysSoFar, or \c nullptr if every nurse would.
+     */
+    const NurseSet *eligibleFor(const int shift, const Roster &daysSoFar) const
+    {
+        Q_UNUSED(shift);
 
-        // Find which nurses had yesterday off.
-        QStringSet nursesWithYesterdayOff = nurses;
-        foreach (const QVariant &shift, daysSoFar.at(daysSoFar.size()-2).toMap()) {
-            foreach (const QVariant &nurse, shift.toList()) {
-                nursesWithYesterdayOff.remove(nurse.toString());
+        // If we don't have 2 days of history yet, then no need to exclude anyone (the days before
+        // the roster began are treated as days off, so a single day off cannot have occurred yet),
+        // unless history has been carried in from before the roster began.
+        // Note, 3 as daysSoFar include the current day.
+        return ((daysSoFar.size() < 3) && (!carriedIn)) ? nullptr : &eligible;
+    }
+
+    QString name() const override
+    {
+        return QStringLiteral("NoSingleDaysOff");
+    }
+
+    void reset(const int nurseCount) override
+    {
+        lastDayWorked.fill(std::numeric_limits<int>::min(), nurseCount); // ie never.
+        undoLog.clear();
+        undoLogSizes.clear();
+        eligible = NurseSet(nurseCount, true);
+        carriedIn = false;
+    }
+
+    void onCarryIn(const QVector<CarryIn::Streak> &streaks) override
+    {
+        // Carried-in days are numbered backwards from day -1, the last day before the roster.
+        for (NurseId nurse = 0; nurse < streaks.size(); ++nurse) {
+            if (streaks.at(nurse).daysWorked > 0) {
+                lastDayWorked[nurse] = -1;
+            } else if (streaks.at(nurse).daysOff > 0) {
+                lastDayWorked[nurse] = -1 - streaks.at(nurse).daysOff;
             }
         }
-        qDebug() << nursesWithYesterdayOff.size() << "of" << nurses.size() << "nurses had yesterday off";
-
-        // Find which nurses had (at least) two days off.
-        QStringSet nursesWithLastTwoDaysOff = nursesWithYesterdayOff;
-        if (daysSoFar.size() > 2) { // If we had two (or more) days of history.
-            foreach (const QVariant &shift, daysSoFar.at(daysSoFar.size()-3).toMap()) {
-                foreach (const QVariant &nurse, shift.toList()) {
-                    nursesWithLastTwoDaysOff.remove(nurse.toString());
+        carriedIn = true;
+        updateEligible(Roster(), -1);
+    }
+
+    void onDayCommitted(const Roster &roster, const int day) override
+    {
+        undoLogSizes.append(undoLog.size());
+        for (int shift = 0; shift < roster.shiftCount(); ++shift) {
+            for (int slot = 0; slot < roster.count(day, shift); ++slot) {
+                const NurseId nurse = roster.at(day, shift, slot);
+                if (lastDayWorked.at(nurse) != day) {
+                    undoLog.append(qMakePair(nurse, lastDayWorked.at(nurse)));
+                    lastDayWorked[nurse] = day;
                 }
             }
         }
-        qDebug() << nursesWithLastTwoDaysOff.size() << "of" << nurses.size() << "nurses had two days off";
+        updateEligible(roster, day);
+    }
 
-        // Remove all nurses with yesterday off, but not two (or more) days off yet (they need to
-        // have today off to allow for their days off to be grouped in two or more days).
-        const int originalSize = nurses.size();
-        nurses.subtract(nursesWithYesterdayOff - nursesWithLastTwoDaysOff);
-        qDebug() << "removed" << (originalSize-nurses.size()) << "of" << originalSize << "nurses";
-        return originalSize-nurses.size();
+    void onDayUncommitted(const Roster &roster, const int day) override
+    {
+        const int undoLogSize = undoLogSizes.takeLast();
+        while (undoLog.size() > undoLogSize) {
+            const QPair<NurseId, int> entry = undoLog.takeLast();
+            lastDayWorked[entry.first] = entry.second;
+        }
+        updateEligible(roster, day-1);
+    }
+
+protected:
+    QVector<int> lastDayWorked;             // Last committed day each nurse worked, by NurseId.
+    QVector<QPair<NurseId, int>> undoLog;   // Previous lastDayWorked values, for onDayUncommitted.
+    QVector<int> undoLogSizes;              // Size of undoLog before each committed day.
+    NurseSet eligible;                      // Nurses that did not have just yesterday off.
+    bool carriedIn;                         // Whether lastDayWorked includes carried-in days.
+
+    /*!
+     * \brief Rebuilds the eligible mask, given that \a yesterday is the last committed day of
+     * \a roster (or -1 if no days have been committed).
+     *
+     * Only nurses rostered on the day before \a yesterday can have had a single day off, so this
+     * need only visit that day's assignments. Before the roster began, only carried-in days count.
+     */
+    void updateEligible(const Roster &roster, const int yesterday)
+    {
+        eligible.fill(true);
+        const int dayBeforeYesterday = yesterday-1;
+        if (dayBeforeYesterday < 0) {
+            for (NurseId nurse = 0; (carriedIn) && (nurse < lastDayWorked.size()); ++nurse) {
+                if (lastDayWorked.at(nurse) == dayBeforeYesterday) {
+                    eligible.remove(nurse);
+                }
+            }
+            return;
+        }
+        for (int shift = 0; shift < roster.shiftCount(); ++shift) {
+            for (int slot = 0; slot < roster.count(dayBeforeYesterday, shift); ++slot) {
+                const NurseId nurse = roster.at(dayBeforeYesterday, shift, slot);
+                if (lastDayWorked.at(nurse) == dayBeforeYesterday) {
+                    eligible.remove(nurse);
+                }
+            }
+        }
     }
 
 };
@@ -0,0 +1,98 @@
+#ifndef __NURSE_LIST_READER_H__
+#define __NURSE_LIST_READER_H__
+
+#include "NurseTable.h"
+
+#include <QByteArray>
+#include <QFile>
+
+#include <cstring>
+
+namespace Cogent {
+
+/*!
+ * \brief Reads lists of nurse names, one per line, into a NurseTable.
+ *
+ * Regular files are memory-mapped (other devices, such as stdin, are read in a single call), then
+ * split into lines in place, with each line's name interned straight into the table, so nurses'
+ * identifiers follow their order in the file, and duplicates are detected in constant time.
+ *
+ * \note Names are assumed to be in the current system's local 8-bit encoding. Typically, this is
+ * UTF-8, but it not guaranteed.
+ */
+class NurseListReader
+{
+
+public:
+    /*!
+     * \brief Returns the nurses read from \a file, which must already be open for reading.
+     *
+     * Leading and trailing whitespace is trimmed from each name, and blank lines are skipped. If
+     * \a skipDups is \c true, repeated names are skipped too, otherwise they are made unique by
+     * appending a number, such as "Alice (7)".
+     */
+    static NurseTable read(QFile &file, const bool skipDups)
+    {
+        const qint64 size = file.size() - file.pos();
+        uchar * const mapped = (size > 0) ? file.map(file.pos(), size) : nullptr;
+        if (mapped != nullptr) {
+            const NurseTable nurses = read(reinterpret_cast<const char *>(mapped), size, skipDups);
+            file.unmap(mapped);
+            return nurses;
+        }
+        const QByteArray data = file.readAll();
+        return read(data.constData(), data.size(), skipDups);
+    }
+
+    /*!
+     * \brief Returns the nurses read from the \a size bytes of \a data, as per read(QFile&, bool).
+     */
+    static NurseTable read(const char * const data, const qint64 size, const bool skipDups)
+    {
+        NurseTable nurses;
+        const char * const end = data + size;
+        for (const char *line = data; line < end;) {
+            const char *lineEnd =
+                static_cast<const char *>(std::memchr(line, '\n', size_t(end - line)));
+            if (lineEnd == nullptr) {
+                lineEnd = end;
+            }
+            const char *begin = line, *last = lineEnd;
+            line = lineEnd + 1;
+
+            // Trim the name, as per QByteArray::trimmed, skipping blank lines.
+            while ((begin < last) && (isSpace(*begin))) {
+                ++begin;
+            }
+            while ((last > begin) && (isSpace(*(last - 1)))) {
+                --last;
+            }
+            if (begin == last) {
+                continue;
+            }
+
+            QString nurse = QString::fromLocal8Bit(begin, int(last - begin));
+            if (!skipDups) {
+                // If (while) we already have a nurse with this name, append the nurse's number to
+                // their name. Note, the use of 'while' instead of 'if' is rarely necessary, but it
+                // does guarantee uniqueness (in case another nurse's name ends in a number).
+                while (nurses.id(nurse) >= 0) {
+                    nurse += QStringLiteral(" (%1)").arg(nurses.size() + 1);
+                }
+            }
+            nurses.intern(nurse);
+        }
+        return nurses;
+    }
+
+protected:
+    static bool isSpace(const char c)
+    {
+        return (c == ' ') || ((c >= '\t') && (c <= '\r'));
+    }
+
+};
+
+} // end Cogent namespace
+
+#endif // __NURSE_LIST_READER_H__
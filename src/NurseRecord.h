@@ -0,0 +1,162 @@
+#ifndef __NURSE_RECORD_H__
+#define __NURSE_RECORD_H__
+
+#include "Logging.h"
+
+#include <QByteArray>
+#include <QDate>
+#include <QDebug>
+#include <QJsonDocument>
+#include <QPair>
+#include <QSet>
+#include <QStringList>
+#include <QVariantMap>
+#include <QVector>
+
+#include <limits>
+
+namespace Cogent {
+
+/*!
+ * \brief A nurse's availability for rostering: leave, part-time cap, skills, and shifts.
+ *
+ * Nurse records are read from a JSON file holding an array of objects, one per nurse, such as:
+ *
+ *     [
+ *       { "name": "Alice", "leave": [ "2018-06-04", { "from": "2018-06-18", "to": "2018-06-22" } ],
+ *         "maxShifts": 12, "skills": [ "icu" ], "shifts": [ "morning", "evening" ] },
+ *       { "name": "Bob" }
+ *     ]
+ *
+ * All but the "name" are optional: "leave" lists dates (or inclusive ranges of dates) on which
+ * the nurse cannot work; "maxShifts" caps the number of shifts the nurse works per month (such as
+ * for part-time staff); "skills" lists the nurse's skills, as may be required by shifts (see
+ * RosterGenerator::setShiftSkills); and "shifts" lists the only shifts the nurse can be rostered
+ * on (by default, any).
+ *
+ * Records are applied by RosterGenerator (see setNurseRecords), which turns them into per-day,
+ * per-shift masks of available nurses once per month, before rostering begins.
+ */
+struct NurseRecord {
+    QString name;
+    QVector<QPair<QDate, QDate>> leave; // Inclusive ranges of dates the nurse is on leave.
+    int maxShifts;                      // Maximum shifts per month, or -1 for no limit.
+    QSet<QString> skills;
+    QSet<QString> shifts;               // Shifts the nurse can work, or empty for any.
+
+    /*!
+     * \brief Constructs a record for the nurse called \a name, who is always available.
+     */
+    explicit NurseRecord(const QString &name = QString()) : name(name), maxShifts(-1) { }
+
+    /*!
+     * \brief Returns \c true if this nurse is on leave on \a date; \c false otherwise.
+     */
+    bool isOnLeave(const QDate &date) const
+    {
+        for (auto iter = leave.constBegin(); iter != leave.constEnd(); ++iter) {
+            if ((iter->first <= date) && (date <= iter->second)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*!
+     * \brief Returns \c true if this nurse can work the shift named \a shift, and has all of the
+     * \a requiredSkills; \c false otherwise.
+     */
+    bool canWork(const QString &shift, const QSet<QString> &requiredSkills = QSet<QString>()) const
+    {
+        return ((shifts.isEmpty()) || (shifts.contains(shift))) &&
+               (skills.contains(requiredSkills));
+    }
+
+    /*!
+     * \brief Returns \a value as a non-negative int, or -1 if it is not a whole number in range.
+     *
+     * The range is checked before converting, since converting an out-of-range double (such as
+     * 1e20, from a hand-edited file) to int is undefined. Rules files are parsed with this too.
+     */
+    static int nonNegativeInt(const QVariant &value)
+    {
+        bool ok = false;
+        const double number = value.toDouble(&ok);
+        if ((!ok) || (!(number >= 0.0)) || (number > double(std::numeric_limits<int>::max()))) {
+            return -1;
+        }
+        return (number == double(int(number))) ? int(number) : -1;
+    }
+
+    /*!
+     * \brief Returns the records in the JSON nurse records file content \a json, in file order.
+     *
+     * If \a json is not a valid nurse records file, returns an empty list, and (if not \c nullptr)
+     * sets \a ok to \c false.
+     */
+    static QVector<NurseRecord> fromJson(const QByteArray &json, bool * const ok = nullptr)
+    {
+        QJsonParseError error;
+        const QJsonDocument document = QJsonDocument::fromJson(json, &error);
+        if (ok) {
+            *ok = false;
+        }
+        if (!document.isArray()) {
+            qCWarning(lcGenerator) << "failed to parse nurse records" << error.errorString();
+            return QVector<NurseRecord>();
+        }
+
+        const auto date = [](const QVariantMap &map, const QString &key) {
+            return QDate::fromString(map.value(key).toString(), Qt::ISODate);
+        };
+        QVector<NurseRecord> records;
+        QSet<QString> names;
+        foreach (const QVariant &item, document.toVariant().toList()) {
+            const QVariantMap map = item.toMap();
+            NurseRecord record(map.value(QStringLiteral("name")).toString().trimmed());
+            if ((record.name.isEmpty()) || (names.contains(record.name))) {
+                qCWarning(lcGenerator) << "invalid nurse name" << item;
+                return QVector<NurseRecord>();
+            }
+            names.insert(record.name);
+
+            foreach (const QVariant &leave, map.value(QStringLiteral("leave")).toList()) {
+                const QPair<QDate, QDate> range = (leave.type() == QVariant::Map)
+                    ? qMakePair(date(leave.toMap(), QStringLiteral("from")),
+                                date(leave.toMap(), QStringLiteral("to")))
+                    : qMakePair(QDate::fromString(leave.toString(), Qt::ISODate),
+                                QDate::fromString(leave.toString(), Qt::ISODate));
+                if ((!range.first.isValid()) || (!range.second.isValid()) ||
+                    (range.first > range.second)) {
+                    qCWarning(lcGenerator) << "invalid leave for" << record.name << leave;
+                    return QVector<NurseRecord>();
+                }
+                record.leave.append(range);
+            }
+
+            if (map.contains(QStringLiteral("maxShifts"))) {
+                record.maxShifts = nonNegativeInt(map.value(QStringLiteral("maxShifts")));
+                if (record.maxShifts < 0) {
+                    qCWarning(lcGenerator) << "invalid maxShifts for" << record.name;
+                    return QVector<NurseRecord>();
+                }
+            }
+
+            foreach (const QString &skill, map.value(QStringLiteral("skills")).toStringList()) {
+                record.skills.insert(skill);
+            }
+            foreach (const QString &shift, map.value(QStringLiteral("shifts")).toStringList()) {
+                record.shifts.insert(shift);
+            }
+            records.append(record);
+        }
+        if (ok) {
+            *ok = true;
+        }
+        return records;
+    }
+};
+
+} // end Cogent namespace
+
+#endif // __NURSE_RECORD_H__
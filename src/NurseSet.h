@@ -0,0 +1,346 @@
+#ifndef __NURSE_SET_H__
+#define __NURSE_SET_H__
+
+#include "NurseTable.h"
+
+#include <QtAlgorithms>
+#include <QVector>
+
+#include <algorithm>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace Cogent {
+
+/*!
+ * \brief Set of NurseId values, stored as a bitset with one bit per nurse.
+ *
+ * Since NurseId values are dense, a set of nurses fits in capacity()/64 machine words, so copying
+ * a set, and intersecting or subtracting two sets, costs a few dozen word operations even for
+ * thousands of nurses, rather than thousands of hash operations. Where the compiler targets AVX2
+ * (eg via -mavx2 or -march=native), intersect() and subtract() process four words at a time.
+ *
+ * Constraints use this to publish masks of eligible nurses, which the roster generator then
+ * simply ANDs together.
+ */
+class NurseSet
+{
+
+public:
+    NurseSet() : bitCount(0) { }
+
+    /*!
+     * \brief Constructs a set with room for nurses [0, \a capacity), containing either all of those
+     * nurses (if \a filled is \c true), or none of them.
+     */
+    explicit NurseSet(const int capacity, const bool filled = false)
+        : bitCount(0)
+    {
+        resize(capacity);
+        fill(filled);
+    }
+
+    /*!
+     * \brief Returns the number of nurses this set can hold without growing.
+     */
+    int capacity() const
+    {
+        return bitCount;
+    }
+
+    /*!
+     * \brief Returns the number of nurses in this set.
+     *
+     * This is O(capacity/64).
+     */
+    int count() const
+    {
+        int total = 0;
+        foreach (const quint64 word, words) {
+            total += qPopulationCount(word);
+        }
+        return total;
+    }
+
+    /*!
+     * \brief Returns \c true if this set contains no nurses; \c false otherwise.
+     */
+    bool isEmpty() const
+    {
+        foreach (const quint64 word, words) {
+            if (word) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*!
+     * \brief Returns \c true if this set contains \a nurse; \c false otherwise.
+     */
+    bool contains(const NurseId nurse) const
+    {
+        return (nurse >= 0) && (nurse < bitCount) && (words.at(nurse/64) & bit(nurse));
+    }
+
+    /*!
+     * \brief Adds \a nurse to this set, growing the set's capacity if necessary.
+     */
+    void insert(const NurseId nurse)
+    {
+        Q_ASSERT(nurse >= 0);
+        if (nurse >= bitCount) {
+            resize(nurse+1);
+        }
+        words[nurse/64] |= bit(nurse);
+    }
+
+    /*!
+     * \brief Removes \a nurse from this set.
+     *
+     * Returns \c true if \a nurse was in this set, otherwise \c false.
+     */
+    bool remove(const NurseId nurse)
+    {
+        if (!contains(nurse)) {
+            return false;
+        }
+        words[nurse/64] &= ~bit(nurse);
+        return true;
+    }
+
+    /*!
+     * \brief Sets this set to contain either every nurse within its capacity (if \a filled is
+     * \c true), or no nurses.
+     */
+    void fill(const bool filled)
+    {
+        words.fill(filled ? ~Q_UINT64_C(0) : Q_UINT64_C(0));
+        clearUnusedBits();
+    }
+
+    /*!
+     * \brief Returns the lowest nurse in this set, or -1 if this set is empty.
+     */
+    NurseId first() const
+    {
+        return next(-1);
+    }
+
+    /*!
+     * \brief Returns the lowest nurse in this set that is greater than \a nurse, or -1 if there is
+     * no such nurse.
+     *
+     * Together with first(), this allows iteration in ascending order:
+     *
+     *     for (NurseId nurse = set.first(); nurse >= 0; nurse = set.next(nurse)) { ... }
+     */
+    NurseId next(const NurseId nurse) const
+    {
+        const int from = nurse + 1;
+        if (from >= bitCount) {
+            return -1;
+        }
+        int index = from / 64;
+        quint64 word = words.at(index) & (~Q_UINT64_C(0) << (from % 64));
+        while (!word) {
+            if (++index >= words.size()) {
+                return -1;
+            }
+            word = words.at(index);
+        }
+        return index * 64 + int(qCountTrailingZeroBits(word));
+    }
+
+    /*!
+     * \brief Makes this set a copy of \a other, with \a other's capacity.
+     *
+     * Unlike assignment (which shares \a other's words until either set is modified), this copies
+     * \a other's words into this set's own, so once this set has grown to \a other's capacity,
+     * reusing it as a scratch copy costs no heap allocations.
+     *
+     * Returns a reference to this set.
+     */
+    NurseSet &assign(const NurseSet &other)
+    {
+        bitCount = other.bitCount;
+        words.resize(other.words.size());
+        std::copy(other.words.constBegin(), other.words.constEnd(), words.begin());
+        return *this;
+    }
+
+    /*!
+     * \brief Adds to this set all nurses in \a other, growing this set's capacity if necessary.
+     *
+     * Returns a reference to this set.
+     */
+    NurseSet &unite(const NurseSet &other)
+    {
+        if (other.bitCount > bitCount) {
+            resize(other.bitCount);
+        }
+        for (int index = 0; index < other.words.size(); ++index) {
+            words[index] |= other.words.at(index);
+        }
+        return *this;
+    }
+
+    /*!
+     * \brief Removes from this set all nurses not in \a other.
+     *
+     * Returns a reference to this set.
+     */
+    NurseSet &intersect(const NurseSet &other)
+    {
+        const int common = qMin(words.size(), other.words.size());
+        andWords(words.data(), other.words.constData(), common);
+        for (int index = common; index < words.size(); ++index) {
+            words[index] = 0; // Beyond other's capacity, so not in other.
+        }
+        return *this;
+    }
+
+    /*!
+     * \brief Removes from this set all nurses not in every one of the \a count sets \a others.
+     *
+     * This is equivalent to intersecting with each of \a others in turn, but makes a single pass
+     * over this set's words, rather than one per set.
+     *
+     * Returns a reference to this set.
+     */
+    NurseSet &intersect(const NurseSet * const * const others, const int count)
+    {
+        quint64 * const data = words.data();
+        for (int index = 0; index < words.size(); ++index) {
+            quint64 word = data[index];
+            for (int other = 0; (word) && (other < count); ++other) {
+                word &= (index < others[other]->words.size()) ? others[other]->words.at(index) : 0;
+            }
+            data[index] = word;
+        }
+        return *this;
+    }
+
+    /*!
+     * \brief Removes from this set all nurses in \a other.
+     *
+     * Returns a reference to this set.
+     */
+    NurseSet &subtract(const NurseSet &other)
+    {
+        andNotWords(words.data(), other.words.constData(), qMin(words.size(), other.words.size()));
+        return *this;
+    }
+
+    /*!
+     * \brief Returns the nurses in this set, in ascending order.
+     */
+    QVector<NurseId> toVector() const
+    {
+        QVector<NurseId> nurses;
+        nurses.reserve(count());
+        for (NurseId nurse = first(); nurse >= 0; nurse = next(nurse)) {
+            nurses.append(nurse);
+        }
+        return nurses;
+    }
+
+    /*!
+     * \brief Returns \c true if this set contains exactly the same nurses as \a other, regardless
+     * of the capacity of either set; \c false otherwise.
+     */
+    bool operator==(const NurseSet &other) const
+    {
+        const int common = qMin(words.size(), other.words.size());
+        for (int index = 0; index < common; ++index) {
+            if (words.at(index) != other.words.at(index)) {
+                return false;
+            }
+        }
+        const QVector<quint64> &longer = (words.size() > common) ? words : other.words;
+        for (int index = common; index < longer.size(); ++index) {
+            if (longer.at(index)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool operator!=(const NurseSet &other) const
+    {
+        return !(*this == other);
+    }
+
+protected:
+    int bitCount;           // Capacity, in bits (ie nurses).
+    QVector<quint64> words; // Bit (nurse % 64) of word (nurse / 64) is set if nurse is in the set.
+
+    static quint64 bit(const NurseId nurse)
+    {
+        return Q_UINT64_C(1) << (nurse % 64);
+    }
+
+    /*!
+     * \brief Sets the capacity of this set to \a capacity, adding no nurses.
+     */
+    void resize(const int capacity)
+    {
+        bitCount = capacity;
+        words.resize((capacity + 63) / 64); // Any new words are zero-initialised.
+        clearUnusedBits();
+    }
+
+    /*!
+     * \brief Clears any bits in the last word beyond capacity(), so that count() and isEmpty()
+     * need not mask them out.
+     */
+    void clearUnusedBits()
+    {
+        if (bitCount % 64) {
+            words.last() &= ~(~Q_UINT64_C(0) << (bitCount % 64));
+        }
+    }
+
+    /*!
+     * \brief Computes \a dst[i] &= \a src[i] for each i in [0, \a count).
+     */
+    static void andWords(quint64 * const dst, const quint64 * const src, const int count)
+    {
+        int index = 0;
+#ifdef __AVX2__
+        for (; index + 4 <= count; index += 4) {
+            __m256i * const d = reinterpret_cast<__m256i *>(dst + index);
+            const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + index));
+            _mm256_storeu_si256(d, _mm256_and_si256(_mm256_loadu_si256(d), s));
+        }
+#endif
+        for (; index < count; ++index) {
+            dst[index] &= src[index];
+        }
+    }
+
+    /*!
+     * \brief Computes \a dst[i] &= ~\a src[i] for each i in [0, \a count).
+     */
+    static void andNotWords(quint64 * const dst, const quint64 * const src, const int count)
+    {
+        int index = 0;
+#ifdef __AVX2__
+        for (; index + 4 <= count; index += 4) {
+            __m256i * const d = reinterpret_cast<__m256i *>(dst + index);
+            const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + index));
+            _mm256_storeu_si256(d, _mm256_andnot_si256(s, _mm256_loadu_si256(d)));
+        }
+#endif
+        for (; index < count; ++index) {
+            dst[index] &= ~src[index];
+        }
+    }
+
+};
+
+} // end Cogent namespace
+
+#endif // __NURSE_SET_H__
@@ -0,0 +1,98 @@
+#ifndef __NURSE_TABLE_H__
+#define __NURSE_TABLE_H__
+
+#include <QHash>
+#include <QStringList>
+
+namespace Cogent {
+
+/*!
+ * \brief Dense integer identifier for a nurse, as assigned by NurseTable.
+ *
+ * Valid identifiers are in the range [0, NurseTable::size()). A negative value (typically -1)
+ * indicates "no nurse".
+ */
+typedef int NurseId;
+
+/*!
+ * \brief Interns nurse names to dense, zero-based integer identifiers.
+ *
+ * The roster generator, constraints and schedulers all work with NurseId values rather than
+ * names, so that the hot path never has to hash or compare strings. Names are only consulted
+ * again when converting a finished roster back to its JSON-compatible form.
+ */
+class NurseTable
+{
+
+public:
+    NurseTable() { }
+
+    /*!
+     * \brief Constructs a table containing each of \a nurses, in order.
+     */
+    explicit NurseTable(const QStringList &nurses)
+    {
+        ids.reserve(nurses.size());
+        foreach (const QString &nurse, nurses) {
+            intern(nurse);
+        }
+    }
+
+    /*!
+     * \brief Returns the identifier for \a nurse, adding \a nurse to this table if not already
+     * present.
+     */
+    NurseId intern(const QString &nurse)
+    {
+        const auto iter = ids.constFind(nurse);
+        if (iter != ids.constEnd()) {
+            return iter.value();
+        }
+        const NurseId id = names.size();
+        ids.insert(nurse, id);
+        names.append(nurse);
+        return id;
+    }
+
+    /*!
+     * \brief Returns the identifier for \a nurse, or -1 if \a nurse is not in this table.
+     */
+    NurseId id(const QString &nurse) const
+    {
+        return ids.value(nurse, -1);
+    }
+
+    /*!
+     * \brief Returns the name of the nurse identified by \a id, or a null string if \a id is not
+     * valid for this table.
+     */
+    QString name(const NurseId id) const
+    {
+        return ((id >= 0) && (id < names.size())) ? names.at(id) : QString();
+    }
+
+    /*!
+     * \brief Returns the names of all nurses in this table, indexed by NurseId.
+     */
+    QStringList toStringList() const
+    {
+        return names;
+    }
+
+    /*!
+     * \brief Returns the number of nurses in this table.
+     */
+    int size() const
+    {
+        return names.size();
+    }
+
+protected:
+    QHash<QString, NurseId> ids;
+    QStringList names; // Indexed by NurseId.
+
+};
+
+} // end Cogent namespace
+
+#endif // __NURSE_TABLE_H__
@@ -0,0 +1,267 @@
+#ifndef __RESTART_GENERATOR_H__
+#define __RESTART_GENERATOR_H__
+
+#include "LeastRecentScheduler.h"
+#include "Logging.h"
+#include "RosterGenerator.h"
+
+#include <QAtomicInt>
+#include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include <QtMath>
+
+#include <functional>
+
+namespace Cogent {
+
+/*!
+ * \brief Generates a roster via several differently-seeded passes, run in parallel.
+ *
+ * Each pass uses its own RosterGenerator, with a copy of its configured scheduler (a
+ * LeastRecentScheduler by default) seeded by the pass number (see SchedulerInterface::setSeed), so
+ * each pass breaks ties differently, and thus may succeed where others fail (such as when the
+ * nurse pool is tight). Pass 0 is unseeded, so produces the same roster as a plain RosterGenerator.
+ *
+ * Without an objective, the roster of the lowest numbered successful pass wins, so the result is
+ * repeatable; once a pass succeeds, all higher numbered passes are cancelled, but lower numbered
+ * passes run to completion. With an objective (see setObjective), all passes run to completion,
+ * and the roster with the lowest objective value wins (ties going to the lowest pass number).
+ */
+class RestartGenerator
+{
+
+public:
+    /*!
+     * \brief Function returning a score for a generated \a roster of the given \a nurses; lower
+     * scores are better.
+     */
+    typedef std::function<double(const QVariantMap &roster, const QStringList &nurses)> Objective;
+
+    /*!
+     * \brief Constructs a generator that runs \a passes passes, applying \a configure to each
+     * pass's RosterGenerator, and generating rosters with \a nursesPerShift nurses per shift.
+     */
+    explicit RestartGenerator(
+        const RosterGenerator::Configurator &configure = RosterGenerator::Configurator(),
+        const int passes = QThread::idealThreadCount(), const int nursesPerShift = 5)
+        : configure(configure), passes(passes), nursesPerShift(nursesPerShift),
+          maxThreads(QThread::idealThreadCount())
+    { }
+
+    /*!
+     * \brief Sets the maximum number of passes to run concurrently.
+     *
+     * The default is QThread::idealThreadCount().
+     */
+    void setMaxThreadCount(const int maxThreads)
+    {
+        this->maxThreads = maxThreads;
+    }
+
+    /*!
+     * \brief Sets the \a objective used to choose between rosters; see shiftCountDeviation for
+     * example. Pass an empty function to take the first roster found instead (the default).
+     */
+    void setObjective(const Objective &objective)
+    {
+        this->objective = objective;
+    }
+
+    /*!
+     * \brief Returns the best roster found for \a nurses in the given \a month of \a year, or an
+     * empty map if no pass could generate a roster.
+     *
+     * Each pass continues on from \a carryIn, as per RosterGenerator::generate.
+     *
+     * This function blocks until all passes have completed (or been cancelled). The passes'
+     * generator metrics are added to this generator's; see metrics().
+     */
+    QVariantMap generate(const int year, const int month, const QStringList &nurses,
+                         const CarryIn &carryIn = CarryIn())
+    {
+        Result best{ -1, 0.0, QVariantMap() };
+        QVector<QAtomicInt> cancelled(passes); // Per pass, all initially zero.
+        QMutex mutex;
+        QThreadPool pool;
+        pool.setMaxThreadCount(maxThreads);
+        for (int pass = 0; pass < passes; ++pass) {
+            const Pass inputs{ pass, year, month, nurses, carryIn };
+            pool.start(new PassRunnable(*this, inputs, best, totals, cancelled, mutex));
+        }
+        pool.waitForDone();
+        if (best.pass < 0) {
+            qCWarning(lcGenerator) << "none of" << passes << "passes generated a roster";
+        } else {
+            qCDebug(lcGenerator) << "chose roster from pass" << best.pass << "with score"
+                                 << best.score;
+        }
+        return best.roster;
+    }
+
+    /*!
+     * \brief Returns the combined metrics of every pass run by generate() so far.
+     */
+    GeneratorMetrics metrics() const
+    {
+        return totals;
+    }
+
+    /*!
+     * \brief Returns the standard deviation of the number of shifts per nurse in \a roster, over
+     * all \a nurses (including any not rostered at all).
+     *
+     * Using this as an objective favours rosters that share the shifts most evenly between nurses.
+     */
+    static double shiftCountDeviation(const QVariantMap &roster, const QStringList &nurses)
+    {
+        if (nurses.isEmpty()) {
+            return 0.0;
+        }
+
+        // Count the shifts per nurse, across all months (ie lists) in the roster.
+        QHash<QString, int> shiftCounts;
+        foreach (const QString &nurse, nurses) {
+            shiftCounts.insert(nurse, 0);
+        }
+        foreach (const QVariant &month, roster) {
+            foreach (const QVariant &day, month.toList()) {
+                foreach (const QVariant &shift, day.toMap()) {
+                    foreach (const QString &nurse, shift.toStringList()) {
+                        shiftCounts[nurse]++;
+                    }
+                }
+            }
+        }
+
+        double sum = 0.0, sumOfSquares = 0.0;
+        foreach (const int count, shiftCounts) {
+            sum += count;
+            sumOfSquares += double(count) * count;
+        }
+        const double mean = sum / shiftCounts.size();
+        return qSqrt(qMax(0.0, sumOfSquares / shiftCounts.size() - mean * mean));
+    }
+
+protected:
+    const RosterGenerator::Configurator configure;
+    const int passes;
+    const int nursesPerShift;
+    int maxThreads;
+    Objective objective;
+    GeneratorMetrics totals;
+
+    /*!
+     * \brief A single pass's inputs.
+     */
+    struct Pass {
+        int pass;
+        int year;
+        int month;
+        QStringList nurses;
+        CarryIn carryIn;
+    };
+
+    /*!
+     * \brief The best roster found so far, and which pass found it.
+     */
+    struct Result {
+        int pass;          // -1 if no roster has been found yet.
+        double score;      // Objective value, if there is an objective.
+        QVariantMap roster;
+    };
+
+    /*!
+     * \brief Runs a single pass, records its roster if it is the best so far, and adds its metrics
+     * to \a metrics.
+     *
+     * Without an objective, a successful pass sets the \a cancelled flags of all higher numbered
+     * passes. This is thread-safe, so may be called concurrently for different passes.
+     */
+    void run(const Pass &pass, Result &best, GeneratorMetrics &metrics,
+             QVector<QAtomicInt> &cancelled, QMutex &mutex) const
+    {
+        RosterGenerator generator(nursesPerShift);
+        if (configure) {
+            configure(generator);
+        }
+        SchedulerInterface *scheduler = generator.cloneScheduler();
+        if (scheduler == nullptr) {
+            qCWarning(lcGenerator) << "cannot copy the configured scheduler; pass" << pass.pass
+                                   << "using a least-recent scheduler instead";
+            scheduler = new LeastRecentScheduler;
+        }
+        scheduler->setSeed(pass.pass);
+        generator.setScheduler(scheduler);
+        if (!objective) {
+            generator.setCancelFlag(&cancelled[pass.pass]);
+        }
+
+        const QVariantMap roster =
+            generator.generate(pass.year, pass.month, pass.nurses, pass.carryIn);
+        if (roster.isEmpty()) {
+            // Note, the generator counts passes cut short by another's roster as cancelled.
+            if (cancelled.at(pass.pass).loadAcquire() != 0) {
+                qCDebug(lcGenerator) << "pass" << pass.pass << "cancelled";
+            } else {
+                qCDebug(lcGenerator) << "pass" << pass.pass << "did not generate a roster";
+            }
+            QMutexLocker locker(&mutex);
+            metrics.merge(generator.metrics());
+            return;
+        }
+        const double score = (objective) ? objective(roster, pass.nurses) : 0.0;
+        qCDebug(lcGenerator) << "pass" << pass.pass << "generated a roster with score" << score;
+
+        QMutexLocker locker(&mutex);
+        metrics.merge(generator.metrics());
+        if ((best.pass < 0) || (score < best.score) ||
+            ((score == best.score) && (pass.pass < best.pass))) {
+            best = Result{ pass.pass, score, roster };
+        }
+        if (!objective) {
+            // Only a lower numbered pass can beat this one, so the higher ones needn't continue.
+            for (int later = pass.pass + 1; later < cancelled.size(); ++later) {
+                cancelled[later].storeRelease(1);
+            }
+        }
+    }
+
+    /*!
+     * \brief Runs a single pass on a thread pool.
+     */
+    class PassRunnable : public QRunnable
+    {
+
+    public:
+        PassRunnable(const RestartGenerator &generator, const Pass &pass, Result &best,
+                     GeneratorMetrics &metrics, QVector<QAtomicInt> &cancelled, QMutex &mutex)
+            : generator(generator), pass(pass), best(best), metrics(metrics),
+              cancelled(cancelled), mutex(mutex)
+        { }
+
+        void run() override
+        {
+            generator.run(pass, best, metrics, cancelled, mutex);
+        }
+
+    protected:
+        const RestartGenerator &generator;
+        const Pass pass;
+        Result &best;
+        GeneratorMetrics &metrics;
+        QVector<QAtomicInt> &cancelled;
+        QMutex &mutex;
+
+    };
+
+};
+
+} // end Cogent namespace
+
+#endif // __RESTART_GENERATOR_H__
@@ -0,0 +1,321 @@
+#ifndef __ROSTER_H__
+#define __ROSTER_H__
+
+#include "Logging.h"
+#include "NurseTable.h"
+
+#include <QDebug>
+#include <QObject>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QVector>
+
+#include <algorithm>
+
+namespace Cogent {
+
+/*!
+ * \brief Compact, integer-indexed representation of a (possibly partial) roster.
+ *
+ * Each day consists of a fixed number of shifts, and each shift of a day is a flat array of
+ * NurseId slots. All slots are stored contiguously in a single day-major, then shift-major, then
+ * slot-major array, so that appending a day or assigning a nurse never allocates in the steady
+ * state, and constraints can inspect any day and shift without unboxing variants or hashing
+ * strings.
+ *
+ * The JSON-shaped QVariantList representation is only produced (via toVariantList) once the
+ * roster is complete.
+ */
+class Roster
+{
+
+public:
+    /*!
+     * \brief Indexes of the default shifts, in the order in which they are allocated.
+     *
+     * Note, the order of shifts here is not reflected in the final output (as JSON Object property
+     * names are explicitly unordered), however, since the "night" shift is subject to more
+     * constraints than the other shifts (AtMostFiveNightShiftsPerMonth), by allocating the night
+     * shift first, we avoid allocating nurses to day shifts, where those nurses may be the only
+     * viable staff for the night shift.
+     */
+    enum Shift {
+        NightShift = 0,
+        MorningShift,
+        EveningShift
+    };
+
+    /*!
+     * \brief Returns the names of the default shifts, indexed by Shift.
+     */
+    static QStringList defaultShiftNames()
+    {
+        return QStringList{ QObject::tr("night"), QObject::tr("morning"), QObject::tr("evening") };
+    }
+
+    /*!
+     * \brief Constructs an empty roster with the given \a shiftNames, reserving room for
+     * \a slotsPerShift nurses per shift.
+     *
+     * Shifts may hold more than \a slotsPerShift nurses; the storage will simply be widened (which
+     * is relatively expensive) the first time that happens.
+     */
+    explicit Roster(const QStringList &shiftNames = defaultShiftNames(), const int slotsPerShift = 5)
+        : names(shiftNames), width(qMax(slotsPerShift, 1))
+    {
+        Q_ASSERT(!names.isEmpty());
+    }
+
+    /*!
+     * \brief Returns the number of days in this roster.
+     */
+    int size() const
+    {
+        return counts.size() / names.size();
+    }
+
+    /*!
+     * \brief Returns \c true if this roster has no days; \c false otherwise.
+     */
+    bool isEmpty() const
+    {
+        return counts.isEmpty();
+    }
+
+    /*!
+     * \brief Returns the number of shifts per day.
+     */
+    int shiftCount() const
+    {
+        return names.size();
+    }
+
+    /*!
+     * \brief Returns the name of the shift at index \a shift.
+     */
+    QString shiftName(const int shift) const
+    {
+        return names.value(shift);
+    }
+
+    /*!
+     * \brief Returns the index of the shift named \a shift, or -1 if there is no such shift.
+     */
+    int shiftIndex(const QString &shift) const
+    {
+        return names.indexOf(shift);
+    }
+
+    /*!
+     * \brief Returns the names of all shifts, indexed by shift.
+     */
+    QStringList shiftNames() const
+    {
+        return names;
+    }
+
+    /*!
+     * \brief Reserves storage for \a days days.
+     */
+    void reserve(const int days)
+    {
+        counts.reserve(days * names.size());
+        assignments.reserve(days * names.size() * width);
+    }
+
+    /*!
+     * \brief Appends an empty day to the roster.
+     */
+    void appendDay()
+    {
+        for (int shift = 0; shift < names.size(); ++shift) {
+            counts.append(0);
+            for (int slot = 0; slot < width; ++slot) {
+                assignments.append(-1);
+            }
+        }
+    }
+
+    /*!
+     * \brief Removes the last day from the roster.
+     */
+    void removeLastDay()
+    {
+        Q_ASSERT(!isEmpty());
+        counts.resize(counts.size() - names.size());
+        assignments.resize(counts.size() * width);
+    }
+
+    /*!
+     * \brief Returns the number of nurses assigned to \a shift on \a day.
+     */
+    int count(const int day, const int shift) const
+    {
+        return counts.at(cell(day, shift));
+    }
+
+    /*!
+     * \brief Returns the nurse assigned to \a slot of \a shift on \a day.
+     */
+    NurseId at(const int day, const int shift, const int slot) const
+    {
+        Q_ASSERT(slot < count(day, shift));
+        return assignments.at(cell(day, shift) * width + slot);
+    }
+
+    /*!
+     * \brief Returns the nurses assigned to \a shift on \a day.
+     */
+    QVector<NurseId> nurses(const int day, const int shift) const
+    {
+        const int offset = cell(day, shift) * width;
+        return assignments.mid(offset, counts.at(cell(day, shift)));
+    }
+
+    /*!
+     * \brief Returns \c true if \a nurse is assigned to any shift on \a day; \c false otherwise.
+     */
+    bool isRostered(const int day, const NurseId nurse) const
+    {
+        for (int shift = 0; shift < names.size(); ++shift) {
+            if (isRostered(day, shift, nurse)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*!
+     * \brief Returns \c true if \a nurse is assigned to \a shift on \a day; \c false otherwise.
+     */
+    bool isRostered(const int day, const int shift, const NurseId nurse) const
+    {
+        const int offset = cell(day, shift) * width;
+        const NurseId * const begin = assignments.constData() + offset;
+        const NurseId * const end = begin + counts.at(cell(day, shift));
+        return std::find(begin, end, nurse) != end;
+    }
+
+    /*!
+     * \brief Assigns \a nurse to the next free slot of \a shift on \a day.
+     */
+    void assign(const int day, const int shift, const NurseId nurse)
+    {
+        Q_ASSERT(nurse >= 0);
+        if (counts.at(cell(day, shift)) == width) {
+            widen(width * 2);
+        }
+        int &count = counts[cell(day, shift)];
+        assignments[cell(day, shift) * width + count++] = nurse;
+    }
+
+    /*!
+     * \brief Removes, and returns, the most recently assigned nurse of \a shift on \a day.
+     */
+    NurseId unassign(const int day, const int shift)
+    {
+        int &count = counts[cell(day, shift)];
+        Q_ASSERT(count > 0);
+        NurseId &slot = assignments[cell(day, shift) * width + --count];
+        const NurseId nurse = slot;
+        slot = -1;
+        return nurse;
+    }
+
+    /*!
+     * \brief Returns this roster as a list of days, where each day is a map of shift names to
+     * lists of nurse names, as looked up in \a nurses.
+     */
+    QVariantList toVariantList(const NurseTable &nurses) const
+    {
+        QVariantList days;
+        days.reserve(size());
+        for (int day = 0; day < size(); ++day) {
+            days.append(dayToVariantMap(day, nurses));
+        }
+        return days;
+    }
+
+    /*!
+     * \brief Returns \a day of this roster as a map of shift names to lists of nurse names, as
+     * looked up in \a nurses; that is, as the \a day element of toVariantList.
+     */
+    QVariantMap dayToVariantMap(const int day, const NurseTable &nurses) const
+    {
+        QVariantMap shifts;
+        for (int shift = 0; shift < names.size(); ++shift) {
+            QStringList shiftNurses;
+            shiftNurses.reserve(count(day, shift));
+            for (int slot = 0; slot < count(day, shift); ++slot) {
+                shiftNurses.append(nurses.name(at(day, shift, slot)));
+            }
+            shifts.insert(names.at(shift), shiftNurses);
+        }
+        return shifts;
+    }
+
+    /*!
+     * \brief Returns a roster built from \a days (as returned by toVariantList), interning any
+     * previously unknown nurse names into \a nurses.
+     *
+     * Shifts not named in \a shiftNames are ignored, with a warning.
+     */
+    static Roster fromVariantList(const QVariantList &days, NurseTable &nurses,
+                                  const QStringList &shiftNames = defaultShiftNames())
+    {
+        Roster roster(shiftNames);
+        roster.reserve(days.size());
+        foreach (const QVariant &day, days) {
+            roster.appendDay();
+            const QVariantMap shifts = day.toMap();
+            for (auto iter = shifts.constBegin(); iter != shifts.constEnd(); ++iter) {
+                const int shift = roster.shiftIndex(iter.key());
+                if (shift < 0) {
+                    qCWarning(lcRoster) << "ignoring unknown shift" << iter.key();
+                    continue;
+                }
+                foreach (const QVariant &nurse, iter.value().toList()) {
+                    roster.assign(roster.size()-1, shift, nurses.intern(nurse.toString()));
+                }
+            }
+        }
+        return roster;
+    }
+
+protected:
+    QStringList names;            // Shift names, indexed by shift.
+    int width;                    // Number of slots per shift.
+    QVector<int> counts;          // Number of assigned slots, indexed by cell().
+    QVector<NurseId> assignments; // Assigned nurses, indexed by cell() * width + slot.
+
+    /*!
+     * \brief Returns the index of \a shift on \a day within the counts array.
+     */
+    int cell(const int day, const int shift) const
+    {
+        Q_ASSERT((day >= 0) && (day < size()));
+        Q_ASSERT((shift >= 0) && (shift < names.size()));
+        return day * names.size() + shift;
+    }
+
+    /*!
+     * \brief Re-lays out the slot storage to hold \a newWidth nurses per shift.
+     */
+    void widen(const int newWidth)
+    {
+        Q_ASSERT(newWidth > width);
+        QVector<NurseId> newAssignments(counts.size() * newWidth, -1);
+        for (int index = 0; index < counts.size(); ++index) {
+            for (int slot = 0; slot < counts.at(index); ++slot) {
+                newAssignments[index * newWidth + slot] = assignments.at(index * width + slot);
+            }
+        }
+        assignments.swap(newAssignments);
+        width = newWidth;
+    }
+
+};
+
+} // end Cogent namespace
+
+#endif // __ROSTER_H__
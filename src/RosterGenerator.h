@@ -1,94 +1,1188 @@
 #ifndef __ROSTER_GENERATOR_H__
 #define __ROSTER_GENERATOR_H__
 
+#include "Availability.h"
 #include "ConstraintInterface.h"
+#include "Demand.h"
+#include "GeneratorMetrics.h"
 #include "LeastRecentScheduler.h"
+#include "Logging.h"
+#include "ScratchPool.h"
 
+#include <QAtomicInt>
 #include <QDate>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QPair>
+#include <QSet>
 #include <QSharedPointer>
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+
 namespace Cogent {
 
 class RosterGenerator
 {
 
 public:
+    /*!
+     * \brief Function to configure (eg add constraints to) a RosterGenerator.
+     */
+    typedef std::function<void(RosterGenerator &generator)> Configurator;
+
     RosterGenerator(const int nursesPerShift = 5)
-        : scheduler(new LeastRecentScheduler()), nursesPerShift(nursesPerShift)
+        : scheduler(new LeastRecentScheduler()), shiftNames(Roster::defaultShiftNames()),
+          demand(QVector<int>(shiftNames.size(), nursesPerShift)), engine(GreedyEngine),
+          maxNodes(100000), maxMilliseconds(10000), cancelled(nullptr), timed(false)
     { }
 
+    virtual ~RosterGenerator() { }
+
+    /*!
+     * \brief Statistics of a constraint's constrain() calls, accumulated over this generator's
+     * lifetime.
+     */
+    typedef GeneratorMetrics::ConstraintStats ConstraintStats;
+
     /*!
      * Register a \a constraint to apply to this roster. This roster will take ownership of the
      * \a constraint, freeing it on destruction.
      */
     void addConstraint(ConstraintInterface * const constraint)
     {
+        constraintOrder.append(constraints.size());
         constraints.append(QSharedPointer<ConstraintInterface>(constraint));
+        stats.append(ConstraintStats{ constraint->name(), 0, 0, 0, 0, 0 });
+    }
+
+    /*!
+     * Returns the statistics of each constraint added via addConstraint, in the order they were
+     * added.
+     */
+    QVector<ConstraintStats> constraintStats() const
+    {
+        return stats;
+    }
+
+    /*!
+     * Replace this roster's scheduler (a LeastRecentScheduler by default) with \a scheduler. This
+     * roster will take ownership of the \a scheduler, freeing it on destruction.
+     */
+    void setScheduler(SchedulerInterface * const scheduler)
+    {
+        this->scheduler = QSharedPointer<SchedulerInterface>(scheduler);
+        startScheduler.clear(); // Any repair now starts from the new scheduler; see repair.
+    }
+
+    /*!
+     * Returns a new copy of this roster's scheduler, including its history so far, or \c nullptr if
+     * the scheduler cannot be copied (see SchedulerInterface::clone). The caller takes ownership.
+     */
+    SchedulerInterface *cloneScheduler() const
+    {
+        return scheduler->clone();
+    }
+
+    /*!
+     * Set the shifts to fill on each day to \a shiftNames, in the order in which they are to be
+     * filled, with the number of nurses on each shift of each day given by \a demand.
+     *
+     * By default, each of Roster::defaultShiftNames is filled with the number of nurses given to
+     * the constructor. Note, constraints refer to shifts by index, so must agree with
+     * \a shiftNames.
+     */
+    void setShifts(const QStringList &shiftNames, const Demand &demand)
+    {
+        Q_ASSERT(!shiftNames.isEmpty());
+        Q_ASSERT(shiftNames.size() == demand.shiftCount());
+        this->shiftNames = shiftNames;
+        this->demand = demand;
+    }
+
+    /*!
+     * Set the skills required of every nurse on each shift to \a shiftSkills (indexed by shift, as
+     * per setShifts). By default, no skills are required.
+     *
+     * Nurses' skills are given by their records (see setNurseRecords); nurses without a record
+     * have no skills.
+     */
+    void setShiftSkills(const QVector<QSet<QString>> &shiftSkills)
+    {
+        this->shiftSkills = shiftSkills;
+    }
+
+    /*!
+     * Set the nurses' leave, part-time caps, skills and shift preferences to \a records.
+     *
+     * Each generate call turns the records of the nurses being rostered into masks of the nurses
+     * available for each shift of each day of the month, which are applied before (and so spare
+     * the work of) any constraints. Nurses without a record are always available (except for
+     * shifts requiring skills).
+     */
+    void setNurseRecords(const QVector<NurseRecord> &records)
+    {
+        this->records.clear();
+        foreach (const NurseRecord &record, records) {
+            this->records.insert(record.name, record);
+        }
+    }
+
+    /*!
+     * Have generate give up (returning an empty map) as soon as it notices \a cancelled become
+     * non-zero, such as when another thread has already produced a roster. The \a cancelled
+     * flag must outlive any generate calls; pass \c nullptr to remove it.
+     */
+    void setCancelFlag(const QAtomicInt * const cancelled)
+    {
+        this->cancelled = cancelled;
+    }
+
+    /*!
+     * \brief Engines available for filling a roster.
+     */
+    enum Engine {
+        GreedyEngine,      // Fill each shift in turn, giving up on the first that can't be filled.
+        BacktrackingEngine // Search (within limits) for a roster, undoing earlier choices as needed.
+    };
+
+    /*!
+     * Set the \a engine to use for subsequent calls to generate. The default is GreedyEngine.
+     */
+    void setEngine(const Engine engine)
+    {
+        this->engine = engine;
+    }
+
+    /*!
+     * Limit the BacktrackingEngine to visiting at most \a maxNodes search nodes (ie shifts
+     * considered), and to at most \a maxMilliseconds of searching, per generate call. A value of
+     * zero (or less) disables the corresponding limit.
+     *
+     * If either limit is reached before a roster is found, the greedy engine is used instead.
+     */
+    void setSearchLimits(const qint64 maxNodes, const qint64 maxMilliseconds)
+    {
+        this->maxNodes = maxNodes;
+        this->maxMilliseconds = maxMilliseconds;
+    }
+
+    /*!
+     * Set whether to time each constraint and scheduler call in this generator's metrics (see
+     * metrics) to \a timed. By default, they are not timed, since even reading the clock is a
+     * significant cost for calls that take well under a microsecond; their other metrics (such as
+     * call counts) are always kept, as is the time taken by each generate (or repair) call.
+     *
+     * Without timing, constraints are reordered (see constrain) as if every call costs the same.
+     */
+    void setTimed(const bool timed)
+    {
+        this->timed = timed;
     }
 
     /*!
      * Returns a roster using (possbly a subset of) \a nurses for the given \a month in the given
      * \a year. If any constraints have been set via addConstraint, they will be applied too.
+     *
+     * If \a carryIn is not empty, the constraints continue on from the roster(s) it was built from,
+     * such that (for example) a single day off cannot straddle the start of the month.
+     */
+    QVariantMap generate(const int year, const int month, const QStringList &nurses,
+                         const CarryIn &carryIn = CarryIn())
+    {
+        QElapsedTimer timer;
+        timer.start();
+        return counted(generateMonth(year, month, nurses, carryIn), timer);
+    }
+
+    /*!
+     * Generates a roster into \a days, as per generate(), returning \c true on success.
+     *
+     * The roster is left in its compact form, with nurses named as per nurses(), so that callers
+     * can write it out (see JsonWriter::write) without first building the whole roster map.
+     */
+    bool generate(const int year, const int month, const QStringList &nurses,
+                  const CarryIn &carryIn, Roster &days)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        return counted(fillMonth(year, month, nurses, carryIn, days), timer);
+    }
+
+    /*!
+     * Returns every nurse given to this generator so far, by ID, as used by generated Rosters.
+     */
+    const NurseTable &nurses() const
+    {
+        return nurseTable;
+    }
+
+    /*!
+     * Returns the key of the \a month of \a year in roster maps, such as "2018-06".
+     */
+    static QString monthKey(const int year, const int month)
+    {
+        return QObject::tr("%1-%2").arg(year).arg(month,2,10,QLatin1Char('0'));
+    }
+
+    /*!
+     * Returns the metadata (such as the "created" time) included in each generated roster map.
+     */
+    static QVariantMap metadata()
+    {
+        QVariantMap metadata;
+        metadata[QObject::tr("created")] = QDateTime::currentDateTime().toString();
+        // Could add plenty of other metadata here in future.
+        return metadata;
+    }
+
+    /*!
+     * \brief Changes to repair an existing roster for; see repair.
+     */
+    struct Changes {
+        QSet<QString> removedNurses;                // Nurses no longer available at all.
+        QVector<QPair<QString, QDate>> blockedDays; // Days on which particular nurses can't work.
+    };
+
+    /*!
+     * Returns a copy of \a days (the \a month of \a year of a roster previously generated for
+     * \a nurses, continuing on from \a carryIn) repaired for \a changes, or an empty map if the
+     * roster cannot be repaired.
+     *
+     * Any assignments of removed or blocked nurses are refilled, as are any shifts whose headcount
+     * differs from this generator's current demand (see setShifts), or whose nurses are no longer
+     * available according to their records (see setNurseRecords). Days before the first such
+     * change are kept exactly as they are; the constraints and scheduler are simply notified of
+     * their assignments, in order, to bring them up to date as of that day. From then on, each
+     * shift keeps as many of its existing nurses as the constraints still allow, and only the
+     * remaining slots are filled afresh, by the scheduler. So a single sick call costs a few
+     * milliseconds, rather than a whole month's generation, and leaves every assignment that it
+     * does not affect (directly or via the constraints) as it was.
+     *
+     * The scheduler is notified as of the start of the month. So if \a days is the month last
+     * generated by this generator, the scheduler is first rewound to a copy taken at the start of
+     * that generate call (if the scheduler can be copied; see SchedulerInterface::clone), rather
+     * than counting the kept days twice. Otherwise, the scheduler must be as at the start of the
+     * month, such as a fresh one, or one given via setScheduler.
+     *
+     * Repairs are made greedily (regardless of the engine set via setEngine). If they fail, a new
+     * roster may still be possible via generate.
+     */
+    QVariantMap repair(const int year, const int month, const QVariantList &days,
+                       const QStringList &nurses, const Changes &changes,
+                       const CarryIn &carryIn = CarryIn())
+    {
+        QElapsedTimer timer;
+        timer.start();
+        return counted(repairMonth(year, month, days, nurses, changes, carryIn), timer);
+    }
+
+    /*!
+     * Returns the metrics of every roster generated (or repaired) by this generator so far.
+     *
+     * Constraints added via addConstraint are reported by name; any sharing a name are combined.
+     */
+    GeneratorMetrics metrics() const
+    {
+        GeneratorMetrics metrics = counters;
+        foreach (const ConstraintStats &constraint, stats) {
+            metrics.addConstraint(constraint);
+        }
+        return metrics;
+    }
+
+protected:
+    QVector<QSharedPointer<ConstraintInterface>> constraints; // In the order they were added.
+    QVector<int> constraintOrder;             // Indexes into constraints, in the order applied.
+    mutable QVector<ConstraintStats> stats;   // Indexed as per constraints.
+    mutable ScratchPool scratch;              // Per-shift temporaries, such as candidate sets.
+    GeneratorMetrics counters;                // All but the constraints' (see stats).
+    QSharedPointer<SchedulerInterface> scheduler;
+    QSharedPointer<const SchedulerInterface> startScheduler; // As at startMonth, for repair.
+    QDate startMonth;        // The first day of the month last generated.
+    QStringList shiftNames;  // Names of the shifts to fill each day, in order.
+    Demand demand;           // Number of nurses to fill each shift of each day with.
+    NurseTable nurseTable;   // Every nurse given to this generator so far; see internNurses.
+    QDate monthStart;        // The current month's first day.
+    QVector<int> headcounts; // The current month's demand, indexed by day * shifts + shift.
+    QVector<QSet<QString>> shiftSkills;  // Skills required on each shift, indexed by shift.
+    QHash<QString, NurseRecord> records; // Nurses' availability, by name.
+    Availability availability;           // The current month's availability, if restricted.
+    Engine engine;
+    qint64 maxNodes;
+    qint64 maxMilliseconds;
+    const QAtomicInt *cancelled;
+    bool timed;              // Whether to time constraint and scheduler calls; see setTimed.
+
+    /*!
+     * Generates a roster, as per generate().
+     */
+    QVariantMap generateMonth(const int year, const int month, const QStringList &nurses,
+                              const CarryIn &carryIn)
+    {
+        Roster days;
+        return fillMonth(year, month, nurses, carryIn, days)
+            ? toVariantMap(year, month, days, nurseTable) : QVariantMap();
+    }
+
+    /*!
+     * Generates a roster into \a days, as per generate(), returning \c true on success.
      */
-    QVariantMap generate(const int year, const int month, const QStringList &nurses)
+    bool fillMonth(const int year, const int month, const QStringList &nurses,
+                   const CarryIn &carryIn, Roster &days)
     {
         const int daysInMonth = RosterGenerator::daysInMonth(year, month);
 
-        // Note, the order of shift names here is not reflected in the final output (as JSON Object
-        // property names are explicitly unordered), however, since the "night" shift is subject to
-        // more constraints than the other shifts (AtMostFiveNightShiftsPerMonth), by allocating
-        // the night shift first, we avoid allocating nurses to day shifts, where those nurses may
-        // be the only viable staff for the night shift.
-        static const QStringList shiftNames{
-            QObject::tr("night"), QObject::tr("morning"), QObject::tr("evening")
-        };
+        // Keep a copy of the scheduler as at the start of the month, for any repair of it.
+        startScheduler = QSharedPointer<const SchedulerInterface>(scheduler->clone());
+        startMonth = QDate(year, month, 1);
 
-        QVariantList days;
-        while (days.size() < daysInMonth) {
-            QVariantMap day;
-            foreach (const QString &shift, shiftNames) {
-                qDebug() << "day" << days.size()+1 << shift;
-
-                // Build a list of candidate nurses by reducing the full list by each constraint.
-                auto candidateNurses = nurses.toSet();
-                foreach(auto &constraint, constraints) {
-                    constraint->constrain(candidateNurses, shift, days + QVariantList{day});
+        // Intern the nurses' names, so that constraints and the scheduler only deal in dense IDs.
+        const NurseSet allNurses = internNurses(nurses);
+
+        // Look up the number of nurses needed on every shift of the month, and give up straight
+        // away if there cannot possibly be enough nurses to meet that demand.
+        if (!prepareMonth(QDate(year, month, 1), daysInMonth, allNurses)) {
+            return false;
+        }
+
+        // Start each constraint afresh (bar any carried-in state); they are then notified of each
+        // assignment as it is made.
+        resetConstraints(carryIn);
+
+        // Fill the roster in place; the current (partial) day is always the roster's last day. Its
+        // slots are sized for the busiest shift of the month, so assignments never reallocate.
+        days = emptyRoster(daysInMonth);
+        return (engine == BacktrackingEngine)
+            ? fillBacktracking(days, daysInMonth, allNurses)
+            : fillGreedy(days, daysInMonth, allNurses);
+    }
+
+    /*!
+     * Repairs a roster, as per repair().
+     */
+    QVariantMap repairMonth(const int year, const int month, const QVariantList &days,
+                            const QStringList &nurses, const Changes &changes,
+                            const CarryIn &carryIn)
+    {
+        const int daysInMonth = RosterGenerator::daysInMonth(year, month);
+        const QDate firstDay(year, month, 1);
+
+        // Intern the nurses, then the rostered nurses; any rostered nurses not in nurses (or
+        // removed) are no longer available. The nurses are interned first so that, as per
+        // generate, any new to this generator are numbered in the order given.
+        internNurses(nurses);
+        const Roster existing = Roster::fromVariantList(days, nurseTable, shiftNames);
+        if (existing.size() != daysInMonth) {
+            qCWarning(lcGenerator) << "cannot repair a roster of" << existing.size() << "days for"
+                                   << year << month;
+            return QVariantMap();
+        }
+        NurseSet allNurses = internNurses(nurses); // Now spanning the rostered nurses too.
+        foreach (const QString &nurse, changes.removedNurses) {
+            const NurseId id = nurseTable.id(nurse);
+            if (id >= 0) {
+                allNurses.remove(id);
+            }
+        }
+        QVector<NurseSet> blocked(daysInMonth, NurseSet(nurseTable.size()));
+        for (auto iter = changes.blockedDays.constBegin(); iter != changes.blockedDays.constEnd();
+             ++iter) {
+            const int day = int(firstDay.daysTo(iter->second));
+            const NurseId nurse = nurseTable.id(iter->first);
+            if ((day >= 0) && (day < daysInMonth) && (nurse >= 0)) {
+                blocked[day].insert(nurse);
+            }
+        }
+        if (!prepareMonth(firstDay, daysInMonth, allNurses)) {
+            return QVariantMap();
+        }
+
+        // Find the first day needing any change; if none do, there's nothing to repair.
+        int firstChangedDay = daysInMonth;
+        for (int day = 0; (day < daysInMonth) && (firstChangedDay == daysInMonth); ++day) {
+            for (int shift = 0; shift < existing.shiftCount(); ++shift) {
+                if (existing.count(day, shift) != headcount(day, shift)) {
+                    firstChangedDay = day;
                 }
-                qDebug() << "constrained to" << candidateNurses.size() << "of" << nurses.size() << "nurses";
+                for (int slot = 0; slot < existing.count(day, shift); ++slot) {
+                    const NurseId nurse = existing.at(day, shift, slot);
+                    if ((!allNurses.contains(nurse)) || (blocked.at(day).contains(nurse)) ||
+                        ((!availability.isEmpty()) &&
+                         (!availability.mask(day, shift).contains(nurse)))) {
+                        firstChangedDay = day;
+                    }
+                }
+            }
+        }
+        qCDebug(lcGenerator) << "repairing from day" << firstChangedDay+1;
+        QVector<NurseSet> rostered(daysInMonth, NurseSet(nurseTable.size()));
+        for (int day = firstChangedDay; day < daysInMonth; ++day) {
+            for (int shift = 0; shift < existing.shiftCount(); ++shift) {
+                for (int slot = 0; slot < existing.count(day, shift); ++slot) {
+                    rostered[day].insert(existing.at(day, shift, slot));
+                }
+            }
+        }
 
-                // Use the scheduler to choose the required number of nurses for this shift.
-                QStringList nursesForThisShift;
-                while (nursesForThisShift.size() < nursesPerShift) {
-                    if (candidateNurses.isEmpty()) {
-                        qWarning() << "not enough nurses to satisfy the" << shift
-                                   << "shift of day" << days.size()+1;
-                        return QVariantMap();
+        // Bring the constraints and scheduler up to date as of the first changed day, having
+        // rewound the scheduler to the start of the month if it has already seen this month. Each
+        // shift is notified to the scheduler as a single choice, as it was made.
+        if ((!startScheduler.isNull()) && (startMonth == firstDay)) {
+            scheduler = QSharedPointer<SchedulerInterface>(startScheduler->clone());
+        }
+        resetConstraints(carryIn);
+        Roster repaired = emptyRoster(daysInMonth);
+        for (int day = 0; day < firstChangedDay; ++day) {
+            repaired.appendDay();
+            for (int shift = 0; shift < existing.shiftCount(); ++shift) {
+                scratch.reset();
+                QVector<NurseId> &keptNurses = scratch.nurseList();
+                for (int slot = 0; slot < existing.count(day, shift); ++slot) {
+                    keptNurses.append(existing.at(day, shift, slot));
+                }
+                assign(repaired, day, shift, keptNurses);
+            }
+            notifyDayCommitted(repaired, day);
+        }
+
+        // Then keep what can be kept of each remaining shift, and fill the rest afresh.
+        int refilled = 0;
+        for (int day = firstChangedDay; day < daysInMonth; ++day) {
+            repaired.appendDay();
+            for (int shift = 0; shift < existing.shiftCount(); ++shift) {
+                scratch.reset();
+                NurseSet &candidateNurses = candidatesFor(shift, repaired, allNurses);
+                candidateNurses.subtract(blocked.at(day));
+                for (int slot = 0; slot < existing.count(day, shift); ++slot) {
+                    const NurseId nurse = existing.at(day, shift, slot);
+                    if ((repaired.count(day, shift) < headcount(day, shift)) &&
+                        (candidateNurses.remove(nurse))) {
+                        assign(repaired, day, shift, nurse);
                     }
-                    const QString nurse = scheduler->chooseNextNurse(candidateNurses);
-                    nursesForThisShift.append(nurse);
-                    candidateNurses.remove(nurse);
                 }
+                // Fill any remaining slots, preferring nurses least likely to disturb the rest of
+                // the existing roster.
+                const int needed = headcount(day, shift) - repaired.count(day, shift);
+                if (needed == 0) {
+                    continue;
+                }
+                const NurseSet &preferred = leastDisruptive(rostered, day, candidateNurses);
+                QVector<NurseId> &chosenNurses = scratch.nurseList();
+                chooseNurses(day, shift, preferred, needed, chosenNurses);
+                if (chosenNurses.size() < needed) {
+                    candidateNurses.subtract(preferred);
+                    chooseNurses(day, shift, candidateNurses, needed - chosenNurses.size(),
+                                 chosenNurses);
+                }
+                foreach (const NurseId nurse, chosenNurses) {
+                    repaired.assign(day, shift, nurse);
+                    availability.onAssigned(nurse);
+                    notifyAssigned(nurse, day, shift);
+                }
+                if (chosenNurses.size() < needed) {
+                    qCWarning(lcGenerator) << "not enough nurses to repair the"
+                                           << repaired.shiftName(shift) << "shift of day" << day+1;
+                    ++counters.failedShifts[repaired.shiftName(shift)];
+                    return QVariantMap();
+                }
+                refilled += needed;
+            }
+            notifyDayCommitted(repaired, day);
+        }
+        qCDebug(lcGenerator) << "refilled" << refilled << "slots from day" << firstChangedDay+1;
+        return toVariantMap(year, month, repaired, nurseTable);
+    }
+
+    /*!
+     * Counts \a roster (empty if it could not be generated) in this generator's metrics, having
+     * taken the time since \a timer was started, then returns it.
+     *
+     * Empty rosters count as failures, unless generation has been cancelled (see setCancelFlag),
+     * since the roster may well have been found otherwise.
+     */
+    QVariantMap counted(const QVariantMap &roster, const QElapsedTimer &timer)
+    {
+        counted(!roster.isEmpty(), timer);
+        return roster;
+    }
+
+    /*!
+     * Counts a roster (\a generated or not) in this generator's metrics, as per the above, then
+     * returns \a generated.
+     */
+    bool counted(const bool generated, const QElapsedTimer &timer)
+    {
+        ++counters.rosters;
+        if ((!generated) && (isCancelled())) {
+            ++counters.cancelled;
+        } else if (!generated) {
+            ++counters.failures;
+        }
+        counters.nanoseconds += timer.nsecsElapsed();
+        return generated;
+    }
+
+    /*!
+     * Returns \c true if generation has been cancelled via setCancelFlag; \c false otherwise.
+     */
+    bool isCancelled() const
+    {
+        return (cancelled) && (cancelled->loadAcquire() != 0);
+    }
+
+    /*!
+     * \brief Search limits, and progress against them, for a single backtracking search.
+     */
+    struct SearchBudget {
+        qint64 nodes;
+        QElapsedTimer timer;
+        bool exhausted;
+    };
+
+    /*!
+     * Returns the set of \a nurses, first adding any not already in this generator's nurse table.
+     *
+     * The table is kept between calls, so each nurse keeps the same NurseId, and so the same
+     * history with the scheduler (which keeps its state by NurseId), whichever nurses (and in
+     * whatever order) each call is given. Nurses in the table but not in \a nurses are simply
+     * not in the returned set, so are never rostered.
+     */
+    NurseSet internNurses(const QStringList &nurses)
+    {
+        foreach (const QString &nurse, nurses) {
+            nurseTable.intern(nurse);
+        }
+        NurseSet set(nurseTable.size());
+        foreach (const QString &nurse, nurses) {
+            set.insert(nurseTable.id(nurse));
+        }
+        return set;
+    }
+
+    /*!
+     * Looks up the demand, and builds the availability of the nurse table, for the
+     * \a daysInMonth days from \a firstDay.
+     *
+     * Returns \c false if \a allNurses cannot possibly meet that demand (see isFeasible);
+     * \c true otherwise.
+     */
+    bool prepareMonth(const QDate &firstDay, const int daysInMonth, const NurseSet &allNurses)
+    {
+        monthStart = firstDay;
+        headcounts = demand.headcounts(firstDay, daysInMonth);
+        bool skillsRequired = false;
+        foreach (const QSet<QString> &skills, shiftSkills) {
+            skillsRequired |= !skills.isEmpty();
+        }
+        availability = ((records.isEmpty()) && (!skillsRequired)) ? Availability()
+            : Availability(records, nurseTable, shiftNames, shiftSkills, firstDay, daysInMonth);
+        if (!isFeasible(allNurses, daysInMonth)) {
+            ++counters.infeasible;
+            return false;
+        }
+        return true;
+    }
+
+    /*!
+     * Returns the \a candidates whose assignment to \a day would least disturb the rest of the
+     * existing roster, given the nurses \a rostered on each of its days: those not already rostered
+     * elsewhere on \a day (who would leave a gap there instead), and either rostered the next day
+     * (extending a run of days worked) or not rostered the day after (so as not to split a run of
+     * days off).
+     *
+     * The returned set is taken from the scratch pool.
+     */
+    NurseSet &leastDisruptive(const QVector<NurseSet> &rostered, const int day,
+                              const NurseSet &candidates) const
+    {
+        NurseSet &nurses = scratch.nurseSet(candidates);
+        nurses.subtract(rostered.at(day));
+        if (day+2 < rostered.size()) {
+            NurseSet &splitting = scratch.nurseSet(rostered.at(day+2));
+            nurses.subtract(splitting.subtract(rostered.at(day+1)));
+        }
+        return nurses;
+    }
+
+    /*!
+     * Resets each constraint for the nurses of the nurse table, continuing on from \a carryIn.
+     */
+    void resetConstraints(const CarryIn &carryIn)
+    {
+        notifyReset(nurseTable.size(),
+                    carryIn.isEmpty() ? QVector<CarryIn::Streak>() : carryIn.streaks(nurseTable));
+    }
 
-                // Add this shift to the day.
-                day[shift] = nursesForThisShift;
+    /*!
+     * Resets each constraint for \a nurseCount nurses, then notifies it of any carried-in
+     * \a streaks.
+     *
+     * This, and the other notify and constraint methods below, are the generator's only uses of
+     * its constraints, so that StaticRosterGenerator can add its own, statically-dispatched ones.
+     */
+    virtual void notifyReset(const int nurseCount, const QVector<CarryIn::Streak> &streaks)
+    {
+        foreach (auto &constraint, constraints) {
+            constraint->reset(nurseCount);
+            if (!streaks.isEmpty()) {
+                constraint->onCarryIn(streaks);
             }
-            // This day to the roster.
-            days.append(day);
         }
+    }
+
+    /*!
+     * Notifies each constraint that \a nurse has been assigned to \a shift of \a day.
+     */
+    virtual void notifyAssigned(const NurseId nurse, const int day, const int shift)
+    {
+        foreach (auto &constraint, constraints) {
+            constraint->onAssigned(nurse, day, shift);
+        }
+    }
+
+    /*!
+     * Notifies each constraint, in reverse order, that the assignment of \a nurse to \a shift of
+     * \a day has been undone.
+     */
+    virtual void notifyUnassigned(const NurseId nurse, const int day, const int shift)
+    {
+        for (int index = constraints.size()-1; index >= 0; --index) {
+            constraints.at(index)->onUnassigned(nurse, day, shift);
+        }
+    }
 
+    /*!
+     * Notifies each constraint that \a day of \a days is complete.
+     */
+    virtual void notifyDayCommitted(const Roster &days, const int day)
+    {
+        foreach (auto &constraint, constraints) {
+            constraint->onDayCommitted(days, day);
+        }
+        reorderConstraints();
+    }
+
+    /*!
+     * Notifies each constraint, in reverse order, that the commit of \a day of \a days has been
+     * undone.
+     */
+    virtual void notifyDayUncommitted(const Roster &days, const int day)
+    {
+        for (int index = constraints.size()-1; index >= 0; --index) {
+            constraints.at(index)->onDayUncommitted(days, day);
+        }
+    }
+
+    /*!
+     * Removes from \a nurses any nurse that fails any constraint for \a shift of the last day of
+     * \a days.
+     *
+     * The constraints are applied in the order given by reorderConstraints(). Once fewer than
+     * \a needed nurses remain, the shift cannot be filled whatever the remaining constraints do, so
+     * they are skipped, and \a nurses is cleared instead (as it would otherwise include nurses that
+     * fail those constraints).
+     */
+    virtual void constrain(NurseSet &nurses, const int shift, const Roster &days,
+                           const int needed) const
+    {
+        if (constraints.isEmpty()) {
+            return;
+        }
+        // Note, constraints that under-report their removals only make this count an overestimate,
+        // which is safe; it merely skips fewer constraints.
+        int remaining = nurses.count();
+        QElapsedTimer timer;
+        for (int position = 0; position < constraintOrder.size(); ++position) {
+            ConstraintStats &stats = this->stats[constraintOrder.at(position)];
+            if (remaining < needed) {
+                ++stats.skipped;
+                continue;
+            }
+            if (timed) {
+                timer.start();
+            }
+            const int removed = constraints.at(constraintOrder.at(position))->constrain(
+                nurses, shift, days);
+            if (timed) {
+                stats.nanoseconds += timer.nsecsElapsed();
+            }
+            ++stats.calls;
+            stats.candidates += remaining;
+            stats.removed += removed;
+            remaining -= removed;
+        }
+        if (remaining < needed) {
+            nurses.fill(false);
+        }
+    }
+
+    /*!
+     * Reorders the constraints (as applied by constrain()) so that those that remove the most
+     * candidates for the least time go first, as per their statistics so far.
+     *
+     * Each constraint is ranked by its average time per call (or simply 1, if not timed; see
+     * setTimed), divided by the average fraction of candidates it removes; constraints not yet
+     * called go first, and those that have never removed anyone go last. The order does not
+     * affect which nurses are candidates, only how soon constrain() can give up on shifts that
+     * cannot be filled.
+     */
+    void reorderConstraints()
+    {
+        std::stable_sort(constraintOrder.begin(), constraintOrder.end(),
+                         [this](const int left, const int right) {
+            return rank(stats.at(left)) < rank(stats.at(right));
+        });
+    }
+
+    /*!
+     * Returns the rank of a constraint with the given \a stats, lowest first; see
+     * reorderConstraints().
+     */
+    double rank(const ConstraintStats &stats) const
+    {
+        if (stats.calls == 0) {
+            return 0.0;
+        }
+        if (stats.removed == 0) {
+            return std::numeric_limits<double>::infinity();
+        }
+        const double costPerCall = timed ? double(stats.nanoseconds) / stats.calls : 1.0;
+        return costPerCall / (double(stats.removed) / stats.candidates);
+    }
+
+    /*!
+     * Lowers \a maxDays, \a maxPerDay and each of \a maxPerShift to each constraint's bounds (see
+     * ConstraintInterface::maxDaysWorked and friends) for a month of \a daysInMonth days.
+     */
+    virtual void constrainBounds(const int daysInMonth, int &maxDays, int &maxPerDay,
+                                 QVector<int> &maxPerShift) const
+    {
+        foreach (auto &constraint, constraints) {
+            maxDays = qMin(maxDays, constraint->maxDaysWorked(daysInMonth));
+            maxPerDay = qMin(maxPerDay, constraint->maxShiftsPerDay(shiftNames.size()));
+            for (int shift = 0; shift < maxPerShift.size(); ++shift) {
+                maxPerShift[shift] = qMin(maxPerShift.at(shift),
+                                          constraint->maxShiftsPerMonth(shift, daysInMonth));
+            }
+        }
+    }
+
+    /*!
+     * Returns an empty roster, with room for \a daysInMonth days of the current month's demand.
+     */
+    Roster emptyRoster(const int daysInMonth) const
+    {
+        Roster days(shiftNames, headcounts.isEmpty() ? 0 :
+                    *std::max_element(headcounts.constBegin(), headcounts.constEnd()));
+        days.reserve(daysInMonth);
+        return days;
+    }
+
+    /*!
+     * Returns \a days (the \a month of \a year) as a roster map, as returned by generate.
+     */
+    static QVariantMap toVariantMap(const int year, const int month, const Roster &days,
+                                    const NurseTable &nurseTable)
+    {
         // Build the final roster, with some metadata.
-        QVariantMap roster;
-        roster[QObject::tr("%1-%2").arg(year).arg(month,2,10,QLatin1Char('0'))] = days;
-        roster[QObject::tr("created")] = QDateTime::currentDateTime().toString();
-        // Could add plenty of other metadata here in future.
+        QVariantMap roster = metadata();
+        roster[monthKey(year, month)] = days.toVariantList(nurseTable);
         return roster;
     }
 
-protected:
-    QVector<QSharedPointer<ConstraintInterface>> constraints;
-    const QSharedPointer<SchedulerInterface> scheduler;
-    const int nursesPerShift;
+    /*!
+     * Returns the number of nurses needed on \a shift of \a day of the current month.
+     */
+    int headcount(const int day, const int shift) const
+    {
+        return headcounts.at(day * shiftNames.size() + shift);
+    }
+
+    /*!
+     * Returns \c false if \a allNurses cannot possibly meet the current month's demand (of
+     * \a daysInMonth days) under the constraints; \c true otherwise.
+     *
+     * This compares the demand to an upper bound on what each nurse can work, according to each
+     * constraint's own bounds (see ConstraintInterface::maxDaysWorked and friends): in total, on
+     * each day, and on each shift. It costs O(days * shifts * constraints), which is negligible
+     * next to filling a roster, so infeasible months are rejected without any search at all. Each
+     * day and shift is also checked against the nurses available then (see setNurseRecords).
+     */
+    bool isFeasible(const NurseSet &allNurses, const int daysInMonth) const
+    {
+        const int nurseCount = allNurses.count();
+        const int shiftCount = shiftNames.size();
+        int maxDays = daysInMonth, maxPerDay = shiftCount;
+        QVector<int> maxPerShift(shiftCount, daysInMonth);
+        constrainBounds(daysInMonth, maxDays, maxPerDay, maxPerShift);
+
+        // Check each day, and each shift, against what all nurses could possibly work.
+        qint64 totalDemand = 0;
+        QVector<qint64> demandPerShift(shiftCount, 0);
+        for (int day = 0; day < daysInMonth; ++day) {
+            const int availableToday = availability.isEmpty() ? nurseCount
+                : availability.nurses(day).intersect(allNurses).count();
+            int demandToday = 0;
+            for (int shift = 0; shift < shiftCount; ++shift) {
+                demandToday += headcount(day, shift);
+                demandPerShift[shift] += headcount(day, shift);
+                if (headcount(day, shift) > nurseCount) {
+                    qCWarning(lcGenerator) << "day" << day+1 << shiftNames.at(shift) << "needs"
+                                           << headcount(day, shift) << "of" << nurseCount
+                                           << "nurses";
+                    return false;
+                }
+                const int availableForShift = availability.isEmpty() ? nurseCount
+                    : NurseSet(availability.mask(day, shift)).intersect(allNurses).count();
+                if (headcount(day, shift) > availableForShift) {
+                    qCWarning(lcGenerator) << "day" << day+1 << shiftNames.at(shift) << "needs"
+                                           << headcount(day, shift) << "of" << availableForShift
+                                           << "available nurses";
+                    return false;
+                }
+            }
+            if (demandToday > qint64(availableToday) * maxPerDay) {
+                qCWarning(lcGenerator) << "day" << day+1 << "needs" << demandToday << "shifts of"
+                                       << availableToday << "nurses, at most" << maxPerDay
+                                       << "each";
+                return false;
+            }
+            totalDemand += demandToday;
+        }
+        qint64 maxShifts = 0;
+        for (int shift = 0; shift < shiftCount; ++shift) {
+            const qint64 capacity = qint64(nurseCount) * qMin(maxPerShift.at(shift), maxDays);
+            if (demandPerShift.at(shift) > capacity) {
+                qCWarning(lcGenerator) << "the" << shiftNames.at(shift) << "shift needs"
+                                       << demandPerShift.at(shift) << "of at most" << capacity
+                                       << "nurse shifts";
+                return false;
+            }
+            maxShifts += qMin(maxPerShift.at(shift), maxDays);
+        }
+
+        // Finally, check the total demand against the total capacity.
+        const qint64 capacity = qint64(nurseCount) * qMin(qint64(maxDays) * maxPerDay, maxShifts);
+        if (totalDemand > capacity) {
+            qCWarning(lcGenerator) << "the month needs" << totalDemand << "of at most" << capacity
+                                   << "nurse shifts";
+            return false;
+        }
+        return true;
+    }
+
+    /*!
+     * Returns the set of \a allNurses that are available for, and satisfy all constraints for,
+     * \a shift of the last day of \a days.
+     *
+     * If there are too few such nurses to fill the shift, the set may be empty instead (see
+     * constrain()). The returned set is taken from the scratch pool.
+     */
+    NurseSet &candidatesFor(const int shift, const Roster &days, const NurseSet &allNurses) const
+    {
+        NurseSet &candidateNurses = scratch.nurseSet();
+        if (availability.isEmpty()) {
+            candidateNurses.assign(allNurses);
+        } else {
+            availability.candidates(days.size()-1, shift, candidateNurses).intersect(allNurses);
+        }
+        constrain(candidateNurses, shift, days, headcount(days.size()-1, shift));
+        return candidateNurses;
+    }
+
+    /*!
+     * Greedily fills \a days (initially empty) up to \a daysInMonth days, from \a allNurses.
+     *
+     * Returns \c true on success, or \c false if a shift could not be filled.
+     */
+    bool fillGreedy(Roster &days, const int daysInMonth, const NurseSet &allNurses)
+    {
+        while (days.size() < daysInMonth) {
+            if (isCancelled()) {
+                qCDebug(lcGenerator) << "roster generation cancelled";
+                return false;
+            }
+            days.appendDay();
+            const int day = days.size()-1;
+            for (int shift = 0; shift < days.shiftCount(); ++shift) {
+                qCDebug(lcGenerator) << "day" << day+1 << days.shiftName(shift);
+
+                // Build a set of candidate nurses by reducing the full set by each constraint.
+                // This, and the shift's other temporaries, reuse the last shift's storage.
+                scratch.reset();
+                const NurseSet &candidateNurses = candidatesFor(shift, days, allNurses);
+                qCDebug(lcGenerator) << "constrained to" << candidateNurses.count() << "of"
+                                     << allNurses.count() << "nurses";
+
+                // Use the scheduler to choose the required number of nurses for this shift.
+                QVector<NurseId> &chosenNurses = scratch.nurseList();
+                chooseNurses(day, shift, candidateNurses, headcount(day, shift), chosenNurses);
+                foreach (const NurseId nurse, chosenNurses) {
+                    days.assign(day, shift, nurse);
+                    availability.onAssigned(nurse);
+                    notifyAssigned(nurse, day, shift);
+                }
+                if (chosenNurses.size() < headcount(day, shift)) {
+                    qCWarning(lcGenerator) << "not enough nurses to satisfy the"
+                                           << days.shiftName(shift) << "shift of day" << day+1;
+                    ++counters.failedShifts[days.shiftName(shift)];
+                    return false;
+                }
+            }
+
+            // Let the constraints update any per-day state (eg consecutive days worked).
+            notifyDayCommitted(days, day);
+        }
+        return true;
+    }
+
+    /*!
+     * Fills \a days (initially empty) up to \a daysInMonth days, from \a allNurses, via a
+     * depth-first search with forward checking.
+     *
+     * Each search node fills one shift. Its candidate nurses are ranked by the scheduler, and the
+     * combinations of those candidates are tried in lexicographic order of rank, each recorded
+     * with the scheduler as a single choice. So for schedulers whose ranking matches their choices
+     * (as LeastRecentScheduler's and FairScheduler's do, seeded or not), the first path explored is
+     * exactly the greedy roster, and the search only departs from it when a later shift cannot be
+     * filled. All choices (including the scheduler's) are undone on backtracking, so if the search
+     * limits are reached, the greedy engine can take over from a clean state.
+     *
+     * Returns \c true on success, or \c false if no roster could be found.
+     */
+    bool fillBacktracking(Roster &days, const int daysInMonth, const NurseSet &allNurses)
+    {
+        SearchBudget budget{ 0, QElapsedTimer(), false };
+        budget.timer.start();
+        scratch.reset();
+        days.appendDay();
+        scheduler->setUndoable(true);
+        const bool found = search(days, 0, 0, daysInMonth, allNurses, budget);
+        scheduler->setUndoable(false); // Nothing more to undo, even if falling back to greedy.
+        counters.searchNodes += budget.nodes;
+        if (found) {
+            qCDebug(lcGenerator) << "found roster after" << budget.nodes << "search nodes";
+            return true;
+        }
+        days.removeLastDay();
+        if (isCancelled()) {
+            qCDebug(lcGenerator) << "roster generation cancelled";
+            return false;
+        }
+        if (!budget.exhausted) {
+            qCWarning(lcGenerator) << "no roster satisfies all constraints with"
+                                   << allNurses.count() << "nurses";
+            return false;
+        }
+        ++counters.searchesExhausted;
+        qCWarning(lcGenerator) << "search limits reached after" << budget.nodes << "nodes and"
+                               << budget.timer.elapsed() << "ms; falling back to greedy generation";
+        return fillGreedy(days, daysInMonth, allNurses);
+    }
+
+    /*!
+     * Recursively fills \a shift of \a day, and all subsequent shifts, of \a days.
+     *
+     * On success, returns \c true with \a days complete. Otherwise returns \c false, having
+     * undone every change made to \a days, the constraints and the scheduler.
+     */
+    bool search(Roster &days, const int day, const int shift, const int daysInMonth,
+                const NurseSet &allNurses, SearchBudget &budget)
+    {
+        // If the day is complete, commit it, and move on to the next day (if any).
+        if (shift == days.shiftCount()) {
+            notifyDayCommitted(days, day);
+            if (day+1 == daysInMonth) {
+                return true;
+            }
+            days.appendDay();
+            if (search(days, day+1, 0, daysInMonth, allNurses, budget)) {
+                return true;
+            }
+            days.removeLastDay();
+            notifyDayUncommitted(days, day);
+            return false;
+        }
+
+        // Check the search limits.
+        if (((maxNodes > 0) && (budget.nodes >= maxNodes)) ||
+            ((maxMilliseconds > 0) && (budget.timer.hasExpired(maxMilliseconds))) ||
+            (isCancelled())) {
+            budget.exhausted = true;
+        }
+        if (budget.exhausted) {
+            return false;
+        }
+        ++budget.nodes;
+
+        // Rank the candidate nurses for this shift. These temporaries are taken from the scratch
+        // pool, and handed back on leaving this node (deeper nodes take and hand back their own).
+        const ScratchPool::Mark mark = scratch.mark();
+        const int headcount = this->headcount(day, shift);
+        QVector<NurseId> &rankedNurses = scratch.nurseList();
+        rankNurses(day, shift, candidatesFor(shift, days, allNurses), rankedNurses);
+        if (rankedNurses.size() < headcount) {
+            qCDebug(lcGenerator) << "backtracking from the" << days.shiftName(shift)
+                                 << "shift of day" << day+1;
+            ++counters.backtracks[days.shiftName(shift)];
+            scratch.release(mark);
+            return false;
+        }
+
+        // Try each combination of headcount ranked nurses, in lexicographic order of rank.
+        QVector<int> &chosen = scratch.nurseList(); // Indexes into rankedNurses.
+        QVector<NurseId> &chosenNurses = scratch.nurseList();
+        for (int index = 0; index < headcount; ++index) {
+            chosen.append(index);
+        }
+        do {
+            chosenNurses.resize(0);
+            foreach (const int index, chosen) {
+                chosenNurses.append(rankedNurses.at(index));
+            }
+            assign(days, day, shift, chosenNurses);
+            if (forwardCheck(days, shift, allNurses) &&
+                search(days, day, shift+1, daysInMonth, allNurses, budget)) {
+                scratch.release(mark);
+                return true;
+            }
+            for (int count = 0; count < headcount; ++count) {
+                unassign(days, day, shift);
+            }
+        } while ((!budget.exhausted) && nextCombination(chosen, rankedNurses.size()));
+        if (!budget.exhausted) {
+            ++counters.backtracks[days.shiftName(shift)]; // Every combination failed.
+        }
+        scratch.release(mark);
+        return false;
+    }
+
+    /*!
+     * Returns \c false if, given the assignments so far, the remaining shifts (after \a shift) of
+     * the last day of \a days cannot possibly all be filled; \c true otherwise.
+     *
+     * Each remaining shift must have enough candidates of its own, and (since the candidates are
+     * subject to the same constraints, such as AtMostOneShiftPerDay) enough candidates between them.
+     */
+    bool forwardCheck(const Roster &days, const int shift, const NurseSet &allNurses) const
+    {
+        const ScratchPool::Mark mark = scratch.mark();
+        NurseSet &remainingCandidates = scratch.nurseSet(allNurses);
+        remainingCandidates.fill(false);
+        int remainingNurses = 0;
+        bool feasible = true;
+        for (int laterShift = shift+1; (feasible) && (laterShift < days.shiftCount());
+             ++laterShift) {
+            const NurseSet &candidates = candidatesFor(laterShift, days, allNurses);
+            feasible = (candidates.count() >= headcount(days.size()-1, laterShift));
+            remainingCandidates.unite(candidates);
+            remainingNurses += headcount(days.size()-1, laterShift);
+        }
+        feasible = (feasible) && (remainingCandidates.count() >= remainingNurses);
+        scratch.release(mark);
+        return feasible;
+    }
+
+    /*!
+     * Appends up to \a count of the scheduler's next nurses from \a available to \a chosen, for
+     * \a shift of \a day, as per SchedulerInterface::appendNextNurses, counting the call in this
+     * generator's metrics.
+     */
+    void chooseNurses(const int day, const int shift, const NurseSet &available, const int count,
+                      QVector<NurseId> &chosen)
+    {
+        QElapsedTimer timer;
+        if (timed) {
+            timer.start();
+        }
+        scheduler->onShift(monthStart.addDays(day), shift);
+        scheduler->appendNextNurses(available, count, chosen);
+        ++counters.schedulerCalls;
+        if (timed) {
+            counters.schedulerNanoseconds += timer.nsecsElapsed();
+        }
+    }
+
+    /*!
+     * Appends all of \a available to \a ranked, in the scheduler's order for \a shift of \a day,
+     * as per SchedulerInterface::appendRankedNurses, counting the call in this generator's metrics.
+     */
+    void rankNurses(const int day, const int shift, const NurseSet &available,
+                    QVector<NurseId> &ranked)
+    {
+        QElapsedTimer timer;
+        if (timed) {
+            timer.start();
+        }
+        scheduler->onShift(monthStart.addDays(day), shift);
+        scheduler->appendRankedNurses(available, ranked);
+        ++counters.schedulerCalls;
+        if (timed) {
+            counters.schedulerNanoseconds += timer.nsecsElapsed();
+        }
+    }
+
+    /*!
+     * Assigns \a nurse to \a shift of \a day, notifying the constraints and scheduler.
+     */
+    void assign(Roster &days, const int day, const int shift, const NurseId nurse)
+    {
+        days.assign(day, shift, nurse);
+        availability.onAssigned(nurse);
+        scheduler->onShift(monthStart.addDays(day), shift);
+        scheduler->onAssigned(nurse);
+        notifyAssigned(nurse, day, shift);
+    }
+
+    /*!
+     * Assigns all of \a nurses to \a shift of \a day, notifying the constraints, and the scheduler
+     * of them as a single choice (see SchedulerInterface::onShiftAssigned).
+     */
+    void assign(Roster &days, const int day, const int shift, const QVector<NurseId> &nurses)
+    {
+        foreach (const NurseId nurse, nurses) {
+            days.assign(day, shift, nurse);
+            availability.onAssigned(nurse);
+            notifyAssigned(nurse, day, shift);
+        }
+        scheduler->onShift(monthStart.addDays(day), shift);
+        scheduler->onShiftAssigned(nurses);
+    }
+
+    /*!
+     * Undoes the most recent assign() to \a shift of \a day.
+     */
+    void unassign(Roster &days, const int day, const int shift)
+    {
+        const NurseId nurse = days.unassign(day, shift);
+        notifyUnassigned(nurse, day, shift);
+        availability.onUnassigned(nurse);
+        scheduler->onUnassigned(nurse);
+    }
+
+    /*!
+     * Advances \a chosen (a strictly increasing list of indexes less than \a size) to the next
+     * combination in lexicographic order.
+     *
+     * Returns \c false if \a chosen was already the last combination.
+     */
+    static bool nextCombination(QVector<int> &chosen, const int size)
+    {
+        int index = chosen.size()-1;
+        while ((index >= 0) && (chosen.at(index) == size - chosen.size() + index)) {
+            --index;
+        }
+        if (index < 0) {
+            return false;
+        }
+        ++chosen[index];
+        for (++index; index < chosen.size(); ++index) {
+            chosen[index] = chosen.at(index-1) + 1;
+        }
+        return true;
+    }
 
     /*!
      * Returns the number of days in the \a month of \a year.
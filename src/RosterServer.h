@@ -0,0 +1,584 @@
+#ifndef __ROSTER_SERVER_H__
+#define __ROSTER_SERVER_H__
+
+#include "CarryIn.h"
+#include "JsonWriter.h"
+#include "Logging.h"
+#include "NurseListReader.h"
+#include "RosterGenerator.h"
+#include "SchedulerInterface.h"
+
+#include <QBuffer>
+#include <QDate>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonDocument>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QThread>
+#include <QThreadPool>
+
+namespace Cogent {
+
+/*!
+ * \brief Serves roster requests on a local socket (or named pipe on Windows), keeping each ward's
+ * nurses and generated rosters in memory between requests.
+ *
+ * This avoids the cost of starting the roster tool, and reloading its rules, nurses and carried-in
+ * state, for every roster, as interactive clients (such as a scheduling UI) would otherwise pay.
+ *
+ * Requests and responses are JSON objects, one per line. Each request has a "command", and may
+ * have an "id", which is echoed in the response (since responses are sent as each request
+ * completes, which is not necessarily the order in which they were received). For example:
+ *
+ *     { "id": 1, "command": "nurses", "ward": "east", "nurses": [ "Alice", "Bob", ... ] }
+ *     { "id": 2, "command": "nurses", "ward": "west", "file": "west/nurses.txt" }
+ *     { "id": 3, "command": "generate", "ward": "east", "month": "2018-06" }
+ *     { "id": 4, "command": "regenerate", "ward": "east", "month": "2018-06" }
+ *     { "id": 5, "command": "repair", "ward": "east", "month": "2018-06",
+ *       "removed": [ "Alice" ], "blocked": { "Bob": [ "2018-06-20", "2018-06-21" ] } }
+ *
+ * The "nurses" command sets a ward's nurses, either directly or from a nurses list file (see
+ * NurseListReader; set "skipDups" to skip duplicate names), responding with the number of nurses.
+ * Files may only be read from within the directory given to setNurseListDirectory, if any.
+ * The "ward" may be omitted (or empty) in all commands, for a default ward.
+ *
+ * The "generate" command generates the given month's roster for the ward, responding with the
+ * roster (in the same form as RosterGenerator::generate returns) as "roster". The roster is kept,
+ * and if the ward's previous month's roster was kept too, the new roster continues on from it:
+ * from the state carried out of every kept month before it (see CarryIn), and from the
+ * scheduler's history as of the end of the previous month, so shifts are shared out fairly across
+ * months too. The "regenerate" command does the same, but with a differently seeded scheduler each
+ * time (see SchedulerInterface::setSeed), so as to offer an alternative roster. Either way, any
+ * kept rosters for later months of the ward are discarded, since they continued on from a roster
+ * that has now been replaced.
+ *
+ * The "repair" command repairs the ward's kept roster for the given month (see
+ * RosterGenerator::repair), for any "removed" nurses, and any nurses "blocked" from working on
+ * given dates, keeping as much of the roster as it can. The repaired roster replaces the kept one,
+ * as per "generate".
+ *
+ * Errors are reported as an "error" message in the response, instead of any other result.
+ * Requests longer than the maximum request size (see setMaxRequestSize) are rejected, and a client
+ * that sends that much without ending its request is disconnected.
+ *
+ * Each ward keeps one configured RosterGenerator, so its rules are applied, and its nurses
+ * interned, only once, however many requests it serves. Requests are handled concurrently on a
+ * thread pool, though each ward's generator handles one request at a time. Note, a month only
+ * continues on from its previous month if that month's roster has been kept by the time generation
+ * starts, so clients should await each month's response before requesting the next month.
+ *
+ * Schedulers that cannot be cloned (see SchedulerInterface::clone) simply carry on from whatever
+ * they last scheduled, whichever month that was for.
+ */
+class RosterServer
+{
+
+public:
+    /*!
+     * \brief Function to configure (eg add constraints to) each request's RosterGenerator.
+     */
+    typedef RosterGenerator::Configurator Configurator;
+
+    /*!
+     * \brief Constructs a server that applies \a configure to each ward's RosterGenerator.
+     */
+    explicit RosterServer(const Configurator &configure = Configurator())
+        : configure(configure), maxRequestSize(defaultMaxRequestSize())
+    {
+        QObject::connect(&server, &QLocalServer::newConnection, &server, [this]() {
+            while (QLocalSocket * const socket = server.nextPendingConnection()) {
+                qCDebug(lcServer) << "client connected";
+                socket->setReadBufferSize(maxRequestSize);
+                QObject::connect(socket, &QLocalSocket::readyRead, socket, [this, socket]() {
+                    readRequests(socket);
+                });
+                QObject::connect(socket, &QLocalSocket::disconnected,
+                                 socket, &QLocalSocket::deleteLater);
+            }
+        });
+    }
+
+    /*!
+     * \brief Destroys the server, after waiting for any requests in progress.
+     */
+    ~RosterServer()
+    {
+        server.close();
+        pool.waitForDone();
+    }
+
+    /*!
+     * \brief Sets the maximum number of requests to handle concurrently.
+     *
+     * The default is QThread::idealThreadCount().
+     */
+    void setMaxThreadCount(const int maxThreads)
+    {
+        pool.setMaxThreadCount(maxThreads);
+    }
+
+    /*!
+     * \brief Default maximum size, in bytes, of a single request line; see setMaxRequestSize.
+     */
+    static int defaultMaxRequestSize()
+    {
+        return 1024 * 1024;
+    }
+
+    /*!
+     * \brief Sets the maximum size, in bytes, of a single request line (including its newline) to
+     * \a maxBytes.
+     *
+     * This bounds how much each client can make the server buffer. Must be set before listening.
+     */
+    void setMaxRequestSize(const int maxBytes)
+    {
+        Q_ASSERT(maxBytes > 0);
+        maxRequestSize = maxBytes;
+    }
+
+    /*!
+     * \brief Allows "nurses" requests to read nurses list files within \a directory (or its
+     * subdirectories), given relative to it.
+     *
+     * By default, no files may be read, since clients could otherwise read any file the server
+     * can. Must be set before listening. Returns \c false if \a directory does not exist.
+     */
+    bool setNurseListDirectory(const QString &directory)
+    {
+        nurseListDirectory = QFileInfo(directory).canonicalFilePath();
+        return !nurseListDirectory.isEmpty();
+    }
+
+    /*!
+     * \brief Starts listening for connections on the local socket called \a name, replacing any
+     * stale socket left by a server that did not shut down cleanly.
+     *
+     * Fails if another server is still listening on \a name. The socket is only accessible to the
+     * current user.
+     *
+     * Returns \c true on success; \c false otherwise.
+     */
+    bool listen(const QString &name)
+    {
+        QLocalSocket probe;
+        probe.connectToServer(name);
+        if (probe.waitForConnected(1000)) {
+            qCWarning(lcServer) << "another server is already listening on" << name;
+            probe.disconnectFromServer();
+            return false;
+        }
+        if ((probe.error() == QLocalSocket::ConnectionRefusedError) ||
+            (probe.error() == QLocalSocket::ServerNotFoundError)) {
+            QLocalServer::removeServer(name); // Stale, so no longer served by anyone.
+        }
+        server.setSocketOptions(QLocalServer::UserAccessOption);
+        if (!server.listen(name)) {
+            qCWarning(lcServer) << "failed to listen on" << name << server.errorString();
+            return false;
+        }
+        qCDebug(lcServer) << "listening on" << server.fullServerName();
+        return true;
+    }
+
+    /*!
+     * \brief Sets the nurses of the ward named \a ward to \a nurses.
+     *
+     * This is thread-safe.
+     */
+    void setNurses(const QString &ward, const QStringList &nurses)
+    {
+        QMutexLocker locker(&mutex);
+        wards[ward].nurses = nurses;
+    }
+
+    /*!
+     * \brief Handles a single \a request line, returning the response line.
+     *
+     * This is thread-safe, so may be called concurrently for different requests.
+     */
+    QByteArray handle(const QByteArray &request)
+    {
+        if (request.size() > maxRequestSize) {
+            return respond(QVariantMap{ { QStringLiteral("error"),
+                QStringLiteral("request exceeds %1 bytes").arg(maxRequestSize) } });
+        }
+        QJsonParseError error;
+        const QJsonDocument document = QJsonDocument::fromJson(request, &error);
+        if (!document.isObject()) {
+            return respond(QVariantMap{ { QStringLiteral("error"),
+                QStringLiteral("invalid request: %1").arg(error.errorString()) } });
+        }
+        const QVariantMap map = document.toVariant().toMap();
+        const QString command = map.value(QStringLiteral("command")).toString();
+        const QString ward = map.value(QStringLiteral("ward")).toString();
+        qCDebug(lcServer) << "handling" << command << "for ward" << ward;
+
+        QVariantMap response;
+        if (command == QStringLiteral("nurses")) {
+            response = loadNurses(ward, map);
+        } else if ((command == QStringLiteral("generate")) ||
+                   (command == QStringLiteral("regenerate"))) {
+            response = generate(ward, map.value(QStringLiteral("month")).toString(),
+                                command == QStringLiteral("regenerate"));
+        } else if (command == QStringLiteral("repair")) {
+            response = repair(ward, map);
+        } else {
+            response.insert(QStringLiteral("error"),
+                            QStringLiteral("unknown command: %1").arg(command));
+        }
+        if (map.contains(QStringLiteral("id"))) {
+            response.insert(QStringLiteral("id"), map.value(QStringLiteral("id")));
+        }
+        return respond(response);
+    }
+
+protected:
+    /*!
+     * \brief A kept month, and the state later months continue on from.
+     */
+    struct Month {
+        QVariantMap roster;
+        CarryIn carryOut; // Carried out of this and every kept month before it.
+        QSharedPointer<const SchedulerInterface> scheduler; // As at the end of the month, if any.
+        int seed = 0;     // The scheduler seed the roster was generated with.
+    };
+
+    /*!
+     * \brief A ward's configured generator, shared by all of the ward's requests.
+     */
+    struct WardGenerator {
+        QMutex mutex;              // Guards the rest, for the duration of each request.
+        RosterGenerator generator;
+        bool configured = false;   // Whether configure has been applied to generator yet.
+        QSharedPointer<const SchedulerInterface> initial; // The configured scheduler, if clonable.
+    };
+
+    /*!
+     * \brief A ward's state, kept between requests.
+     */
+    struct Ward {
+        QStringList nurses;
+        QMap<QString, Month> months;             // Kept months, by month ('YYYY-MM').
+        QHash<QString, int> seeds;               // Last scheduler seed used, by month.
+        QSharedPointer<WardGenerator> generator; // Created by the ward's first roster request.
+    };
+
+    const Configurator configure;
+    int maxRequestSize;          // In bytes, including the newline.
+    QString nurseListDirectory;  // Canonical path nurses list files must be within, if any.
+    QMutex mutex;                // Guards wards.
+    QHash<QString, Ward> wards;
+    QLocalServer server;
+    QThreadPool pool;            // Last, so it is destroyed (and waited for) first.
+
+    /*!
+     * \brief Handles a "nurses" \a request for \a ward.
+     */
+    QVariantMap loadNurses(const QString &ward, const QVariantMap &request)
+    {
+        QStringList nurses;
+        if (request.contains(QStringLiteral("file"))) {
+            const QString fileName = request.value(QStringLiteral("file")).toString();
+            if (nurseListDirectory.isEmpty()) {
+                return QVariantMap{ { QStringLiteral("error"),
+                                      QStringLiteral("nurses list files are not enabled") } };
+            }
+            // Resolve any symbolic links and '..'s before checking the file is within the
+            // directory, so neither can escape it.
+            const QDir directory(nurseListDirectory);
+            const QFileInfo info(directory.filePath(fileName));
+            const QString path = info.canonicalFilePath();
+            const QString relativePath = directory.relativeFilePath(path);
+            if ((path.isEmpty()) || (!info.isFile()) || (relativePath == QStringLiteral("..")) ||
+                (relativePath.startsWith(QStringLiteral("../"))) ||
+                (QDir::isAbsolutePath(relativePath))) {
+                return QVariantMap{ { QStringLiteral("error"),
+                                      QStringLiteral("no such nurses list: %1").arg(fileName) } };
+            }
+            QFile file(path);
+            if (!file.open(QFile::ReadOnly|QFile::Text)) {
+                return QVariantMap{ { QStringLiteral("error"),
+                    QStringLiteral("failed to open %1 for reading").arg(file.fileName()) } };
+            }
+            nurses = NurseListReader::read(
+                file, request.value(QStringLiteral("skipDups")).toBool()).toStringList();
+        } else {
+            nurses = request.value(QStringLiteral("nurses")).toStringList();
+        }
+        setNurses(ward, nurses);
+        return QVariantMap{ { QStringLiteral("nurses"), nurses.size() } };
+    }
+
+    /*!
+     * \brief Handles a "generate" (or, if \a regenerate is \c true, "regenerate") request for
+     * \a month ('YYYY-MM') of \a ward.
+     */
+    QVariantMap generate(const QString &ward, const QString &month, const bool regenerate)
+    {
+        const QDate firstDay = parseMonth(month);
+        if (!firstDay.isValid()) {
+            return QVariantMap{ { QStringLiteral("error"),
+                                  QStringLiteral("invalid month: %1").arg(month) } };
+        }
+        const QString key = monthKey(firstDay);
+
+        // Take what we need from the ward's state, then generate without holding the lock.
+        QStringList nurses;
+        Month previous;
+        Month generated;
+        QSharedPointer<WardGenerator> wardGenerator;
+        {
+            QMutexLocker locker(&mutex);
+            Ward &state = wards[ward];
+            nurses = state.nurses;
+            previous = state.months.value(monthKey(firstDay.addMonths(-1)));
+            if (regenerate) {
+                generated.seed = ++state.seeds[key];
+            }
+            wardGenerator = generatorOf(state);
+        }
+        if (nurses.isEmpty()) {
+            return QVariantMap{ { QStringLiteral("error"), QStringLiteral("have no nurses") } };
+        }
+
+        {
+            QMutexLocker locker(&wardGenerator->mutex);
+            RosterGenerator &generator =
+                prepareGenerator(*wardGenerator, previous.scheduler, generated.seed);
+            generated.roster =
+                generator.generate(firstDay.year(), firstDay.month(), nurses, previous.carryOut);
+            if (generated.roster.isEmpty()) {
+                return QVariantMap{ { QStringLiteral("error"),
+                                      QStringLiteral("no roster found") } };
+            }
+            generated.scheduler =
+                QSharedPointer<const SchedulerInterface>(generator.cloneScheduler());
+        }
+        generated.carryOut = CarryIn::fromRoster(generated.roster, previous.carryOut);
+
+        keep(ward, key, generated);
+        return QVariantMap{ { QStringLiteral("roster"), generated.roster } };
+    }
+
+    /*!
+     * \brief Handles a "repair" \a request for \a ward.
+     */
+    QVariantMap repair(const QString &ward, const QVariantMap &request)
+    {
+        const QDate firstDay = parseMonth(request.value(QStringLiteral("month")).toString());
+        if (!firstDay.isValid()) {
+            return QVariantMap{ { QStringLiteral("error"), QStringLiteral("invalid month: %1")
+                                  .arg(request.value(QStringLiteral("month")).toString()) } };
+        }
+        const QString key = monthKey(firstDay);
+
+        RosterGenerator::Changes changes;
+        foreach (const QString &nurse, request.value(QStringLiteral("removed")).toStringList()) {
+            changes.removedNurses.insert(nurse);
+        }
+        const QVariantMap blocked = request.value(QStringLiteral("blocked")).toMap();
+        for (auto iter = blocked.constBegin(); iter != blocked.constEnd(); ++iter) {
+            foreach (const QString &date, iter.value().toStringList()) {
+                changes.blockedDays.append(
+                    qMakePair(iter.key(), QDate::fromString(date, Qt::ISODate)));
+            }
+        }
+
+        // Take what we need from the ward's state, then repair without holding the lock.
+        QStringList nurses;
+        Month previous;
+        Month existing;
+        QSharedPointer<WardGenerator> wardGenerator;
+        {
+            QMutexLocker locker(&mutex);
+            Ward &state = wards[ward];
+            nurses = state.nurses;
+            previous = state.months.value(monthKey(firstDay.addMonths(-1)));
+            existing = state.months.value(key);
+            wardGenerator = generatorOf(state);
+        }
+        if (existing.roster.isEmpty()) {
+            return QVariantMap{ { QStringLiteral("error"),
+                                  QStringLiteral("no roster to repair for %1").arg(key) } };
+        }
+
+        Month repaired;
+        repaired.seed = existing.seed;
+        {
+            QMutexLocker locker(&wardGenerator->mutex);
+            RosterGenerator &generator =
+                prepareGenerator(*wardGenerator, previous.scheduler, repaired.seed);
+            repaired.roster = generator.repair(firstDay.year(), firstDay.month(),
+                existing.roster.value(key).toList(), nurses, changes, previous.carryOut);
+            if (repaired.roster.isEmpty()) {
+                return QVariantMap{ { QStringLiteral("error"),
+                                      QStringLiteral("no repair found") } };
+            }
+            repaired.scheduler =
+                QSharedPointer<const SchedulerInterface>(generator.cloneScheduler());
+        }
+        repaired.carryOut = CarryIn::fromRoster(repaired.roster, previous.carryOut);
+
+        keep(ward, key, repaired);
+        return QVariantMap{ { QStringLiteral("roster"), repaired.roster } };
+    }
+
+    /*!
+     * \brief Returns \a state's generator, creating it (unconfigured) if need be.
+     *
+     * Must be called with the mutex locked.
+     */
+    static QSharedPointer<WardGenerator> generatorOf(Ward &state)
+    {
+        if (!state.generator) {
+            state.generator.reset(new WardGenerator);
+        }
+        return state.generator;
+    }
+
+    /*!
+     * \brief Returns \a ward's generator, configured (if not already), and with a scheduler that
+     * continues on from \a history (or the configured scheduler, if null), seeded with \a seed.
+     *
+     * Must be called with \a ward's mutex locked.
+     */
+    RosterGenerator &prepareGenerator(WardGenerator &ward,
+                                      const QSharedPointer<const SchedulerInterface> &history,
+                                      const int seed)
+    {
+        if (!ward.configured) {
+            if (configure) {
+                configure(ward.generator);
+            }
+            ward.initial =
+                QSharedPointer<const SchedulerInterface>(ward.generator.cloneScheduler());
+            ward.configured = true;
+        }
+        const QSharedPointer<const SchedulerInterface> start = history ? history : ward.initial;
+        if (start) {
+            SchedulerInterface * const scheduler = start->clone();
+            scheduler->setSeed(quint64(seed));
+            ward.generator.setScheduler(scheduler);
+        }
+        return ward.generator;
+    }
+
+    /*!
+     * \brief Keeps \a kept as the \a month ('YYYY-MM') of \a ward, discarding any later months,
+     * since they continued on from the month replaced.
+     */
+    void keep(const QString &ward, const QString &month, const Month &kept)
+    {
+        QMutexLocker locker(&mutex);
+        QMap<QString, Month> &months = wards[ward].months;
+        for (auto iter = months.upperBound(month); iter != months.end();) {
+            iter = months.erase(iter);
+        }
+        months.insert(month, kept);
+    }
+
+    /*!
+     * \brief Queues each complete request line from \a socket, disconnecting the client if it
+     * sends more than the maximum request size without ending a request.
+     *
+     * The socket's read buffer is limited to the maximum request size, so a full buffer without a
+     * complete line means the request is too long.
+     */
+    void readRequests(QLocalSocket * const socket)
+    {
+        while (socket->canReadLine()) {
+            pool.start(new RequestRunnable(*this, socket, socket->readLine()));
+        }
+        if (socket->bytesAvailable() >= maxRequestSize) {
+            qCWarning(lcServer) << "disconnecting client with over-long request";
+            socket->write(respond(QVariantMap{ { QStringLiteral("error"),
+                QStringLiteral("request exceeds %1 bytes").arg(maxRequestSize) } }));
+            socket->disconnectFromServer();
+        }
+    }
+
+    /*!
+     * \brief Returns the first day of \a month ('YYYY-MM'), or an invalid date if \a month is not
+     * valid.
+     */
+    static QDate parseMonth(const QString &month)
+    {
+        const QStringList parts = month.split(QLatin1Char('-'));
+        return (parts.size() == 2)
+            ? QDate(parts.first().toInt(), parts.last().toInt(), 1) : QDate();
+    }
+
+    /*!
+     * \brief Returns \a response as a single line of compact JSON.
+     */
+    static QByteArray respond(const QVariantMap &response)
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        JsonWriter(&buffer, QJsonDocument::Compact).write(response);
+        QByteArray line = buffer.buffer();
+        if (!line.endsWith('\n')) {
+            line.append('\n');
+        }
+        return line;
+    }
+
+    /*!
+     * \brief Returns the 'YYYY-MM' key for the month of \a date, as RosterGenerator uses.
+     */
+    static QString monthKey(const QDate &date)
+    {
+        return QStringLiteral("%1-%2").arg(date.year()).arg(date.month(), 2, 10, QLatin1Char('0'));
+    }
+
+    /*!
+     * \brief Handles a single request on the thread pool, then sends the response back to the
+     * client on the client's own thread.
+     */
+    class RequestRunnable : public QRunnable
+    {
+
+    public:
+        /*!
+         * \brief Constructs a runnable for \a request from \a client, on the client's thread.
+         */
+        RequestRunnable(RosterServer &server, QLocalSocket * const client,
+                        const QByteArray &request)
+            : server(server), client(new QPointer<QLocalSocket>(client)), request(request)
+        { }
+
+        void run() override
+        {
+            // Note, the guarded pointer is only shared here, not copied; it is only resolved once
+            // back on the client's thread, where the client may be deleted.
+            const QByteArray response = server.handle(request);
+            const QSharedPointer<const QPointer<QLocalSocket>> client = this->client;
+            QMetaObject::invokeMethod(&server.server, [client, response]() {
+                if (QLocalSocket * const socket = *client) {
+                    socket->write(response);
+                }
+            }, Qt::QueuedConnection);
+        }
+
+    protected:
+        RosterServer &server;
+        const QSharedPointer<const QPointer<QLocalSocket>> client; // Created on client's thread.
+        const QByteArray request;
+    };
+
+};
+
+} // end Cogent namespace
+
+#endif // __ROSTER_SERVER_H__
@@ -0,0 +1,313 @@
+#ifndef __ROSTER_VALIDATOR_H__
+#define __ROSTER_VALIDATOR_H__
+
+#include "BinaryRoster.h"
+#include "ConstraintInterface.h"
+#include "Logging.h"
+#include "NurseTable.h"
+
+#include <QDate>
+#include <QDebug>
+#include <QMap>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QVector>
+
+#include <limits>
+
+namespace Cogent {
+
+/*!
+ * \brief Checks existing rosters (such as manually edited ones) against a set of constraints,
+ * reporting every violation.
+ *
+ * Each ward's months are checked in a single chronological pass, replaying each assignment through
+ * the same incremental notifications the generator uses (see ConstraintInterface), so checking a
+ * roster costs about as much as generating it did. Each shift is checked just as the generator
+ * fills it: each constraint filters all nurses for that shift, as of the assignments before it,
+ * and any nurse rostered on that shift but filtered out is in violation of that constraint.
+ *
+ * Consecutive months of the same ward continue on from each other (as per CarryIn), using each
+ * nurse's running streak; a gap between months starts the next month afresh.
+ */
+class RosterValidator
+{
+
+public:
+    /*!
+     * \brief A single nurse's shift that violates a constraint.
+     */
+    struct Violation {
+        QString ward;       // Empty for single-ward rosters.
+        QDate date;
+        QString shift;
+        QString nurse;
+        QString constraint; // The constraint's name (see ConstraintInterface::name).
+
+        /*!
+         * \brief Returns this violation as a map, suitable for JSON output.
+         */
+        QVariantMap toVariantMap() const
+        {
+            QVariantMap map{
+                { QStringLiteral("date"), date.toString(Qt::ISODate) },
+                { QStringLiteral("shift"), shift },
+                { QStringLiteral("nurse"), nurse },
+                { QStringLiteral("constraint"), constraint },
+            };
+            if (!ward.isEmpty()) {
+                map.insert(QStringLiteral("ward"), ward);
+            }
+            return map;
+        }
+    };
+
+    /*!
+     * \brief Constructs a validator for rosters of the default shifts, with no constraints.
+     */
+    RosterValidator() : shiftNames(Roster::defaultShiftNames()) { }
+
+    /*!
+     * \brief Adds \a constraint to check rosters against, taking ownership of it.
+     */
+    void addConstraint(ConstraintInterface * const constraint)
+    {
+        constraints.append(QSharedPointer<ConstraintInterface>(constraint));
+    }
+
+    /*!
+     * \brief Sets the shifts of each day to \a names, in the order in which they are filled.
+     *
+     * Shifts not named in \a names are ignored, with a warning.
+     */
+    void setShifts(const QStringList &names)
+    {
+        shiftNames = names;
+    }
+
+    /*!
+     * \brief Returns every violation in \a rosters, in ward, date, shift and constraint order.
+     *
+     * \a rosters may be either a single ward's roster (month names mapped to lists of days, as per
+     * RosterGenerator::generate), or a batch of rosters (ward names mapped to single ward rosters,
+     * as per BatchGenerator::generate). Other entries, such as "created", are skipped.
+     */
+    QVector<Violation> validate(const QVariantMap &rosters)
+    {
+        QMap<QString, QVariantMap> wards;
+        for (auto iter = rosters.constBegin(); iter != rosters.constEnd(); ++iter) {
+            if (iter.value().type() == QVariant::List) {
+                wards[QString()].insert(iter.key(), iter.value());
+            } else if (iter.value().type() == QVariant::Map) {
+                wards.insert(iter.key(), iter.value().toMap());
+            }
+        }
+
+        QVector<Violation> violations;
+        for (auto ward = wards.constBegin(); ward != wards.constEnd(); ++ward) {
+            NurseTable nurses;
+            History history;
+            // Note, QVariantMap keys are sorted, and 'yyyy-MM' keys sort chronologically.
+            for (auto month = ward->constBegin(); month != ward->constEnd(); ++month) {
+                const QDate firstDay = QDate::fromString(month.key(), QStringLiteral("yyyy-MM"));
+                if ((firstDay.isValid()) && (month.value().type() == QVariant::List)) {
+                    const Roster roster =
+                        Roster::fromVariantList(month.value().toList(), nurses, shiftNames);
+                    validate(ward.key(), firstDay, roster, nurses, history, violations);
+                }
+            }
+        }
+        return violations;
+    }
+
+    /*!
+     * \brief Returns every violation in the rosters of the open binary roster \a file, in ward,
+     * date, shift and constraint order.
+     */
+    QVector<Violation> validate(const BinaryRoster &file)
+    {
+        // Map the file's shifts to ours, and its nurses' identifiers to a table (in file order).
+        QVector<int> shifts;
+        for (int shift = 0; shift < file.shiftCount(); ++shift) {
+            shifts.append(shiftNames.indexOf(file.shiftName(shift)));
+            if (shifts.last() < 0) {
+                qCWarning(lcRoster) << "ignoring unknown shift" << file.shiftName(shift);
+            }
+        }
+        NurseTable nurses;
+        for (NurseId nurse = 0; nurse < file.nurseCount(); ++nurse) {
+            nurses.intern(file.nurseName(nurse));
+        }
+
+        // Order the file's rosters by ward, then month.
+        QMap<QString, QMap<QString, int>> wards;
+        for (int roster = 0; roster < file.rosterCount(); ++roster) {
+            wards[file.ward(roster)].insert(file.month(roster), roster);
+        }
+
+        QVector<Violation> violations;
+        for (auto ward = wards.constBegin(); ward != wards.constEnd(); ++ward) {
+            History history;
+            for (auto month = ward->constBegin(); month != ward->constEnd(); ++month) {
+                const QDate firstDay = QDate::fromString(month.key(), QStringLiteral("yyyy-MM"));
+                if (!firstDay.isValid()) {
+                    continue;
+                }
+                Roster roster(shiftNames);
+                roster.reserve(file.days(month.value()));
+                for (int day = 0; day < file.days(month.value()); ++day) {
+                    roster.appendDay();
+                    for (int shift = 0; shift < shifts.size(); ++shift) {
+                        if (shifts.at(shift) < 0) {
+                            continue;
+                        }
+                        foreach (const NurseId nurse, file.nurses(month.value(), day, shift)) {
+                            roster.assign(day, shifts.at(shift), nurse);
+                        }
+                    }
+                }
+                validate(ward.key(), firstDay, roster, nurses, history, violations);
+            }
+        }
+        return violations;
+    }
+
+protected:
+    QVector<QSharedPointer<ConstraintInterface>> constraints;
+    QStringList shiftNames; // Names of the shifts of each day, in the order they're filled.
+
+    /*!
+     * \brief Each nurse's running streak across a ward's months, indexed by NurseId.
+     *
+     * Days are Julian day numbers, so that streaks carry across month boundaries unchanged.
+     */
+    struct History {
+        QDate nextDay;                  // The day after the last day checked, if any.
+        QVector<qint64> lastDayWorked;  // Or never(), if not worked yet.
+        QVector<qint64> firstDayOfStreak;
+    };
+
+    static qint64 never()
+    {
+        return std::numeric_limits<qint64>::min();
+    }
+
+    /*!
+     * \brief Appends every violation in \a roster, the month of \a ward beginning \a firstDay, to
+     * \a violations, continuing on from (and then updating) the ward's \a history.
+     */
+    void validate(const QString &ward, const QDate &firstDay, const Roster &roster,
+                  const NurseTable &nurses, History &history, QVector<Violation> &violations)
+    {
+        // Carry in each nurse's streak, if this month directly follows the last one checked.
+        const int nurseCount = nurses.size();
+        const qint64 firstJulianDay = firstDay.toJulianDay();
+        const bool carriedIn = (history.nextDay == firstDay);
+        if (!carriedIn) {
+            history.lastDayWorked.fill(never(), nurseCount);
+            history.firstDayOfStreak.fill(never(), nurseCount);
+        }
+        while (history.lastDayWorked.size() < nurseCount) {
+            history.lastDayWorked.append(never());
+            history.firstDayOfStreak.append(never());
+        }
+        QVector<CarryIn::Streak> streaks(nurseCount, CarryIn::Streak{ 0, 0 });
+        for (NurseId nurse = 0; (carriedIn) && (nurse < nurseCount); ++nurse) {
+            const qint64 lastDay = history.lastDayWorked.at(nurse);
+            if (lastDay == firstJulianDay - 1) {
+                streaks[nurse].daysWorked = int(lastDay - history.firstDayOfStreak.at(nurse) + 1);
+            } else if (lastDay != never()) {
+                streaks[nurse].daysOff = int(firstJulianDay - 1 - lastDay);
+            }
+        }
+        foreach (auto &constraint, constraints) {
+            constraint->reset(nurseCount);
+            if (carriedIn) {
+                constraint->onCarryIn(streaks);
+            }
+        }
+
+        // Check each shift, then notify the constraints of its assignments.
+        Roster daysSoFar(shiftNames);
+        daysSoFar.reserve(roster.size());
+        NurseSet allowed(nurseCount), rostered(nurseCount);
+        for (int day = 0; day < roster.size(); ++day) {
+            daysSoFar.appendDay();
+            for (int shift = 0; shift < roster.shiftCount(); ++shift) {
+                for (int index = 0; index < constraints.size(); ++index) {
+                    allowed.fill(true);
+                    constraints.at(index)->constrain(allowed, shift, daysSoFar);
+                    for (int slot = 0; slot < roster.count(day, shift); ++slot) {
+                        if (!allowed.contains(roster.at(day, shift, slot))) {
+                            violations.append(violation(ward, firstDay.addDays(day), shift,
+                                nurses.name(roster.at(day, shift, slot)), index));
+                        }
+                    }
+                }
+                rostered.fill(false);
+                for (int slot = 0; slot < roster.count(day, shift); ++slot) {
+                    const NurseId nurse = roster.at(day, shift, slot);
+                    if (rostered.contains(nurse)) {
+                        // Listed twice on the same shift, so check again as of the first listing.
+                        checkAgain(ward, firstDay.addDays(day), shift, nurse, nurses,
+                                   daysSoFar, violations);
+                    }
+                    rostered.insert(nurse);
+                    daysSoFar.assign(day, shift, nurse);
+                    foreach (auto &constraint, constraints) {
+                        constraint->onAssigned(nurse, day, shift);
+                    }
+                }
+            }
+            foreach (auto &constraint, constraints) {
+                constraint->onDayCommitted(daysSoFar, day);
+            }
+
+            // Update each rostered nurse's streak.
+            const qint64 julianDay = firstJulianDay + day;
+            for (int shift = 0; shift < roster.shiftCount(); ++shift) {
+                for (int slot = 0; slot < roster.count(day, shift); ++slot) {
+                    const NurseId nurse = roster.at(day, shift, slot);
+                    if (history.lastDayWorked.at(nurse) != julianDay - 1) {
+                        history.firstDayOfStreak[nurse] = julianDay;
+                    }
+                    history.lastDayWorked[nurse] = julianDay;
+                }
+            }
+        }
+        history.nextDay = firstDay.addDays(roster.size());
+    }
+
+    /*!
+     * \brief Appends a violation to \a violations for each constraint that would not allow
+     * \a nurse (of \a nurses) on \a shift of \a date again, given \a daysSoFar.
+     */
+    void checkAgain(const QString &ward, const QDate &date, const int shift, const NurseId nurse,
+                    const NurseTable &nurses, const Roster &daysSoFar,
+                    QVector<Violation> &violations)
+    {
+        for (int index = 0; index < constraints.size(); ++index) {
+            NurseSet single(nurses.size());
+            single.insert(nurse);
+            if (constraints.at(index)->constrain(single, shift, daysSoFar) > 0) {
+                violations.append(violation(ward, date, shift, nurses.name(nurse), index));
+            }
+        }
+    }
+
+    /*!
+     * \brief Returns a violation of the constraint at \a index by \a nurse, on \a shift of \a date.
+     */
+    Violation violation(const QString &ward, const QDate &date, const int shift,
+                        const QString &nurse, const int index) const
+    {
+        return Violation{ ward, date, shiftNames.at(shift), nurse, constraints.at(index)->name() };
+    }
+
+};
+
+} // end Cogent namespace
+
+#endif // __ROSTER_VALIDATOR_H__
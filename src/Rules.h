@@ -0,0 +1,379 @@
+#ifndef __RULES_H__
+#define __RULES_H__
+
+#include "AtMostConsecutiveDays.h"
+#include "AtMostOneShiftPerDay.h"
+#include "AtMostShiftsPerMonth.h"
+#include "Demand.h"
+#include "Logging.h"
+#include "NoSingleDaysOff.h"
+#include "NurseRecord.h"
+#include "RosterGenerator.h"
+#include "RosterValidator.h"
+
+#include <QByteArray>
+#include <QDebug>
+#include <QJsonDocument>
+#include <QPair>
+#include <QSet>
+#include <QVariantMap>
+#include <QVector>
+
+#include <functional>
+
+namespace Cogent {
+
+/*!
+ * \brief A ward's shift model and constraint parameters, as loaded from a rules file.
+ *
+ * A rules file is a JSON object listing the shifts to fill each day (in the order in which they
+ * are to be filled), and the constraints to apply, such as:
+ *
+ *     {
+ *       "shifts": [
+ *         { "name": "night",   "nurses": 5 },
+ *         { "name": "morning", "nurses": 5 },
+ *         { "name": "evening", "nurses": 5 }
+ *       ],
+ *       "constraints": [
+ *         { "type": "AtMostConsecutiveDays", "days": 5 },
+ *         { "type": "AtMostShiftsPerMonth", "shift": "night", "shifts": 5 },
+ *         { "type": "AtMostOneShiftPerDay" },
+ *         { "type": "NoSingleDaysOff" }
+ *       ]
+ *     }
+ *
+ * The above is equivalent to the built-in rules (see defaults).
+ *
+ * Each shift's number of nurses may also be overridden for days of the week, and for particular
+ * dates (such as public holidays), either of which may be zero. For example:
+ *
+ *     { "name": "morning", "nurses": 5, "weekdays": { "saturday": 3, "sunday": 3 } }
+ *
+ *     "holidays": { "2018-12-25": { "morning": 2, "evening": 2 } }
+ *
+ * Shifts may also list skills that every nurse on that shift must have (according to the nurses'
+ * records; see NurseRecord), such as:
+ *
+ *     { "name": "night", "nurses": 5, "skills": [ "icu" ] }
+ *
+ * The rules are validated, and compiled into constraint factories (with all shift names resolved
+ * to indexes), once when loaded. Applying them to each RosterGenerator (see configure) then costs
+ * no more than adding the built-in constraints would.
+ */
+class Rules
+{
+
+public:
+    /*!
+     * \brief Constructs an empty (and invalid) set of rules.
+     */
+    Rules() { }
+
+    /*!
+     * \brief Returns the built-in rules: the default shifts, with \a nursesPerShift nurses each,
+     * and the four standard constraints.
+     */
+    static Rules defaults(const int nursesPerShift = 5)
+    {
+        Rules rules;
+        foreach (const QString &shiftName, Roster::defaultShiftNames()) {
+            rules.shifts.append(qMakePair(shiftName, nursesPerShift));
+        }
+        rules.shiftDemand = Demand(rules.nursesPerShift());
+        rules.appendConsecutiveDays(5);
+        rules.appendShiftsPerMonth(Roster::NightShift, 5);
+        rules.appendOneShiftPerDay();
+        rules.appendNoSingleDaysOff();
+        return rules;
+    }
+
+    /*!
+     * \brief Returns the rules read from the JSON rules file content \a json.
+     *
+     * If \a json is not a valid rules file, returns invalid rules, and (if not \c nullptr) sets
+     * \a ok to \c false.
+     */
+    static Rules fromJson(const QByteArray &json, bool * const ok = nullptr)
+    {
+        QJsonParseError error;
+        const QJsonDocument document = QJsonDocument::fromJson(json, &error);
+        if (!document.isObject()) {
+            qCWarning(lcGenerator) << "failed to parse rules" << error.errorString();
+            if (ok) {
+                *ok = false;
+            }
+            return Rules();
+        }
+        const Rules rules = fromVariantMap(document.toVariant().toMap());
+        if (ok) {
+            *ok = rules.isValid();
+        }
+        return rules;
+    }
+
+    /*!
+     * \brief Returns the rules in \a map (a parsed rules file), or invalid rules if \a map is not
+     * valid.
+     */
+    static Rules fromVariantMap(const QVariantMap &map)
+    {
+        Rules rules;
+        QSet<QString> shiftNames;
+        foreach (const QVariant &item, map.value(QStringLiteral("shifts")).toList()) {
+            const QString name = item.toMap().value(QStringLiteral("name")).toString();
+            const int nurses = positiveInt(item.toMap(), QStringLiteral("nurses"));
+            if ((name.isEmpty()) || (shiftNames.contains(name)) || (nurses <= 0)) {
+                qCWarning(lcGenerator) << "invalid shift" << item;
+                return Rules();
+            }
+            shiftNames.insert(name);
+            rules.shifts.append(qMakePair(name, nurses));
+            rules.shiftSkills.append(QSet<QString>());
+            foreach (const QString &skill,
+                     item.toMap().value(QStringLiteral("skills")).toStringList()) {
+                rules.shiftSkills.last().insert(skill);
+            }
+        }
+        if (rules.shifts.isEmpty()) {
+            qCWarning(lcGenerator) << "rules have no shifts";
+            return Rules();
+        }
+
+        // Apply any weekday, then holiday, overrides to each shift's number of nurses.
+        rules.shiftDemand = Demand(rules.nursesPerShift());
+        const QVariantList shiftItems = map.value(QStringLiteral("shifts")).toList();
+        for (int shift = 0; shift < shiftItems.size(); ++shift) {
+            const QVariantMap weekdays =
+                shiftItems.at(shift).toMap().value(QStringLiteral("weekdays")).toMap();
+            for (auto iter = weekdays.constBegin(); iter != weekdays.constEnd(); ++iter) {
+                const int dayOfWeek = weekdayNames().indexOf(iter.key()) + Qt::Monday;
+                const int nurses = nonNegativeInt(weekdays, iter.key());
+                if ((dayOfWeek < Qt::Monday) || (nurses < 0)) {
+                    qCWarning(lcGenerator) << "invalid weekday" << iter.key() << "for shift"
+                                           << rules.shifts.at(shift).first;
+                    return Rules();
+                }
+                rules.shiftDemand.setNurses(Qt::DayOfWeek(dayOfWeek), shift, nurses);
+            }
+        }
+        const QVariantMap holidays = map.value(QStringLiteral("holidays")).toMap();
+        for (auto iter = holidays.constBegin(); iter != holidays.constEnd(); ++iter) {
+            const QDate date = QDate::fromString(iter.key(), Qt::ISODate);
+            const QVariantMap holidayShifts = iter.value().toMap();
+            for (auto shiftIter = holidayShifts.constBegin(); shiftIter != holidayShifts.constEnd();
+                 ++shiftIter) {
+                const int shift = rules.shiftIndex(shiftIter.key());
+                const int nurses = nonNegativeInt(holidayShifts, shiftIter.key());
+                if ((!date.isValid()) || (shift < 0) || (nurses < 0)) {
+                    qCWarning(lcGenerator) << "invalid holiday" << iter.key() << shiftIter.key();
+                    return Rules();
+                }
+                rules.shiftDemand.setNurses(date, shift, nurses);
+            }
+        }
+
+        foreach (const QVariant &item, map.value(QStringLiteral("constraints")).toList()) {
+            const QVariantMap constraint = item.toMap();
+            const QString type = constraint.value(QStringLiteral("type")).toString();
+            if (type == QStringLiteral("AtMostConsecutiveDays")) {
+                const int days = positiveInt(constraint, QStringLiteral("days"));
+                if (days <= 0) {
+                    qCWarning(lcGenerator) << "invalid days for" << type;
+                    return Rules();
+                }
+                rules.appendConsecutiveDays(days);
+            } else if (type == QStringLiteral("AtMostShiftsPerMonth")) {
+                const QString shiftName = constraint.value(QStringLiteral("shift")).toString();
+                const int shift = rules.shiftIndex(shiftName);
+                const int shifts = positiveInt(constraint, QStringLiteral("shifts"));
+                if ((shift < 0) || (shifts <= 0)) {
+                    qCWarning(lcGenerator) << "invalid shift or shifts for" << type;
+                    return Rules();
+                }
+                rules.appendShiftsPerMonth(shift, shifts);
+            } else if (type == QStringLiteral("AtMostOneShiftPerDay")) {
+                rules.appendOneShiftPerDay();
+            } else if (type == QStringLiteral("NoSingleDaysOff")) {
+                rules.appendNoSingleDaysOff();
+            } else {
+                qCWarning(lcGenerator) << "unknown constraint type" << type;
+                return Rules();
+            }
+        }
+        return rules;
+    }
+
+    /*!
+     * \brief Returns \c true if these rules have at least one shift; \c false otherwise.
+     */
+    bool isValid() const
+    {
+        return !shifts.isEmpty();
+    }
+
+    /*!
+     * \brief Returns the names of the shifts to fill each day, in the order they are filled.
+     */
+    QStringList shiftNames() const
+    {
+        QStringList names;
+        for (auto iter = shifts.constBegin(); iter != shifts.constEnd(); ++iter) {
+            names.append(iter->first);
+        }
+        return names;
+    }
+
+    /*!
+     * \brief Returns the number of nurses to fill each shift with, indexed by shift.
+     */
+    QVector<int> nursesPerShift() const
+    {
+        QVector<int> nurses;
+        for (auto iter = shifts.constBegin(); iter != shifts.constEnd(); ++iter) {
+            nurses.append(iter->second);
+        }
+        return nurses;
+    }
+
+    /*!
+     * \brief Returns the number of nurses to fill each shift of each day with, including any
+     * weekday and holiday overrides.
+     */
+    Demand demand() const
+    {
+        return shiftDemand;
+    }
+
+    /*!
+     * \brief Returns the types of the constraints, in the order in which they are applied.
+     */
+    QStringList constraintTypes() const
+    {
+        QStringList types;
+        for (auto iter = constraints.constBegin(); iter != constraints.constEnd(); ++iter) {
+            types.append(iter->first);
+        }
+        return types;
+    }
+
+    /*!
+     * \brief Returns a copy of these rules without any constraints of the given \a type.
+     */
+    Rules withoutConstraint(const QString &type) const
+    {
+        Rules rules(*this);
+        for (int index = rules.constraints.size()-1; index >= 0; --index) {
+            if (rules.constraints.at(index).first == type) {
+                rules.constraints.remove(index);
+            }
+        }
+        return rules;
+    }
+
+    /*!
+     * \brief Applies these rules' shifts, and a new instance of each of their constraints, to
+     * \a generator.
+     */
+    void configure(RosterGenerator &generator) const
+    {
+        Q_ASSERT(isValid());
+        generator.setShifts(shiftNames(), shiftDemand);
+        generator.setShiftSkills(shiftSkills);
+        for (auto iter = constraints.constBegin(); iter != constraints.constEnd(); ++iter) {
+            generator.addConstraint(iter->second());
+        }
+    }
+
+    /*!
+     * \brief Applies these rules' shifts, and a new instance of each of their constraints, to
+     * \a validator.
+     */
+    void configure(RosterValidator &validator) const
+    {
+        Q_ASSERT(isValid());
+        validator.setShifts(shiftNames());
+        for (auto iter = constraints.constBegin(); iter != constraints.constEnd(); ++iter) {
+            validator.addConstraint(iter->second());
+        }
+    }
+
+protected:
+    typedef std::function<ConstraintInterface *()> ConstraintFactory;
+
+    QVector<QPair<QString, int>> shifts; // Shift names, and nurses per shift, in order.
+    Demand shiftDemand;                  // Nurses per shift, with any overrides applied.
+    QVector<QSet<QString>> shiftSkills;  // Skills required on each shift, in shift order.
+    QVector<QPair<QString, ConstraintFactory>> constraints; // Constraint types, and factories.
+
+    /*!
+     * \brief Returns the index of the shift named \a name, or -1 if there is no such shift.
+     */
+    int shiftIndex(const QString &name) const
+    {
+        for (int index = 0; index < shifts.size(); ++index) {
+            if (shifts.at(index).first == name) {
+                return index;
+            }
+        }
+        return -1;
+    }
+
+    /*!
+     * \brief Returns the positive integer value of \a key in \a map, or 0 if there is none.
+     */
+    static int positiveInt(const QVariantMap &map, const QString &key)
+    {
+        return qMax(nonNegativeInt(map, key), 0);
+    }
+
+    /*!
+     * \brief Returns the non-negative integer value of \a key in \a map, or -1 if there is none,
+     * as per NurseRecord::nonNegativeInt (so nurse records and rules files agree on what's valid).
+     */
+    static int nonNegativeInt(const QVariantMap &map, const QString &key)
+    {
+        return NurseRecord::nonNegativeInt(map.value(key));
+    }
+
+    /*!
+     * \brief Returns the names of the days of the week, as used in rules files, from Monday.
+     */
+    static QStringList weekdayNames()
+    {
+        return QStringList{
+            QStringLiteral("monday"), QStringLiteral("tuesday"), QStringLiteral("wednesday"),
+            QStringLiteral("thursday"), QStringLiteral("friday"), QStringLiteral("saturday"),
+            QStringLiteral("sunday"),
+        };
+    }
+
+    void appendConsecutiveDays(const int days)
+    {
+        constraints.append(qMakePair(QStringLiteral("AtMostConsecutiveDays"), ConstraintFactory(
+            [days]() { return new AtMostConsecutiveDays(days); })));
+    }
+
+    void appendShiftsPerMonth(const int shift, const int shifts)
+    {
+        constraints.append(qMakePair(QStringLiteral("AtMostShiftsPerMonth"), ConstraintFactory(
+            [shift, shifts]() { return new AtMostShiftsPerMonth(shift, shifts); })));
+    }
+
+    void appendOneShiftPerDay()
+    {
+        constraints.append(qMakePair(QStringLiteral("AtMostOneShiftPerDay"), ConstraintFactory(
+            []() { return new AtMostOneShiftPerDay(); })));
+    }
+
+    void appendNoSingleDaysOff()
+    {
+        constraints.append(qMakePair(QStringLiteral("NoSingleDaysOff"), ConstraintFactory(
+            []() { return new NoSingleDaysOff(); })));
+    }
+
+};
+
+} // end Cogent namespace
+
+#endif // __RULES_H__
@@ -1,8 +1,10 @@
 #ifndef __SCHEDULER_INTERFACE_H__
 #define __SCHEDULER_INTERFACE_H__
 
-#include <QSet>
-#include <QString>
+#include "NurseSet.h"
+
+#include <QDate>
+#include <QVector>
 
 namespace Cogent {
 
@@ -13,20 +15,182 @@ class SchedulerInterface
 {
 
 public:
-    typedef QSet<QString> QStringSet;
-
     /*!
      * \brief Returns the next nurse to fill a roster position given a list of \a availableNurses.
      *
      * Derived classed must implement this virtual function to apply their own scheduling
      * heuristic.
      */
-    virtual QString chooseNextNurse(const QStringSet &availableNurses) = 0;
+    virtual NurseId chooseNextNurse(const NurseSet &availableNurses) = 0;
+
+    /*!
+     * \brief Returns the next \a count nurses to fill roster positions given a set of
+     * \a availableNurses, in the order they would have been returned by successive calls to
+     * chooseNextNurse (each excluding the nurses already chosen).
+     *
+     * If fewer than \a count nurses are available, all available nurses are returned.
+     *
+     * This default implementation simply calls chooseNextNurse repeatedly. Derived classes may
+     * override it to choose all \a count nurses in a single pass.
+     */
+    virtual QVector<NurseId> chooseNextNurses(const NurseSet &availableNurses, const int count)
+    {
+        QVector<NurseId> nurses;
+        nurses.reserve(count);
+        NurseSet remainingNurses = availableNurses;
+        while ((nurses.size() < count) && (!remainingNurses.isEmpty())) {
+            const NurseId nurse = chooseNextNurse(remainingNurses);
+            nurses.append(nurse);
+            remainingNurses.remove(nurse);
+        }
+        return nurses;
+    }
+
+    /*!
+     * \brief Appends the next \a count nurses (as per chooseNextNurses) to \a nurses.
+     *
+     * Callers pass a reused buffer (see ScratchPool), so derived classes that override this to
+     * append directly to \a nurses make choosing nurses free of heap allocations. This default
+     * implementation simply appends the result of chooseNextNurses.
+     */
+    virtual void appendNextNurses(const NurseSet &availableNurses, const int count,
+                                  QVector<NurseId> &nurses)
+    {
+        nurses += chooseNextNurses(availableNurses, count);
+    }
+
+    /*!
+     * \brief Returns all of \a availableNurses, in the order this scheduler would choose them,
+     * without recording any of them as chosen.
+     *
+     * Solvers that explore alternative assignments (such as RosterGenerator's backtracking engine)
+     * use this, along with onAssigned() and onUnassigned(), instead of the choose functions. This
+     * default implementation expresses no preference, returning nurses in ascending NurseId order.
+     */
+    virtual QVector<NurseId> rankNurses(const NurseSet &availableNurses) const
+    {
+        return availableNurses.toVector();
+    }
+
+    /*!
+     * \brief Appends all of \a availableNurses to \a nurses, in the order of rankNurses.
+     *
+     * As for appendNextNurses, this default implementation simply appends the result of
+     * rankNurses.
+     */
+    virtual void appendRankedNurses(const NurseSet &availableNurses,
+                                    QVector<NurseId> &nurses) const
+    {
+        nurses += rankNurses(availableNurses);
+    }
+
+    /*!
+     * \brief Notes that the following choices, rankings and onAssigned() calls (until the next call
+     * to this function) are for \a shift (an index into the roster's shifts) of \a date.
+     *
+     * Schedulers that weigh some shifts differently (such as FairScheduler, with night and weekend
+     * shifts) use this; the order of the calls is not otherwise significant, as solvers may move
+     * back and forth between shifts. This default implementation ignores it.
+     */
+    virtual void onShift(const QDate &date, const int shift)
+    {
+        Q_UNUSED(date);
+        Q_UNUSED(shift);
+    }
+
+    /*!
+     * \brief Records \a nurse as chosen, exactly as if just returned by chooseNextNurse.
+     */
+    virtual void onAssigned(const NurseId nurse)
+    {
+        Q_UNUSED(nurse);
+    }
+
+    /*!
+     * \brief Records \a nurses as chosen for a single shift, exactly as if just returned (in that
+     * order) by a single appendNextNurses call.
+     *
+     * Schedulers that treat nurses chosen together differently from nurses chosen one at a time
+     * (such as a seeded LeastRecentScheduler) override this, so that solvers recording a whole
+     * shift's choice get the same result as choosing it. This default implementation simply calls
+     * onAssigned() for each nurse in turn.
+     */
+    virtual void onShiftAssigned(const QVector<NurseId> &nurses)
+    {
+        foreach (const NurseId nurse, nurses) {
+            onAssigned(nurse);
+        }
+    }
+
+    /*!
+     * \brief Undoes the most recent recording of \a nurse as chosen.
+     *
+     * Undos must be made in the exact reverse order of the choices (via onAssigned() or any of the
+     * choose functions) they undo, and only choices made while undoable (see setUndoable) may be
+     * undone.
+     */
+    virtual void onUnassigned(const NurseId nurse)
+    {
+        Q_UNUSED(nurse);
+    }
+
+    /*!
+     * \brief Sets whether subsequent choices may be undone (via onUnassigned()) to \a undoable.
+     *
+     * Solvers that explore alternative assignments (such as RosterGenerator's backtracking engine)
+     * make the scheduler undoable only for the duration of their search, so that schedulers need
+     * not keep undo state for every choice they ever make. Choices are not undoable by default,
+     * and setting this (either way) forgets how to undo any earlier choices. This default
+     * implementation ignores it.
+     */
+    virtual void setUndoable(const bool undoable)
+    {
+        Q_UNUSED(undoable);
+    }
+
+    /*!
+     * \brief Breaks any subsequent ties between equally preferred nurses according to \a seed,
+     * keeping all history recorded so far.
+     *
+     * Differently seeded schedulers offer alternative, equally valid choices (as RosterServer's
+     * "regenerate" command does); a \a seed of 0 restores the default tie-breaking. This default
+     * implementation ignores it.
+     */
+    virtual void setSeed(const quint64 seed)
+    {
+        Q_UNUSED(seed);
+    }
+
+    /*!
+     * \brief Returns a new copy of this scheduler, including all history recorded so far, or
+     * \c nullptr if this scheduler cannot be copied (as this default implementation returns).
+     *
+     * The caller takes ownership of the copy. Copies let callers (such as RosterServer) keep a
+     * scheduler's history as of the end of each month, so that later months continue on from it.
+     */
+    virtual SchedulerInterface *clone() const
+    {
+        return nullptr;
+    }
 
     /*!
      * \brief Virtual destructor for safe polymorphic destruction.
      */
     virtual ~SchedulerInterface() { }
+
+protected:
+    /*!
+     * \brief Returns \a key thoroughly mixed, for pseudo-random (but repeatable) tie-breaking.
+     *
+     * This is the SplitMix64 finaliser, which is cheap, and mixes well enough that consecutive
+     * keys (such as nurses, or seeds) produce unrelated values.
+     */
+    static quint64 mix(quint64 key)
+    {
+        key = (key ^ (key >> 30)) * Q_UINT64_C(0xBF58476D1CE4E5B9);
+        key = (key ^ (key >> 27)) * Q_UINT64_C(0x94D049BB133111EB);
+        return key ^ (key >> 31);
+    }
 };
 
 } // end Cogent namespace
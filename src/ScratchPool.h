@@ -0,0 +1,107 @@
+#ifndef __SCRATCH_POOL_H__
+#define __SCRATCH_POOL_H__
+
+#include "NurseSet.h"
+
+#include <QSharedPointer>
+#include <QVector>
+
+namespace Cogent {
+
+/*!
+ * \brief A pool of scratch buffers for the temporaries needed afresh for every shift, such as each
+ * shift's candidate nurses, and the nurses chosen from them.
+ *
+ * Buffers are taken from the pool in order, and handed back all at once, either via reset() (eg
+ * once per shift), or back to an earlier mark() (eg on leaving a search node, since search nodes
+ * nest). Handed back buffers keep their storage, and are taken again in the same order. So once
+ * the pool holds as many buffers as are ever needed at once (typically after the first shift, or
+ * the deepest search node), and each has grown to the size needed, taking buffers from the pool
+ * costs no heap allocations at all.
+ *
+ * Each generator has its own pool, so generators running in parallel threads never contend for
+ * the same allocator locks in their inner loops. References to buffers remain valid until they
+ * are handed back; the buffers must not be copied (which would share their storage) either.
+ */
+class ScratchPool
+{
+
+public:
+    /*!
+     * \brief The number of each kind of buffer taken, as returned by mark().
+     */
+    struct Mark {
+        int nurseSets;
+        int nurseLists;
+    };
+
+    ScratchPool() : taken{ 0, 0 } { }
+
+    /*!
+     * \brief Returns a scratch set, of unspecified capacity and contents, to be assigned (see
+     * NurseSet::assign) before use.
+     */
+    NurseSet &nurseSet()
+    {
+        if (taken.nurseSets == nurseSets.size()) {
+            nurseSets.append(QSharedPointer<NurseSet>(new NurseSet));
+        }
+        return *nurseSets.at(taken.nurseSets++);
+    }
+
+    /*!
+     * \brief Returns a scratch copy of \a nurses.
+     */
+    NurseSet &nurseSet(const NurseSet &nurses)
+    {
+        return nurseSet().assign(nurses);
+    }
+
+    /*!
+     * \brief Returns an empty scratch list of nurses.
+     */
+    QVector<NurseId> &nurseList()
+    {
+        if (taken.nurseLists == nurseLists.size()) {
+            nurseLists.append(QSharedPointer<QVector<NurseId>>(new QVector<NurseId>));
+        }
+        QVector<NurseId> &list = *nurseLists.at(taken.nurseLists++);
+        list.resize(0); // Unlike squeeze(), keeps the list's storage.
+        return list;
+    }
+
+    /*!
+     * \brief Returns the buffers taken so far, for release().
+     */
+    Mark mark() const
+    {
+        return taken;
+    }
+
+    /*!
+     * \brief Hands back every buffer taken since \a mark was returned by mark().
+     */
+    void release(const Mark &mark)
+    {
+        Q_ASSERT((mark.nurseSets <= taken.nurseSets) && (mark.nurseLists <= taken.nurseLists));
+        taken = mark;
+    }
+
+    /*!
+     * \brief Hands back every buffer taken.
+     */
+    void reset()
+    {
+        release(Mark{ 0, 0 });
+    }
+
+protected:
+    QVector<QSharedPointer<NurseSet>> nurseSets;
+    QVector<QSharedPointer<QVector<NurseId>>> nurseLists;
+    Mark taken;
+
+};
+
+} // end Cogent namespace
+
+#endif // __SCRATCH_POOL_H__
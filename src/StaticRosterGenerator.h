@@ -0,0 +1,249 @@
+#ifndef __STATIC_ROSTER_GENERATOR_H__
+#define __STATIC_ROSTER_GENERATOR_H__
+
+#include "AtMostFiveConsecutiveDays.h"
+#include "AtMostFiveNightShiftsPerMonth.h"
+#include "AtMostOneShiftPerDay.h"
+#include "NoSingleDaysOff.h"
+#include "RosterGenerator.h"
+
+#include <tuple>
+
+namespace Cogent {
+
+/*!
+ * \brief A RosterGenerator whose constraints, one of each of \a Constraints, are fixed at compile
+ * time.
+ *
+ * RosterGenerator calls each of its constraints via ConstraintInterface, for every shift and every
+ * assignment. This generator instead holds its constraints by value, and calls them directly, so
+ * the compiler can inline them; the generator itself makes just one virtual call per shift or
+ * assignment. Further, constraints that publish their eligible nurses as a mask, via a non-virtual
+ * eligibleFor() (such as AtMostConsecutiveDays), are applied to each shift's candidates in a single
+ * fused pass over the candidates' words, rather than one pass (and two counts) per constraint.
+ * Other constraints are applied via their constrain() as usual.
+ *
+ * Each of \a Constraints must be default constructible. More constraints may still be added at
+ * runtime via addConstraint; they are applied after \a Constraints.
+ *
+ * Note, \a Constraints are not counted in the generator's per-constraint statistics, so are
+ * neither reordered by how much they prune, nor short-circuited, nor included in metrics(). So
+ * the roster application always uses RosterGenerator, and this generator is kept for measuring
+ * the cost of dynamic dispatch (see bench_RosterGenerator).
+ */
+template<class... Constraints>
+class StaticRosterGenerator : public RosterGenerator
+{
+
+public:
+    StaticRosterGenerator(const int nursesPerShift = 5) : RosterGenerator(nursesPerShift) { }
+
+protected:
+    mutable std::tuple<Constraints...> staticConstraints; // Mutable, as constrain() is not const.
+
+    /*!
+     * \brief Compile-time list of indexes into staticConstraints, for expanding over them.
+     */
+    template<int... Indexes> struct IndexList { };
+    template<int Count, int... Indexes>
+    struct MakeIndexList : MakeIndexList<Count-1, Count-1, Indexes...> { };
+    template<int... Indexes>
+    struct MakeIndexList<0, Indexes...> { typedef IndexList<Indexes...> Type; };
+    typedef typename MakeIndexList<int(sizeof...(Constraints))>::Type AllIndexes;
+
+    void notifyReset(const int nurseCount, const QVector<CarryIn::Streak> &streaks) override
+    {
+        reset(AllIndexes(), nurseCount, streaks);
+        RosterGenerator::notifyReset(nurseCount, streaks);
+    }
+
+    void notifyAssigned(const NurseId nurse, const int day, const int shift) override
+    {
+        assigned(AllIndexes(), nurse, day, shift);
+        RosterGenerator::notifyAssigned(nurse, day, shift);
+    }
+
+    void notifyUnassigned(const NurseId nurse, const int day, const int shift) override
+    {
+        RosterGenerator::notifyUnassigned(nurse, day, shift);
+        unassigned(AllIndexes(), nurse, day, shift);
+    }
+
+    void notifyDayCommitted(const Roster &days, const int day) override
+    {
+        dayCommitted(AllIndexes(), days, day);
+        RosterGenerator::notifyDayCommitted(days, day);
+    }
+
+    void notifyDayUncommitted(const Roster &days, const int day) override
+    {
+        RosterGenerator::notifyDayUncommitted(days, day);
+        dayUncommitted(AllIndexes(), days, day);
+    }
+
+    void constrain(NurseSet &nurses, const int shift, const Roster &days,
+                   const int needed) const override
+    {
+        const NurseSet *masks[sizeof...(Constraints) + 1]; // +1, as arrays cannot be empty.
+        int maskCount = 0;
+        constrain(AllIndexes(), nurses, shift, days, masks, maskCount);
+        if (maskCount > 0) {
+            nurses.intersect(masks, maskCount);
+        }
+        RosterGenerator::constrain(nurses, shift, days, needed);
+    }
+
+    void constrainBounds(const int daysInMonth, int &maxDays, int &maxPerDay,
+                         QVector<int> &maxPerShift) const override
+    {
+        constrainBounds(AllIndexes(), daysInMonth, maxDays, maxPerDay, maxPerShift);
+        RosterGenerator::constrainBounds(daysInMonth, maxDays, maxPerDay, maxPerShift);
+    }
+
+    // Each of the following calls the same member of every one of staticConstraints, in order,
+    // by expanding the Indexes (and Constraints) packs. The calls are qualified, so are not
+    // dispatched virtually.
+
+    template<int... Indexes>
+    void reset(IndexList<Indexes...>, const int nurseCount,
+               const QVector<CarryIn::Streak> &streaks)
+    {
+        const int expand[] = { 0, (std::get<Indexes>(staticConstraints).Constraints::reset(
+            nurseCount), 0)... };
+        Q_UNUSED(expand);
+        Q_UNUSED(nurseCount); // When Constraints is empty.
+        if (!streaks.isEmpty()) {
+            const int carried[] = { 0, (std::get<Indexes>(staticConstraints).Constraints::
+                onCarryIn(streaks), 0)... };
+            Q_UNUSED(carried);
+        }
+    }
+
+    template<int... Indexes>
+    void assigned(IndexList<Indexes...>, const NurseId nurse, const int day, const int shift)
+    {
+        const int expand[] = { 0, (std::get<Indexes>(staticConstraints).Constraints::onAssigned(
+            nurse, day, shift), 0)... };
+        Q_UNUSED(expand);
+        Q_UNUSED(nurse); // These three are unused when Constraints is empty.
+        Q_UNUSED(day);
+        Q_UNUSED(shift);
+    }
+
+    template<int... Indexes>
+    void unassigned(IndexList<Indexes...>, const NurseId nurse, const int day, const int shift)
+    {
+        const int expand[] = { 0, (std::get<Indexes>(staticConstraints).Constraints::onUnassigned(
+            nurse, day, shift), 0)... };
+        Q_UNUSED(expand);
+        Q_UNUSED(nurse);
+        Q_UNUSED(day);
+        Q_UNUSED(shift);
+    }
+
+    template<int... Indexes>
+    void dayCommitted(IndexList<Indexes...>, const Roster &days, const int day)
+    {
+        const int expand[] = { 0, (std::get<Indexes>(staticConstraints).Constraints::
+            onDayCommitted(days, day), 0)... };
+        Q_UNUSED(expand);
+        Q_UNUSED(days);
+        Q_UNUSED(day);
+    }
+
+    template<int... Indexes>
+    void dayUncommitted(IndexList<Indexes...>, const Roster &days, const int day)
+    {
+        const int expand[] = { 0, (std::get<Indexes>(staticConstraints).Constraints::
+            onDayUncommitted(days, day), 0)... };
+        Q_UNUSED(expand);
+        Q_UNUSED(days);
+        Q_UNUSED(day);
+    }
+
+    template<int... Indexes>
+    void constrain(IndexList<Indexes...>, NurseSet &nurses, const int shift, const Roster &days,
+                   const NurseSet **masks, int &maskCount) const
+    {
+        const int expand[] = { 0, (filter(std::get<Indexes>(staticConstraints), nurses, shift,
+                                          days, masks, maskCount, 0), 0)... };
+        Q_UNUSED(expand);
+        Q_UNUSED(nurses);
+        Q_UNUSED(shift);
+        Q_UNUSED(days);
+        Q_UNUSED(masks);
+        Q_UNUSED(maskCount);
+    }
+
+    template<int... Indexes>
+    void constrainBounds(IndexList<Indexes...>, const int daysInMonth, int &maxDays,
+                         int &maxPerDay, QVector<int> &maxPerShift) const
+    {
+        const int expand[] = { 0, (bound(std::get<Indexes>(staticConstraints), daysInMonth,
+                                         maxDays, maxPerDay, maxPerShift), 0)... };
+        Q_UNUSED(expand);
+        Q_UNUSED(daysInMonth);
+        Q_UNUSED(maxDays);
+        Q_UNUSED(maxPerDay);
+        Q_UNUSED(maxPerShift);
+    }
+
+    /*!
+     * \brief Appends \a constraint's eligible nurses for \a shift of the last day of \a days (if it
+     * restricts that shift at all) to \a masks, to be intersected with \a nurses later.
+     *
+     * This overload is only viable for constraints with an eligibleFor() method.
+     */
+    template<class Constraint>
+    static auto filter(Constraint &constraint, NurseSet &nurses, const int shift,
+                       const Roster &days, const NurseSet **masks, int &maskCount, int)
+        -> decltype(constraint.Constraint::eligibleFor(shift, days), void())
+    {
+        Q_UNUSED(nurses);
+        const NurseSet * const mask = constraint.Constraint::eligibleFor(shift, days);
+        if (mask) {
+            masks[maskCount++] = mask;
+        }
+    }
+
+    /*!
+     * \brief Removes from \a nurses any that fail \a constraint for \a shift of the last day of
+     * \a days, for constraints without an eligibleFor() method.
+     */
+    template<class Constraint>
+    static void filter(Constraint &constraint, NurseSet &nurses, const int shift,
+                       const Roster &days, const NurseSet **masks, int &maskCount, long)
+    {
+        Q_UNUSED(masks);
+        Q_UNUSED(maskCount);
+        constraint.Constraint::constrain(nurses, shift, days);
+    }
+
+    /*!
+     * \brief Lowers \a maxDays, \a maxPerDay and each of \a maxPerShift to \a constraint's bounds,
+     * for a month of \a daysInMonth days.
+     */
+    template<class Constraint>
+    void bound(const Constraint &constraint, const int daysInMonth, int &maxDays, int &maxPerDay,
+               QVector<int> &maxPerShift) const
+    {
+        maxDays = qMin(maxDays, constraint.Constraint::maxDaysWorked(daysInMonth));
+        maxPerDay = qMin(maxPerDay, constraint.Constraint::maxShiftsPerDay(shiftNames.size()));
+        for (int shift = 0; shift < maxPerShift.size(); ++shift) {
+            maxPerShift[shift] = qMin(maxPerShift.at(shift),
+                                      constraint.Constraint::maxShiftsPerMonth(shift, daysInMonth));
+        }
+    }
+
+};
+
+/*!
+ * \brief A generator with the four standard constraints (as per Rules::defaults) fixed at compile
+ * time, for the default shifts.
+ */
+typedef StaticRosterGenerator<AtMostFiveConsecutiveDays, AtMostFiveNightShiftsPerMonth,
+                              AtMostOneShiftPerDay, NoSingleDaysOff> StandardRosterGenerator;
+
+} // end Cogent namespace
+
+#endif // __STATIC_ROSTER_GENERATOR_H__
@@ -1,23 +1,54 @@
 #include <QCommandLineParser>
 #include <QCoreApplication>
 #include <QDebug>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QJsonDocument>
 #include <QLoggingCategory>
+#include <algorithm>
 #include <iostream>
 
-#include "AtMostFiveConsecutiveDays.h"
-#include "AtMostFiveNightShiftsPerMonth.h"
-#include "AtMostOneShiftPerDay.h"
-#include "NoSingleDaysOff.h"
+#include "BatchGenerator.h"
+#include "BinaryRoster.h"
+#include "CarryIn.h"
+#include "FairScheduler.h"
+#include "GeneratorMetrics.h"
+#include "JsonWriter.h"
+#include "NurseListReader.h"
+#include "RestartGenerator.h"
 #include "RosterGenerator.h"
+#include "RosterServer.h"
+#include "RosterValidator.h"
+#include "Rules.h"
 
 using namespace Cogent;
 
-void configureGenerator(Cogent::RosterGenerator &generator, const QCommandLineParser &parser);
+void configureGenerator(Cogent::RosterGenerator &generator, const Cogent::Rules &rules,
+                        const QVector<Cogent::NurseRecord> &records,
+                        const QCommandLineParser &parser);
 void configureLogging(const QCommandLineParser &parser);
+int generateBatch(const Cogent::Rules &rules, const QVector<Cogent::NurseRecord> &records,
+                  const QCommandLineParser &parser);
+bool openOutput(QFile &file, const QFile::OpenMode mode, const QCommandLineParser &parser);
+QVector<Cogent::BatchGenerator::WardJob> readBatchManifest(const QCommandLineParser &parser);
+bool readCarryIn(const QString &fileName, Cogent::CarryIn &carryIn);
+bool readNurseRecords(const QString &fileName, QVector<Cogent::NurseRecord> &records);
+int serve(const Cogent::Rules &rules, const QVector<Cogent::NurseRecord> &records,
+          const QCommandLineParser &parser);
+Cogent::Rules readRules(const QCommandLineParser &parser);
 QStringList readNursesList(const QCommandLineParser &parser);
-bool writeToJson(const QVariantMap &roster, const QCommandLineParser &parser);
+QStringList readNursesList(QFile &file, const bool skipDups);
+int validateRosters(const Cogent::Rules &rules, const QCommandLineParser &parser);
+bool writeCarryOut(const QVariantMap &roster, const Cogent::CarryIn &carryIn,
+                   const QCommandLineParser &parser);
+bool writeCarryOut(const Cogent::Roster &days, const Cogent::NurseTable &nurses,
+                   const Cogent::CarryIn &carryIn, const QCommandLineParser &parser);
+bool writeCarryOut(const Cogent::CarryIn &carryOut, const QCommandLineParser &parser);
+bool writeMetrics(const Cogent::GeneratorMetrics &metrics, const QCommandLineParser &parser);
+bool writeRoster(const QVariantMap &roster, const QCommandLineParser &parser);
+bool writeRoster(const int year, const int month, const Cogent::Roster &days,
+                 const Cogent::NurseTable &nurses, const QCommandLineParser &parser);
 
 int main(int argc, char *argv[])
 {
@@ -29,20 +60,74 @@ int main(int argc, char *argv[])
     parser.addHelpOption();
     parser.addOptions({
         {{QStringLiteral("d"), QStringLiteral("debug")}, QStringLiteral("Enable debug output")},
+        { QStringLiteral("log-rules"),
+          QStringLiteral("Enable or disable logging categories, such as 'cogent.constraint.debug=true'"),
+          QStringLiteral("rules")},
         { QStringLiteral("no-color"), QStringLiteral("Do not color the output")},
-        { QStringLiteral("no-c1"),    QStringLiteral("Skip constraint 1 (AtMostFiveConsecutiveDays)")},
-        { QStringLiteral("no-c2"),    QStringLiteral("Skip constraint 2 (AtMostFiveNightShiftsPerMonth)")},
+        { QStringLiteral("no-c1"),    QStringLiteral("Skip constraint 1 (AtMostConsecutiveDays)")},
+        { QStringLiteral("no-c2"),    QStringLiteral("Skip constraint 2 (AtMostShiftsPerMonth)")},
         { QStringLiteral("no-c3"),    QStringLiteral("Skip constraint 3 (AtMostOneShiftPerDay)")},
         { QStringLiteral("no-c4"),    QStringLiteral("Skip constraint 4 (NoSingleDaysOff)")},
         {{QStringLiteral("c"), QStringLiteral("compact")}, QStringLiteral("Use compact output")},
+        { QStringLiteral("binary"),
+          QStringLiteral("Write rosters in binary format, for fast lookups by other tools")},
         { QStringLiteral("no-color"), QStringLiteral("Do not color the output")},
         {{QStringLiteral("i"), QStringLiteral("nurses")},
           QStringLiteral("Read names of available nurses from file (default is stdin)"),
           QStringLiteral("file") },
+        { QStringLiteral("records"),
+          QStringLiteral("Read nurses' leave, shift caps, skills and shifts from a JSON file"),
+          QStringLiteral("file") },
         {{QStringLiteral("o"), QStringLiteral("output")},
           QStringLiteral("Write output to file (default is stdout)"),
           QStringLiteral("file")},
         { QStringLiteral("skip-dups"), QStringLiteral("Skip duplicate nurse names")},
+        {{QStringLiteral("b"), QStringLiteral("backtrack")},
+          QStringLiteral("Search for a roster (with backtracking) if the greedy approach can't find one")},
+        { QStringLiteral("max-nodes"),
+          QStringLiteral("Limit backtracking to visiting at most n shifts (default is 100000)"),
+          QStringLiteral("n")},
+        { QStringLiteral("max-time"),
+          QStringLiteral("Limit backtracking to ms milliseconds (default is 10000)"),
+          QStringLiteral("ms")},
+        { QStringLiteral("batch"),
+          QStringLiteral("Generate rosters for all wards and months listed in a JSON manifest file"),
+          QStringLiteral("manifest")},
+        {{QStringLiteral("j"), QStringLiteral("jobs")},
+          QStringLiteral("Generate at most n wards' rosters (or passes) concurrently (default is one per CPU)"),
+          QStringLiteral("n")},
+        {{QStringLiteral("r"), QStringLiteral("restarts")},
+          QStringLiteral("Make n differently-seeded passes, keeping the first roster found"),
+          QStringLiteral("n")},
+        { QStringLiteral("fair"),
+          QStringLiteral("With --restarts, complete all passes, keeping the fairest roster")},
+        { QStringLiteral("scheduler"),
+          QStringLiteral("Use the 'least-recent' (default) or 'fair' scheduler, which balances total, night and weekend shifts"),
+          QStringLiteral("name")},
+        { QStringLiteral("carry-in"),
+          QStringLiteral("Continue on from the previous month's roster (JSON output or carry-out file)"),
+          QStringLiteral("file")},
+        { QStringLiteral("carry-out"),
+          QStringLiteral("Write the state to carry in to the next month to file"),
+          QStringLiteral("file")},
+        { QStringLiteral("rules"),
+          QStringLiteral("Read shifts and constraints from a JSON rules file (default is built-in)"),
+          QStringLiteral("file")},
+        { QStringLiteral("serve"),
+          QStringLiteral("Serve roster requests on a local socket, keeping wards' state in memory"),
+          QStringLiteral("name")},
+        { QStringLiteral("serve-nurses-dir"),
+          QStringLiteral("With --serve, let clients load nurses list files from within dir"),
+          QStringLiteral("dir")},
+        { QStringLiteral("validate"),
+          QStringLiteral("Check a JSON or binary roster file against the rules, listing all violations"),
+          QStringLiteral("file")},
+        { QStringLiteral("metrics"),
+          QStringLiteral("Write generation metrics (time and candidates pruned per constraint, etc) to file"),
+          QStringLiteral("file")},
+        { QStringLiteral("metrics-format"),
+          QStringLiteral("Write metrics as 'json' (the default) or 'prometheus' text"),
+          QStringLiteral("format")},
     });
     parser.addPositionalArgument(
         QStringLiteral("YYYY MM"),
@@ -50,6 +135,39 @@ int main(int argc, char *argv[])
     parser.process(app);
     configureLogging(parser);
 
+    // Check the scheduler, if given; each restart pass uses its own, differently seeded, copy.
+    const QString scheduler = parser.value(QStringLiteral("scheduler"));
+    if ((!scheduler.isEmpty()) && (scheduler != QLatin1String("least-recent")) &&
+        (scheduler != QLatin1String("fair"))) {
+        qCritical() << "unknown scheduler" << scheduler;
+        return EXIT_FAILURE;
+    }
+
+    // Load the shifts and constraints to apply.
+    const Cogent::Rules rules = readRules(parser);
+    if (!rules.isValid()) {
+        return EXIT_FAILURE;
+    }
+
+    // Read the nurses' records, if any.
+    QVector<Cogent::NurseRecord> records;
+    if ((parser.isSet(QStringLiteral("records"))) &&
+        (!readNurseRecords(parser.value(QStringLiteral("records")), records))) {
+        return EXIT_FAILURE;
+    }
+
+    // Validate existing rosters, generate a batch of rosters, or serve roster requests, if
+    // requested.
+    if (parser.isSet(QStringLiteral("validate"))) {
+        return validateRosters(rules, parser);
+    }
+    if (parser.isSet(QStringLiteral("batch"))) {
+        return generateBatch(rules, records, parser);
+    }
+    if (parser.isSet(QStringLiteral("serve"))) {
+        return serve(rules, records, parser);
+    }
+
     // Fetcth the year / month.
     if (parser.positionalArguments().size() != 2) {
         parser.showHelp(EXIT_FAILURE);
@@ -61,38 +179,429 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
-    // Read the nurses list.
-    const QStringList nurses = readNursesList(parser);
+    // Read the nurses list (or, if only records were given, roster the nurses with records).
+    QStringList nurses;
+    if ((parser.isSet(QStringLiteral("records"))) && (!parser.isSet(QStringLiteral("nurses")))) {
+        foreach (const Cogent::NurseRecord &record, records) {
+            nurses.append(record.name);
+        }
+    } else {
+        nurses = readNursesList(parser);
+    }
     if (nurses.isEmpty()) {
         qCritical() << "have no nurses to roster";
         return EXIT_FAILURE;
     }
 
-    // Generate the roster.
-    Cogent::RosterGenerator generator;
-    configureGenerator(generator, parser);
-    const QVariantMap roster = generator.generate(year, month, nurses);
+    // Read the state carried in from the previous month, if any.
+    Cogent::CarryIn carryIn;
+    if ((parser.isSet(QStringLiteral("carry-in"))) &&
+        (!readCarryIn(parser.value(QStringLiteral("carry-in")), carryIn))) {
+        return EXIT_FAILURE;
+    }
+
+    // Generate the roster. A single generator's roster is kept in its compact form, and written
+    // out straight from that; only the restart passes' rosters are built as maps.
+    QVariantMap roster;
+    Cogent::Roster days;
+    Cogent::NurseTable nurseTable;
+    bool generated = false;
+    Cogent::GeneratorMetrics metrics;
+    if (parser.isSet(QStringLiteral("restarts"))) {
+        Cogent::RestartGenerator restarts(
+            [&rules, &records, &parser](Cogent::RosterGenerator &generator) {
+            configureGenerator(generator, rules, records, parser);
+        }, parser.value(QStringLiteral("restarts")).toInt());
+        if (parser.isSet(QStringLiteral("fair"))) {
+            restarts.setObjective(Cogent::RestartGenerator::shiftCountDeviation);
+        }
+        if (parser.isSet(QStringLiteral("jobs"))) {
+            restarts.setMaxThreadCount(parser.value(QStringLiteral("jobs")).toInt());
+        }
+        roster = restarts.generate(year, month, nurses, carryIn);
+        generated = !roster.isEmpty();
+        metrics = restarts.metrics();
+    } else {
+        // Note, the generator with the standard constraints built in at compile time is not used
+        // here, as it bypasses the per-constraint statistics, ordering, and metrics.
+        Cogent::RosterGenerator generator;
+        configureGenerator(generator, rules, records, parser);
+        generated = generator.generate(year, month, nurses, carryIn, days);
+        nurseTable = generator.nurses();
+        metrics = generator.metrics();
+    }
+    if ((!writeMetrics(metrics, parser)) || (!generated)) {
+        return EXIT_FAILURE;
+    }
+
+    // Output the roster in JSON format, and the state to carry in to the next month (if wanted).
     if (roster.isEmpty()) {
+        return ((writeRoster(year, month, days, nurseTable, parser)) &&
+                (writeCarryOut(days, nurseTable, carryIn, parser))) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    return ((writeRoster(roster, parser)) && (writeCarryOut(roster, carryIn, parser)))
+        ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*!
+ * Configure the given \a generator according to the \a rules, nurse \a records, and the command
+ * line \a parser
+ */
+void configureGenerator(Cogent::RosterGenerator &generator, const Cogent::Rules &rules,
+                        const QVector<Cogent::NurseRecord> &records,
+                        const QCommandLineParser &parser)
+{
+    rules.configure(generator);
+    generator.setNurseRecords(records);
+    generator.setTimed(parser.isSet(QStringLiteral("metrics")));
+    if (parser.value(QStringLiteral("scheduler")) == QLatin1String("fair")) {
+        generator.setScheduler(new Cogent::FairScheduler(
+            Cogent::FairScheduler::defaultWeights(),
+            rules.shiftNames().indexOf(QStringLiteral("night")))); // -1 if there is none.
+    }
+
+    if (parser.isSet(QStringLiteral("backtrack"))) {
+        generator.setEngine(Cogent::RosterGenerator::BacktrackingEngine);
+        generator.setSearchLimits(
+            parser.isSet(QStringLiteral("max-nodes")) ? parser.value(QStringLiteral("max-nodes")).toLongLong() : 100000,
+            parser.isSet(QStringLiteral("max-time"))  ? parser.value(QStringLiteral("max-time")).toLongLong()  : 10000);
+    }
+}
+
+/*!
+ * Generates rosters for all wards and months in the batch manifest given on the command line
+ * \a parser, and writes them (keyed by ward name) in JSON format.
+ *
+ * The manifest is a JSON array of objects, each with a "ward" name, a "nurses" file name (relative
+ * to the manifest file), and a "months" array of months in 'YYYY-MM' format. For example:
+ *
+ *     [ { "ward": "east", "nurses": "east.txt", "months": [ "2018-05", "2018-06" ] } ]
+ *
+ * Returns EXIT_SUCCESS if all rosters were generated and written; EXIT_FAILURE otherwise.
+ */
+int generateBatch(const Cogent::Rules &rules, const QVector<Cogent::NurseRecord> &records,
+                  const QCommandLineParser &parser)
+{
+    const QVector<Cogent::BatchGenerator::WardJob> jobs = readBatchManifest(parser);
+    if (jobs.isEmpty()) {
         return EXIT_FAILURE;
     }
 
-    // Output the roster in JSON format.
-    return (writeToJson(roster, parser)) ? EXIT_SUCCESS : EXIT_FAILURE;
+    Cogent::BatchGenerator batch(
+        [&rules, &records, &parser](Cogent::RosterGenerator &generator) {
+        configureGenerator(generator, rules, records, parser);
+    });
+    if (parser.isSet(QStringLiteral("jobs"))) {
+        batch.setMaxThreadCount(parser.value(QStringLiteral("jobs")).toInt());
+    }
+    const QVariantMap rosters = batch.generate(jobs);
+
+    bool generated = writeMetrics(batch.metrics(), parser);
+    for (auto iter = rosters.constBegin(); iter != rosters.constEnd(); ++iter) {
+        if (iter.value().toMap().isEmpty()) {
+            qCritical() << "failed to generate roster for ward" << iter.key();
+            generated = false;
+        }
+    }
+    return (generated && writeRoster(rosters, parser)) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 /*!
- * Configure the given \a generator according the command line \a parser
+ * Opens \a file (or stdout) for writing, in \a mode, according to the options in \a parser.
+ *
+ * Returns \c true on success; \c false otherwise.
+ */
+bool openOutput(QFile &file, const QFile::OpenMode mode, const QCommandLineParser &parser)
+{
+    if (parser.isSet(QStringLiteral("output"))) {
+        file.setFileName(parser.value(QStringLiteral("output")));
+        qDebug() << "writing to" << file.fileName();
+        if (!file.open(mode)) {
+            qCritical() << "failed to open" << file.fileName() << "for writing";
+            return false;
+        }
+    } else {
+        qDebug() << "writing to stdout";
+        if (!file.open(stdout, mode)) {
+            qCritical() << "failed to open stdout for writing";
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * Returns the list of ward jobs read from the batch manifest given on the command line \a parser,
+ * or an empty list on error.
+ */
+QVector<Cogent::BatchGenerator::WardJob> readBatchManifest(const QCommandLineParser &parser)
+{
+    const QString fileName = parser.value(QStringLiteral("batch"));
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly|QFile::Text)) {
+        qCritical() << "failed to open" << fileName << "for reading";
+        return QVector<Cogent::BatchGenerator::WardJob>();
+    }
+    QJsonParseError error;
+    const QJsonDocument manifest = QJsonDocument::fromJson(file.readAll(), &error);
+    if (!manifest.isArray()) {
+        qCritical() << "failed to parse" << fileName << error.errorString();
+        return QVector<Cogent::BatchGenerator::WardJob>();
+    }
+
+    const QDir manifestDir(QFileInfo(fileName).absolutePath());
+    QVector<Cogent::BatchGenerator::WardJob> jobs;
+    QSet<QString> wards;
+    foreach (const QVariant &item, manifest.toVariant().toList()) {
+        const QVariantMap map = item.toMap();
+        Cogent::BatchGenerator::WardJob job;
+        job.ward = map.value(QStringLiteral("ward")).toString();
+        if ((job.ward.isEmpty()) || (wards.contains(job.ward))) {
+            qCritical() << "missing or duplicate ward name" << job.ward << "in" << fileName;
+            return QVector<Cogent::BatchGenerator::WardJob>();
+        }
+        wards.insert(job.ward);
+
+        foreach (const QString &month, map.value(QStringLiteral("months")).toStringList()) {
+            const QStringList parts = month.split(QLatin1Char('-'));
+            const int year = parts.first().toInt();
+            const int monthOfYear = parts.last().toInt();
+            if ((parts.size() != 2) || (monthOfYear < 1) || (monthOfYear > 12)) {
+                qCritical() << "invalid month" << month << "for ward" << job.ward;
+                return QVector<Cogent::BatchGenerator::WardJob>();
+            }
+            job.months.append(qMakePair(year, monthOfYear));
+        }
+
+        // Each month continues on from the one before, so they must be consecutive, in order.
+        std::sort(job.months.begin(), job.months.end());
+        for (int index = 1; index < job.months.size(); ++index) {
+            const Cogent::BatchGenerator::Month &previous = job.months.at(index-1);
+            const Cogent::BatchGenerator::Month &current = job.months.at(index);
+            const int gap = (current.first - previous.first) * 12 + current.second - previous.second;
+            if (gap != 1) {
+                qCritical() << ((gap == 0) ? "duplicate month" : "gap before month")
+                            << QStringLiteral("%1-%2").arg(current.first)
+                               .arg(current.second, 2, 10, QLatin1Char('0'))
+                            << "for ward" << job.ward;
+                return QVector<Cogent::BatchGenerator::WardJob>();
+            }
+        }
+
+        QFile nursesFile(manifestDir.absoluteFilePath(map.value(QStringLiteral("nurses")).toString()));
+        qDebug() << "reading nurses list from" << nursesFile.fileName();
+        if (!nursesFile.open(QFile::ReadOnly|QFile::Text)) {
+            qCritical() << "failed to open" << nursesFile.fileName() << "for reading";
+            return QVector<Cogent::BatchGenerator::WardJob>();
+        }
+        job.nurses = readNursesList(nursesFile, parser.isSet(QStringLiteral("skip-dups")));
+        if (job.nurses.isEmpty()) {
+            qCritical() << "have no nurses to roster for ward" << job.ward;
+            return QVector<Cogent::BatchGenerator::WardJob>();
+        }
+        jobs.append(job);
+    }
+    if (jobs.isEmpty()) {
+        qCritical() << "no wards listed in" << fileName;
+    }
+    return jobs;
+}
+
+/*!
+ * Reads the state to carry in to this month from \a fileName, which may be either the previous
+ * month's JSON output, or a snapshot written via --carry-out, into \a carryIn.
+ *
+ * Returns \c true on success; \c false otherwise.
  */
-void configureGenerator(Cogent::RosterGenerator &generator, const QCommandLineParser &parser)
+bool readCarryIn(const QString &fileName, Cogent::CarryIn &carryIn)
 {
-    if (!parser.isSet(QStringLiteral("no-c1")))
-        generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
-    if (!parser.isSet(QStringLiteral("no-c2")))
-        generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(QObject::tr("night")));
-    if (!parser.isSet(QStringLiteral("no-c3")))
-        generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
-    if (!parser.isSet(QStringLiteral("no-c4")))
-        generator.addConstraint(new Cogent::NoSingleDaysOff());
+    QFile file(fileName);
+    qDebug() << "reading carry-in state from" << fileName;
+    if (!file.open(QFile::ReadOnly)) {
+        qCritical() << "failed to open" << fileName << "for reading";
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    const QJsonDocument json = QJsonDocument::fromJson(data);
+    if (json.isObject()) {
+        carryIn = Cogent::CarryIn::fromRoster(json.toVariant().toMap());
+        return true;
+    }
+    bool ok = false;
+    carryIn = Cogent::CarryIn::fromByteArray(data, &ok);
+    if (!ok) {
+        qCritical() << fileName << "is neither a JSON roster nor a carry-out file";
+    }
+    return ok;
+}
+
+/*!
+ * Serves roster requests on the local socket given on the command line \a parser (see
+ * Cogent::RosterServer), until the application quits. Any nurses given on the command line are
+ * loaded into the server's default ward.
+ *
+ * Returns EXIT_FAILURE if the server could not start; otherwise the application's exit code.
+ */
+int serve(const Cogent::Rules &rules, const QVector<Cogent::NurseRecord> &records,
+          const QCommandLineParser &parser)
+{
+    Cogent::RosterServer server([&rules, &records, &parser](Cogent::RosterGenerator &generator) {
+        configureGenerator(generator, rules, records, parser);
+    });
+    if (parser.isSet(QStringLiteral("jobs"))) {
+        server.setMaxThreadCount(parser.value(QStringLiteral("jobs")).toInt());
+    }
+    if (parser.isSet(QStringLiteral("nurses"))) {
+        const QStringList nurses = readNursesList(parser);
+        if (nurses.isEmpty()) {
+            qCritical() << "have no nurses to roster";
+            return EXIT_FAILURE;
+        }
+        server.setNurses(QString(), nurses);
+    }
+    if ((parser.isSet(QStringLiteral("serve-nurses-dir"))) &&
+        (!server.setNurseListDirectory(parser.value(QStringLiteral("serve-nurses-dir"))))) {
+        qCritical() << "no such directory" << parser.value(QStringLiteral("serve-nurses-dir"));
+        return EXIT_FAILURE;
+    }
+    if (!server.listen(parser.value(QStringLiteral("serve")))) {
+        qCritical() << "failed to serve on" << parser.value(QStringLiteral("serve"));
+        return EXIT_FAILURE;
+    }
+    return QCoreApplication::exec();
+}
+
+/*!
+ * Reads nurse \a records from the JSON file named \a fileName (see Cogent::NurseRecord).
+ *
+ * Returns \c true on success; \c false otherwise.
+ */
+bool readNurseRecords(const QString &fileName, QVector<Cogent::NurseRecord> &records)
+{
+    QFile file(fileName);
+    qDebug() << "reading nurse records from" << fileName;
+    if (!file.open(QFile::ReadOnly)) {
+        qCritical() << "failed to open" << fileName << "for reading";
+        return false;
+    }
+    bool ok = false;
+    records = Cogent::NurseRecord::fromJson(file.readAll(), &ok);
+    if (!ok) {
+        qCritical() << "failed to load nurse records from" << fileName;
+    }
+    return ok;
+}
+
+/*!
+ * Returns the rules read from the file given on the command line \a parser (or the built-in rules
+ * if none), less any constraints skipped via the --no-c1 to --no-c4 options, or invalid rules on
+ * error.
+ */
+Cogent::Rules readRules(const QCommandLineParser &parser)
+{
+    Cogent::Rules rules = Cogent::Rules::defaults();
+    if (parser.isSet(QStringLiteral("rules"))) {
+        QFile file(parser.value(QStringLiteral("rules")));
+        qDebug() << "reading rules from" << file.fileName();
+        if (!file.open(QFile::ReadOnly|QFile::Text)) {
+            qCritical() << "failed to open" << file.fileName() << "for reading";
+            return Cogent::Rules();
+        }
+        bool ok = false;
+        rules = Cogent::Rules::fromJson(file.readAll(), &ok);
+        if (!ok) {
+            qCritical() << "failed to load rules from" << file.fileName();
+            return Cogent::Rules();
+        }
+    }
+
+    // Each --no-cN option skips all constraints of the corresponding type.
+    const QStringList types{
+        QStringLiteral("AtMostConsecutiveDays"), QStringLiteral("AtMostShiftsPerMonth"),
+        QStringLiteral("AtMostOneShiftPerDay"),  QStringLiteral("NoSingleDaysOff"),
+    };
+    for (int index = 0; index < types.size(); ++index) {
+        if (parser.isSet(QStringLiteral("no-c%1").arg(index+1))) {
+            rules = rules.withoutConstraint(types.at(index));
+        }
+    }
+    return rules;
+}
+
+/*!
+ * Writes the state to carry in to the month after \a roster (which itself continued on from
+ * \a carryIn) to the file given on the command line \a parser, if any.
+ *
+ * Returns \c true on success, or if no file was given; \c false otherwise.
+ */
+bool writeCarryOut(const QVariantMap &roster, const Cogent::CarryIn &carryIn,
+                   const QCommandLineParser &parser)
+{
+    return (!parser.isSet(QStringLiteral("carry-out"))) ||
+        (writeCarryOut(Cogent::CarryIn::fromRoster(roster, carryIn), parser));
+}
+
+bool writeCarryOut(const Cogent::Roster &days, const Cogent::NurseTable &nurses,
+                   const Cogent::CarryIn &carryIn, const QCommandLineParser &parser)
+{
+    return (!parser.isSet(QStringLiteral("carry-out"))) ||
+        (writeCarryOut(carryIn.advanced(days, nurses), parser));
+}
+
+bool writeCarryOut(const Cogent::CarryIn &carryOut, const QCommandLineParser &parser)
+{
+    QFile file(parser.value(QStringLiteral("carry-out")));
+    qDebug() << "writing carry-out state to" << file.fileName();
+    if (!file.open(QFile::WriteOnly)) {
+        qCritical() << "failed to open" << file.fileName() << "for writing";
+        return false;
+    }
+    const QByteArray data = carryOut.toByteArray();
+    if (file.write(data) != data.size()) {
+        qCritical() << "failed to write carry-out state to file";
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * Writes the generator \a metrics to the file given on the command line \a parser (if any), in the
+ * format given there (JSON by default, or Prometheus text).
+ *
+ * Returns \c true on success, or if no file was given; \c false otherwise.
+ */
+bool writeMetrics(const Cogent::GeneratorMetrics &metrics, const QCommandLineParser &parser)
+{
+    if (!parser.isSet(QStringLiteral("metrics"))) {
+        return true;
+    }
+    const QString format = parser.value(QStringLiteral("metrics-format"));
+    if ((!format.isEmpty()) && (format != QLatin1String("json")) &&
+        (format != QLatin1String("prometheus"))) {
+        qCritical() << "unknown metrics format" << format;
+        return false;
+    }
+    QFile file(parser.value(QStringLiteral("metrics")));
+    qDebug() << "writing metrics to" << file.fileName();
+    if (!file.open(QFile::WriteOnly|QFile::Text)) {
+        qCritical() << "failed to open" << file.fileName() << "for writing";
+        return false;
+    }
+    if (format == QLatin1String("prometheus")) {
+        const QByteArray data = metrics.toPrometheus().toUtf8();
+        if (file.write(data) != data.size()) {
+            qCritical() << "failed to write metrics to file";
+            return false;
+        }
+        return true;
+    }
+    Cogent::JsonWriter writer(&file, parser.isSet(QStringLiteral("compact"))
+        ? QJsonDocument::Compact : QJsonDocument::Indented);
+    if (!writer.write(metrics.toVariantMap())) {
+        qCritical() << "failed to write metrics to file";
+        return false;
+    }
+    return true;
 }
 
 /*!
@@ -103,9 +612,20 @@ void configureLogging(const QCommandLineParser &parser)
     // Start with the Qt default message pattern (see qtbase:::qlogging.cpp:defaultPattern)
     QString messagePattern = QStringLiteral("%{if-category}%{category}: %{endif}%{message}");
 
+    // Enable debug output for all of our logging categories (see Logging.h), and/or apply any
+    // explicit rules (separated by semicolons). Note, debug output is compiled out of release
+    // builds, unless configured with CONFIG+=trace.
+    QStringList filterRules;
     if (parser.isSet(QStringLiteral("debug"))) {
         messagePattern.prepend(QStringLiteral("%{time process} %{type} %{function} "));
         QLoggingCategory::defaultCategory()->setEnabled(QtDebugMsg, true);
+        filterRules.append(QStringLiteral("cogent.*.debug=true"));
+    }
+    if (parser.isSet(QStringLiteral("log-rules"))) {
+        filterRules.append(parser.value(QStringLiteral("log-rules")).split(QLatin1Char(';')));
+    }
+    if (!filterRules.isEmpty()) {
+        QLoggingCategory::setFilterRules(filterRules.join(QLatin1Char('\n')));
     }
 
     if (!parser.isSet(QStringLiteral("no-color"))) {
@@ -145,55 +665,134 @@ QStringList readNursesList(const QCommandLineParser &parser)
     }
 
     // Read all nurses from the input file (or stdin).
-    QSet<QString> nurses;
-    while (!file.atEnd()) {
-        QString nurse = QString::fromLocal8Bit(file.readLine().trimmed());
-        if (!parser.isSet(QStringLiteral("skip-dups"))) {
-            // If (while) we already have a nurse with this name, append the nurse's line number
-            // to their name. Note, the use of 'while' instead of 'if' is rarely necessary, but it
-            // does guarantee uniqueness (in case another nurse's name ends in a number).
-            while (nurses.contains(nurse)) {
-                nurse += QStringLiteral(" (%1)").arg(nurses.size()+1);
-            }
-        }
-        nurses.insert(nurse);
-    }
+    return readNursesList(file, parser.isSet(QStringLiteral("skip-dups")));
+}
+
+/*!
+ * Returns a list of nurses read from \a file, which must already be open for reading, in file
+ * order. If \a skipDups is \c true, duplicate names are skipped, otherwise they are made unique.
+ */
+QStringList readNursesList(QFile &file, const bool skipDups)
+{
+    const Cogent::NurseTable nurses = Cogent::NurseListReader::read(file, skipDups);
     qDebug() << "read" << nurses.size() << "nurses";
-    return nurses.toList();
+    return nurses.toStringList();
 }
 
 /*!
- * Converts \a roster to JSON, and writes it to file or stdout according to the options in
- * \a parser.
+ * Writes \a roster as JSON (or in binary roster format) to file or stdout according to the options
+ * in \a parser.
  *
  * Returns \c true on success; \c false otherwise.
  */
-bool writeToJson(const QVariantMap &roster, const QCommandLineParser &parser)
+bool writeRoster(const QVariantMap &roster, const QCommandLineParser &parser)
 {
     // Open the file (or stdout) for writing.
-    QFile file(parser.value(QStringLiteral("output")));
-    if (parser.isSet(QStringLiteral("output"))) {
-        qDebug() << "writing roster to" << parser.value(QStringLiteral("output"));
-        if (!file.open(QFile::WriteOnly|QFile::Text)) {
-            qCritical() << "failed to open" << parser.value(QStringLiteral("output")) << "for writing";
-            return false;
-        }
-    } else {
-        qDebug() << "writing to roster stdout";
-        if (!file.open(stdout, QFile::WriteOnly|QFile::Text)) {
-            qCritical() << "failed to open stdout for writing";
+    const bool binary = parser.isSet(QStringLiteral("binary"));
+    QFile file;
+    if (!openOutput(file, binary ? QFile::WriteOnly : (QFile::WriteOnly|QFile::Text), parser)) {
+        return false;
+    }
+
+    // Write the roster in binary format, if requested.
+    if (binary) {
+        if (!Cogent::BinaryRoster::write(&file, roster)) {
+            qCritical() << "failed to write binary roster to file";
             return false;
         }
+        return true;
+    }
+
+    // Stream the roster to file as JSON, without first building the whole document in memory.
+    Cogent::JsonWriter writer(&file, parser.isSet(QStringLiteral("compact"))
+        ? QJsonDocument::Compact : QJsonDocument::Indented);
+    if (!writer.write(roster)) {
+        qCritical() << "failed to write JSON to file";
+        return false;
+    }
+    return true;
+}
+
+bool writeRoster(const int year, const int month, const Cogent::Roster &days,
+                 const Cogent::NurseTable &nurses, const QCommandLineParser &parser)
+{
+    // The binary format is written from the roster map, so build that map if requested.
+    const QString monthKey = Cogent::RosterGenerator::monthKey(year, month);
+    if (parser.isSet(QStringLiteral("binary"))) {
+        QVariantMap roster = Cogent::RosterGenerator::metadata();
+        roster.insert(monthKey, days.toVariantList(nurses));
+        return writeRoster(roster, parser);
     }
 
-    // Convert the roster to JSON, and write it to file.
-    const QJsonDocument::JsonFormat jsonFormat = parser.isSet(QStringLiteral("compact"))
-        ? QJsonDocument::Compact : QJsonDocument::Indented;
-    const QByteArray json = QJsonDocument::fromVariant(roster).toJson(jsonFormat);
-    const int bytesWritten = file.write(json);
-    if (bytesWritten != json.size()) {
+    // Otherwise, stream the roster to file as JSON, straight from its compact form.
+    QFile file;
+    if (!openOutput(file, QFile::WriteOnly|QFile::Text, parser)) {
+        return false;
+    }
+    Cogent::JsonWriter writer(&file, parser.isSet(QStringLiteral("compact"))
+        ? QJsonDocument::Compact : QJsonDocument::Indented);
+    if (!writer.write(monthKey, days, nurses, Cogent::RosterGenerator::metadata())) {
         qCritical() << "failed to write JSON to file";
         return false;
     }
     return true;
 }
+
+/*!
+ * Checks the rosters in the JSON or binary roster file given on the command line \a parser against
+ * the \a rules, and writes every violation (if any) as a JSON array, such as:
+ *
+ *     [ { "date": "2018-06-07", "shift": "night", "nurse": "Alice",
+ *         "constraint": "AtMostConsecutiveDays" } ]
+ *
+ * Returns EXIT_SUCCESS if the rosters were read and have no violations; EXIT_FAILURE otherwise.
+ */
+int validateRosters(const Cogent::Rules &rules, const QCommandLineParser &parser)
+{
+    const QString fileName = parser.value(QStringLiteral("validate"));
+    Cogent::RosterValidator validator;
+    rules.configure(validator);
+
+    // Binary roster files are mapped (and checked in place); anything else must be JSON.
+    QVector<Cogent::RosterValidator::Violation> violations;
+    Cogent::BinaryRoster binaryRoster;
+    QFile file(fileName);
+    qDebug() << "reading rosters from" << fileName;
+    if (!file.open(QFile::ReadOnly)) {
+        qCritical() << "failed to open" << fileName << "for reading";
+        return EXIT_FAILURE;
+    }
+    if (file.peek(4) == QByteArray("CGRB")) {
+        file.close();
+        if (!binaryRoster.open(fileName)) {
+            return EXIT_FAILURE;
+        }
+        violations = validator.validate(binaryRoster);
+    } else {
+        QJsonParseError error;
+        const QJsonDocument json = QJsonDocument::fromJson(file.readAll(), &error);
+        if (!json.isObject()) {
+            qCritical() << "failed to parse" << fileName << error.errorString();
+            return EXIT_FAILURE;
+        }
+        violations = validator.validate(json.toVariant().toMap());
+    }
+    qDebug() << "found" << violations.size() << "violations";
+
+    QVariantList list;
+    list.reserve(violations.size());
+    foreach (const Cogent::RosterValidator::Violation &violation, violations) {
+        list.append(violation.toVariantMap());
+    }
+    QFile output;
+    if (!openOutput(output, QFile::WriteOnly|QFile::Text, parser)) {
+        return EXIT_FAILURE;
+    }
+    Cogent::JsonWriter writer(&output, parser.isSet(QStringLiteral("compact"))
+        ? QJsonDocument::Compact : QJsonDocument::Indented);
+    if (!writer.write(list)) {
+        qCritical() << "failed to write JSON to file";
+        return EXIT_FAILURE;
+    }
+    return violations.isEmpty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
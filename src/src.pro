@@ -2,6 +2,10 @@
 TEMPLATE = app
 TARGET = roster
 QT -= gui
+QT += network
+
+# RosterServer queues responses via QMetaObject::invokeMethod with a functor, new in Qt 5.10.
+equals(QT_MAJOR_VERSION, 5):lessThan(QT_MINOR_VERSION, 10): error(Qt 5.10 or later is required)
 
 # Enable message log contexts (file, line, function).
 DEFINES += QT_MESSAGELOGCONTEXT
@@ -12,10 +16,19 @@ DEFINES += QT_NO_CAST_FROM_ASCII QT_NO_CAST_TO_ASCII
 # Enable C++11 and all compiler warnings.
 CONFIG += C++11 warn_on
 
+# Compile debug (trace) output out of release builds, unless configured with CONFIG+=trace.
+CONFIG(release,debug|release):!trace: DEFINES += QT_NO_DEBUG_OUTPUT
+
 # Treat warnings as errors.
 win32-msvc*:QMAKE_CXXFLAGS_WARN_ON += /WX
 else:       QMAKE_CXXFLAGS_WARN_ON += -Werror
 
+# Use AVX2 instructions (such as in NurseSet's bulk operations), if configured with CONFIG+=avx2.
+avx2 {
+  win32-msvc*:QMAKE_CXXFLAGS += /arch:AVX2
+  else:       QMAKE_CXXFLAGS += -mavx2
+}
+
 # Neaten the output directories (also makes them consistent across platforms).
 CONFIG(debug,debug|release) DESTDIR = debug
 CONFIG(release,debug|release) DESTDIR = release
@@ -26,13 +39,35 @@ UI_DIR = $$DESTDIR/tmp
 
 # Include resources and source files.
 HEADERS += \
+  AtMostConsecutiveDays.h \
   AtMostFiveConsecutiveDays.h \
   AtMostFiveNightShiftsPerMonth.h \
   AtMostOneShiftPerDay.h \
+  AtMostShiftsPerMonth.h \
+  Availability.h \
+  BatchGenerator.h \
+  BinaryRoster.h \
+  CarryIn.h \
   ConstraintInterface.h \
+  Demand.h \
+  FairScheduler.h \
+  GeneratorMetrics.h \
+  JsonWriter.h \
   LeastRecentScheduler.h \
+  Logging.h \
   NoSingleDaysOff.h \
+  NurseListReader.h \
+  NurseRecord.h \
+  NurseSet.h \
+  NurseTable.h \
+  RestartGenerator.h \
+  Roster.h \
   RosterGenerator.h \
+  RosterServer.h \
+  RosterValidator.h \
+  Rules.h \
   SchedulerInterface.h \
+  ScratchPool.h \
+  StaticRosterGenerator.h \
 
 SOURCES += main.cpp
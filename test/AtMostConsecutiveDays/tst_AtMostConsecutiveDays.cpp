@@ -0,0 +1,95 @@
+#include "../../src/AtMostConsecutiveDays.h"
+
+#include <QTest>
+
+// Returns a roster of \a days days, with nurse 0 rostered on the last \a streak of them, and
+// nurse 1 on all but the day before those, followed by an empty current day.
+Cogent::Roster makeRoster(const int days, const int streak)
+{
+    Cogent::Roster roster;
+    for (int day = 0; day < days; ++day) {
+        roster.appendDay();
+        if (day != days - streak - 1) {
+            roster.assign(day, Cogent::Roster::MorningShift, (day < days - streak) ? 1 : 0);
+        }
+    }
+    roster.appendDay();
+    return roster;
+}
+
+class tst_AtMostConsecutiveDays : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void constrain_data();
+    void constrain();
+    void carryIn_data();
+    void carryIn();
+};
+
+void tst_AtMostConsecutiveDays::constrain_data()
+{
+    QTest::addColumn<int>("maxDays");
+    QTest::addColumn<int>("days");
+    QTest::addColumn<int>("streak");
+    QTest::addColumn<int>("removed");
+
+    QTest::newRow("one-day-limit-none-worked")   << 1 << 3  << 0 << 0;
+    QTest::newRow("one-day-limit-one-worked")    << 1 << 3  << 1 << 1;
+    QTest::newRow("three-day-limit-two-worked")  << 3 << 5  << 2 << 0;
+    QTest::newRow("three-day-limit-three-worked") << 3 << 5  << 3 << 1;
+    QTest::newRow("three-day-limit-first-days")  << 3 << 3  << 3 << 1;
+    QTest::newRow("seven-day-limit-six-worked")  << 7 << 10 << 6 << 0;
+    QTest::newRow("seven-day-limit-seven-worked") << 7 << 10 << 7 << 1;
+    QTest::newRow("seven-day-limit-ten-worked")  << 7 << 10 << 10 << 1;
+}
+
+void tst_AtMostConsecutiveDays::constrain()
+{
+    QFETCH(int, maxDays);
+    QFETCH(int, days);
+    QFETCH(int, streak);
+    QFETCH(int, removed);
+
+    const Cogent::Roster roster = makeRoster(days, streak);
+    Cogent::AtMostConsecutiveDays constraint(maxDays);
+    constraint.replay(roster, 2);
+    Cogent::NurseSet nurses(2, true);
+    QCOMPARE(constraint.constrain(nurses, Cogent::Roster::MorningShift, roster), removed);
+    QCOMPARE(nurses.contains(0), removed == 0);
+    QVERIFY(nurses.contains(1));
+}
+
+void tst_AtMostConsecutiveDays::carryIn_data()
+{
+    QTest::addColumn<int>("maxDays");
+    QTest::addColumn<int>("carriedDays");
+    QTest::addColumn<int>("streak");
+    QTest::addColumn<int>("removed");
+
+    QTest::newRow("under-limit")              << 4 << 1 << 2 << 0;
+    QTest::newRow("at-limit-across-months")   << 4 << 2 << 2 << 1;
+    QTest::newRow("at-limit-before-month")    << 4 << 4 << 0 << 1;
+    QTest::newRow("over-limit-before-month")  << 4 << 6 << 0 << 1;
+}
+
+void tst_AtMostConsecutiveDays::carryIn()
+{
+    QFETCH(int, maxDays);
+    QFETCH(int, carriedDays);
+    QFETCH(int, streak);
+    QFETCH(int, removed);
+
+    // Nurse 0's streak continues on from the carried-in days (if worked from the first day).
+    const Cogent::Roster roster = makeRoster(streak, streak);
+    const QVector<Cogent::CarryIn::Streak> streaks{ { carriedDays, 0 }, { 0, 1 } };
+    Cogent::AtMostConsecutiveDays constraint(maxDays);
+    constraint.replay(roster, 2, streaks);
+    Cogent::NurseSet nurses(2, true);
+    QCOMPARE(constraint.constrain(nurses, Cogent::Roster::MorningShift, roster), removed);
+    QCOMPARE(nurses.contains(0), removed == 0);
+}
+
+QTEST_APPLESS_MAIN(tst_AtMostConsecutiveDays)
+#include "tst_AtMostConsecutiveDays.moc"
@@ -1,9 +1,8 @@
 #include "../../src/AtMostFiveConsecutiveDays.h"
+#include "../TestConstraints.h"
 
 #include <QTest>
 
-typedef Cogent::ConstraintInterface::QStringSet QStringSet;
-
 class tst_AtMostFiveConsecutiveDays : public QObject
 {
     Q_OBJECT
@@ -11,6 +10,10 @@ class tst_AtMostFiveConsecutiveDays : public QObject
 private slots:
     void constrain_data();
     void constrain();
+    void rewind_data();
+    void rewind();
+    void carryIn_data();
+    void carryIn();
 };
 
 void tst_AtMostFiveConsecutiveDays::constrain_data()
@@ -111,21 +114,80 @@ void tst_AtMostFiveConsecutiveDays::constrain()
     QFETCH(QStringSet, expected);
     QFETCH(int, removed);
 
+    Cogent::NurseTable table;
+    const Cogent::Roster roster = Cogent::Roster::fromVariantList(days, table);
+    Cogent::NurseSet nurseIds = toNurseIds(nurses, table);
+
     Cogent::AtMostFiveConsecutiveDays constraint;
-    QCOMPARE(constraint.constrain(nurses, QString(), days), removed);
-    QCOMPARE(nurses, expected);
+    constraint.replay(roster, table.size());
+    QCOMPARE(constraint.constrain(nurseIds, Cogent::Roster::MorningShift, roster), removed);
+    QCOMPARE(toNames(nurseIds, table), expected);
 }
 
-// Let QTest know how to format QStringSet values (via QDebug, which already supports QSet).
-namespace QTest {
-    template<> char *toString(const QStringSet &value)
-    {
-        QString string;
-        QDebug debug(&string);
-        debug << value;
-        return qstrdup(string.toLocal8Bit().data());
-    }
-};
+void tst_AtMostFiveConsecutiveDays::rewind_data()
+{
+    constrain_data();
+}
+
+void tst_AtMostFiveConsecutiveDays::rewind()
+{
+    QFETCH(QVariantList, days);
+    QFETCH(QStringSet, nurses);
+    QFETCH(QStringSet, expected);
+    QFETCH(int, removed);
+
+    Cogent::NurseTable table;
+    const Cogent::Roster roster = Cogent::Roster::fromVariantList(days, table);
+    Cogent::NurseSet nurseIds = toNurseIds(nurses, table);
+
+    Cogent::AtMostFiveConsecutiveDays constraint;
+    // Replay a later, fully rostered day too, then rewind back to the current day.
+    const Cogent::Roster moreDays = withFullDay(roster, table.size());
+    constraint.replay(moreDays, table.size());
+    constraint.rewind(moreDays, roster.size()-1);
+    QCOMPARE(constraint.constrain(nurseIds, Cogent::Roster::MorningShift, roster), removed);
+    QCOMPARE(toNames(nurseIds, table), expected);
+}
+
+void tst_AtMostFiveConsecutiveDays::carryIn_data()
+{
+    addCarryInColumns();
+
+    const QStringSet alice { QStringLiteral("Alice") };
+    const QStringSet bob   { QStringLiteral("Bob")   };
+    const QStringSet aliceAndBob{ QStringLiteral("Alice"), QStringLiteral("Bob") };
+    const QVariantMap aliceOn{ { QStringLiteral("morning"), QVariant(alice.toList()) } };
+    const QVariantMap allOff;
+
+    QTest::newRow("nothing-carried-in")
+        << QVariantList() << QVariantList{ allOff } << aliceAndBob << aliceAndBob << 0;
+
+    QTest::newRow("four-on-at-month-end")
+        << QVariantList{ allOff, aliceOn, aliceOn, aliceOn, aliceOn } << QVariantList{ allOff }
+        << aliceAndBob << aliceAndBob << 0;
+
+    QTest::newRow("five-on-at-month-end")
+        << QVariantList{ aliceOn, aliceOn, aliceOn, aliceOn, aliceOn } << QVariantList{ allOff }
+        << aliceAndBob << bob << 1;
+
+    QTest::newRow("five-on-then-off-at-month-end")
+        << QVariantList{ aliceOn, aliceOn, aliceOn, aliceOn, aliceOn, allOff }
+        << QVariantList{ allOff } << aliceAndBob << aliceAndBob << 0;
+
+    QTest::newRow("two-on-at-month-end-then-three")
+        << QVariantList{ aliceOn, aliceOn } << QVariantList{ aliceOn, aliceOn, aliceOn, allOff }
+        << aliceAndBob << bob << 1;
+
+    QTest::newRow("two-on-at-month-end-then-two")
+        << QVariantList{ aliceOn, aliceOn } << QVariantList{ aliceOn, aliceOn, allOff }
+        << aliceAndBob << aliceAndBob << 0;
+}
+
+void tst_AtMostFiveConsecutiveDays::carryIn()
+{
+    Cogent::AtMostFiveConsecutiveDays constraint;
+    verifyCarryIn(constraint, Cogent::Roster::MorningShift);
+}
 
 QTEST_APPLESS_MAIN(tst_AtMostFiveConsecutiveDays)
 #include "tst_AtMostFiveConsecutiveDays.moc"
@@ -1,9 +1,8 @@
 #include "../../src/AtMostFiveNightShiftsPerMonth.h"
+#include "../TestNurses.h"
 
 #include <QTest>
 
-typedef Cogent::ConstraintInterface::QStringSet QStringSet;
-
 class tst_AtMostFiveNightShiftsPerMonth : public QObject
 {
     Q_OBJECT
@@ -11,6 +10,8 @@ class tst_AtMostFiveNightShiftsPerMonth : public QObject
 private slots:
     void constrain_data();
     void constrain();
+    void rewind_data();
+    void rewind();
 };
 
 void tst_AtMostFiveNightShiftsPerMonth::constrain_data()
@@ -127,30 +128,58 @@ void tst_AtMostFiveNightShiftsPerMonth::constrain()
     QFETCH(QStringSet, expected);
     QFETCH(int, removed);
 
-    Cogent::AtMostFiveNightShiftsPerMonth constraint(QStringLiteral("night"));
+    Cogent::NurseTable table;
+    const Cogent::Roster roster = Cogent::Roster::fromVariantList(days, table);
+    Cogent::NurseSet nurseIds = toNurseIds(nurses, table);
+
+    Cogent::AtMostFiveNightShiftsPerMonth constraint(Cogent::Roster::NightShift);
+    constraint.replay(roster, table.size());
 
     {   // When for non-night shifts, the constrain should remove no-one.
-        QStringSet tempNurses = nurses;
-        QCOMPARE(constraint.constrain(tempNurses, QString(), days), 0);
-        QCOMPARE(tempNurses, nurses);
-        QCOMPARE(constraint.constrain(tempNurses, QStringLiteral("morning"), days), 0);
-        QCOMPARE(tempNurses, nurses);
+        Cogent::NurseSet tempNurses = nurseIds;
+        QCOMPARE(constraint.constrain(tempNurses, -1, roster), 0);
+        QCOMPARE(tempNurses, nurseIds);
+        QCOMPARE(constraint.constrain(tempNurses, Cogent::Roster::MorningShift, roster), 0);
+        QCOMPARE(tempNurses, nurseIds);
     }
 
-    QCOMPARE(constraint.constrain(nurses, QStringLiteral("night"), days), removed);
-    QCOMPARE(nurses, expected);
+    QCOMPARE(constraint.constrain(nurseIds, Cogent::Roster::NightShift, roster), removed);
+    QCOMPARE(toNames(nurseIds, table), expected);
+}
+
+void tst_AtMostFiveNightShiftsPerMonth::rewind_data()
+{
+    constrain_data();
 }
 
-// Let QTest know how to format QStringSet values (via QDebug, which already supports QSet).
-namespace QTest {
-    template<> char *toString(const QStringSet &value)
-    {
-        QString string;
-        QDebug debug(&string);
-        debug << value;
-        return qstrdup(string.toLocal8Bit().data());
+void tst_AtMostFiveNightShiftsPerMonth::rewind()
+{
+    QFETCH(QVariantList, days);
+    QFETCH(QStringSet, nurses);
+    QFETCH(QStringSet, expected);
+    QFETCH(int, removed);
+
+    Cogent::NurseTable table;
+    const Cogent::Roster roster = Cogent::Roster::fromVariantList(days, table);
+    Cogent::NurseSet nurseIds = toNurseIds(nurses, table);
+
+    Cogent::AtMostFiveNightShiftsPerMonth constraint(Cogent::Roster::NightShift);
+    // Replay a later, fully rostered day too, then rewind back to the current day.
+    const Cogent::Roster moreDays = withFullDay(roster, table.size());
+    constraint.replay(moreDays, table.size());
+    constraint.rewind(moreDays, roster.size()-1);
+
+    {   // When for non-night shifts, the constrain should remove no-one.
+        Cogent::NurseSet tempNurses = nurseIds;
+        QCOMPARE(constraint.constrain(tempNurses, -1, roster), 0);
+        QCOMPARE(tempNurses, nurseIds);
+        QCOMPARE(constraint.constrain(tempNurses, Cogent::Roster::MorningShift, roster), 0);
+        QCOMPARE(tempNurses, nurseIds);
     }
-};
+
+    QCOMPARE(constraint.constrain(nurseIds, Cogent::Roster::NightShift, roster), removed);
+    QCOMPARE(toNames(nurseIds, table), expected);
+}
 
 QTEST_APPLESS_MAIN(tst_AtMostFiveNightShiftsPerMonth)
 #include "tst_AtMostFiveNightShiftsPerMonth.moc"
@@ -1,9 +1,8 @@
 #include "../../src/AtMostOneShiftPerDay.h"
+#include "../TestNurses.h"
 
 #include <QTest>
 
-typedef Cogent::ConstraintInterface::QStringSet QStringSet;
-
 class tst_AtMostOneShiftPerDay : public QObject
 {
     Q_OBJECT
@@ -11,6 +10,8 @@ class tst_AtMostOneShiftPerDay : public QObject
 private slots:
     void constrain_data();
     void constrain();
+    void rewind_data();
+    void rewind();
 };
 
 void tst_AtMostOneShiftPerDay::constrain_data()
@@ -51,21 +52,40 @@ void tst_AtMostOneShiftPerDay::constrain()
     QFETCH(QStringSet, expected);
     QFETCH(int, removed);
 
+    Cogent::NurseTable table;
+    const Cogent::Roster roster = Cogent::Roster::fromVariantList(days, table);
+    Cogent::NurseSet nurseIds = toNurseIds(nurses, table);
+
     Cogent::AtMostOneShiftPerDay constraint;
-    QCOMPARE(constraint.constrain(nurses, QString(), days), removed);
-    QCOMPARE(nurses, expected);
+    constraint.replay(roster, table.size());
+    QCOMPARE(constraint.constrain(nurseIds, Cogent::Roster::MorningShift, roster), removed);
+    QCOMPARE(toNames(nurseIds, table), expected);
 }
 
-// Let QTest know how to format QStringSet values (via QDebug, which already supports QSet).
-namespace QTest {
-    template<> char *toString(const QStringSet &value)
-    {
-        QString string;
-        QDebug debug(&string);
-        debug << value;
-        return qstrdup(string.toLocal8Bit().data());
-    }
-};
+void tst_AtMostOneShiftPerDay::rewind_data()
+{
+    constrain_data();
+}
+
+void tst_AtMostOneShiftPerDay::rewind()
+{
+    QFETCH(QVariantList, days);
+    QFETCH(QStringSet, nurses);
+    QFETCH(QStringSet, expected);
+    QFETCH(int, removed);
+
+    Cogent::NurseTable table;
+    const Cogent::Roster roster = Cogent::Roster::fromVariantList(days, table);
+    Cogent::NurseSet nurseIds = toNurseIds(nurses, table);
+
+    Cogent::AtMostOneShiftPerDay constraint;
+    // Replay a later, fully rostered day too, then rewind back to the current day.
+    const Cogent::Roster moreDays = withFullDay(roster, table.size());
+    constraint.replay(moreDays, table.size());
+    constraint.rewind(moreDays, roster.size()-1);
+    QCOMPARE(constraint.constrain(nurseIds, Cogent::Roster::MorningShift, roster), removed);
+    QCOMPARE(toNames(nurseIds, table), expected);
+}
 
 QTEST_APPLESS_MAIN(tst_AtMostOneShiftPerDay)
 #include "tst_AtMostOneShiftPerDay.moc"
@@ -0,0 +1,73 @@
+#include "../../src/AtMostShiftsPerMonth.h"
+
+#include <QTest>
+
+// Returns a roster with nurse 0 rostered on \a count of \a shift (one per day), and nurse 1 on
+// the same number of another shift, followed by an empty current day.
+Cogent::Roster makeRoster(const int shift, const int count)
+{
+    Cogent::Roster roster;
+    for (int day = 0; day < count; ++day) {
+        roster.appendDay();
+        roster.assign(day, shift, 0);
+        roster.assign(day, (shift + 1) % roster.shiftCount(), 1);
+    }
+    roster.appendDay();
+    return roster;
+}
+
+class tst_AtMostShiftsPerMonth : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void constrain_data();
+    void constrain();
+};
+
+void tst_AtMostShiftsPerMonth::constrain_data()
+{
+    QTest::addColumn<int>("shift");
+    QTest::addColumn<int>("maxShifts");
+    QTest::addColumn<int>("count");
+    QTest::addColumn<int>("removed");
+
+    QTest::newRow("one-morning-of-one")    << int(Cogent::Roster::MorningShift) << 1 << 1 << 1;
+    QTest::newRow("two-mornings-of-three") << int(Cogent::Roster::MorningShift) << 3 << 2 << 0;
+    QTest::newRow("three-mornings-of-three")
+        << int(Cogent::Roster::MorningShift) << 3 << 3 << 1;
+    QTest::newRow("seven-nights-of-eight") << int(Cogent::Roster::NightShift)   << 8 << 7 << 0;
+    QTest::newRow("eight-nights-of-eight") << int(Cogent::Roster::NightShift)   << 8 << 8 << 1;
+    QTest::newRow("no-evenings-of-two")    << int(Cogent::Roster::EveningShift) << 2 << 0 << 0;
+    QTest::newRow("four-evenings-of-two")  << int(Cogent::Roster::EveningShift) << 2 << 4 << 1;
+}
+
+void tst_AtMostShiftsPerMonth::constrain()
+{
+    QFETCH(int, shift);
+    QFETCH(int, maxShifts);
+    QFETCH(int, count);
+    QFETCH(int, removed);
+
+    const Cogent::Roster roster = makeRoster(shift, count);
+    Cogent::AtMostShiftsPerMonth constraint(shift, maxShifts);
+    constraint.replay(roster, 2);
+    const Cogent::NurseSet allNurses(2, true);
+
+    // Other shifts are not limited at all.
+    for (int otherShift = 0; otherShift < roster.shiftCount(); ++otherShift) {
+        if (otherShift != shift) {
+            Cogent::NurseSet nurses = allNurses;
+            QCOMPARE(constraint.constrain(nurses, otherShift, roster), 0);
+            QCOMPARE(nurses, allNurses);
+        }
+    }
+
+    Cogent::NurseSet nurses = allNurses;
+    QCOMPARE(constraint.constrain(nurses, shift, roster), removed);
+    QCOMPARE(nurses.contains(0), removed == 0);
+    QVERIFY(nurses.contains(1));
+}
+
+QTEST_APPLESS_MAIN(tst_AtMostShiftsPerMonth)
+#include "tst_AtMostShiftsPerMonth.moc"
@@ -0,0 +1,155 @@
+#include "../../src/Availability.h"
+#include "../../src/Roster.h"
+
+#include <QTest>
+
+class tst_Availability : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void unrestricted();
+    void leave();
+    void shifts();
+    void skills();
+    void caps();
+
+protected:
+    Cogent::NurseTable nurses;
+    QHash<QString, Cogent::NurseRecord> records;
+
+    // Returns the availability of all nurses, per their records, for June 2018.
+    Cogent::Availability june(const QVector<QSet<QString>> &shiftSkills =
+                                  QVector<QSet<QString>>()) const
+    {
+        return Cogent::Availability(records, nurses, Cogent::Roster::defaultShiftNames(),
+                                    shiftSkills, QDate(2018, 6, 1), 30);
+    }
+};
+
+void tst_Availability::init()
+{
+    nurses = Cogent::NurseTable(QStringList{
+        QStringLiteral("Alice"), QStringLiteral("Bob"), QStringLiteral("Carol") });
+    records.clear();
+    foreach (const QString &name, nurses.toStringList()) {
+        records.insert(name, Cogent::NurseRecord(name));
+    }
+}
+
+void tst_Availability::unrestricted()
+{
+    const Cogent::Availability none;
+    QVERIFY(none.isEmpty());
+
+    // Records without any restrictions still build (full) masks.
+    const Cogent::Availability availability = june();
+    QVERIFY(!availability.isEmpty());
+    for (int day = 0; day < 30; ++day) {
+        for (int shift = 0; shift < 3; ++shift) {
+            QCOMPARE(availability.mask(day, shift).count(), 3);
+            QCOMPARE(availability.candidates(day, shift).count(), 3);
+        }
+    }
+}
+
+void tst_Availability::leave()
+{
+    // Leave that starts before, and ends after, the month is clipped to the month.
+    records[QStringLiteral("Alice")].leave.append(qMakePair(QDate(2018, 5, 28), QDate(2018, 6, 2)));
+    records[QStringLiteral("Alice")].leave.append(qMakePair(QDate(2018, 6, 15), QDate(2018, 6, 15)));
+    records[QStringLiteral("Bob")].leave.append(qMakePair(QDate(2018, 6, 29), QDate(2018, 7, 10)));
+    records[QStringLiteral("Carol")].leave.append(qMakePair(QDate(2018, 7, 1), QDate(2018, 7, 2)));
+
+    const Cogent::Availability availability = june();
+    const Cogent::NurseId alice = nurses.id(QStringLiteral("Alice"));
+    const Cogent::NurseId bob = nurses.id(QStringLiteral("Bob"));
+    for (int day = 0; day < 30; ++day) {
+        const QDate date(2018, 6, day + 1);
+        for (int shift = 0; shift < 3; ++shift) {
+            const Cogent::NurseSet mask = availability.mask(day, shift);
+            QCOMPARE(mask.contains(alice),
+                     !records.value(QStringLiteral("Alice")).isOnLeave(date));
+            QCOMPARE(mask.contains(bob), day < 28);
+            QVERIFY(mask.contains(nurses.id(QStringLiteral("Carol"))));
+        }
+    }
+    QCOMPARE(availability.nurses(0).count(), 2);
+    QCOMPARE(availability.nurses(2).count(), 3);
+    QCOMPARE(availability.nurses(29).count(), 2);
+}
+
+void tst_Availability::shifts()
+{
+    records[QStringLiteral("Bob")].shifts.insert(QStringLiteral("night"));
+    const Cogent::Availability availability = june();
+    const Cogent::NurseId bob = nurses.id(QStringLiteral("Bob"));
+    for (int day = 0; day < 30; ++day) {
+        QVERIFY(availability.mask(day, Cogent::Roster::NightShift).contains(bob));
+        QVERIFY(!availability.mask(day, Cogent::Roster::MorningShift).contains(bob));
+        QVERIFY(!availability.mask(day, Cogent::Roster::EveningShift).contains(bob));
+    }
+}
+
+void tst_Availability::skills()
+{
+    // Only Carol has the skills required for night shifts; nurses without records have none.
+    records[QStringLiteral("Alice")].skills.insert(QStringLiteral("icu"));
+    records[QStringLiteral("Carol")].skills.insert(QStringLiteral("icu"));
+    records[QStringLiteral("Carol")].skills.insert(QStringLiteral("senior"));
+    records.remove(QStringLiteral("Bob"));
+    QVector<QSet<QString>> shiftSkills(3);
+    shiftSkills[Cogent::Roster::NightShift].insert(QStringLiteral("icu"));
+    shiftSkills[Cogent::Roster::NightShift].insert(QStringLiteral("senior"));
+    shiftSkills[Cogent::Roster::MorningShift].insert(QStringLiteral("icu"));
+
+    const Cogent::Availability availability = june(shiftSkills);
+    const Cogent::NurseSet night = availability.mask(0, Cogent::Roster::NightShift);
+    QCOMPARE(night.count(), 1);
+    QVERIFY(night.contains(nurses.id(QStringLiteral("Carol"))));
+    const Cogent::NurseSet morning = availability.mask(0, Cogent::Roster::MorningShift);
+    QCOMPARE(morning.count(), 2);
+    QVERIFY(!morning.contains(nurses.id(QStringLiteral("Bob"))));
+    QCOMPARE(availability.mask(0, Cogent::Roster::EveningShift).count(), 3);
+}
+
+void tst_Availability::caps()
+{
+    records[QStringLiteral("Alice")].maxShifts = 2;
+    records[QStringLiteral("Bob")].maxShifts = 0;
+    Cogent::Availability availability = june();
+    const Cogent::NurseId alice = nurses.id(QStringLiteral("Alice"));
+    const Cogent::NurseId bob = nurses.id(QStringLiteral("Bob"));
+    const Cogent::NurseId carol = nurses.id(QStringLiteral("Carol"));
+
+    // Caps do not affect the masks themselves, only the candidates.
+    QVERIFY(availability.mask(0, 0).contains(bob));
+    QVERIFY(!availability.candidates(0, 0).contains(bob));
+    QVERIFY(availability.candidates(0, 0).contains(alice));
+
+    availability.onAssigned(alice);
+    QVERIFY(availability.candidates(0, 0).contains(alice));
+    availability.onAssigned(alice);
+    for (int day = 0; day < 30; ++day) {
+        QVERIFY(!availability.candidates(day, 1).contains(alice));
+    }
+
+    // Candidates can also be copied into an existing set, replacing its contents.
+    Cogent::NurseSet candidates(1000, true);
+    QCOMPARE(availability.candidates(0, 1, candidates), availability.candidates(0, 1));
+    QCOMPARE(candidates.capacity(), availability.mask(0, 1).capacity());
+
+    // Undoing an assignment makes the nurse available again.
+    availability.onUnassigned(alice);
+    QVERIFY(availability.candidates(0, 0).contains(alice));
+
+    // Uncapped nurses are never removed.
+    for (int count = 0; count < 100; ++count) {
+        availability.onAssigned(carol);
+    }
+    QVERIFY(availability.candidates(0, 0).contains(carol));
+}
+
+QTEST_APPLESS_MAIN(tst_Availability)
+#include "tst_Availability.moc"
@@ -0,0 +1,121 @@
+#include "../../src/AtMostFiveConsecutiveDays.h"
+#include "../../src/AtMostFiveNightShiftsPerMonth.h"
+#include "../../src/AtMostOneShiftPerDay.h"
+#include "../../src/BatchGenerator.h"
+#include "../../src/NoSingleDaysOff.h"
+#include "../TestNurses.h"
+
+#include <QTest>
+
+// Adds the standard constraints to \a generator.
+void addConstraints(Cogent::RosterGenerator &generator)
+{
+    generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+}
+
+// Returns a copy of \a roster without its (time-dependent) "created" metadata.
+QVariantMap withoutCreated(QVariantMap roster)
+{
+    roster.remove(QStringLiteral("created"));
+    return roster;
+}
+
+class tst_BatchGenerator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void generate_data();
+    void generate();
+    void failedWard();
+};
+
+void tst_BatchGenerator::generate_data()
+{
+    QTest::addColumn<int>("wardCount");
+    QTest::addColumn<int>("maxThreads");
+
+    QTest::newRow("one-ward-one-thread")     << 1  << 1;
+    QTest::newRow("many-wards-one-thread")   << 8  << 1;
+    QTest::newRow("many-wards-many-threads") << 12 << 4;
+}
+
+void tst_BatchGenerator::generate()
+{
+    QFETCH(int, wardCount);
+    QFETCH(int, maxThreads);
+
+    // Build a job for each ward, with varying numbers of nurses and months.
+    const QVector<Cogent::BatchGenerator::Month> months{
+        qMakePair(2018, 11), qMakePair(2018, 12), qMakePair(2019, 1)
+    };
+    QVector<Cogent::BatchGenerator::WardJob> jobs;
+    for (int ward = 0; ward < wardCount; ++ward) {
+        Cogent::BatchGenerator::WardJob job;
+        job.ward = QStringLiteral("ward %1").arg(ward);
+        job.nurses = makeNurses(40 + ward);
+        job.months = months.mid(0, 1 + ward % months.size());
+        jobs.append(job);
+    }
+
+    Cogent::BatchGenerator batch(addConstraints);
+    batch.setMaxThreadCount(maxThreads);
+    const QVariantMap rosters = batch.generate(jobs);
+    QCOMPARE(rosters.size(), wardCount);
+
+    // Each ward's roster should match that of a single generator, run over the months in order,
+    // carrying each month's state in to the next.
+    foreach (const Cogent::BatchGenerator::WardJob &job, jobs) {
+        Cogent::RosterGenerator generator;
+        addConstraints(generator);
+        QVariantMap expected;
+        Cogent::CarryIn carryIn;
+        foreach (const Cogent::BatchGenerator::Month &month, job.months) {
+            const QVariantMap roster =
+                generator.generate(month.first, month.second, job.nurses, carryIn);
+            QVERIFY(!roster.isEmpty());
+            carryIn = Cogent::CarryIn::fromRoster(roster, carryIn);
+            const QVariantMap monthRoster = withoutCreated(roster);
+            for (auto iter = monthRoster.constBegin(); iter != monthRoster.constEnd(); ++iter) {
+                expected.insert(iter.key(), iter.value());
+            }
+        }
+        const QVariantMap actual = rosters.value(job.ward).toMap();
+        QVERIFY(actual.contains(QStringLiteral("created")));
+        QCOMPARE(withoutCreated(actual), expected);
+        QCOMPARE(expected.size(), job.months.size());
+    }
+}
+
+void tst_BatchGenerator::failedWard()
+{
+    // One nurse can never satisfy any constraints, so that ward should fail, but not the other.
+    Cogent::BatchGenerator::WardJob tiny, large;
+    tiny.ward = QStringLiteral("tiny");
+    tiny.nurses = QStringList{ QStringLiteral("Alice") };
+    tiny.months = { qMakePair(2018, 5) };
+    large.ward = QStringLiteral("large");
+    large.nurses = makeNurses(50);
+    large.months = { qMakePair(2018, 5), qMakePair(2018, 6) };
+
+    Cogent::BatchGenerator batch(addConstraints);
+    const QVariantMap rosters = batch.generate(QVector<Cogent::BatchGenerator::WardJob>{ tiny, large });
+    QCOMPARE(rosters.size(), 2);
+    QVERIFY(rosters.value(QStringLiteral("tiny")).toMap().isEmpty());
+    QVERIFY(rosters.value(QStringLiteral("large")).toMap().contains(QStringLiteral("2018-06")));
+
+    // Both wards' metrics are combined, including the tiny ward's infeasible month.
+    const Cogent::GeneratorMetrics metrics = batch.metrics();
+    QCOMPARE(metrics.rosters, qint64(3));
+    QCOMPARE(metrics.failures, qint64(1));
+    QCOMPARE(metrics.infeasible, qint64(1));
+    QCOMPARE(metrics.schedulerCalls, qint64((31 + 30) * 3));
+    QCOMPARE(metrics.constraints.size(), 4);
+    QCOMPARE(metrics.constraints.at(0).calls, qint64((31 + 30) * 3));
+}
+
+QTEST_APPLESS_MAIN(tst_BatchGenerator)
+#include "tst_BatchGenerator.moc"
@@ -0,0 +1,207 @@
+#include "../../src/BinaryRoster.h"
+
+#include <QBuffer>
+#include <QTemporaryDir>
+#include <QTest>
+
+// Returns a day with \a night, \a morning and \a evening nurses on the respective shifts.
+QVariantMap day(const QStringList &night, const QStringList &morning, const QStringList &evening)
+{
+    return QVariantMap{
+        { QStringLiteral("night"),   night },
+        { QStringLiteral("morning"), morning },
+        { QStringLiteral("evening"), evening },
+    };
+}
+
+// Returns a three day roster, in the form RosterGenerator::generate returns (but without metadata).
+QVariantMap makeRoster(const QString &month)
+{
+    const QString alice = QStringLiteral("Alice"), bob = QStringLiteral("Bob");
+    const QString carol = QStringLiteral("Carol"), zoe = QString::fromUtf8("Zo\xc3\xab");
+    return QVariantMap{
+        { month, QVariantList{
+            day({ alice }, { bob, carol }, { zoe }),
+            day({ bob }, { alice }, { carol, zoe }),
+            day({ }, { zoe, alice, bob }, { }),
+        } },
+    };
+}
+
+// Returns \a bytes with the 32-bit little-endian word at \a offset replaced by \a value.
+QByteArray withWord(QByteArray bytes, const int offset, const quint32 value)
+{
+    qToLittleEndian<quint32>(value, reinterpret_cast<uchar *>(bytes.data() + offset));
+    return bytes;
+}
+
+class tst_BinaryRoster : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void roundTrip_data();
+    void roundTrip();
+    void lookups();
+    void invalid_data();
+    void invalid();
+
+protected:
+    QTemporaryDir dir;
+
+    // Writes \a rosters to a binary roster file named \a name, returning the file's path.
+    QString writeFile(const QString &name, const QVariantMap &rosters)
+    {
+        QFile file(dir.filePath(name));
+        if ((!file.open(QFile::WriteOnly)) || (!Cogent::BinaryRoster::write(&file, rosters))) {
+            return QString();
+        }
+        return file.fileName();
+    }
+};
+
+void tst_BinaryRoster::initTestCase()
+{
+    QVERIFY(dir.isValid());
+}
+
+void tst_BinaryRoster::roundTrip_data()
+{
+    QTest::addColumn<QVariantMap>("rosters");
+    QTest::addColumn<QVariantMap>("expected");
+
+    QVariantMap withMetadata = makeRoster(QStringLiteral("2018-06"));
+    QTest::newRow("empty") << QVariantMap() << QVariantMap();
+    QTest::newRow("single-ward") << withMetadata << withMetadata;
+    withMetadata.insert(QStringLiteral("created"), QStringLiteral("Sat Jun 30 12:00:00 2018"));
+    QTest::newRow("metadata") << withMetadata << makeRoster(QStringLiteral("2018-06"));
+
+    QVariantMap ward = makeRoster(QStringLiteral("2018-06"));
+    ward.insert(QStringLiteral("2018-07"),
+                makeRoster(QStringLiteral("2018-07")).value(QStringLiteral("2018-07")));
+    const QVariantMap batch{
+        { QStringLiteral("ICU"), ward },
+        { QStringLiteral("Maternity"), makeRoster(QStringLiteral("2018-07")) },
+    };
+    QTest::newRow("batch") << batch << batch;
+}
+
+void tst_BinaryRoster::roundTrip()
+{
+    QFETCH(QVariantMap, rosters);
+    QFETCH(QVariantMap, expected);
+
+    const QString fileName = writeFile(QString::fromLatin1(QTest::currentDataTag()), rosters);
+    QVERIFY(!fileName.isEmpty());
+    Cogent::BinaryRoster binary;
+    QVERIFY(binary.open(fileName));
+    QCOMPARE(binary.toVariantMap(), expected);
+}
+
+void tst_BinaryRoster::lookups()
+{
+    const QVariantMap batch{
+        { QStringLiteral("ICU"), makeRoster(QStringLiteral("2018-06")) },
+        { QStringLiteral("Maternity"), makeRoster(QStringLiteral("2018-07")) },
+    };
+    const QString fileName = writeFile(QStringLiteral("lookups"), batch);
+    QVERIFY(!fileName.isEmpty());
+    Cogent::BinaryRoster binary;
+    QVERIFY(binary.open(fileName));
+    QVERIFY(binary.isOpen());
+
+    // Shifts are in order of first appearance (ie JSON property order), nurses in byte order.
+    QCOMPARE(binary.shiftCount(), 3);
+    QCOMPARE(binary.shiftName(0), QStringLiteral("evening"));
+    QCOMPARE(binary.shiftIndex(QStringLiteral("night")), 2);
+    QCOMPARE(binary.shiftIndex(QStringLiteral("weekend")), -1);
+    QCOMPARE(binary.nurseCount(), 4);
+    QCOMPARE(binary.nurseName(3), QString::fromUtf8("Zo\xc3\xab"));
+    QCOMPARE(binary.nurseName(4), QString());
+    QCOMPARE(binary.nurseId(QStringLiteral("Alice")), 0);
+    QCOMPARE(binary.nurseId(QStringLiteral("Carol")), 2);
+    QCOMPARE(binary.nurseId(QString::fromUtf8("Zo\xc3\xab")), 3);
+    QCOMPARE(binary.nurseId(QStringLiteral("Zo")), -1);
+    QCOMPARE(binary.nurseId(QStringLiteral("Dave")), -1);
+
+    // Who works a given shift of a given day.
+    QCOMPARE(binary.rosterCount(), 2);
+    const int roster = binary.rosterIndex(QStringLiteral("Maternity"), QStringLiteral("2018-07"));
+    QCOMPARE(roster, 1);
+    QCOMPARE(binary.rosterIndex(QStringLiteral("ICU"), QStringLiteral("2018-07")), -1);
+    QCOMPARE(binary.ward(roster), QStringLiteral("Maternity"));
+    QCOMPARE(binary.month(roster), QStringLiteral("2018-07"));
+    QCOMPARE(binary.days(roster), 3);
+    QCOMPARE(binary.nurses(roster, 1, 0), QVector<Cogent::NurseId>({ 2, 3 }));
+    QCOMPARE(binary.nurses(roster, 2, 1), QVector<Cogent::NurseId>({ 3, 0, 1 }));
+    QCOMPARE(binary.nurses(roster, 2, 2), QVector<Cogent::NurseId>());
+
+    // All shifts worked by a given nurse.
+    const QVector<Cogent::BinaryRoster::Assignment> assignments =
+        binary.assignments(binary.nurseId(QStringLiteral("Bob")));
+    QCOMPARE(assignments.size(), 6);
+    foreach (const Cogent::BinaryRoster::Assignment &assignment, assignments) {
+        QVERIFY(binary.nurses(assignment.roster, assignment.day, assignment.shift).contains(1));
+    }
+    QCOMPARE(assignments.at(0).roster, 0);
+    QCOMPARE(assignments.at(0).day, 0);
+    QCOMPARE(assignments.at(0).shift, 1);
+    QCOMPARE(assignments.at(5).roster, 1);
+    QCOMPARE(assignments.at(5).day, 2);
+    QCOMPARE(assignments.at(5).shift, 1);
+
+    binary.close();
+    QVERIFY(!binary.isOpen());
+    QCOMPARE(binary.rosterCount(), 0);
+}
+
+void tst_BinaryRoster::invalid_data()
+{
+    QTest::addColumn<QByteArray>("contents");
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    QVERIFY(Cogent::BinaryRoster::write(&buffer, makeRoster(QStringLiteral("2018-06"))));
+    const QByteArray valid = buffer.buffer();
+
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("json") << QByteArray("{ \"2018-06\": [] }\n");
+    QTest::newRow("bad-magic") << QByteArray("XGRB").append(valid.mid(4));
+    QTest::newRow("bad-version") << valid.left(4).append('\x02').append(valid.mid(5));
+    QTest::newRow("truncated") << valid.left(valid.size() - 4);
+    QTest::newRow("header-only") << valid.left(32);
+
+    // The last slot (of the last day's evening shift) is unfilled, so holds -1; replace it with
+    // nurse IDs beyond the four nurses.
+    QTest::newRow("nurse-out-of-range") << valid.left(valid.size() - 4)
+        .append(QByteArray("\x04\x00\x00\x00", 4));
+    QTest::newRow("nurse-negative") << valid.left(valid.size() - 4)
+        .append(QByteArray("\xfe\xff\xff\xff", 4));
+
+    // Header counts are untrusted: 2^31 days of 3 shifts of 2^31 slots (of 4 bytes) is 3 * 2^64
+    // bytes, which wraps to 0 if multiplied unchecked. Nor may counts exceed an int.
+    const int rosterIndex = int(qFromLittleEndian<quint32>(
+        reinterpret_cast<const uchar *>(valid.constData() + 24)));
+    QTest::newRow("slot-count-overflow")
+        << withWord(withWord(valid, 20, 0x80000000), rosterIndex, 0x80000000);
+    QTest::newRow("negative-days") << withWord(valid, rosterIndex, 0x80000000);
+    QTest::newRow("huge-slots") << withWord(valid, 20, 0xffffffff);
+}
+
+void tst_BinaryRoster::invalid()
+{
+    QFETCH(QByteArray, contents);
+
+    QFile file(dir.filePath(QString::fromLatin1(QTest::currentDataTag())));
+    QVERIFY(file.open(QFile::WriteOnly));
+    QCOMPARE(file.write(contents), qint64(contents.size()));
+    file.close();
+
+    Cogent::BinaryRoster binary;
+    QVERIFY(!binary.open(file.fileName()));
+    QVERIFY(!binary.isOpen());
+}
+
+QTEST_APPLESS_MAIN(tst_BinaryRoster)
+#include "tst_BinaryRoster.moc"
@@ -0,0 +1,164 @@
+#include "../../src/CarryIn.h"
+#include "../TestNurses.h"
+
+#include <QTest>
+
+// Returns a day with \a nurses on the morning shift, and no-one on any other shift.
+QVariantMap morning(const QStringList &nurses)
+{
+    return QVariantMap{
+        { QStringLiteral("night"),   QStringList() },
+        { QStringLiteral("morning"), nurses },
+        { QStringLiteral("evening"), QStringList() },
+    };
+}
+
+class tst_CarryIn : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void advanced_data();
+    void advanced();
+    void tail();
+    void fromRoster();
+    void streaks();
+    void byteArrayRoundTrip();
+    void invalidByteArray();
+};
+
+void tst_CarryIn::advanced_data()
+{
+    QTest::addColumn<QVariantList>("days");
+    QTest::addColumn<int>("aliceDaysWorked");
+    QTest::addColumn<int>("aliceDaysOff");
+
+    const QStringList alice{ QStringLiteral("Alice") };
+    const QStringList bob{ QStringLiteral("Bob") };
+
+    QTest::newRow("no-days") << QVariantList() << 0 << 0;
+    QTest::newRow("never-worked")
+        << QVariantList{ morning(bob), morning(bob) } << 0 << 0;
+    QTest::newRow("worked-last-day")
+        << QVariantList{ morning(bob), morning(alice) } << 1 << 0;
+    QTest::newRow("worked-three-days")
+        << QVariantList{ morning(alice), morning(bob), morning(alice), morning(alice),
+                         morning(alice) } << 3 << 0;
+    QTest::newRow("off-two-days")
+        << QVariantList{ morning(alice), morning(bob), morning(bob) } << 0 << 2;
+}
+
+void tst_CarryIn::advanced()
+{
+    QFETCH(QVariantList, days);
+    QFETCH(int, aliceDaysWorked);
+    QFETCH(int, aliceDaysOff);
+
+    // Advancing all at once, a day at a time, or from a compact roster should give the same
+    // streaks.
+    const Cogent::CarryIn allAtOnce = Cogent::CarryIn().advanced(days);
+    Cogent::CarryIn dayByDay;
+    foreach (const QVariant &day, days) {
+        dayByDay = dayByDay.advanced(QVariantList{ day });
+    }
+    Cogent::NurseTable table;
+    const Cogent::Roster roster = Cogent::Roster::fromVariantList(days, table);
+    const Cogent::CarryIn fromRoster = Cogent::CarryIn().advanced(roster, table);
+    const QList<Cogent::CarryIn> carryIns{ allAtOnce, dayByDay, fromRoster };
+    foreach (const Cogent::CarryIn &carryIn, carryIns) {
+        const Cogent::CarryIn::Streak streak = carryIn.streak(QStringLiteral("Alice"));
+        QCOMPARE(streak.daysWorked, aliceDaysWorked);
+        QCOMPARE(streak.daysOff, aliceDaysOff);
+        QCOMPARE(carryIn.isEmpty(), days.isEmpty());
+        QCOMPARE(carryIn.tail(), days);
+    }
+}
+
+void tst_CarryIn::tail()
+{
+    QVariantList days;
+    for (int day = 0; day < 10; ++day) {
+        days.append(morning(makeNurses(1, day)));
+    }
+    const Cogent::CarryIn carryIn = Cogent::CarryIn().advanced(days, 3);
+    QCOMPARE(carryIn.tail(), days.mid(7));
+    Cogent::NurseTable table;
+    const Cogent::Roster roster = Cogent::Roster::fromVariantList(days, table);
+    QCOMPARE(Cogent::CarryIn().advanced(roster, table, 3).tail(), days.mid(7));
+
+    // Streaks are kept for all nurses, not only those in the tail.
+    QCOMPARE(carryIn.streak(QStringLiteral("Nurse 0")).daysOff, 9);
+    QCOMPARE(carryIn.streak(QStringLiteral("Nurse 9")).daysWorked, 1);
+}
+
+void tst_CarryIn::fromRoster()
+{
+    const QStringList alice{ QStringLiteral("Alice") };
+    const QStringList bob{ QStringLiteral("Bob") };
+    const QVariantList may{ morning(alice), morning(alice) };
+    const QVariantList june{ morning(alice), morning(bob) };
+
+    // Months should be applied in order, regardless of the order they were inserted.
+    QVariantMap roster;
+    roster.insert(QStringLiteral("created"), QStringLiteral("today"));
+    roster.insert(QStringLiteral("2018-06"), june);
+    roster.insert(QStringLiteral("2018-05"), may);
+    const Cogent::CarryIn carryIn = Cogent::CarryIn::fromRoster(roster);
+    QCOMPARE(carryIn.tail(), QVariantList(may + june));
+    QCOMPARE(carryIn.streak(QStringLiteral("Alice")).daysOff, 1);
+    QCOMPARE(carryIn.streak(QStringLiteral("Bob")).daysWorked, 1);
+
+    // Continuing on from a previous state should extend its streaks.
+    const Cogent::CarryIn previous = Cogent::CarryIn().advanced(QVariantList{ morning(bob) });
+    const QVariantMap mayOnly{ { QStringLiteral("2018-05"), may } };
+    QCOMPARE(Cogent::CarryIn::fromRoster(roster, previous).streak(QStringLiteral("Bob")).daysWorked, 1);
+    QCOMPARE(Cogent::CarryIn::fromRoster(mayOnly, previous).streak(QStringLiteral("Bob")).daysOff, 2);
+}
+
+void tst_CarryIn::streaks()
+{
+    const Cogent::CarryIn carryIn = Cogent::CarryIn().advanced(QVariantList{
+        morning(QStringList{ QStringLiteral("Alice"), QStringLiteral("Carol") }),
+        morning(QStringList{ QStringLiteral("Alice") }),
+    });
+
+    // Nurses not carried in get zero streaks, and carried-in nurses not in the table are ignored.
+    const Cogent::NurseTable table(QStringList{ QStringLiteral("Bob"), QStringLiteral("Alice") });
+    const QVector<Cogent::CarryIn::Streak> streaks = carryIn.streaks(table);
+    QCOMPARE(streaks.size(), 2);
+    QCOMPARE(streaks.at(0).daysWorked, 0);
+    QCOMPARE(streaks.at(0).daysOff, 0);
+    QCOMPARE(streaks.at(1).daysWorked, 2);
+    QCOMPARE(streaks.at(1).daysOff, 0);
+}
+
+void tst_CarryIn::byteArrayRoundTrip()
+{
+    const Cogent::CarryIn carryIn = Cogent::CarryIn().advanced(QVariantList{
+        morning(QStringList{ QStringLiteral("Alice"), QStringLiteral("Bob") }),
+        morning(QStringList{ QStringLiteral("Alice") }),
+    });
+
+    bool ok = false;
+    const Cogent::CarryIn loaded = Cogent::CarryIn::fromByteArray(carryIn.toByteArray(), &ok);
+    QVERIFY(ok);
+    QCOMPARE(loaded.tail(), carryIn.tail());
+    QCOMPARE(loaded.streak(QStringLiteral("Alice")).daysWorked, 2);
+    QCOMPARE(loaded.streak(QStringLiteral("Bob")).daysOff, 1);
+    QCOMPARE(loaded.toByteArray(), carryIn.toByteArray());
+}
+
+void tst_CarryIn::invalidByteArray()
+{
+    const QByteArray snapshot = Cogent::CarryIn().advanced(QVariantList{
+        morning(QStringList{ QStringLiteral("Alice") }) }).toByteArray();
+
+    bool ok = true;
+    QVERIFY(Cogent::CarryIn::fromByteArray(QByteArray("{}"), &ok).isEmpty());
+    QVERIFY(!ok);
+    QVERIFY(Cogent::CarryIn::fromByteArray(snapshot.left(snapshot.size()-1), &ok).isEmpty());
+    QVERIFY(!ok);
+}
+
+QTEST_APPLESS_MAIN(tst_CarryIn)
+#include "tst_CarryIn.moc"
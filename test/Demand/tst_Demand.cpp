@@ -0,0 +1,58 @@
+#include "../../src/Demand.h"
+
+#include <QTest>
+
+class tst_Demand : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void nurses_data();
+    void nurses();
+    void month();
+};
+
+void tst_Demand::nurses_data()
+{
+    QTest::addColumn<QDate>("date");
+    QTest::addColumn<int>("shift");
+    QTest::addColumn<int>("expected");
+
+    // 2018-12-24 was a Monday, 2018-12-29 a Saturday, and 2018-12-25 a (Tuesday) holiday.
+    QTest::newRow("weekday")               << QDate(2018, 12, 24) << 0 << 5;
+    QTest::newRow("other-weekday")         << QDate(2018, 12, 27) << 1 << 4;
+    QTest::newRow("saturday")              << QDate(2018, 12, 29) << 0 << 2;
+    QTest::newRow("saturday-other-shift")  << QDate(2018, 12, 29) << 1 << 4;
+    QTest::newRow("holiday")               << QDate(2018, 12, 25) << 0 << 1;
+    QTest::newRow("holiday-other-shift")   << QDate(2018, 12, 25) << 1 << 4;
+    QTest::newRow("holiday-on-saturday")   << QDate(2021, 12, 25) << 0 << 1;
+    QTest::newRow("saturday-next-year")    << QDate(2019, 12, 28) << 0 << 2;
+}
+
+void tst_Demand::nurses()
+{
+    QFETCH(QDate, date);
+    QFETCH(int, shift);
+    QFETCH(int, expected);
+
+    Cogent::Demand demand(QVector<int>{ 5, 4 });
+    demand.setNurses(Qt::Saturday, 0, 2);
+    demand.setNurses(QDate(2018, 12, 25), 0, 1);
+    demand.setNurses(QDate(2021, 12, 25), 0, 1);
+    QCOMPARE(demand.shiftCount(), 2);
+    QCOMPARE(demand.nurses(date, shift), expected);
+}
+
+void tst_Demand::month()
+{
+    Cogent::Demand demand(QVector<int>{ 3, 2, 1 });
+    demand.setNurses(Qt::Sunday, 2, 0);
+    demand.setNurses(QDate(2018, 7, 2), 1, 7);
+
+    // 2018-07-01 was a Sunday; the headcounts are indexed by day * shifts + shift.
+    const QVector<int> headcounts = demand.headcounts(QDate(2018, 7, 1), 3);
+    QCOMPARE(headcounts, QVector<int>({ 3, 2, 0,  3, 7, 1,  3, 2, 1 }));
+}
+
+QTEST_APPLESS_MAIN(tst_Demand)
+#include "tst_Demand.moc"
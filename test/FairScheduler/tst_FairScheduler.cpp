@@ -0,0 +1,226 @@
+#include "../../src/AtMostFiveConsecutiveDays.h"
+#include "../../src/AtMostFiveNightShiftsPerMonth.h"
+#include "../../src/AtMostOneShiftPerDay.h"
+#include "../../src/FairScheduler.h"
+#include "../../src/NoSingleDaysOff.h"
+#include "../../src/RosterGenerator.h"
+#include "../TestNurses.h"
+
+#include <QTest>
+
+// Weights that ignore recency, and count each night or weekend shift as ten ordinary shifts.
+const Cogent::FairScheduler::Weights countsOnly{ 0.0, 1.0, 10.0, 10.0 };
+
+// Returns a set of the nurses \a first to \a last inclusive.
+Cogent::NurseSet nurses(const Cogent::NurseId first, const Cogent::NurseId last)
+{
+    Cogent::NurseSet set;
+    for (Cogent::NurseId nurse = first; nurse <= last; ++nurse) {
+        set.insert(nurse);
+    }
+    return set;
+}
+
+class tst_FairScheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void fewestShifts();
+    void nights();
+    void weekends();
+    void recency();
+    void chooseNextNurses();
+    void undo();
+    void clone();
+    void generate();
+};
+
+void tst_FairScheduler::fewestShifts()
+{
+    Cogent::FairScheduler scheduler;
+    scheduler.onAssigned(0);
+    scheduler.onAssigned(0);
+    scheduler.onAssigned(1);
+    QCOMPARE(scheduler.shiftsWorked(0), 2);
+    QCOMPARE(scheduler.shiftsWorked(1), 1);
+    QCOMPARE(scheduler.shiftsWorked(2), 0);
+
+    // Without dates, recency plays no part, and ties go to the lowest NurseId.
+    QCOMPARE(scheduler.chooseNextNurse(nurses(0, 2)), Cogent::NurseId(2));
+    QCOMPARE(scheduler.chooseNextNurse(nurses(0, 1)), Cogent::NurseId(1));
+    QCOMPARE(scheduler.chooseNextNurse(nurses(0, 2)), Cogent::NurseId(2));
+    QCOMPARE(scheduler.chooseNextNurse(nurses(0, 2)), Cogent::NurseId(0));
+    QCOMPARE(scheduler.shiftsWorked(0), 3);
+}
+
+void tst_FairScheduler::nights()
+{
+    Cogent::FairScheduler scheduler(countsOnly);
+    for (int count = 0; count < 3; ++count) {
+        scheduler.onAssigned(0);
+    }
+    scheduler.onShift(QDate(), Cogent::Roster::NightShift);
+    scheduler.onAssigned(1);
+    QCOMPARE(scheduler.nightsWorked(0), 0);
+    QCOMPARE(scheduler.nightsWorked(1), 1);
+
+    // Nurse 1 has worked fewer shifts, but nurse 0 fewer night shifts.
+    QCOMPARE(scheduler.rankNurses(nurses(0, 1)), QVector<Cogent::NurseId>({ 0, 1 }));
+    scheduler.onShift(QDate(), Cogent::Roster::MorningShift);
+    QCOMPARE(scheduler.rankNurses(nurses(0, 1)), QVector<Cogent::NurseId>({ 1, 0 }));
+
+    // The night shift is configurable.
+    Cogent::FairScheduler eveningScheduler(countsOnly, Cogent::Roster::EveningShift);
+    eveningScheduler.onShift(QDate(), Cogent::Roster::NightShift);
+    eveningScheduler.onAssigned(0);
+    QCOMPARE(eveningScheduler.nightsWorked(0), 0);
+    eveningScheduler.onShift(QDate(), Cogent::Roster::EveningShift);
+    eveningScheduler.onAssigned(0);
+    QCOMPARE(eveningScheduler.nightsWorked(0), 1);
+}
+
+void tst_FairScheduler::weekends()
+{
+    // 2018-06-02 was a Saturday, and 2018-06-04 a Monday.
+    Cogent::FairScheduler scheduler(countsOnly);
+    scheduler.onShift(QDate(2018, 6, 4), Cogent::Roster::MorningShift);
+    for (int count = 0; count < 3; ++count) {
+        scheduler.onAssigned(0);
+    }
+    scheduler.onShift(QDate(2018, 6, 2), Cogent::Roster::MorningShift);
+    scheduler.onAssigned(1);
+    QCOMPARE(scheduler.weekendsWorked(0), 0);
+    QCOMPARE(scheduler.weekendsWorked(1), 1);
+
+    // Nurse 1 has worked fewer shifts, but nurse 0 fewer weekend shifts.
+    scheduler.onShift(QDate(2018, 6, 3), Cogent::Roster::MorningShift);
+    QCOMPARE(scheduler.rankNurses(nurses(0, 1)), QVector<Cogent::NurseId>({ 0, 1 }));
+    scheduler.onShift(QDate(2018, 6, 4), Cogent::Roster::MorningShift);
+    QCOMPARE(scheduler.rankNurses(nurses(0, 1)), QVector<Cogent::NurseId>({ 1, 0 }));
+}
+
+void tst_FairScheduler::recency()
+{
+    Cogent::FairScheduler scheduler(Cogent::FairScheduler::Weights{ 1.0, 0.0, 0.0, 0.0 });
+    scheduler.onShift(QDate(2018, 6, 1), Cogent::Roster::MorningShift);
+    scheduler.onAssigned(1);
+    scheduler.onShift(QDate(2018, 6, 3), Cogent::Roster::MorningShift);
+    scheduler.onAssigned(0);
+
+    // Nurses who have never worked come first, then those who have rested longest.
+    scheduler.onShift(QDate(2018, 6, 4), Cogent::Roster::MorningShift);
+    QCOMPARE(scheduler.rankNurses(nurses(0, 2)), QVector<Cogent::NurseId>({ 2, 1, 0 }));
+}
+
+void tst_FairScheduler::chooseNextNurses()
+{
+    Cogent::FairScheduler scheduler;
+    scheduler.onAssigned(0);
+    scheduler.onAssigned(3);
+
+    // All nurses for a shift are ranked before any are recorded, and only available nurses chosen.
+    QCOMPARE(scheduler.chooseNextNurses(nurses(0, 4), 3), QVector<Cogent::NurseId>({ 1, 2, 4 }));
+    QCOMPARE(scheduler.chooseNextNurses(nurses(1, 4), 2), QVector<Cogent::NurseId>({ 1, 2 }));
+    QCOMPARE(scheduler.chooseNextNurses(nurses(0, 1), 5), QVector<Cogent::NurseId>({ 0, 1 }));
+    QCOMPARE(scheduler.chooseNextNurses(Cogent::NurseSet(), 5), QVector<Cogent::NurseId>());
+
+    // Appending leaves existing entries as they are.
+    QVector<Cogent::NurseId> chosen{ 9 };
+    scheduler.appendNextNurses(nurses(0, 4), 1, chosen);
+    QCOMPARE(chosen, QVector<Cogent::NurseId>({ 9, 3 }));
+}
+
+void tst_FairScheduler::undo()
+{
+    Cogent::FairScheduler scheduler;
+    scheduler.onShift(QDate(2018, 6, 1), Cogent::Roster::NightShift);
+    scheduler.chooseNextNurses(nurses(0, 9), 5);
+    const QVector<Cogent::NurseId> before = scheduler.rankNurses(nurses(0, 9));
+
+    // Undoing every later assignment, in reverse order, restores the rankings and counts.
+    scheduler.setUndoable(true);
+    scheduler.onShift(QDate(2018, 6, 2), Cogent::Roster::NightShift);
+    const QVector<Cogent::NurseId> assigned = before.mid(0, 5);
+    foreach (const Cogent::NurseId nurse, assigned) {
+        scheduler.onAssigned(nurse);
+    }
+    QVERIFY(scheduler.rankNurses(nurses(0, 9)) != before);
+    QCOMPARE(scheduler.nightsWorked(assigned.first()), 1);
+    QCOMPARE(scheduler.weekendsWorked(assigned.first()), 1);
+    for (int index = assigned.size() - 1; index >= 0; --index) {
+        scheduler.onUnassigned(assigned.at(index));
+    }
+    scheduler.onShift(QDate(2018, 6, 1), Cogent::Roster::NightShift);
+    QCOMPARE(scheduler.rankNurses(nurses(0, 9)), before);
+    QCOMPARE(scheduler.nightsWorked(assigned.first()), 0);
+    QCOMPARE(scheduler.weekendsWorked(assigned.first()), 0);
+}
+
+void tst_FairScheduler::clone()
+{
+    Cogent::FairScheduler scheduler;
+    scheduler.onShift(QDate(2018, 6, 1), Cogent::Roster::NightShift);
+    scheduler.chooseNextNurses(nurses(0, 9), 5);
+
+    // Clones carry on exactly as the original would, with the same counts.
+    const QScopedPointer<Cogent::SchedulerInterface> clone(scheduler.clone());
+    QVERIFY(clone);
+    clone->onShift(QDate(2018, 6, 2), Cogent::Roster::NightShift);
+    scheduler.onShift(QDate(2018, 6, 2), Cogent::Roster::NightShift);
+    QCOMPARE(clone->chooseNextNurses(nurses(0, 9), 3), scheduler.chooseNextNurses(nurses(0, 9), 3));
+
+    // Seeds only break ties: the two nurses yet to work still come first, in some order.
+    const QVector<Cogent::NurseId> ranked = scheduler.rankNurses(nurses(0, 9));
+    bool reordered = false;
+    for (quint64 seed = 1; seed <= 10; ++seed) {
+        clone->setSeed(seed);
+        const QVector<Cogent::NurseId> seeded = clone->rankNurses(nurses(0, 9));
+        QCOMPARE(seeded.mid(0, 2).toList().toSet(), ranked.mid(0, 2).toList().toSet());
+        reordered = reordered || (seeded != ranked);
+    }
+    QVERIFY(reordered);
+    clone->setSeed(0);
+    QCOMPARE(clone->rankNurses(nurses(0, 9)), ranked);
+}
+
+void tst_FairScheduler::generate()
+{
+    const QStringList nurseNames = makeNurses(35);
+    Cogent::RosterGenerator generator;
+    generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+    Cogent::FairScheduler * const scheduler = new Cogent::FairScheduler;
+    generator.setScheduler(scheduler);
+
+    // Generate half a year, in which a least-recent scheduler leaves some nurses every weekend off.
+    Cogent::CarryIn carryIn;
+    for (int month = 1; month <= 6; ++month) {
+        const QVariantMap roster = generator.generate(2018, month, nurseNames, carryIn);
+        QVERIFY(!roster.isEmpty());
+        carryIn = Cogent::CarryIn::fromRoster(roster, carryIn);
+    }
+
+    // Every nurse's total, night and weekend shifts are within two of every other's.
+    int minShifts = scheduler->shiftsWorked(0), maxShifts = minShifts, totalShifts = 0;
+    int minNights = scheduler->nightsWorked(0), maxNights = minNights;
+    int minWeekends = scheduler->weekendsWorked(0), maxWeekends = minWeekends;
+    for (Cogent::NurseId nurse = 0; nurse < nurseNames.size(); ++nurse) {
+        totalShifts += scheduler->shiftsWorked(nurse);
+        minShifts = qMin(minShifts, scheduler->shiftsWorked(nurse));
+        maxShifts = qMax(maxShifts, scheduler->shiftsWorked(nurse));
+        minNights = qMin(minNights, scheduler->nightsWorked(nurse));
+        maxNights = qMax(maxNights, scheduler->nightsWorked(nurse));
+        minWeekends = qMin(minWeekends, scheduler->weekendsWorked(nurse));
+        maxWeekends = qMax(maxWeekends, scheduler->weekendsWorked(nurse));
+    }
+    QCOMPARE(totalShifts, 181 * 3 * 5);
+    QVERIFY(maxShifts - minShifts <= 2);
+    QVERIFY(maxNights - minNights <= 2);
+    QVERIFY(maxWeekends - minWeekends <= 2);
+}
+
+QTEST_APPLESS_MAIN(tst_FairScheduler)
+#include "tst_FairScheduler.moc"
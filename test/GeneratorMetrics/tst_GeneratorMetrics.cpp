@@ -0,0 +1,161 @@
+#include "../../src/GeneratorMetrics.h"
+
+#include <QTest>
+
+// Returns metrics with a little of everything, scaled by \a scale.
+Cogent::GeneratorMetrics makeMetrics(const int scale)
+{
+    Cogent::GeneratorMetrics metrics;
+    metrics.rosters = 2 * scale;
+    metrics.failures = 1 * scale;
+    metrics.infeasible = 1 * scale;
+    metrics.cancelled = 1 * scale;
+    metrics.nanoseconds = 3000000000LL * scale;
+    metrics.schedulerCalls = 90 * scale;
+    metrics.schedulerNanoseconds = 500000000LL * scale;
+    metrics.searchNodes = 100 * scale;
+    metrics.searchesExhausted = 1 * scale;
+    metrics.backtracks.insert(QStringLiteral("night"), 7 * scale);
+    metrics.failedShifts.insert(QStringLiteral("evening"), 1 * scale);
+    metrics.addConstraint(Cogent::GeneratorMetrics::ConstraintStats{
+        QStringLiteral("AtMostOneShiftPerDay"), 90 * scale, 3600 * scale, 450 * scale,
+        250000000LL * scale, 0 });
+    return metrics;
+}
+
+class tst_GeneratorMetrics : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void addConstraint();
+    void merge();
+    void toVariantMap();
+    void toPrometheus();
+    void toPrometheusEscaping();
+};
+
+void tst_GeneratorMetrics::addConstraint()
+{
+    Cogent::GeneratorMetrics metrics;
+    metrics.addConstraint({ QStringLiteral("a"), 1, 10, 2, 100, 0 });
+    metrics.addConstraint({ QStringLiteral("b"), 1, 10, 0, 100, 1 });
+    metrics.addConstraint({ QStringLiteral("a"), 2, 20, 3, 200, 1 });
+
+    // Constraints of the same name are combined, in the order first added.
+    QCOMPARE(metrics.constraints.size(), 2);
+    QCOMPARE(metrics.constraints.at(0).name, QStringLiteral("a"));
+    QCOMPARE(metrics.constraints.at(0).calls, qint64(3));
+    QCOMPARE(metrics.constraints.at(0).candidates, qint64(30));
+    QCOMPARE(metrics.constraints.at(0).removed, qint64(5));
+    QCOMPARE(metrics.constraints.at(0).nanoseconds, qint64(300));
+    QCOMPARE(metrics.constraints.at(0).skipped, qint64(1));
+    QCOMPARE(metrics.constraints.at(1).name, QStringLiteral("b"));
+    QCOMPARE(metrics.constraints.at(1).skipped, qint64(1));
+}
+
+void tst_GeneratorMetrics::merge()
+{
+    Cogent::GeneratorMetrics metrics = makeMetrics(1);
+    Cogent::GeneratorMetrics other = makeMetrics(2);
+    other.backtracks.insert(QStringLiteral("day"), 1);
+    other.addConstraint({ QStringLiteral("NoSingleDaysOff"), 90, 3000, 10, 1000, 0 });
+    metrics.merge(other);
+
+    QCOMPARE(metrics.rosters, qint64(6));
+    QCOMPARE(metrics.failures, qint64(3));
+    QCOMPARE(metrics.infeasible, qint64(3));
+    QCOMPARE(metrics.cancelled, qint64(3));
+    QCOMPARE(metrics.nanoseconds, qint64(9000000000LL));
+    QCOMPARE(metrics.schedulerCalls, qint64(270));
+    QCOMPARE(metrics.schedulerNanoseconds, qint64(1500000000LL));
+    QCOMPARE(metrics.searchNodes, qint64(300));
+    QCOMPARE(metrics.searchesExhausted, qint64(3));
+    QCOMPARE(metrics.backtracks.value(QStringLiteral("night")), qint64(21));
+    QCOMPARE(metrics.backtracks.value(QStringLiteral("day")), qint64(1));
+    QCOMPARE(metrics.failedShifts.value(QStringLiteral("evening")), qint64(3));
+    QCOMPARE(metrics.constraints.size(), 2);
+    QCOMPARE(metrics.constraints.at(0).calls, qint64(270));
+    QCOMPARE(metrics.constraints.at(0).removed, qint64(1350));
+    QCOMPARE(metrics.constraints.at(1).name, QStringLiteral("NoSingleDaysOff"));
+}
+
+void tst_GeneratorMetrics::toVariantMap()
+{
+    const QVariantMap map = makeMetrics(1).toVariantMap();
+    QCOMPARE(map.value(QStringLiteral("rosters")).toLongLong(), qint64(2));
+    QCOMPARE(map.value(QStringLiteral("failures")).toLongLong(), qint64(1));
+    QCOMPARE(map.value(QStringLiteral("infeasible")).toLongLong(), qint64(1));
+    QCOMPARE(map.value(QStringLiteral("cancelled")).toLongLong(), qint64(1));
+    QCOMPARE(map.value(QStringLiteral("nanoseconds")).toLongLong(), qint64(3000000000LL));
+
+    const QVariantMap scheduler = map.value(QStringLiteral("scheduler")).toMap();
+    QCOMPARE(scheduler.value(QStringLiteral("calls")).toLongLong(), qint64(90));
+    QCOMPARE(scheduler.value(QStringLiteral("nanoseconds")).toLongLong(), qint64(500000000));
+
+    const QVariantMap search = map.value(QStringLiteral("search")).toMap();
+    QCOMPARE(search.value(QStringLiteral("nodes")).toLongLong(), qint64(100));
+    QCOMPARE(search.value(QStringLiteral("exhausted")).toLongLong(), qint64(1));
+    QCOMPARE(search.value(QStringLiteral("backtracks")).toMap(),
+             QVariantMap({{ QStringLiteral("night"), qint64(7) }}));
+    QCOMPARE(map.value(QStringLiteral("failedShifts")).toMap(),
+             QVariantMap({{ QStringLiteral("evening"), qint64(1) }}));
+
+    const QVariantList constraints = map.value(QStringLiteral("constraints")).toList();
+    QCOMPARE(constraints.size(), 1);
+    const QVariantMap constraint = constraints.first().toMap();
+    QCOMPARE(constraint.value(QStringLiteral("name")).toString(),
+             QStringLiteral("AtMostOneShiftPerDay"));
+    QCOMPARE(constraint.value(QStringLiteral("calls")).toLongLong(), qint64(90));
+    QCOMPARE(constraint.value(QStringLiteral("candidates")).toLongLong(), qint64(3600));
+    QCOMPARE(constraint.value(QStringLiteral("removed")).toLongLong(), qint64(450));
+    QCOMPARE(constraint.value(QStringLiteral("skipped")).toLongLong(), qint64(0));
+    QCOMPARE(constraint.value(QStringLiteral("nanoseconds")).toLongLong(), qint64(250000000));
+}
+
+void tst_GeneratorMetrics::toPrometheus()
+{
+    const QStringList lines = makeMetrics(1).toPrometheus().split(QLatin1Char('\n'));
+
+    // Each metric is described, then sampled (with times in seconds).
+    QVERIFY(lines.contains(QStringLiteral("# TYPE cogent_rosters_total counter")));
+    QVERIFY(lines.contains(QStringLiteral("cogent_rosters_total 2")));
+    QVERIFY(lines.contains(QStringLiteral("cogent_roster_failures_total 1")));
+    QVERIFY(lines.contains(QStringLiteral("cogent_rosters_infeasible_total 1")));
+    QVERIFY(lines.contains(QStringLiteral("cogent_rosters_cancelled_total 1")));
+    QVERIFY(lines.contains(QStringLiteral("cogent_roster_seconds_total 3")));
+    QVERIFY(lines.contains(QStringLiteral("cogent_scheduler_calls_total 90")));
+    QVERIFY(lines.contains(QStringLiteral("cogent_scheduler_seconds_total 0.5")));
+    QVERIFY(lines.contains(QStringLiteral("cogent_search_nodes_total 100")));
+    QVERIFY(lines.contains(QStringLiteral("cogent_searches_exhausted_total 1")));
+    QVERIFY(lines.contains(QStringLiteral("cogent_search_backtracks_total{shift=\"night\"} 7")));
+    QVERIFY(lines.contains(QStringLiteral("cogent_failed_shifts_total{shift=\"evening\"} 1")));
+    const QString label = QStringLiteral("{constraint=\"AtMostOneShiftPerDay\"}");
+    QVERIFY(lines.contains(QStringLiteral("cogent_constraint_calls_total%1 90").arg(label)));
+    QVERIFY(lines.contains(QStringLiteral("cogent_constraint_candidates_total%1 3600").arg(label)));
+    QVERIFY(lines.contains(QStringLiteral("cogent_constraint_removed_total%1 450").arg(label)));
+    QVERIFY(lines.contains(QStringLiteral("cogent_constraint_skipped_total%1 0").arg(label)));
+    QVERIFY(lines.contains(QStringLiteral("cogent_constraint_seconds_total%1 0.25").arg(label)));
+
+    // Every line is a comment or a sample; the text ends with a newline.
+    QCOMPARE(lines.last(), QString());
+    foreach (const QString &line, lines.mid(0, lines.size() - 1)) {
+        QVERIFY2(line.startsWith(QLatin1String("# ")) || line.startsWith(QLatin1String("cogent_")),
+                 qPrintable(line));
+    }
+
+    // The prefix is configurable.
+    QVERIFY(makeMetrics(1).toPrometheus(QStringLiteral("ward_")).split(QLatin1Char('\n'))
+            .contains(QStringLiteral("ward_rosters_total 2")));
+}
+
+void tst_GeneratorMetrics::toPrometheusEscaping()
+{
+    Cogent::GeneratorMetrics metrics;
+    metrics.failedShifts.insert(QStringLiteral("a \"b\" \\c\nd"), 1);
+    QVERIFY(metrics.toPrometheus().split(QLatin1Char('\n')).contains(
+        QStringLiteral("cogent_failed_shifts_total{shift=\"a \\\"b\\\" \\\\c\\nd\"} 1")));
+}
+
+QTEST_APPLESS_MAIN(tst_GeneratorMetrics)
+#include "tst_GeneratorMetrics.moc"
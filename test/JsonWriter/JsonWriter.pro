@@ -0,0 +1 @@
+include(../test.pri)
@@ -0,0 +1,143 @@
+#include "../../src/JsonWriter.h"
+#include "../TestNurses.h"
+
+#include <QBuffer>
+#include <QDate>
+#include <QTest>
+
+#include <limits>
+
+class tst_JsonWriter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void write_data();
+    void write();
+    void writeRoster_data();
+    void writeRoster();
+};
+
+// Returns a roster-like map of \a days days, each of three shifts of five nurses, large enough to
+// span many writes to the device.
+QVariantMap makeRoster(const int days)
+{
+    const QStringList shiftNames{
+        QStringLiteral("day"), QStringLiteral("evening"), QStringLiteral("night") };
+    const QStringList pool = makeNurses(40);
+    QVariantList rosterDays;
+    for (int day = 0; day < days; ++day) {
+        QVariantMap shifts;
+        foreach (const QString &shift, shiftNames) {
+            QStringList nurses;
+            for (int slot = 0; slot < 5; ++slot) {
+                nurses.append(pool.at((day * 7 + slot) % pool.size()));
+            }
+            shifts.insert(shift, nurses);
+        }
+        rosterDays.append(shifts);
+    }
+    return QVariantMap{
+        { QStringLiteral("2018-01"), rosterDays },
+        { QStringLiteral("created"), QStringLiteral("2018-01-01T00:00:00Z") },
+    };
+}
+
+void tst_JsonWriter::write_data()
+{
+    QTest::addColumn<QVariant>("value");
+
+    QTest::newRow("empty-map") << QVariant(QVariantMap());
+    QTest::newRow("empty-list") << QVariant(QVariantList());
+    QTest::newRow("empty-members") << QVariant(QVariantMap{
+        { QStringLiteral("list"), QVariantList() },
+        { QStringLiteral("map"), QVariantMap() },
+        { QStringLiteral("string"), QString() },
+    });
+    QTest::newRow("scalars") << QVariant(QVariantList{
+        true, false, QVariant(), 0, -1, 42u, qlonglong(1) << 40, 0.5, -2.25, 1e-7, 1.0 / 3.0, 3.0,
+        std::numeric_limits<double>::infinity(), QDate(2018, 12, 25),
+    });
+    QTest::newRow("large-numbers") << QVariant(QVariantList{
+        9007199254740992.0, 18446744073709549568.0, 18446744073709551616.0, -1e20, 1e20, 1e300,
+        std::numeric_limits<double>::max(),
+    });
+    QTest::newRow("escapes") << QVariant(QVariantMap{
+        { QStringLiteral("quote\"backslash\\"), QStringLiteral("tab\tnewline\nreturn\r") },
+        { QStringLiteral("controls"), QString(QStringLiteral("\b\f\x01\x1f")) },
+        { QStringLiteral("unicode"),
+          QString::fromUtf8("Zo\xc3\xab \xe2\x82\xac \xf0\x9f\x98\x80") },
+    });
+    QTest::newRow("nested") << QVariant(QVariantMap{
+        { QStringLiteral("a"), QVariantList{ QVariantMap{ { QStringLiteral("b"), 1 } },
+                                             QVariant(QVariantList()) } },
+        { QStringLiteral("hash"), QVariantHash{ { QStringLiteral("z"), 1 },
+                                                { QStringLiteral("y"), 2 },
+                                                { QStringLiteral("x"), 3 } } },
+        { QStringLiteral("names"), QStringList{ QStringLiteral("Ann"), QStringLiteral("Bob") } },
+    });
+    QTest::newRow("month") << QVariant(makeRoster(31));
+    QTest::newRow("year") << QVariant(makeRoster(365));
+}
+
+void tst_JsonWriter::write()
+{
+    QFETCH(QVariant, value);
+
+    const QJsonDocument document = QJsonDocument::fromVariant(value);
+    const QList<QJsonDocument::JsonFormat> formats{
+        QJsonDocument::Indented, QJsonDocument::Compact };
+    foreach (const QJsonDocument::JsonFormat format, formats) {
+        QBuffer buffer;
+        QVERIFY(buffer.open(QIODevice::WriteOnly));
+        Cogent::JsonWriter writer(&buffer, format);
+        QVERIFY((value.type() == QVariant::Map)
+            ? writer.write(value.toMap()) : writer.write(value.toList()));
+        QCOMPARE(buffer.buffer(), document.toJson(format));
+    }
+}
+
+void tst_JsonWriter::writeRoster_data()
+{
+    QTest::addColumn<QVariantList>("days");
+    QTest::addColumn<QVariantMap>("metadata");
+
+    const QVariantList month = makeRoster(31).value(QStringLiteral("2018-01")).toList();
+    const QVariantMap created{
+        { QStringLiteral("created"), QStringLiteral("2018-01-01T00:00:00Z") } };
+    QTest::newRow("no-days") << QVariantList() << created;
+    QTest::newRow("empty-shifts") << QVariantList{ QVariantMap() } << created;
+    QTest::newRow("no-metadata") << month << QVariantMap();
+    QTest::newRow("month") << month << created;
+    QTest::newRow("year") << makeRoster(365).value(QStringLiteral("2018-01")).toList() << created;
+    QTest::newRow("metadata-around") << month << QVariantMap{
+        { QStringLiteral("2017-12"), 1 }, { QStringLiteral("2018-01"), 2 },
+        { QStringLiteral("created"), QStringLiteral("now") } };
+}
+
+void tst_JsonWriter::writeRoster()
+{
+    QFETCH(QVariantList, days);
+    QFETCH(QVariantMap, metadata);
+
+    // Note, the shifts are allocated in a different order to their names' order.
+    Cogent::NurseTable table;
+    const Cogent::Roster roster = Cogent::Roster::fromVariantList(days, table, QStringList{
+        QStringLiteral("night"), QStringLiteral("day"), QStringLiteral("evening") });
+    QVariantMap expected = metadata;
+    expected.insert(QStringLiteral("2018-01"), roster.toVariantList(table));
+
+    const QJsonDocument document = QJsonDocument::fromVariant(expected);
+    const QList<QJsonDocument::JsonFormat> formats{
+        QJsonDocument::Indented, QJsonDocument::Compact };
+    foreach (const QJsonDocument::JsonFormat format, formats) {
+        QBuffer buffer;
+        QVERIFY(buffer.open(QIODevice::WriteOnly));
+        Cogent::JsonWriter writer(&buffer, format);
+        QVERIFY(writer.write(QStringLiteral("2018-01"), roster, table, metadata));
+        QCOMPARE(buffer.buffer(), document.toJson(format));
+    }
+}
+
+QTEST_APPLESS_MAIN(tst_JsonWriter)
+#include "tst_JsonWriter.moc"
@@ -1,9 +1,8 @@
 #include "../../src/LeastRecentScheduler.h"
+#include "../TestNurses.h"
 
 #include <QTest>
 
-typedef Cogent::SchedulerInterface::QStringSet QStringSet;
-
 class tst_LeastRecentScheduler : public QObject
 {
     Q_OBJECT
@@ -11,6 +10,11 @@ class tst_LeastRecentScheduler : public QObject
 private slots:
     void chooseNextNurse_data();
     void chooseNextNurse();
+    void chooseNextNurses_data();
+    void chooseNextNurses();
+    void undo();
+    void undoSeeded();
+    void clone();
 };
 
 void tst_LeastRecentScheduler::chooseNextNurse_data()
@@ -37,6 +41,15 @@ void tst_LeastRecentScheduler::chooseNextNurse_data()
     QTest::newRow("seen-both-only-bob-available")   << aliceThenBob << bob.toSet()   << bob.first();
 
     QTest::newRow("saw-alice-first") << aliceThenBob << aliceThenBob.toSet() << alice.first();
+
+    const QStringList aliceBobAlice{ QStringLiteral("Alice"), QStringLiteral("Bob"), QStringLiteral("Alice") };
+    QTest::newRow("saw-alice-again") << aliceBobAlice << aliceThenBob.toSet() << bob.first();
+
+    const QStringList carol { QStringLiteral("Carol") };
+    const QStringList aliceBobCarolBob{ QStringLiteral("Alice"), QStringLiteral("Bob"),
+                                        QStringLiteral("Carol"), QStringLiteral("Bob") };
+    QTest::newRow("alice-least-recent") << aliceBobCarolBob << (aliceThenBob + carol).toSet() << alice.first();
+    QTest::newRow("carol-least-recent-available") << aliceBobCarolBob << (bob + carol).toSet() << carol.first();
 }
 
 void tst_LeastRecentScheduler::chooseNextNurse()
@@ -45,27 +58,184 @@ void tst_LeastRecentScheduler::chooseNextNurse()
     QFETCH(QStringSet, nurses);
     QFETCH(QString, expected);
 
+    Cogent::NurseTable table;
     Cogent::LeastRecentScheduler scheduler;
 
     // Seed the scheduler with the test nurses, in explicit order.
     foreach (const QString &nurse, seedNurses) {
-        scheduler.chooseNextNurse(QStringSet{nurse});
+        Cogent::NurseSet seed;
+        seed.insert(table.intern(nurse));
+        scheduler.chooseNextNurse(seed);
     }
 
     // Check the scheduler returns the expected nurse.
-    QCOMPARE(scheduler.chooseNextNurse(nurses), expected);
+    QCOMPARE(table.name(scheduler.chooseNextNurse(toNurseIds(nurses, table))), expected);
 }
 
-// Let QTest know how to format QStringSet values (via QDebug, which already supports QSet).
-namespace QTest {
-    template<> char *toString(const QStringSet &value)
-    {
-        QString string;
-        QDebug debug(&string);
-        debug << value;
-        return qstrdup(string.toLocal8Bit().data());
+void tst_LeastRecentScheduler::chooseNextNurses_data()
+{
+    QTest::addColumn<QStringList>("seedNurses");
+    QTest::addColumn<QStringSet>("nurses");
+    QTest::addColumn<int>("count");
+    QTest::addColumn<QStringList>("expected");
+
+    const QString alice = QStringLiteral("Alice");
+    const QString bob   = QStringLiteral("Bob");
+    const QString carol = QStringLiteral("Carol");
+    const QString dave  = QStringLiteral("Dave");
+
+    QTest::newRow("no-nurses") << QStringList() << QStringSet() << 2 << QStringList();
+
+    QTest::newRow("none-wanted") << QStringList{ alice } << QStringSet{ alice } << 0 << QStringList();
+
+    QTest::newRow("not-enough-nurses")
+        << QStringList{ alice, bob } << QStringSet{ alice, bob } << 3 << QStringList{ alice, bob };
+
+    QTest::newRow("least-recent-first")
+        << QStringList{ alice, bob, carol, alice }
+        << QStringSet{ alice, bob, carol } << 2 << QStringList{ bob, carol };
+
+    QTest::newRow("skip-unavailable")
+        << QStringList{ alice, bob, carol, alice }
+        << QStringSet{ alice, carol } << 2 << QStringList{ carol, alice };
+
+    QTest::newRow("unseen-then-least-recent")
+        << QStringList{ alice, bob, carol }
+        << QStringSet{ alice, bob, dave } << 2 << QStringList{ dave, alice };
+}
+
+void tst_LeastRecentScheduler::chooseNextNurses()
+{
+    QFETCH(QStringList, seedNurses);
+    QFETCH(QStringSet, nurses);
+    QFETCH(int, count);
+    QFETCH(QStringList, expected);
+
+    Cogent::NurseTable table;
+    Cogent::LeastRecentScheduler batchScheduler, loopScheduler, appendScheduler;
+
+    // Seed the schedulers with the test nurses, in explicit order.
+    foreach (const QString &nurse, seedNurses) {
+        Cogent::NurseSet seed;
+        seed.insert(table.intern(nurse));
+        batchScheduler.chooseNextNurse(seed);
+        loopScheduler.chooseNextNurse(seed);
+        appendScheduler.chooseNextNurse(seed);
     }
-};
+    const Cogent::NurseSet nurseIds = toNurseIds(nurses, table);
+
+    // Check the single-pass override returns the expected nurses, in order.
+    QStringList names;
+    foreach (const Cogent::NurseId nurse, batchScheduler.chooseNextNurses(nurseIds, count)) {
+        names.append(table.name(nurse));
+    }
+    QCOMPARE(names, expected);
+
+    // Check the default (repeated chooseNextNurse) implementation agrees.
+    QStringList loopNames;
+    foreach (const Cogent::NurseId nurse,
+             loopScheduler.Cogent::SchedulerInterface::chooseNextNurses(nurseIds, count)) {
+        loopNames.append(table.name(nurse));
+    }
+    QCOMPARE(loopNames, expected);
+
+    // Check appending to an existing list agrees too, leaving the existing entries alone.
+    QVector<Cogent::NurseId> appended{ -1 };
+    appendScheduler.appendNextNurses(nurseIds, count, appended);
+    QCOMPARE(appended.size(), expected.size() + 1);
+    QCOMPARE(appended.first(), -1);
+    for (int index = 0; index < expected.size(); ++index) {
+        QCOMPARE(table.name(appended.at(index+1)), expected.at(index));
+    }
+
+    // Check all schedulers recorded the same allocations.
+    for (int round = 0; round < nurses.size(); ++round) {
+        const Cogent::NurseId nurse = batchScheduler.chooseNextNurse(nurseIds);
+        QCOMPARE(loopScheduler.chooseNextNurse(nurseIds), nurse);
+        QCOMPARE(appendScheduler.chooseNextNurse(nurseIds), nurse);
+    }
+}
+
+void tst_LeastRecentScheduler::undo()
+{
+    Cogent::NurseTable table;
+    Cogent::LeastRecentScheduler scheduler;
+    const QStringList names{ QStringLiteral("Alice"), QStringLiteral("Bob"),
+                             QStringLiteral("Carol"), QStringLiteral("Dave") };
+    foreach (const QString &name, names.mid(0, 3)) {
+        Cogent::NurseSet seed;
+        seed.insert(table.intern(name));
+        scheduler.chooseNextNurse(seed);
+    }
+    const Cogent::NurseSet nurses = toNurseIds(names.toSet(), table);
+    const QVector<Cogent::NurseId> ranked = scheduler.rankNurses(nurses);
+    QCOMPARE(ranked, (QVector<Cogent::NurseId>{ 3, 0, 1, 2 })); // Dave is unseen.
+
+    // Record (and then undo) some assignments, including the previously-unseen Dave.
+    scheduler.setUndoable(true);
+    const QVector<Cogent::NurseId> assigned{ 1, 3, 1, 0 };
+    foreach (const Cogent::NurseId nurse, assigned) {
+        scheduler.onAssigned(nurse);
+    }
+    QCOMPARE(scheduler.rankNurses(nurses), (QVector<Cogent::NurseId>{ 2, 3, 1, 0 }));
+    for (int index = assigned.size()-1; index >= 0; --index) {
+        scheduler.onUnassigned(assigned.at(index));
+    }
+    QCOMPARE(scheduler.rankNurses(nurses), ranked);
+}
+
+void tst_LeastRecentScheduler::undoSeeded()
+{
+    // Seeded schedulers order each batch's nurses pseudo-randomly, so undoing an allocation must
+    // restore its place within its batch, not just at the end.
+    Cogent::LeastRecentScheduler scheduler(42);
+    const Cogent::NurseSet nurses(20, true);
+    for (int batch = 0; batch < 3; ++batch) {
+        QCOMPARE(scheduler.chooseNextNurses(nurses, 5).size(), 5);
+    }
+    const QVector<Cogent::NurseId> ranked = scheduler.rankNurses(nurses);
+    QCOMPARE(ranked.size(), 20);
+
+    scheduler.setUndoable(true);
+    const QVector<Cogent::NurseId> assigned = ranked.mid(2, 6) + ranked.mid(0, 1);
+    foreach (const Cogent::NurseId nurse, assigned) {
+        scheduler.onAssigned(nurse);
+    }
+    QVERIFY(scheduler.rankNurses(nurses) != ranked);
+    for (int index = assigned.size()-1; index >= 0; --index) {
+        scheduler.onUnassigned(assigned.at(index));
+    }
+    QCOMPARE(scheduler.rankNurses(nurses), ranked);
+
+    // And once undone, the scheduler chooses just as it would have without the undone work.
+    Cogent::LeastRecentScheduler fresh(42);
+    for (int batch = 0; batch < 3; ++batch) {
+        fresh.chooseNextNurses(nurses, 5);
+    }
+    QCOMPARE(scheduler.chooseNextNurses(nurses, 5), fresh.chooseNextNurses(nurses, 5));
+}
+
+void tst_LeastRecentScheduler::clone()
+{
+    // Clones carry on exactly as the original would, even once reseeded.
+    Cogent::LeastRecentScheduler scheduler(7);
+    const Cogent::NurseSet nurses(20, true);
+    for (int batch = 0; batch < 3; ++batch) {
+        scheduler.chooseNextNurses(nurses, 5);
+    }
+    const QScopedPointer<Cogent::SchedulerInterface> clone(scheduler.clone());
+    QVERIFY(clone);
+    QCOMPARE(clone->rankNurses(nurses), scheduler.rankNurses(nurses));
+    QCOMPARE(clone->chooseNextNurses(nurses, 5), scheduler.chooseNextNurses(nurses, 5));
+    clone->setSeed(0);
+    scheduler.setSeed(0);
+    QCOMPARE(clone->chooseNextNurses(nurses, 5), scheduler.chooseNextNurses(nurses, 5));
+
+    // Reseeding keeps every nurse's history, so the least recent nurses still come first.
+    const QVector<Cogent::NurseId> ranked = scheduler.rankNurses(nurses);
+    clone->setSeed(99);
+    QCOMPARE(clone->rankNurses(nurses).mid(0, 5), ranked.mid(0, 5));
+}
 
 QTEST_APPLESS_MAIN(tst_LeastRecentScheduler)
 #include "tst_LeastRecentScheduler.moc"
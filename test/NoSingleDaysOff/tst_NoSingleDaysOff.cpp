@@ -1,9 +1,8 @@
 #include "../../src/NoSingleDaysOff.h"
+#include "../TestConstraints.h"
 
 #include <QTest>
 
-typedef Cogent::ConstraintInterface::QStringSet QStringSet;
-
 class tst_NoSingleDaysOff : public QObject
 {
     Q_OBJECT
@@ -11,6 +10,10 @@ class tst_NoSingleDaysOff : public QObject
 private slots:
     void constrain_data();
     void constrain();
+    void rewind_data();
+    void rewind();
+    void carryIn_data();
+    void carryIn();
 };
 
 void tst_NoSingleDaysOff::constrain_data()
@@ -93,21 +96,80 @@ void tst_NoSingleDaysOff::constrain()
     QFETCH(QStringSet, expected);
     QFETCH(int, removed);
 
+    Cogent::NurseTable table;
+    const Cogent::Roster roster = Cogent::Roster::fromVariantList(days, table);
+    Cogent::NurseSet nurseIds = toNurseIds(nurses, table);
+
     Cogent::NoSingleDaysOff constraint;
-    QCOMPARE(constraint.constrain(nurses, QString(), days), removed);
-    QCOMPARE(nurses, expected);
+    constraint.replay(roster, table.size());
+    QCOMPARE(constraint.constrain(nurseIds, Cogent::Roster::MorningShift, roster), removed);
+    QCOMPARE(toNames(nurseIds, table), expected);
 }
 
-// Let QTest know how to format QStringSet values (via QDebug, which already supports QSet).
-namespace QTest {
-    template<> char *toString(const QStringSet &value)
-    {
-        QString string;
-        QDebug debug(&string);
-        debug << value;
-        return qstrdup(string.toLocal8Bit().data());
-    }
-};
+void tst_NoSingleDaysOff::rewind_data()
+{
+    constrain_data();
+}
+
+void tst_NoSingleDaysOff::rewind()
+{
+    QFETCH(QVariantList, days);
+    QFETCH(QStringSet, nurses);
+    QFETCH(QStringSet, expected);
+    QFETCH(int, removed);
+
+    Cogent::NurseTable table;
+    const Cogent::Roster roster = Cogent::Roster::fromVariantList(days, table);
+    Cogent::NurseSet nurseIds = toNurseIds(nurses, table);
+
+    Cogent::NoSingleDaysOff constraint;
+    // Replay a later, fully rostered day too, then rewind back to the current day.
+    const Cogent::Roster moreDays = withFullDay(roster, table.size());
+    constraint.replay(moreDays, table.size());
+    constraint.rewind(moreDays, roster.size()-1);
+    QCOMPARE(constraint.constrain(nurseIds, Cogent::Roster::MorningShift, roster), removed);
+    QCOMPARE(toNames(nurseIds, table), expected);
+}
+
+void tst_NoSingleDaysOff::carryIn_data()
+{
+    addCarryInColumns();
+
+    const QStringSet alice { QStringLiteral("Alice") };
+    const QStringSet bob   { QStringLiteral("Bob")   };
+    const QStringSet aliceAndBob{ QStringLiteral("Alice"), QStringLiteral("Bob") };
+    const QVariantMap aliceOn{ { QStringLiteral("morning"), QVariant(alice.toList()) } };
+    const QVariantMap allOff;
+
+    QTest::newRow("nothing-carried-in")
+        << QVariantList() << QVariantList{ allOff } << aliceAndBob << aliceAndBob << 0;
+
+    QTest::newRow("on-at-month-end")
+        << QVariantList{ allOff, aliceOn } << QVariantList{ allOff }
+        << aliceAndBob << aliceAndBob << 0;
+
+    QTest::newRow("one-off-at-month-end")
+        << QVariantList{ aliceOn, allOff } << QVariantList{ allOff }
+        << aliceAndBob << bob << 1; // Alice needs another day off.
+
+    QTest::newRow("two-off-at-month-end")
+        << QVariantList{ aliceOn, allOff, allOff } << QVariantList{ allOff }
+        << aliceAndBob << aliceAndBob << 0;
+
+    QTest::newRow("on-at-month-end-then-off")
+        << QVariantList{ aliceOn } << QVariantList{ allOff, allOff }
+        << aliceAndBob << bob << 1; // Alice needs another day off.
+
+    QTest::newRow("on-at-month-end-then-on")
+        << QVariantList{ aliceOn } << QVariantList{ aliceOn, allOff }
+        << aliceAndBob << aliceAndBob << 0;
+}
+
+void tst_NoSingleDaysOff::carryIn()
+{
+    Cogent::NoSingleDaysOff constraint;
+    verifyCarryIn(constraint, Cogent::Roster::MorningShift);
+}
 
 QTEST_APPLESS_MAIN(tst_NoSingleDaysOff)
 #include "tst_NoSingleDaysOff.moc"
@@ -0,0 +1,107 @@
+#include "../../src/NurseListReader.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+class tst_NurseListReader : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void read_data();
+    void read();
+    void readFile();
+    void readTestData();
+    void manyDuplicates();
+};
+
+void tst_NurseListReader::read_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<bool>("skipDups");
+    QTest::addColumn<QStringList>("expected");
+
+    const QString alice = QStringLiteral("Alice"), bob = QStringLiteral("Bob");
+    QTest::newRow("empty") << QByteArray() << false << QStringList();
+    QTest::newRow("blank-lines") << QByteArray("\n \n\t\r\n") << false << QStringList();
+    QTest::newRow("one") << QByteArray("Alice") << false << QStringList{ alice };
+    QTest::newRow("trailing-newline") << QByteArray("Alice\n") << false << QStringList{ alice };
+    QTest::newRow("file-order") << QByteArray("Bob\nAlice\n") << false
+                                << QStringList{ bob, alice };
+    QTest::newRow("whitespace") << QByteArray("  Bob \r\n\tAlice\r\n") << false
+                                << QStringList{ bob, alice };
+    QTest::newRow("unicode") << QByteArray("Zo\xc3\xab\n") << false
+                             << QStringList{ QString::fromUtf8("Zo\xc3\xab") };
+    QTest::newRow("skip-dups") << QByteArray("Bob\nAlice\nBob\n") << true
+                               << QStringList{ bob, alice };
+    QTest::newRow("rename-dups") << QByteArray("Bob\nAlice\nBob\nBob\n") << false
+                                 << QStringList{ bob, alice, QStringLiteral("Bob (3)"),
+                                                 QStringLiteral("Bob (4)") };
+    QTest::newRow("rename-dups-clash") << QByteArray("Bob (3)\nBob\nBob\n") << false
+                                       << QStringList{ QStringLiteral("Bob (3)"), bob,
+                                                       QStringLiteral("Bob (3) (3)") };
+}
+
+void tst_NurseListReader::read()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(bool, skipDups);
+    QFETCH(QStringList, expected);
+
+    const Cogent::NurseTable nurses =
+        Cogent::NurseListReader::read(data.constData(), data.size(), skipDups);
+    QCOMPARE(nurses.toStringList(), expected);
+    for (int index = 0; index < expected.size(); ++index) {
+        QCOMPARE(nurses.id(expected.at(index)), index);
+    }
+}
+
+void tst_NurseListReader::readFile()
+{
+    // Regular files are mapped, rather than read.
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QFile file(dir.filePath(QStringLiteral("nurses.txt")));
+    QVERIFY(file.open(QFile::WriteOnly));
+    QVERIFY(file.write("Carol\nBob\nAlice\nBob\n") > 0);
+    file.close();
+    QVERIFY(file.open(QFile::ReadOnly|QFile::Text));
+    QCOMPARE(Cogent::NurseListReader::read(file, true).toStringList(), QStringList({
+        QStringLiteral("Carol"), QStringLiteral("Bob"), QStringLiteral("Alice") }));
+}
+
+void tst_NurseListReader::readTestData()
+{
+    QFile file(QFINDTESTDATA("../../data/nurses.txt"));
+    QVERIFY(file.open(QFile::ReadOnly|QFile::Text));
+    const QStringList unique = Cogent::NurseListReader::read(file, true).toStringList();
+    QCOMPARE(unique.size(), 98);
+    QCOMPARE(unique.first(), QStringLiteral("Gannon"));
+
+    QVERIFY(file.seek(0));
+    const QStringList all = Cogent::NurseListReader::read(file, false).toStringList();
+    QCOMPARE(all.size(), 110);
+}
+
+void tst_NurseListReader::manyDuplicates()
+{
+    // A large export, with every name repeated across ten sites.
+    QByteArray data;
+    for (int site = 0; site < 10; ++site) {
+        for (int nurse = 0; nurse < 4000; ++nurse) {
+            data.append("Nurse ").append(QByteArray::number(nurse)).append('\n');
+        }
+    }
+    const QStringList unique = Cogent::NurseListReader::read(data.constData(), data.size(), true)
+        .toStringList();
+    QCOMPARE(unique.size(), 4000);
+    QCOMPARE(unique.last(), QStringLiteral("Nurse 3999"));
+
+    const QStringList all = Cogent::NurseListReader::read(data.constData(), data.size(), false)
+        .toStringList();
+    QCOMPARE(all.size(), 40000);
+    QCOMPARE(all.at(4000), QStringLiteral("Nurse 0 (4001)"));
+}
+
+QTEST_APPLESS_MAIN(tst_NurseListReader)
+#include "tst_NurseListReader.moc"
@@ -0,0 +1,145 @@
+#include "../../src/NurseRecord.h"
+
+#include <QTest>
+
+// Returns \a list as a set (QList::toSet is deprecated in later Qt versions).
+QSet<QString> toSet(const QStringList &list)
+{
+    QSet<QString> set;
+    foreach (const QString &item, list) {
+        set.insert(item);
+    }
+    return set;
+}
+
+class tst_NurseRecord : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void isOnLeave();
+    void canWork_data();
+    void canWork();
+    void fromJson();
+    void invalid_data();
+    void invalid();
+};
+
+void tst_NurseRecord::isOnLeave()
+{
+    Cogent::NurseRecord record(QStringLiteral("Alice"));
+    QVERIFY(!record.isOnLeave(QDate(2018, 6, 1)));
+    record.leave.append(qMakePair(QDate(2018, 6, 4), QDate(2018, 6, 4)));
+    record.leave.append(qMakePair(QDate(2018, 6, 18), QDate(2018, 6, 22)));
+    QVERIFY(!record.isOnLeave(QDate(2018, 6, 3)));
+    QVERIFY(record.isOnLeave(QDate(2018, 6, 4)));
+    QVERIFY(!record.isOnLeave(QDate(2018, 6, 5)));
+    QVERIFY(record.isOnLeave(QDate(2018, 6, 18)));
+    QVERIFY(record.isOnLeave(QDate(2018, 6, 20)));
+    QVERIFY(record.isOnLeave(QDate(2018, 6, 22)));
+    QVERIFY(!record.isOnLeave(QDate(2018, 6, 23)));
+}
+
+void tst_NurseRecord::canWork_data()
+{
+    QTest::addColumn<QStringList>("skills");
+    QTest::addColumn<QStringList>("shifts");
+    QTest::addColumn<QString>("shift");
+    QTest::addColumn<QStringList>("requiredSkills");
+    QTest::addColumn<bool>("expected");
+
+    const QString night = QStringLiteral("night"), morning = QStringLiteral("morning");
+    const QString icu = QStringLiteral("icu"), senior = QStringLiteral("senior");
+    QTest::newRow("any") << QStringList() << QStringList() << night << QStringList() << true;
+    QTest::newRow("listed-shift") << QStringList() << QStringList{ night, morning } << morning
+                                  << QStringList() << true;
+    QTest::newRow("unlisted-shift") << QStringList() << QStringList{ night } << morning
+                                    << QStringList() << false;
+    QTest::newRow("skilled") << QStringList{ icu, senior } << QStringList() << night
+                             << QStringList{ icu } << true;
+    QTest::newRow("unskilled") << QStringList{ icu } << QStringList() << night
+                               << QStringList{ icu, senior } << false;
+    QTest::newRow("no-skills") << QStringList() << QStringList() << night
+                               << QStringList{ icu } << false;
+}
+
+void tst_NurseRecord::canWork()
+{
+    QFETCH(QStringList, skills);
+    QFETCH(QStringList, shifts);
+    QFETCH(QString, shift);
+    QFETCH(QStringList, requiredSkills);
+    QFETCH(bool, expected);
+
+    Cogent::NurseRecord record(QStringLiteral("Alice"));
+    record.skills = toSet(skills);
+    record.shifts = toSet(shifts);
+    QCOMPARE(record.canWork(shift, toSet(requiredSkills)), expected);
+}
+
+void tst_NurseRecord::fromJson()
+{
+    bool ok = false;
+    const QVector<Cogent::NurseRecord> records = Cogent::NurseRecord::fromJson(
+        "[ { \"name\": \"Bob\" },"
+        "  { \"name\": \"Alice\", \"maxShifts\": 12, \"skills\": [ \"icu\" ],"
+        "    \"shifts\": [ \"morning\", \"evening\" ],"
+        "    \"leave\": [ \"2018-06-04\","
+        "                 { \"from\": \"2018-06-18\", \"to\": \"2018-06-22\" } ] } ]",
+        &ok);
+    QVERIFY(ok);
+    QCOMPARE(records.size(), 2);
+
+    // Records are in file order, with defaults for any missing properties.
+    QCOMPARE(records.at(0).name, QStringLiteral("Bob"));
+    QCOMPARE(records.at(0).maxShifts, -1);
+    QVERIFY(records.at(0).leave.isEmpty());
+    QVERIFY(records.at(0).skills.isEmpty());
+    QVERIFY(records.at(0).shifts.isEmpty());
+
+    QCOMPARE(records.at(1).name, QStringLiteral("Alice"));
+    QCOMPARE(records.at(1).maxShifts, 12);
+    QCOMPARE(records.at(1).skills, QSet<QString>{ QStringLiteral("icu") });
+    QCOMPARE(records.at(1).shifts,
+             QSet<QString>({ QStringLiteral("morning"), QStringLiteral("evening") }));
+    QCOMPARE(records.at(1).leave.size(), 2);
+    QCOMPARE(records.at(1).leave.at(0), qMakePair(QDate(2018, 6, 4), QDate(2018, 6, 4)));
+    QCOMPARE(records.at(1).leave.at(1), qMakePair(QDate(2018, 6, 18), QDate(2018, 6, 22)));
+
+    QVERIFY(Cogent::NurseRecord::fromJson("[]", &ok).isEmpty());
+    QVERIFY(ok);
+}
+
+void tst_NurseRecord::invalid_data()
+{
+    QTest::addColumn<QByteArray>("json");
+
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("object") << QByteArray("{ \"name\": \"Alice\" }");
+    QTest::newRow("no-name") << QByteArray("[ { \"maxShifts\": 1 } ]");
+    QTest::newRow("blank-name") << QByteArray("[ { \"name\": \" \" } ]");
+    QTest::newRow("duplicate-name")
+        << QByteArray("[ { \"name\": \"Bob\" }, { \"name\": \"Bob\" } ]");
+    QTest::newRow("negative-cap") << QByteArray("[ { \"name\": \"Bob\", \"maxShifts\": -1 } ]");
+    QTest::newRow("fractional-cap") << QByteArray("[ { \"name\": \"Bob\", \"maxShifts\": 1.5 } ]");
+    QTest::newRow("text-cap") << QByteArray("[ { \"name\": \"Bob\", \"maxShifts\": \"ten\" } ]");
+    QTest::newRow("huge-cap") << QByteArray("[ { \"name\": \"Bob\", \"maxShifts\": 1e20 } ]");
+    QTest::newRow("bad-date")
+        << QByteArray("[ { \"name\": \"Bob\", \"leave\": [ \"2018-02-30\" ] } ]");
+    QTest::newRow("reversed-range") << QByteArray("[ { \"name\": \"Bob\", \"leave\": "
+        "[ { \"from\": \"2018-06-22\", \"to\": \"2018-06-18\" } ] } ]");
+    QTest::newRow("open-range") << QByteArray(
+        "[ { \"name\": \"Bob\", \"leave\": [ { \"from\": \"2018-06-22\" } ] } ]");
+}
+
+void tst_NurseRecord::invalid()
+{
+    QFETCH(QByteArray, json);
+
+    bool ok = true;
+    QVERIFY(Cogent::NurseRecord::fromJson(json, &ok).isEmpty());
+    QVERIFY(!ok);
+}
+
+QTEST_APPLESS_MAIN(tst_NurseRecord)
+#include "tst_NurseRecord.moc"
@@ -0,0 +1,190 @@
+#include "../../src/NurseSet.h"
+
+#include <QTest>
+
+// Returns a set of capacity \a capacity containing every multiple of \a step below \a capacity.
+Cogent::NurseSet multiplesOf(const int step, const int capacity)
+{
+    Cogent::NurseSet set(capacity);
+    for (Cogent::NurseId nurse = 0; nurse < capacity; nurse += step) {
+        set.insert(nurse);
+    }
+    return set;
+}
+
+class tst_NurseSet : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void insertRemove();
+    void fill_data();
+    void fill();
+    void intersect_data();
+    void intersect();
+    void intersectAll_data();
+    void intersectAll();
+    void subtract_data();
+    void subtract();
+    void mismatchedCapacities();
+    void assign();
+};
+
+void tst_NurseSet::insertRemove()
+{
+    Cogent::NurseSet set;
+    QVERIFY(set.isEmpty());
+    QCOMPARE(set.first(), -1);
+
+    set.insert(70); // Grows the set.
+    set.insert(3);
+    QCOMPARE(set.capacity(), 71);
+    QCOMPARE(set.count(), 2);
+    QVERIFY(set.contains(3));
+    QVERIFY(set.contains(70));
+    QVERIFY(!set.contains(4));
+    QVERIFY(!set.contains(-1));
+    QVERIFY(!set.contains(1000));
+    QCOMPARE(set.toVector(), (QVector<Cogent::NurseId>{ 3, 70 }));
+
+    QVERIFY(set.remove(3));
+    QVERIFY(!set.remove(3));
+    QVERIFY(!set.remove(1000));
+    QCOMPARE(set.first(), 70);
+    QCOMPARE(set.next(70), -1);
+}
+
+void tst_NurseSet::fill_data()
+{
+    QTest::addColumn<int>("capacity");
+
+    QTest::newRow("0")    << 0;
+    QTest::newRow("1")    << 1;
+    QTest::newRow("63")   << 63;
+    QTest::newRow("64")   << 64;
+    QTest::newRow("65")   << 65;
+    QTest::newRow("256")  << 256;  // Exactly one 256-bit vector, when built with CONFIG+=avx2.
+    QTest::newRow("5000") << 5000;
+}
+
+void tst_NurseSet::fill()
+{
+    QFETCH(int, capacity);
+
+    Cogent::NurseSet set(capacity, true);
+    QCOMPARE(set.capacity(), capacity);
+    QCOMPARE(set.count(), capacity);
+    QCOMPARE(set.isEmpty(), capacity == 0);
+    QCOMPARE(set.first(), (capacity == 0) ? -1 : 0);
+    QVERIFY(!set.contains(capacity)); // No bits set beyond the capacity.
+
+    set.fill(false);
+    QCOMPARE(set.count(), 0);
+    QVERIFY(set.isEmpty());
+    QCOMPARE(set, Cogent::NurseSet());
+}
+
+void tst_NurseSet::intersect_data()
+{
+    fill_data();
+}
+
+void tst_NurseSet::intersect()
+{
+    QFETCH(int, capacity);
+
+    Cogent::NurseSet set = multiplesOf(2, capacity);
+    set.intersect(multiplesOf(3, capacity));
+    QCOMPARE(set, multiplesOf(6, capacity));
+    QCOMPARE(set.count(), (capacity + 5) / 6);
+}
+
+void tst_NurseSet::intersectAll_data()
+{
+    fill_data();
+}
+
+void tst_NurseSet::intersectAll()
+{
+    QFETCH(int, capacity);
+
+    // Intersecting with several sets at once is the same as intersecting with each in turn.
+    const Cogent::NurseSet threes = multiplesOf(3, capacity), fives = multiplesOf(5, capacity);
+    const Cogent::NurseSet shorter(capacity / 2, true);
+    const Cogent::NurseSet * const others[] = { &threes, &fives, &shorter };
+    Cogent::NurseSet set = multiplesOf(2, capacity);
+    set.intersect(others, 3);
+    Cogent::NurseSet expected = multiplesOf(2, capacity);
+    expected.intersect(threes).intersect(fives).intersect(shorter);
+    QCOMPARE(set, expected);
+
+    set = multiplesOf(2, capacity);
+    set.intersect(others, 0);
+    QCOMPARE(set, multiplesOf(2, capacity));
+}
+
+void tst_NurseSet::subtract_data()
+{
+    fill_data();
+}
+
+void tst_NurseSet::subtract()
+{
+    QFETCH(int, capacity);
+
+    Cogent::NurseSet set = multiplesOf(2, capacity);
+    set.subtract(multiplesOf(3, capacity));
+    for (Cogent::NurseId nurse = 0; nurse < capacity; ++nurse) {
+        QCOMPARE(set.contains(nurse), (nurse % 2 == 0) && (nurse % 3 != 0));
+    }
+}
+
+void tst_NurseSet::mismatchedCapacities()
+{
+    // Nurses beyond the other set's capacity are not in the other set.
+    Cogent::NurseSet set(1000, true);
+    set.intersect(Cogent::NurseSet(300, true));
+    QCOMPARE(set.count(), 300);
+    QCOMPARE(set, Cogent::NurseSet(300, true));
+
+    set = Cogent::NurseSet(300, true);
+    set.intersect(Cogent::NurseSet(1000, true));
+    QCOMPARE(set.count(), 300);
+
+    set = Cogent::NurseSet(1000, true);
+    set.subtract(Cogent::NurseSet(300, true));
+    QCOMPARE(set.count(), 700);
+    QCOMPARE(set.first(), 300);
+}
+
+void tst_NurseSet::assign()
+{
+    // Assigning copies the other set's nurses and capacity, whether larger or smaller.
+    Cogent::NurseSet set;
+    const Cogent::NurseSet large = multiplesOf(3, 1000);
+    QCOMPARE(set.assign(large), large);
+    QCOMPARE(set.capacity(), 1000);
+    const Cogent::NurseSet small = multiplesOf(2, 100);
+    QCOMPARE(set.assign(small), small);
+    QCOMPARE(set.capacity(), 100);
+    QCOMPARE(set.count(), 50);
+
+    // The copy is independent of the original.
+    set.remove(0);
+    QVERIFY(small.contains(0));
+    QVERIFY(!set.contains(0));
+}
+
+// Let QTest know how to format NurseSet values.
+namespace QTest {
+    template<> char *toString(const Cogent::NurseSet &value)
+    {
+        QString string;
+        QDebug debug(&string);
+        debug << value.toVector();
+        return qstrdup(string.toLocal8Bit().data());
+    }
+};
+
+QTEST_APPLESS_MAIN(tst_NurseSet)
+#include "tst_NurseSet.moc"
@@ -0,0 +1,202 @@
+#include "../../src/AtMostFiveConsecutiveDays.h"
+#include "../../src/AtMostFiveNightShiftsPerMonth.h"
+#include "../../src/AtMostOneShiftPerDay.h"
+#include "../../src/FairScheduler.h"
+#include "../../src/NoSingleDaysOff.h"
+#include "../../src/RestartGenerator.h"
+#include "../TestNurses.h"
+
+#include <QTest>
+
+// Adds the standard constraints to \a generator.
+void addConstraints(Cogent::RosterGenerator &generator)
+{
+    generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+}
+
+// Returns a copy of \a roster without its (time-dependent) "created" metadata.
+QVariantMap withoutCreated(QVariantMap roster)
+{
+    roster.remove(QStringLiteral("created"));
+    return roster;
+}
+
+class tst_RestartGenerator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void firstFound_data();
+    void firstFound();
+    void objective();
+    void configuredScheduler();
+    void cancelled();
+    void noneFound();
+    void shiftCountDeviation_data();
+    void shiftCountDeviation();
+};
+
+void tst_RestartGenerator::firstFound_data()
+{
+    QTest::addColumn<int>("year");
+    QTest::addColumn<int>("month");
+    QTest::addColumn<int>("days");
+    QTest::addColumn<int>("nurseCount");
+
+    // Tight nurse pools that a single (unseeded) greedy pass fails to roster.
+    QTest::newRow("29-days-31-nurses") << 2020 << 2  << 29 << 31;
+    QTest::newRow("30-days-31-nurses") << 2018 << 6  << 30 << 31;
+}
+
+void tst_RestartGenerator::firstFound()
+{
+    QFETCH(int, year);
+    QFETCH(int, month);
+    QFETCH(int, days);
+    QFETCH(int, nurseCount);
+    const QStringList nurses = makeNurses(nurseCount);
+
+    // Confirm that a single greedy pass is not enough.
+    Cogent::RosterGenerator generator;
+    addConstraints(generator);
+    QCOMPARE(generator.generate(year, month, nurses), QVariantMap());
+
+    // But one of many seeded passes is.
+    Cogent::RestartGenerator restarts(addConstraints, 32);
+    restarts.setMaxThreadCount(4);
+    const QVariantMap roster = restarts.generate(year, month, nurses);
+    const QString monthKey = QStringLiteral("%1-%2").arg(year).arg(month, 2, 10, QLatin1Char('0'));
+    QVERIFY(roster.contains(monthKey));
+    QCOMPARE(roster.value(monthKey).toList().size(), days);
+
+    // The lowest successful pass wins, however the passes are scheduled, so this is repeatable.
+    Cogent::RestartGenerator inOrder(addConstraints, 32);
+    inOrder.setMaxThreadCount(1);
+    QCOMPARE(withoutCreated(inOrder.generate(year, month, nurses)), withoutCreated(roster));
+    QCOMPARE(withoutCreated(restarts.generate(year, month, nurses)), withoutCreated(roster));
+}
+
+void tst_RestartGenerator::objective()
+{
+    const QStringList nurses = makeNurses(40);
+
+    // The unseeded pass is the same as a plain generator's.
+    Cogent::RosterGenerator generator;
+    addConstraints(generator);
+    const QVariantMap plainRoster = generator.generate(2018, 5, nurses);
+    QVERIFY(!plainRoster.isEmpty());
+    const double plainScore = Cogent::RestartGenerator::shiftCountDeviation(plainRoster, nurses);
+
+    // So the best of many passes can be no worse, and should be repeatable.
+    Cogent::RestartGenerator restarts(addConstraints, 8);
+    restarts.setObjective(Cogent::RestartGenerator::shiftCountDeviation);
+    const QVariantMap roster = restarts.generate(2018, 5, nurses);
+    QVERIFY(!roster.isEmpty());
+    QVERIFY(Cogent::RestartGenerator::shiftCountDeviation(roster, nurses) <= plainScore);
+    QCOMPARE(withoutCreated(restarts.generate(2018, 5, nurses)), withoutCreated(roster));
+}
+
+void tst_RestartGenerator::configuredScheduler()
+{
+    // Adds the standard constraints, and a fair scheduler, to \a generator.
+    const auto configure = [](Cogent::RosterGenerator &generator) {
+        addConstraints(generator);
+        generator.setScheduler(new Cogent::FairScheduler);
+    };
+    const QStringList nurses = makeNurses(40);
+
+    // Record every pass's roster; with a single thread, the passes run in order.
+    QVariantList passRosters;
+    Cogent::RestartGenerator restarts(configure, 3);
+    restarts.setMaxThreadCount(1);
+    restarts.setObjective([&passRosters](const QVariantMap &roster, const QStringList &) {
+        passRosters.append(withoutCreated(roster));
+        return 0.0;
+    });
+    QVERIFY(!restarts.generate(2018, 5, nurses).isEmpty());
+    QCOMPARE(passRosters.size(), 3);
+
+    // Each pass uses a copy of the configured scheduler, seeded by the pass number.
+    for (int pass = 0; pass < passRosters.size(); ++pass) {
+        Cogent::RosterGenerator generator;
+        configure(generator);
+        Cogent::SchedulerInterface * const scheduler = generator.cloneScheduler();
+        scheduler->setSeed(pass);
+        generator.setScheduler(scheduler);
+        const QVariantMap roster = withoutCreated(generator.generate(2018, 5, nurses));
+        QCOMPARE(passRosters.at(pass), QVariant(roster));
+    }
+    QVERIFY(passRosters.at(1) != passRosters.at(0));
+}
+
+void tst_RestartGenerator::cancelled()
+{
+    // With a single thread, the passes run in order, and the first (unseeded) pass finds a roster.
+    Cogent::RestartGenerator restarts(addConstraints, 4);
+    restarts.setMaxThreadCount(1);
+    QVERIFY(!restarts.generate(2018, 5, makeNurses(40)).isEmpty());
+
+    // So the remaining passes are cancelled, which does not count as failing.
+    const Cogent::GeneratorMetrics metrics = restarts.metrics();
+    QCOMPARE(metrics.rosters, qint64(4));
+    QCOMPARE(metrics.failures, qint64(0));
+    QCOMPARE(metrics.cancelled, qint64(3));
+}
+
+void tst_RestartGenerator::noneFound()
+{
+    // Fewer nurses than can possibly cover every night shift (see README.md).
+    Cogent::RestartGenerator restarts(addConstraints, 4);
+    QCOMPARE(restarts.generate(2018, 2, makeNurses(27)), QVariantMap());
+
+    // Every pass is counted, as every pass failed.
+    const Cogent::GeneratorMetrics metrics = restarts.metrics();
+    QCOMPARE(metrics.rosters, qint64(4));
+    QCOMPARE(metrics.failures, qint64(4));
+    QCOMPARE(metrics.infeasible, qint64(4));
+    QCOMPARE(metrics.cancelled, qint64(0));
+}
+
+void tst_RestartGenerator::shiftCountDeviation_data()
+{
+    QTest::addColumn<QVariantMap>("roster");
+    QTest::addColumn<QStringList>("nurses");
+    QTest::addColumn<double>("expected");
+
+    const QString alice = QStringLiteral("Alice");
+    const QString bob   = QStringLiteral("Bob");
+    const QStringList aliceAndBob{ alice, bob };
+    const QString month = QStringLiteral("2018-05");
+
+    QTest::newRow("no-nurses") << QVariantMap() << QStringList() << 0.0;
+
+    QTest::newRow("nobody-rostered") << QVariantMap() << aliceAndBob << 0.0;
+
+    QTest::newRow("equal-shifts")
+        << QVariantMap{ { month, QVariantList{
+               QVariantMap{ { QStringLiteral("night"), QStringList{ alice } } },
+               QVariantMap{ { QStringLiteral("night"), QStringList{ bob } } },
+           } } }
+        << aliceAndBob << 0.0;
+
+    QTest::newRow("one-nurse-unrostered") // Counts of 2 and 0, so mean 1, deviation 1.
+        << QVariantMap{ { month, QVariantList{
+               QVariantMap{ { QStringLiteral("night"), QStringList{ alice } } },
+               QVariantMap{ { QStringLiteral("morning"), QStringList{ alice } } },
+           } } }
+        << aliceAndBob << 1.0;
+}
+
+void tst_RestartGenerator::shiftCountDeviation()
+{
+    QFETCH(QVariantMap, roster);
+    QFETCH(QStringList, nurses);
+    QFETCH(double, expected);
+    QCOMPARE(Cogent::RestartGenerator::shiftCountDeviation(roster, nurses), expected);
+}
+
+QTEST_APPLESS_MAIN(tst_RestartGenerator)
+#include "tst_RestartGenerator.moc"
@@ -0,0 +1,118 @@
+#include "../../src/Roster.h"
+
+#include <QTest>
+
+class tst_Roster : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void variantRoundTrip_data();
+    void variantRoundTrip();
+    void assign();
+    void widen();
+};
+
+void tst_Roster::variantRoundTrip_data()
+{
+    QTest::addColumn<QVariantList>("days");
+
+    const QStringList alice { QStringLiteral("Alice") };
+    const QStringList aliceAndBob{ QStringLiteral("Alice"), QStringLiteral("Bob") };
+
+    QTest::newRow("no-days") << QVariantList();
+
+    QTest::newRow("one-empty-day")
+        << QVariantList{
+               QVariantMap{
+                   { QStringLiteral("night"),   QStringList() },
+                   { QStringLiteral("morning"), QStringList() },
+                   { QStringLiteral("evening"), QStringList() },
+               }
+           };
+
+    QTest::newRow("two-days")
+        << QVariantList{
+               QVariantMap{
+                   { QStringLiteral("night"),   alice },
+                   { QStringLiteral("morning"), QStringList() },
+                   { QStringLiteral("evening"), QStringList{ QStringLiteral("Bob") } },
+               },
+               QVariantMap{
+                   { QStringLiteral("night"),   QStringList() },
+                   { QStringLiteral("morning"), aliceAndBob },
+                   { QStringLiteral("evening"), QStringList() },
+               }
+           };
+}
+
+void tst_Roster::variantRoundTrip()
+{
+    QFETCH(QVariantList, days);
+
+    Cogent::NurseTable table;
+    const Cogent::Roster roster = Cogent::Roster::fromVariantList(days, table);
+    QCOMPARE(roster.size(), days.size());
+    QCOMPARE(roster.toVariantList(table), days);
+}
+
+void tst_Roster::assign()
+{
+    Cogent::NurseTable table;
+    const Cogent::NurseId alice = table.intern(QStringLiteral("Alice"));
+    const Cogent::NurseId bob = table.intern(QStringLiteral("Bob"));
+    QCOMPARE(table.intern(QStringLiteral("Alice")), alice);
+    QCOMPARE(table.id(QStringLiteral("Carol")), -1);
+    QCOMPARE(table.size(), 2);
+
+    Cogent::Roster roster;
+    QVERIFY(roster.isEmpty());
+    roster.appendDay();
+    roster.appendDay();
+    QCOMPARE(roster.size(), 2);
+
+    roster.assign(1, Cogent::Roster::MorningShift, bob);
+    roster.assign(1, Cogent::Roster::MorningShift, alice);
+    QCOMPARE(roster.count(1, Cogent::Roster::MorningShift), 2);
+    QCOMPARE(roster.count(0, Cogent::Roster::MorningShift), 0);
+    QCOMPARE(roster.nurses(1, Cogent::Roster::MorningShift), (QVector<Cogent::NurseId>{ bob, alice }));
+    QVERIFY(roster.isRostered(1, alice));
+    QVERIFY(roster.isRostered(1, Cogent::Roster::MorningShift, alice));
+    QVERIFY(!roster.isRostered(1, Cogent::Roster::NightShift, alice));
+    QVERIFY(!roster.isRostered(0, alice));
+
+    QCOMPARE(roster.unassign(1, Cogent::Roster::MorningShift), alice);
+    QVERIFY(!roster.isRostered(1, alice));
+    QVERIFY(roster.isRostered(1, bob));
+
+    roster.removeLastDay();
+    QCOMPARE(roster.size(), 1);
+    QVERIFY(!roster.isRostered(0, bob));
+}
+
+void tst_Roster::widen()
+{
+    // Start with a single slot per shift, so that every additional nurse forces a re-layout.
+    Cogent::Roster roster(Cogent::Roster::defaultShiftNames(), 1);
+    for (int day = 0; day < 3; ++day) {
+        roster.appendDay();
+        for (int shift = 0; shift < roster.shiftCount(); ++shift) {
+            roster.assign(day, shift, day * 10 + shift);
+        }
+    }
+    for (Cogent::NurseId nurse = 100; nurse < 105; ++nurse) {
+        roster.assign(1, Cogent::Roster::EveningShift, nurse);
+    }
+
+    QCOMPARE(roster.count(1, Cogent::Roster::EveningShift), 6);
+    QCOMPARE(roster.nurses(1, Cogent::Roster::EveningShift),
+             (QVector<Cogent::NurseId>{ 12, 100, 101, 102, 103, 104 }));
+    for (int day = 0; day < 3; ++day) {
+        for (int shift = 0; shift < roster.shiftCount(); ++shift) {
+            QCOMPARE(roster.at(day, shift, 0), day * 10 + shift);
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(tst_Roster)
+#include "tst_Roster.moc"
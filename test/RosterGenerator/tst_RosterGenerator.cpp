@@ -1,11 +1,98 @@
 #include "../../src/AtMostFiveConsecutiveDays.h"
 #include "../../src/AtMostFiveNightShiftsPerMonth.h"
 #include "../../src/AtMostOneShiftPerDay.h"
+#include "../../src/FairScheduler.h"
+#include "../../src/LeastRecentScheduler.h"
 #include "../../src/NoSingleDaysOff.h"
 #include "../../src/RosterGenerator.h"
+#include "../../src/RosterValidator.h"
+#include "../TestNurses.h"
 
 #include <QTest>
 
+// Returns the number of assignments in \a days that violate any of the standard constraints, or any
+// shift that does not have exactly \a nursesPerShift nurses, continuing on from \a carryIn.
+int countViolations(const QVariantList &days, const int nursesPerShift = 5,
+                    const Cogent::CarryIn &carryIn = Cogent::CarryIn())
+{
+    Cogent::NurseTable table;
+    const Cogent::Roster roster = Cogent::Roster::fromVariantList(days, table);
+    QVector<QSharedPointer<Cogent::ConstraintInterface>> constraints {
+        QSharedPointer<Cogent::ConstraintInterface>(new Cogent::AtMostFiveConsecutiveDays()),
+        QSharedPointer<Cogent::ConstraintInterface>(new Cogent::AtMostFiveNightShiftsPerMonth()),
+        QSharedPointer<Cogent::ConstraintInterface>(new Cogent::AtMostOneShiftPerDay()),
+        QSharedPointer<Cogent::ConstraintInterface>(new Cogent::NoSingleDaysOff()),
+    };
+    foreach (auto &constraint, constraints) {
+        constraint->reset(table.size());
+        if (!carryIn.isEmpty()) {
+            constraint->onCarryIn(carryIn.streaks(table));
+        }
+    }
+
+    // Re-check each assignment, in the order the generator makes them.
+    int violations = 0;
+    Cogent::Roster daysSoFar;
+    for (int day = 0; day < roster.size(); ++day) {
+        daysSoFar.appendDay();
+        for (int shift = 0; shift < roster.shiftCount(); ++shift) {
+            if (roster.count(day, shift) != nursesPerShift) {
+                violations++;
+            }
+            for (int slot = 0; slot < roster.count(day, shift); ++slot) {
+                const Cogent::NurseId nurse = roster.at(day, shift, slot);
+                foreach (auto &constraint, constraints) {
+                    Cogent::NurseSet candidate;
+                    candidate.insert(nurse);
+                    violations += constraint->constrain(candidate, shift, daysSoFar);
+                }
+                daysSoFar.assign(day, shift, nurse);
+                foreach (auto &constraint, constraints) {
+                    constraint->onAssigned(nurse, day, shift);
+                }
+            }
+        }
+        foreach (auto &constraint, constraints) {
+            constraint->onDayCommitted(daysSoFar, day);
+        }
+    }
+    return violations;
+}
+
+// A constraint that removes up to a fixed number of candidates from every shift, logging its name
+// on each call.
+class TestConstraint : public Cogent::ConstraintInterface
+{
+public:
+    TestConstraint(const QString &name, const int maxRemoved, QStringList * const calls)
+        : testName(name), maxRemoved(maxRemoved), calls(calls) { }
+
+    int constrain(Cogent::NurseSet &nurses, const int shift, const Cogent::Roster &daysSoFar)
+        override
+    {
+        Q_UNUSED(shift);
+        Q_UNUSED(daysSoFar);
+        calls->append(testName);
+        int removed = 0;
+        for (Cogent::NurseId nurse = nurses.first(); (nurse >= 0) && (removed < maxRemoved);
+             nurse = nurses.next(nurse)) {
+            nurses.remove(nurse);
+            ++removed;
+        }
+        return removed;
+    }
+
+    QString name() const override
+    {
+        return testName;
+    }
+
+protected:
+    const QString testName;
+    const int maxRemoved;
+    QStringList * const calls;
+};
+
 class tst_RosterGenerator : public QObject
 {
     Q_OBJECT
@@ -13,6 +100,27 @@ class tst_RosterGenerator : public QObject
 private slots:
     void generate_data();
     void generate();
+    void backtracking_data();
+    void backtracking();
+    void backtrackingFollowsGreedy_data();
+    void backtrackingFollowsGreedy();
+    void carryIn_data();
+    void carryIn();
+    void nurseOrder();
+    void demand();
+    void infeasible_data();
+    void infeasible();
+    void records();
+    void repair_data();
+    void repair();
+    void repairHeadcounts();
+    void repairInfeasible();
+    void repairRewindsScheduler();
+    void constraintStats();
+    void constraintOrder();
+    void shortCircuit();
+    void metrics();
+    void timing();
 };
 
 void tst_RosterGenerator::generate_data()
@@ -54,7 +162,7 @@ void tst_RosterGenerator::generate()
     // Setup a generator instance.
     Cogent::RosterGenerator generator;
     generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
-    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(QObject::tr("night")));
+    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
     generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
     generator.addConstraint(new Cogent::NoSingleDaysOff());
 
@@ -71,7 +179,644 @@ void tst_RosterGenerator::generate()
     const QVariantList monthRoster = roster.value(monthKey).toList();
     QCOMPARE(monthRoster.size(), days);
 
+    // Check constraints, including via the validator (as used to audit rosters).
+    QCOMPARE(countViolations(monthRoster), 0);
+    Cogent::RosterValidator validator;
+    validator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    validator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    validator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    validator.addConstraint(new Cogent::NoSingleDaysOff());
+    QCOMPARE(validator.validate(roster).size(), 0);
+
+    // Generating into a compact roster, with a likewise fresh generator, gives the same days.
+    Cogent::RosterGenerator compactGenerator;
+    compactGenerator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    compactGenerator.addConstraint(
+        new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    compactGenerator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    compactGenerator.addConstraint(new Cogent::NoSingleDaysOff());
+    Cogent::Roster compact;
+    QVERIFY(!compactGenerator.generate(year, month, nurses.mid(0,1), Cogent::CarryIn(), compact));
+    QVERIFY(compactGenerator.generate(year, month, nurses, Cogent::CarryIn(), compact));
+    QCOMPARE(compact.toVariantList(compactGenerator.nurses()), monthRoster);
+    QCOMPARE(Cogent::RosterGenerator::monthKey(year, month), monthKey);
+}
+
+void tst_RosterGenerator::backtracking_data()
+{
+    QTest::addColumn<int>("year");
+    QTest::addColumn<int>("month");
+    QTest::addColumn<int>("days");
+    QTest::addColumn<int>("nurseCount");
+    QTest::addColumn<bool>("expectRoster");
+
+    // Tight nurse pools that the greedy engine fails to roster, but the backtracking engine can.
+    QTest::newRow("29-days-29-nurses") << 2020 << 02 << 29 << 29 << true;
+    QTest::newRow("29-days-31-nurses") << 2020 << 02 << 29 << 31 << true;
+    QTest::newRow("30-days-31-nurses") << 2018 << 06 << 30 << 31 << true;
+
+    // Fewer nurses than can possibly cover every night shift (see README.md).
+    QTest::newRow("28-days-27-nurses") << 2018 << 02 << 28 << 27 << false;
+}
+
+void tst_RosterGenerator::backtracking()
+{
+    QFETCH(int, year);
+    QFETCH(int, month);
+    QFETCH(int, days);
+    QFETCH(int, nurseCount);
+    QFETCH(bool, expectRoster);
+
+    const QStringList nurses = makeNurses(nurseCount);
+
+    // Check that the greedy engine alone really does fail to roster these nurses.
+    Cogent::RosterGenerator greedy;
+    greedy.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    greedy.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    greedy.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    greedy.addConstraint(new Cogent::NoSingleDaysOff());
+    QVERIFY(greedy.generate(year, month, nurses).isEmpty());
+
+    // Setup a generator instance, with a node limit to keep infeasible cases quick.
+    Cogent::RosterGenerator generator;
+    generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+    generator.setEngine(Cogent::RosterGenerator::BacktrackingEngine);
+    generator.setSearchLimits(20000, 0);
+
+    // Generate the roster.
+    const QVariantMap roster = generator.generate(year, month, nurses);
+    QCOMPARE(!roster.isEmpty(), expectRoster);
+    if (!expectRoster) {
+        return;
+    }
+
+    // Check the roster contains the right month, with the expected number of days.
+    const QString monthKey = QStringLiteral("%1-%2").arg(year).arg(month, 2, 10,QLatin1Char('0'));
+    QVERIFY(roster.contains(monthKey));
+    const QVariantList monthRoster = roster.value(monthKey).toList();
+    QCOMPARE(monthRoster.size(), days);
+
     // Check constraints.
+    QCOMPARE(countViolations(monthRoster), 0);
+}
+
+void tst_RosterGenerator::backtrackingFollowsGreedy_data()
+{
+    QTest::addColumn<bool>("fair");
+    QTest::addColumn<quint64>("seed");
+
+    QTest::newRow("least-recent-unseeded") << false << Q_UINT64_C(0);
+    QTest::newRow("least-recent-seeded")   << false << Q_UINT64_C(12345);
+    QTest::newRow("fair-unseeded")         << true  << Q_UINT64_C(0);
+    QTest::newRow("fair-seeded")           << true  << Q_UINT64_C(12345);
+}
+
+void tst_RosterGenerator::backtrackingFollowsGreedy()
+{
+    QFETCH(bool, fair);
+    QFETCH(quint64, seed);
+
+    // Where the greedy engine succeeds, the search's first path (and so its roster) is the same.
+    const QStringList nurses = makeNurses(40);
+    QVariantMap rosters[2];
+    for (int index = 0; index < 2; ++index) {
+        Cogent::RosterGenerator generator;
+        generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+        generator.addConstraint(
+            new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+        generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+        generator.addConstraint(new Cogent::NoSingleDaysOff());
+        Cogent::SchedulerInterface * const scheduler = (fair)
+            ? static_cast<Cogent::SchedulerInterface *>(new Cogent::FairScheduler)
+            : static_cast<Cogent::SchedulerInterface *>(new Cogent::LeastRecentScheduler);
+        scheduler->setSeed(seed);
+        generator.setScheduler(scheduler);
+        if (index == 1) {
+            generator.setEngine(Cogent::RosterGenerator::BacktrackingEngine);
+        }
+        rosters[index] = generator.generate(2018, 06, nurses);
+    }
+    QVERIFY(!rosters[0].isEmpty());
+    QCOMPARE(rosters[1], rosters[0]);
+}
+
+void tst_RosterGenerator::carryIn_data()
+{
+    QTest::addColumn<int>("nurseCount");
+
+    QTest::newRow("40-nurses") << 40;
+    QTest::newRow("60-nurses") << 60;
+    QTest::newRow("98-nurses") << 98;
+}
+
+void tst_RosterGenerator::carryIn()
+{
+    QFETCH(int, nurseCount);
+
+    const QStringList nurses = makeNurses(nurseCount);
+
+    Cogent::RosterGenerator generator;
+    generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+
+    // Roll several months forward, checking that no constraints are violated across each boundary.
+    Cogent::CarryIn carryIn;
+    for (int month = 1; month <= 6; ++month) {
+        const QVariantMap roster = generator.generate(2018, month, nurses, carryIn);
+        const QString monthKey = QStringLiteral("2018-%1").arg(month, 2, 10, QLatin1Char('0'));
+        QVERIFY(roster.contains(monthKey));
+        QCOMPARE(countViolations(roster.value(monthKey).toList(), 5, carryIn), 0);
+        carryIn = Cogent::CarryIn::fromRoster(roster, carryIn);
+    }
+}
+
+void tst_RosterGenerator::nurseOrder()
+{
+    const QStringList nurses = makeNurses(20);
+    QStringList reversed;
+    foreach (const QString &nurse, nurses) {
+        reversed.prepend(nurse);
+    }
+
+    // The scheduler's history is kept by nurse, rather than by position in each call's list of
+    // nurses, so the next month's roster does not depend on the order the nurses are given in.
+    Cogent::RosterGenerator ordered, reordered;
+    QVERIFY(!ordered.generate(2018, 1, nurses).isEmpty());
+    QVERIFY(!reordered.generate(2018, 1, nurses).isEmpty());
+    const QVariantList february = ordered.generate(2018, 2, nurses)
+        .value(QStringLiteral("2018-02")).toList();
+    QCOMPARE(february.size(), 28);
+    QCOMPARE(reordered.generate(2018, 2, reversed).value(QStringLiteral("2018-02")).toList(),
+             february);
+
+    // Nurses given to earlier calls, but not this one, are never rostered.
+    const QVariantMap march = ordered.generate(2018, 3, nurses.mid(5));
+    QVERIFY(!march.isEmpty());
+    foreach (const QVariant &day, march.value(QStringLiteral("2018-03")).toList()) {
+        foreach (const QVariant &shift, day.toMap()) {
+            foreach (const QString &nurse, nurses.mid(0, 5)) {
+                QVERIFY(!shift.toStringList().contains(nurse));
+            }
+        }
+    }
+}
+
+void tst_RosterGenerator::demand()
+{
+    const QStringList nurses = makeNurses(60);
+
+    // Fewer nurses on weekends, and fewer again (with no evening shift) on Christmas Day.
+    Cogent::Demand demand(QVector<int>{ 4, 6, 5 });
+    for (int shift = 0; shift < demand.shiftCount(); ++shift) {
+        demand.setNurses(Qt::Saturday, shift, 2);
+        demand.setNurses(Qt::Sunday, shift, 2);
+    }
+    demand.setNurses(QDate(2018, 12, 25), Cogent::Roster::MorningShift, 1);
+    demand.setNurses(QDate(2018, 12, 25), Cogent::Roster::EveningShift, 0);
+
+    Cogent::RosterGenerator generator;
+    generator.setShifts(Cogent::Roster::defaultShiftNames(), demand);
+    generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+    const QVariantList days =
+        generator.generate(2018, 12, nurses).value(QStringLiteral("2018-12")).toList();
+    QCOMPARE(days.size(), 31);
+
+    for (int day = 0; day < days.size(); ++day) {
+        const QDate date(2018, 12, day+1);
+        const QVariantMap shifts = days.at(day).toMap();
+        for (int shift = 0; shift < demand.shiftCount(); ++shift) {
+            const QString shiftName = Cogent::Roster::defaultShiftNames().at(shift);
+            QCOMPARE(shifts.value(shiftName).toList().size(), demand.nurses(date, shift));
+        }
+    }
+    QCOMPARE(days.at(24).toMap().value(QStringLiteral("morning")).toList().size(), 1);
+    QCOMPARE(days.at(29).toMap().value(QStringLiteral("night")).toList().size(), 2); // Sunday.
+}
+
+void tst_RosterGenerator::infeasible_data()
+{
+    QTest::addColumn<int>("month");
+    QTest::addColumn<int>("nurseCount");
+    QTest::addColumn<QVector<int>>("nursesPerShift");
+
+    // Fewer nurses than can possibly cover every night shift (see README.md).
+    QTest::newRow("night-shifts")  << 2 << 27 << QVector<int>{ 5, 5, 5 };
+
+    // Fewer nurses than a single shift, or a single day, needs.
+    QTest::newRow("single-shift")  << 5 << 4  << QVector<int>{ 5, 5, 5 };
+    QTest::newRow("single-day")    << 5 << 12 << QVector<int>{ 5, 5, 5 };
+
+    // Enough nurses for every shift and day, but not for five days on, one day off, all month.
+    QTest::newRow("whole-month")   << 5 << 18 << QVector<int>{ 1, 8, 8 };
+}
+
+void tst_RosterGenerator::infeasible()
+{
+    QFETCH(int, month);
+    QFETCH(int, nurseCount);
+    QFETCH(QVector<int>, nursesPerShift);
+
+    const QStringList nurses = makeNurses(nurseCount);
+
+    // Without any search limits, only the feasibility bound can end this quickly.
+    Cogent::RosterGenerator generator;
+    generator.setShifts(Cogent::Roster::defaultShiftNames(), Cogent::Demand(nursesPerShift));
+    generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+    generator.setEngine(Cogent::RosterGenerator::BacktrackingEngine);
+    generator.setSearchLimits(0, 0);
+    QCOMPARE(generator.generate(2018, month, nurses), QVariantMap());
+}
+
+void tst_RosterGenerator::records()
+{
+    const QStringList nurses = makeNurses(40);
+
+    // One nurse on leave for the first ten days, one part-time, and one working mornings only.
+    QVector<Cogent::NurseRecord> records{ Cogent::NurseRecord(nurses.at(0)),
+        Cogent::NurseRecord(nurses.at(1)), Cogent::NurseRecord(nurses.at(2)) };
+    records[0].leave.append(qMakePair(QDate(2018, 11, 25), QDate(2018, 12, 10)));
+    records[1].maxShifts = 4;
+    records[2].shifts.insert(QStringLiteral("morning"));
+
+    Cogent::RosterGenerator generator;
+    generator.setShifts(Cogent::Roster::defaultShiftNames(), Cogent::Demand(QVector<int>{ 5, 5, 5 }));
+    generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+    generator.setEngine(Cogent::RosterGenerator::BacktrackingEngine);
+    generator.setNurseRecords(records);
+    const QVariantList days =
+        generator.generate(2018, 12, nurses).value(QStringLiteral("2018-12")).toList();
+    QCOMPARE(days.size(), 31);
+    QCOMPARE(countViolations(days), 0);
+
+    int partTimeShifts = 0;
+    for (int day = 0; day < days.size(); ++day) {
+        const QVariantMap shifts = days.at(day).toMap();
+        for (auto iter = shifts.constBegin(); iter != shifts.constEnd(); ++iter) {
+            const QVariantList shiftNurses = iter.value().toList();
+            if (day < 10) {
+                QVERIFY(!shiftNurses.contains(nurses.at(0)));
+            }
+            if (iter.key() != QStringLiteral("morning")) {
+                QVERIFY(!shiftNurses.contains(nurses.at(2)));
+            }
+            partTimeShifts += shiftNurses.count(nurses.at(1));
+        }
+    }
+    QVERIFY(partTimeShifts <= 4);
+
+    // Months in which too few nurses are available are rejected up front.
+    for (int index = 0; index < 30; ++index) {
+        records.append(Cogent::NurseRecord(nurses.at(index + 3)));
+        records.last().leave.append(qMakePair(QDate(2018, 12, 25), QDate(2018, 12, 25)));
+    }
+    generator.setNurseRecords(records);
+    generator.setSearchLimits(0, 0);
+    QCOMPARE(generator.generate(2018, 12, nurses), QVariantMap());
+}
+
+void tst_RosterGenerator::repair_data()
+{
+    QTest::addColumn<QStringList>("removedNurses");
+    QTest::addColumn<QStringList>("blockedNurses");
+    QTest::addColumn<QDate>("blockedDate");
+    QTest::addColumn<int>("firstChangedDay"); // Or -1 for the removed nurse's first day rostered.
+
+    const QStringList none;
+    QTest::newRow("no-changes") << none << none << QDate() << 30;
+    QTest::newRow("sick-day") << none << QStringList{ QStringLiteral("Nurse 3") }
+                              << QDate(2018, 6, 20) << 19;
+    QTest::newRow("not-rostered") << none
+                                  << QStringList{ QStringLiteral("Nurse 3"),
+                                                  QStringLiteral("Nurse 4") }
+                                  << QDate(2018, 6, 12) << 30;
+    QTest::newRow("removed") << QStringList{ QStringLiteral("Nurse 7") } << none << QDate() << -1;
+    QTest::newRow("unknown") << QStringList{ QStringLiteral("Nobody") } << none << QDate() << 30;
+}
+
+void tst_RosterGenerator::repair()
+{
+    QFETCH(QStringList, removedNurses);
+    QFETCH(QStringList, blockedNurses);
+    QFETCH(QDate, blockedDate);
+    QFETCH(int, firstChangedDay);
+
+    const QStringList nurses = makeNurses(40);
+    Cogent::RosterGenerator generator;
+    generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+    const QVariantList days =
+        generator.generate(2018, 6, nurses).value(QStringLiteral("2018-06")).toList();
+    QCOMPARE(days.size(), 30);
+
+    // Removed nurses make a difference from their first rostered day.
+    Cogent::RosterGenerator::Changes changes;
+    foreach (const QString &nurse, removedNurses) {
+        changes.removedNurses.insert(nurse);
+    }
+    foreach (const QString &nurse, blockedNurses) {
+        changes.blockedDays.append(qMakePair(nurse, blockedDate));
+    }
+    if (firstChangedDay < 0) {
+        firstChangedDay = 30;
+        for (int day = 0; (day < days.size()) && (firstChangedDay == 30); ++day) {
+            foreach (const QVariant &shift, days.at(day).toMap()) {
+                if (shift.toStringList().contains(removedNurses.first())) {
+                    firstChangedDay = day;
+                }
+            }
+        }
+    }
+
+    const QVariantList repaired =
+        generator.repair(2018, 6, days, nurses, changes).value(QStringLiteral("2018-06")).toList();
+    QCOMPARE(repaired.size(), 30);
+    QCOMPARE(countViolations(repaired), 0);
+    for (int day = 0; day < firstChangedDay; ++day) {
+        QCOMPARE(repaired.at(day), days.at(day));
+    }
+    if (firstChangedDay < 30) {
+        QVERIFY(repaired.at(firstChangedDay) != days.at(firstChangedDay));
+    }
+
+    // Removed and blocked nurses are gone, and most other assignments are unchanged.
+    int unchanged = 0;
+    for (int day = 0; day < repaired.size(); ++day) {
+        const QVariantMap shifts = repaired.at(day).toMap();
+        for (auto iter = shifts.constBegin(); iter != shifts.constEnd(); ++iter) {
+            const QStringList shiftNurses = iter.value().toStringList();
+            foreach (const QString &nurse, removedNurses) {
+                QVERIFY(!shiftNurses.contains(nurse));
+            }
+            if (QDate(2018, 6, day+1) == blockedDate) {
+                foreach (const QString &nurse, blockedNurses) {
+                    QVERIFY(!shiftNurses.contains(nurse));
+                }
+            }
+            const QStringList before = days.at(day).toMap().value(iter.key()).toStringList();
+            foreach (const QString &nurse, shiftNurses) {
+                unchanged += before.contains(nurse) ? 1 : 0;
+            }
+        }
+    }
+    QVERIFY(unchanged >= 30 * 15 * 9 / 10);
+}
+
+void tst_RosterGenerator::repairHeadcounts()
+{
+    const QStringList nurses = makeNurses(40);
+    Cogent::RosterGenerator generator;
+    generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+    const QVariantList days =
+        generator.generate(2018, 6, nurses).value(QStringLiteral("2018-06")).toList();
+
+    // One fewer nurse on the 10th's morning shift, and one more on the 25th's evening shift.
+    Cogent::Demand demand(QVector<int>{ 5, 5, 5 });
+    demand.setNurses(QDate(2018, 6, 10), Cogent::Roster::MorningShift, 4);
+    demand.setNurses(QDate(2018, 6, 25), Cogent::Roster::EveningShift, 6);
+    generator.setShifts(Cogent::Roster::defaultShiftNames(), demand);
+    const QVariantList repaired =
+        generator.repair(2018, 6, days, nurses, Cogent::RosterGenerator::Changes())
+            .value(QStringLiteral("2018-06")).toList();
+    QCOMPARE(repaired.size(), 30);
+    for (int day = 0; day < 9; ++day) {
+        QCOMPARE(repaired.at(day), days.at(day));
+    }
+    const QStringList before =
+        days.at(9).toMap().value(QStringLiteral("morning")).toStringList();
+    const QStringList after =
+        repaired.at(9).toMap().value(QStringLiteral("morning")).toStringList();
+    QCOMPARE(after, before.mid(0, 4));
+    QCOMPARE(repaired.at(24).toMap().value(QStringLiteral("evening")).toList().size(), 6);
+}
+
+void tst_RosterGenerator::repairInfeasible()
+{
+    const QStringList nurses = makeNurses(40);
+    Cogent::RosterGenerator generator;
+    generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+    const QVariantList days =
+        generator.generate(2018, 6, nurses).value(QStringLiteral("2018-06")).toList();
+
+    // Too few nurses left to fill the month, and a roster that is not of the given month.
+    Cogent::RosterGenerator::Changes changes;
+    for (int index = 0; index < 20; ++index) {
+        changes.removedNurses.insert(nurses.at(index));
+    }
+    QCOMPARE(generator.repair(2018, 6, days, nurses, changes), QVariantMap());
+    QCOMPARE(generator.repair(2018, 7, days, nurses, Cogent::RosterGenerator::Changes()),
+             QVariantMap());
+}
+
+void tst_RosterGenerator::repairRewindsScheduler()
+{
+    // FairScheduler counts every shift, so would weigh the kept days twice if not rewound.
+    const QStringList nurses = makeNurses(40);
+    Cogent::RosterGenerator generators[2];
+    for (int index = 0; index < 2; ++index) {
+        generators[index].addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+        generators[index].addConstraint(
+            new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+        generators[index].addConstraint(new Cogent::AtMostOneShiftPerDay());
+        generators[index].addConstraint(new Cogent::NoSingleDaysOff());
+        generators[index].setScheduler(new Cogent::FairScheduler);
+    }
+    const QVariantList days =
+        generators[0].generate(2018, 6, nurses).value(QStringLiteral("2018-06")).toList();
+    QCOMPARE(days.size(), 30);
+    Cogent::RosterGenerator::Changes changes;
+    changes.blockedDays.append(qMakePair(
+        days.at(14).toMap().value(QStringLiteral("night")).toStringList().first(),
+        QDate(2018, 6, 15)));
+
+    // The generator that generated the month repairs it just as a fresh one does, repeatedly.
+    const QVariantMap repaired = generators[1].repair(2018, 6, days, nurses, changes);
+    QVERIFY(!repaired.isEmpty());
+    QCOMPARE(generators[0].repair(2018, 6, days, nurses, changes), repaired);
+    QCOMPARE(generators[0].repair(2018, 6, days, nurses, changes), repaired);
+
+    // Unless given a new scheduler, which is taken to be as at the start of the month.
+    generators[0].setScheduler(new Cogent::FairScheduler);
+    QCOMPARE(generators[0].repair(2018, 6, days, nurses, changes), repaired);
+}
+
+void tst_RosterGenerator::constraintStats()
+{
+    const QStringList nurses = makeNurses(40);
+    Cogent::RosterGenerator generator;
+    generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+    QVERIFY(!generator.generate(2018, 6, nurses).isEmpty());
+
+    // Every constraint is applied to every shift, in the order they were added.
+    const QVector<Cogent::RosterGenerator::ConstraintStats> stats = generator.constraintStats();
+    QCOMPARE(stats.size(), 4);
+    QCOMPARE(stats.at(0).name, QStringLiteral("AtMostConsecutiveDays"));
+    QCOMPARE(stats.at(1).name, QStringLiteral("AtMostShiftsPerMonth"));
+    QCOMPARE(stats.at(2).name, QStringLiteral("AtMostOneShiftPerDay"));
+    QCOMPARE(stats.at(3).name, QStringLiteral("NoSingleDaysOff"));
+    foreach (const auto &constraint, stats) {
+        QCOMPARE(constraint.calls, qint64(30 * 3));
+        QCOMPARE(constraint.skipped, qint64(0));
+        QVERIFY(constraint.removed <= constraint.candidates);
+        QVERIFY(constraint.nanoseconds >= 0);
+    }
+
+    // Each day, the evening and night shifts lose the 5 and 10 nurses already rostered that day.
+    QCOMPARE(stats.at(2).removed, qint64(30 * (5 + 10)));
+}
+
+void tst_RosterGenerator::constraintOrder()
+{
+    const QStringList nurses = makeNurses(40);
+    QStringList calls;
+    Cogent::RosterGenerator generator;
+    generator.addConstraint(new TestConstraint(QStringLiteral("none"), 0, &calls));
+    generator.addConstraint(new TestConstraint(QStringLiteral("one"), 1, &calls));
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    QVERIFY(!generator.generate(2018, 6, nurses).isEmpty());
+
+    // The first day is constrained in the order added, and later days by selectivity, such that
+    // the constraint that never removes anyone goes last.
+    QCOMPARE(calls.size(), 30 * 3 * 2);
+    for (int index = 0; index < 3 * 2; index += 2) {
+        QCOMPARE(calls.at(index), QStringLiteral("none"));
+        QCOMPARE(calls.at(index+1), QStringLiteral("one"));
+    }
+    for (int index = 3 * 2; index < calls.size(); index += 2) {
+        QCOMPARE(calls.at(index), QStringLiteral("one"));
+        QCOMPARE(calls.at(index+1), QStringLiteral("none"));
+    }
+}
+
+void tst_RosterGenerator::shortCircuit()
+{
+    const QStringList nurses = makeNurses(40);
+    QStringList calls;
+    Cogent::RosterGenerator generator;
+    generator.addConstraint(new TestConstraint(QStringLiteral("most"), 36, &calls));
+    generator.addConstraint(new TestConstraint(QStringLiteral("none"), 0, &calls));
+    QCOMPARE(generator.generate(2018, 6, nurses), QVariantMap());
+
+    // Once too few nurses remain for the first shift, the remaining constraints are skipped.
+    QCOMPARE(calls, QStringList{ QStringLiteral("most") });
+    const QVector<Cogent::RosterGenerator::ConstraintStats> stats = generator.constraintStats();
+    QCOMPARE(stats.at(0).calls, qint64(1));
+    QCOMPARE(stats.at(0).candidates, qint64(40));
+    QCOMPARE(stats.at(0).removed, qint64(36));
+    QCOMPARE(stats.at(1).calls, qint64(0));
+    QCOMPARE(stats.at(1).skipped, qint64(1));
+
+    // The same with the backtracking engine, which tries no combinations of the remaining nurses.
+    calls.clear();
+    generator.setEngine(Cogent::RosterGenerator::BacktrackingEngine);
+    QCOMPARE(generator.generate(2018, 6, nurses), QVariantMap());
+    QCOMPARE(calls, QStringList{ QStringLiteral("most") });
+}
+
+void tst_RosterGenerator::metrics()
+{
+    const QStringList nurses = makeNurses(40);
+    Cogent::RosterGenerator generator;
+    generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth(Cogent::Roster::NightShift));
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+    QVERIFY(!generator.generate(2018, 6, nurses).isEmpty());
+
+    // The greedy engine calls the scheduler once per shift, and never backtracks.
+    Cogent::GeneratorMetrics metrics = generator.metrics();
+    QCOMPARE(metrics.rosters, qint64(1));
+    QCOMPARE(metrics.failures, qint64(0));
+    QCOMPARE(metrics.infeasible, qint64(0));
+    QVERIFY(metrics.nanoseconds > 0);
+    QCOMPARE(metrics.schedulerCalls, qint64(30 * 3));
+    QVERIFY(metrics.schedulerNanoseconds <= metrics.nanoseconds);
+    QCOMPARE(metrics.searchNodes, qint64(0));
+    QVERIFY(metrics.backtracks.isEmpty());
+    QVERIFY(metrics.failedShifts.isEmpty());
+    QCOMPARE(metrics.constraints.size(), 4);
+    QCOMPARE(metrics.constraints.at(2).name, QStringLiteral("AtMostOneShiftPerDay"));
+    QCOMPARE(metrics.constraints.at(2).calls, qint64(30 * 3));
+
+    // A tight pool fails greedily, at a known shift, but the search backtracks to find a roster.
+    QStringList tightNurses = nurses.mid(0, 29);
+    QCOMPARE(generator.generate(2020, 2, tightNurses), QVariantMap());
+    metrics = generator.metrics();
+    QCOMPARE(metrics.rosters, qint64(2));
+    QCOMPARE(metrics.failures, qint64(1));
+    QCOMPARE(metrics.failedShifts.size(), 1);
+    QCOMPARE(metrics.failedShifts.first(), qint64(1));
+    generator.setEngine(Cogent::RosterGenerator::BacktrackingEngine);
+    generator.setSearchLimits(20000, 0);
+    QVERIFY(!generator.generate(2020, 2, tightNurses).isEmpty());
+    metrics = generator.metrics();
+    QCOMPARE(metrics.rosters, qint64(3));
+    QCOMPARE(metrics.failures, qint64(1));
+    QVERIFY(metrics.searchNodes >= 29 * 3);
+    QVERIFY(!metrics.backtracks.isEmpty());
+    QCOMPARE(metrics.searchesExhausted, qint64(0));
+
+    // Infeasible months are rejected before any shifts are filled.
+    QCOMPARE(generator.generate(2018, 2, nurses.mid(0, 27)), QVariantMap());
+    metrics = generator.metrics();
+    QCOMPARE(metrics.rosters, qint64(4));
+    QCOMPARE(metrics.failures, qint64(2));
+    QCOMPARE(metrics.infeasible, qint64(1));
+}
+
+void tst_RosterGenerator::timing()
+{
+    const QStringList nurses = makeNurses(40);
+    Cogent::RosterGenerator generator;
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+    QVERIFY(!generator.generate(2018, 6, nurses).isEmpty());
+
+    // Constraint and scheduler calls are counted, but not timed, by default.
+    Cogent::GeneratorMetrics metrics = generator.metrics();
+    QVERIFY(metrics.nanoseconds > 0);
+    QCOMPARE(metrics.schedulerCalls, qint64(30 * 3));
+    QCOMPARE(metrics.schedulerNanoseconds, qint64(0));
+    foreach (const auto &constraint, metrics.constraints) {
+        QCOMPARE(constraint.calls, qint64(30 * 3));
+        QCOMPARE(constraint.nanoseconds, qint64(0));
+    }
+
+    // Once timed, they are timed too.
+    generator.setTimed(true);
+    QVERIFY(!generator.generate(2018, 7, nurses).isEmpty());
+    metrics = generator.metrics();
+    QCOMPARE(metrics.schedulerCalls, qint64((30 + 31) * 3));
+    QVERIFY(metrics.schedulerNanoseconds > 0);
+    QVERIFY(metrics.schedulerNanoseconds <= metrics.nanoseconds);
+    foreach (const auto &constraint, metrics.constraints) {
+        QCOMPARE(constraint.calls, qint64((30 + 31) * 3));
+        QVERIFY(constraint.nanoseconds > 0);
+    }
 }
 
 QTEST_APPLESS_MAIN(tst_RosterGenerator)
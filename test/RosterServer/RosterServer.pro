@@ -0,0 +1,5 @@
+include(../test.pri)
+QT += network
+
+# RosterServer queues responses via QMetaObject::invokeMethod with a functor, new in Qt 5.10.
+equals(QT_MAJOR_VERSION, 5):lessThan(QT_MINOR_VERSION, 10): error(Qt 5.10 or later is required)
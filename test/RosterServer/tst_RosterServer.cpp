@@ -0,0 +1,341 @@
+#include "../../src/LeastRecentScheduler.h"
+#include "../../src/RosterServer.h"
+#include "../../src/Rules.h"
+#include "../TestNurses.h"
+
+#include <QTest>
+
+#include <functional>
+
+// Runs a function on a thread pool.
+class Runnable : public QRunnable
+{
+public:
+    explicit Runnable(const std::function<void()> &function) : function(function) { }
+    void run() override { function(); }
+protected:
+    const std::function<void()> function;
+};
+
+class tst_RosterServer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void invalid_data();
+    void invalid();
+    void nurses();
+    void nursesFile_data();
+    void nursesFile();
+    void maxRequestSize();
+    void generate();
+    void regenerate();
+    void repair();
+    void wards();
+
+protected:
+    // Returns a configurator that applies the built-in rules.
+    static Cogent::RosterServer::Configurator configurator()
+    {
+        return [](Cogent::RosterGenerator &generator) {
+            Cogent::Rules::defaults().configure(generator);
+        };
+    }
+
+    // Returns the server's response to \a request (given as a map), as a map.
+    static QVariantMap handle(Cogent::RosterServer &server, const QVariantMap &request)
+    {
+        const QByteArray response =
+            server.handle(QJsonDocument::fromVariant(request).toJson(QJsonDocument::Compact));
+        if ((!response.endsWith('\n')) || (response.count('\n') != 1)) {
+            return QVariantMap();
+        }
+        return QJsonDocument::fromJson(response).toVariant().toMap();
+    }
+
+    // Returns a "generate" (or "regenerate") request for \a month of \a ward.
+    static QVariantMap generateRequest(const QString &ward, const QString &month,
+                                       const bool regenerate = false)
+    {
+        return QVariantMap{
+            { QStringLiteral("command"),
+              regenerate ? QStringLiteral("regenerate") : QStringLiteral("generate") },
+            { QStringLiteral("ward"), ward },
+            { QStringLiteral("month"), month },
+        };
+    }
+
+    // Returns \a roster, less its "created" timestamp.
+    static QVariantMap withoutMetadata(QVariantMap roster)
+    {
+        roster.remove(QStringLiteral("created"));
+        return roster;
+    }
+
+    // Returns the roster a standalone RosterGenerator generates for \a month of \a year, for
+    // \a nurses.
+    static QVariantMap expectedRoster(const int year, const int month, const QStringList &nurses)
+    {
+        Cogent::RosterGenerator generator;
+        configurator()(generator);
+        return withoutMetadata(generator.generate(year, month, nurses));
+    }
+};
+
+void tst_RosterServer::invalid_data()
+{
+    QTest::addColumn<QByteArray>("request");
+
+    QTest::newRow("empty") << QByteArray("\n");
+    QTest::newRow("not-json") << QByteArray("generate 2018-06\n");
+    QTest::newRow("not-object") << QByteArray("[ \"generate\" ]\n");
+    QTest::newRow("no-command") << QByteArray("{ \"id\": 1 }\n");
+    QTest::newRow("unknown-command") << QByteArray("{ \"id\": 1, \"command\": \"delete\" }\n");
+    QTest::newRow("no-nurses")
+        << QByteArray("{ \"command\": \"generate\", \"month\": \"2018-06\" }");
+    QTest::newRow("bad-month")
+        << QByteArray("{ \"command\": \"generate\", \"month\": \"2018-13\" }");
+    QTest::newRow("no-roster")
+        << QByteArray("{ \"command\": \"repair\", \"month\": \"2018-06\" }");
+    QTest::newRow("bad-file")
+        << QByteArray("{ \"command\": \"nurses\", \"file\": \"/nonexistent\" }");
+}
+
+void tst_RosterServer::invalid()
+{
+    QFETCH(QByteArray, request);
+
+    Cogent::RosterServer server(configurator());
+    const QByteArray response = server.handle(request);
+    QVERIFY(response.endsWith('\n'));
+    const QVariantMap map = QJsonDocument::fromJson(response).toVariant().toMap();
+    QVERIFY(!map.value(QStringLiteral("error")).toString().isEmpty());
+    QVERIFY(!map.contains(QStringLiteral("roster")));
+    if (request.contains("\"id\"")) {
+        QCOMPARE(map.value(QStringLiteral("id")).toInt(), 1);
+    }
+}
+
+void tst_RosterServer::nurses()
+{
+    Cogent::RosterServer server(configurator());
+    QVariantMap response = handle(server, QVariantMap{
+        { QStringLiteral("id"), QStringLiteral("a") },
+        { QStringLiteral("command"), QStringLiteral("nurses") },
+        { QStringLiteral("nurses"), makeNurses(40) },
+    });
+    QCOMPARE(response.value(QStringLiteral("nurses")).toInt(), 40);
+    QCOMPARE(response.value(QStringLiteral("id")).toString(), QStringLiteral("a"));
+    QVERIFY(!response.contains(QStringLiteral("error")));
+
+    // Nurses lists may also be read from file, as per the --nurses and --skip-dups options, if
+    // within the nurses list directory.
+    QVERIFY(server.setNurseListDirectory(QFINDTESTDATA("../../data")));
+    response = handle(server, QVariantMap{
+        { QStringLiteral("command"), QStringLiteral("nurses") },
+        { QStringLiteral("file"), QStringLiteral("nurses.txt") },
+        { QStringLiteral("skipDups"), true },
+    });
+    QCOMPARE(response.value(QStringLiteral("nurses")).toInt(), 98);
+}
+
+void tst_RosterServer::nursesFile_data()
+{
+    QTest::addColumn<bool>("enabled");
+    QTest::addColumn<QString>("file");
+    QTest::addColumn<bool>("allowed");
+
+    const QString nurses = QFINDTESTDATA("../../data/nurses.txt");
+    QTest::newRow("relative") << true << QStringLiteral("nurses.txt") << true;
+    QTest::newRow("absolute") << true << nurses << true;
+    QTest::newRow("within") << true << QStringLiteral("../data/./nurses.txt") << true;
+    QTest::newRow("disabled") << false << QStringLiteral("nurses.txt") << false;
+    QTest::newRow("missing") << true << QStringLiteral("missing.txt") << false;
+    QTest::newRow("parent") << true << QStringLiteral("../README.md") << false;
+    QTest::newRow("outside") << true << QFINDTESTDATA("../../README.md") << false;
+    QTest::newRow("directory") << true << QStringLiteral(".") << false;
+}
+
+void tst_RosterServer::nursesFile()
+{
+    QFETCH(bool, enabled);
+    QFETCH(QString, file);
+    QFETCH(bool, allowed);
+
+    // Clients may only read nurses lists from within the configured directory, if any.
+    Cogent::RosterServer server(configurator());
+    if (enabled) {
+        QVERIFY(server.setNurseListDirectory(QFINDTESTDATA("../../data")));
+    }
+    const QVariantMap response = handle(server, QVariantMap{
+        { QStringLiteral("command"), QStringLiteral("nurses") },
+        { QStringLiteral("file"), file },
+    });
+    QCOMPARE(response.contains(QStringLiteral("nurses")), allowed);
+    QCOMPARE(response.contains(QStringLiteral("error")), !allowed);
+}
+
+void tst_RosterServer::maxRequestSize()
+{
+    Cogent::RosterServer server(configurator());
+    server.setMaxRequestSize(256);
+    const QVariantMap request{
+        { QStringLiteral("command"), QStringLiteral("nurses") },
+        { QStringLiteral("nurses"), makeNurses(10) },
+    };
+    QCOMPARE(handle(server, request).value(QStringLiteral("nurses")).toInt(), 10);
+
+    // Longer requests are rejected outright, without being parsed.
+    const QVariantMap response = handle(server, QVariantMap{
+        { QStringLiteral("command"), QStringLiteral("nurses") },
+        { QStringLiteral("nurses"), makeNurses(100) },
+    });
+    QVERIFY(!response.value(QStringLiteral("error")).toString().isEmpty());
+    QVERIFY(!response.contains(QStringLiteral("nurses")));
+}
+
+void tst_RosterServer::generate()
+{
+    const QStringList nurses = makeNurses(40);
+    Cogent::RosterServer server(configurator());
+    server.setNurses(QString(), nurses);
+
+    // Each month continues on from the previous month's kept roster, if any, as a single
+    // generator would (so including the scheduler's history).
+    Cogent::RosterGenerator generator;
+    configurator()(generator);
+    const QVariantMap june =
+        handle(server, generateRequest(QString(), QStringLiteral("2018-06")))
+            .value(QStringLiteral("roster")).toMap();
+    QCOMPARE(withoutMetadata(june), withoutMetadata(generator.generate(2018, 6, nurses)));
+    const QVariantMap july =
+        handle(server, generateRequest(QString(), QStringLiteral("2018-07")))
+            .value(QStringLiteral("roster")).toMap();
+    QCOMPARE(withoutMetadata(july), withoutMetadata(
+        generator.generate(2018, 7, nurses, Cogent::CarryIn::fromRoster(june))));
+    const QVariantMap august =
+        handle(server, generateRequest(QString(), QStringLiteral("2018-08")))
+            .value(QStringLiteral("roster")).toMap();
+    QCOMPARE(withoutMetadata(august), withoutMetadata(generator.generate(2018, 8, nurses,
+        Cogent::CarryIn::fromRoster(july, Cogent::CarryIn::fromRoster(june)))));
+
+    // Months without a kept previous month start afresh.
+    const QVariantMap october =
+        handle(server, generateRequest(QString(), QStringLiteral("2018-10")))
+            .value(QStringLiteral("roster")).toMap();
+    QCOMPARE(withoutMetadata(october), expectedRoster(2018, 10, nurses));
+}
+
+void tst_RosterServer::regenerate()
+{
+    const QStringList nurses = makeNurses(40);
+    Cogent::RosterServer server(configurator());
+    server.setNurses(QString(), nurses);
+    const QVariantMap june =
+        handle(server, generateRequest(QString(), QStringLiteral("2018-06")))
+            .value(QStringLiteral("roster")).toMap();
+    handle(server, generateRequest(QString(), QStringLiteral("2018-07")));
+
+    // Regenerating offers a different roster each time.
+    const QVariantMap june1 =
+        handle(server, generateRequest(QString(), QStringLiteral("2018-06"), true))
+            .value(QStringLiteral("roster")).toMap();
+    const QVariantMap june2 =
+        handle(server, generateRequest(QString(), QStringLiteral("2018-06"), true))
+            .value(QStringLiteral("roster")).toMap();
+    QCOMPARE(june1.value(QStringLiteral("2018-06")).toList().size(), 30);
+    QVERIFY(withoutMetadata(june1) != withoutMetadata(june));
+    QVERIFY(withoutMetadata(june2) != withoutMetadata(june1));
+
+    // And later months then continue on from the latest roster, and its scheduler's history, but
+    // with the default seed again.
+    Cogent::RosterGenerator generator;
+    configurator()(generator);
+    Cogent::LeastRecentScheduler * const scheduler = new Cogent::LeastRecentScheduler(2);
+    generator.setScheduler(scheduler);
+    QCOMPARE(withoutMetadata(generator.generate(2018, 6, nurses)), withoutMetadata(june2));
+    scheduler->setSeed(0);
+    const QVariantMap july =
+        handle(server, generateRequest(QString(), QStringLiteral("2018-07")))
+            .value(QStringLiteral("roster")).toMap();
+    QCOMPARE(withoutMetadata(july), withoutMetadata(
+        generator.generate(2018, 7, nurses, Cogent::CarryIn::fromRoster(june2))));
+}
+
+void tst_RosterServer::repair()
+{
+    const QStringList nurses = makeNurses(40);
+    Cogent::RosterServer server(configurator());
+    server.setNurses(QString(), nurses);
+    const QVariantList june =
+        handle(server, generateRequest(QString(), QStringLiteral("2018-06")))
+            .value(QStringLiteral("roster")).toMap().value(QStringLiteral("2018-06")).toList();
+    handle(server, generateRequest(QString(), QStringLiteral("2018-07")));
+
+    // Block a nurse rostered on the 20th, and remove another altogether.
+    const QString sick =
+        june.at(19).toMap().value(QStringLiteral("night")).toStringList().first();
+    const QString removed = nurses.last();
+    Cogent::RosterGenerator::Changes changes;
+    changes.removedNurses.insert(removed);
+    changes.blockedDays.append(qMakePair(sick, QDate(2018, 6, 20)));
+    const QVariantMap response = handle(server, QVariantMap{
+        { QStringLiteral("command"), QStringLiteral("repair") },
+        { QStringLiteral("month"), QStringLiteral("2018-06") },
+        { QStringLiteral("removed"), QStringList{ removed } },
+        { QStringLiteral("blocked"), QVariantMap{
+            { sick, QStringList{ QStringLiteral("2018-06-20") } } } },
+    });
+    QVERIFY(!response.contains(QStringLiteral("error")));
+    const QVariantList repaired = response.value(QStringLiteral("roster")).toMap()
+        .value(QStringLiteral("2018-06")).toList();
+    QCOMPARE(repaired.size(), 30);
+    QCOMPARE(repaired.at(0), june.at(0));
+    foreach (const QVariant &shift, repaired.at(19).toMap()) {
+        QVERIFY(!shift.toStringList().contains(sick));
+    }
+    foreach (const QVariant &day, repaired) {
+        foreach (const QVariant &shift, day.toMap()) {
+            QVERIFY(!shift.toStringList().contains(removed));
+        }
+    }
+
+    // The repaired roster is kept, and later months continue on from it, as a single generator
+    // would.
+    Cogent::RosterGenerator generator;
+    configurator()(generator);
+    const QVariantMap expected = generator.repair(2018, 6, june, nurses, changes);
+    QCOMPARE(withoutMetadata(response.value(QStringLiteral("roster")).toMap()),
+             withoutMetadata(expected));
+    const QVariantMap july =
+        handle(server, generateRequest(QString(), QStringLiteral("2018-07")))
+            .value(QStringLiteral("roster")).toMap();
+    QCOMPARE(withoutMetadata(july), withoutMetadata(
+        generator.generate(2018, 7, nurses, Cogent::CarryIn::fromRoster(expected))));
+}
+
+void tst_RosterServer::wards()
+{
+    // Wards' requests may be handled concurrently, without affecting each other.
+    Cogent::RosterServer server(configurator());
+    const QStringList wards{ QStringLiteral("east"), QStringLiteral("west") };
+    server.setNurses(wards.first(), makeNurses(40));
+    server.setNurses(wards.last(), makeNurses(60));
+
+    QVector<QVariantMap> rosters(wards.size());
+    QThreadPool pool;
+    for (int index = 0; index < wards.size(); ++index) {
+        QVariantMap &roster = rosters[index];
+        const QString ward = wards.at(index);
+        pool.start(new Runnable([&server, &roster, ward]() {
+            roster = handle(server, generateRequest(ward, QStringLiteral("2018-06")))
+                .value(QStringLiteral("roster")).toMap();
+        }));
+    }
+    pool.waitForDone();
+    QCOMPARE(withoutMetadata(rosters.at(0)), expectedRoster(2018, 6, makeNurses(40)));
+    QCOMPARE(withoutMetadata(rosters.at(1)), expectedRoster(2018, 6, makeNurses(60)));
+}
+
+QTEST_APPLESS_MAIN(tst_RosterServer)
+#include "tst_RosterServer.moc"
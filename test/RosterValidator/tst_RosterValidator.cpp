@@ -0,0 +1,236 @@
+#include "../../src/AtMostConsecutiveDays.h"
+#include "../../src/AtMostOneShiftPerDay.h"
+#include "../../src/AtMostShiftsPerMonth.h"
+#include "../../src/NoSingleDaysOff.h"
+#include "../../src/RosterGenerator.h"
+#include "../../src/RosterValidator.h"
+#include "../TestNurses.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+// Returns a day with \a night, \a morning and \a evening nurses on the respective shifts.
+QVariantMap day(const QStringList &night, const QStringList &morning, const QStringList &evening)
+{
+    return QVariantMap{
+        { QStringLiteral("night"),   night },
+        { QStringLiteral("morning"), morning },
+        { QStringLiteral("evening"), evening },
+    };
+}
+
+// Returns \a daysOff empty days, then a day for each character of \a pattern, with \a nurse on
+// \a shift for each '1'.
+QVariantList pattern(const QString &nurse, const QString &shift, const char * const pattern,
+                     const int daysOff = 0)
+{
+    QVariantList days;
+    for (int day = 0; day < daysOff; ++day) {
+        days.append(::day({ }, { }, { }));
+    }
+    for (const char *worked = pattern; *worked != '\0'; ++worked) {
+        QVariantMap day = ::day({ }, { }, { });
+        if (*worked == '1') {
+            day.insert(shift, QStringList{ nurse });
+        }
+        days.append(day);
+    }
+    return days;
+}
+
+class tst_RosterValidator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void validate_data();
+    void validate();
+    void binary_data();
+    void binary();
+    void batch();
+    void generated();
+
+protected:
+    QTemporaryDir dir;
+
+    // Returns a validator with the standard constraints (as per Rules::defaults).
+    static Cogent::RosterValidator makeValidator()
+    {
+        Cogent::RosterValidator validator;
+        validator.addConstraint(new Cogent::AtMostConsecutiveDays(5));
+        validator.addConstraint(new Cogent::AtMostShiftsPerMonth(Cogent::Roster::NightShift, 5));
+        validator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+        validator.addConstraint(new Cogent::NoSingleDaysOff());
+        return validator;
+    }
+
+    // Returns each of \a violations as a single string, for easy comparison.
+    static QStringList toStringList(const QVector<Cogent::RosterValidator::Violation> &violations)
+    {
+        QStringList list;
+        foreach (const Cogent::RosterValidator::Violation &violation, violations) {
+            list.append(QStringList{ violation.ward, violation.date.toString(Qt::ISODate),
+                violation.shift, violation.nurse, violation.constraint }.join(QLatin1Char(' '))
+                .trimmed());
+        }
+        return list;
+    }
+};
+
+void tst_RosterValidator::initTestCase()
+{
+    QVERIFY(dir.isValid());
+}
+
+void tst_RosterValidator::validate_data()
+{
+    QTest::addColumn<QVariantMap>("rosters");
+    QTest::addColumn<QStringList>("expected");
+
+    const QString alice = QStringLiteral("Alice"), bob = QStringLiteral("Bob");
+    const QString night = QStringLiteral("night"), morning = QStringLiteral("morning");
+    const QString june = QStringLiteral("2018-06");
+
+    QTest::newRow("empty") << QVariantMap{ { june, QVariantList() } } << QStringList();
+    QTest::newRow("five-days") << QVariantMap{ { june, pattern(alice, morning, "11111") } }
+                               << QStringList();
+    QTest::newRow("six-days") << QVariantMap{ { june, pattern(alice, morning, "111111") } }
+        << QStringList{ QStringLiteral("2018-06-06 morning Alice AtMostConsecutiveDays") };
+    QTest::newRow("single-day-off") << QVariantMap{ { june, pattern(alice, morning, "1101") } }
+        << QStringList{ QStringLiteral("2018-06-04 morning Alice NoSingleDaysOff") };
+    QTest::newRow("six-nights") << QVariantMap{ { june, pattern(alice, night, "110011001100") } }
+        << QStringList{ QStringLiteral("2018-06-10 night Alice AtMostShiftsPerMonth") };
+    QTest::newRow("two-shifts") << QVariantMap{ { june, QVariantList{
+            day({ alice }, { bob, alice }, { }), day({ }, { bob }, { bob }) } } }
+        << QStringList{ QStringLiteral("2018-06-01 morning Alice AtMostOneShiftPerDay"),
+                        QStringLiteral("2018-06-02 evening Bob AtMostOneShiftPerDay") };
+    QTest::newRow("listed-twice") << QVariantMap{ { june, QVariantList{
+            day({ alice, bob, alice }, { }, { }) } } }
+        << QStringList{ QStringLiteral("2018-06-01 night Alice AtMostOneShiftPerDay") };
+    QTest::newRow("unknown-shift") << QVariantMap{ { june, QVariantList{
+            QVariantMap{ { QStringLiteral("weekend"), QStringList{ alice } } } } } }
+        << QStringList();
+
+    // Streaks continue on from the previous month, but not across a gap.
+    QTest::newRow("carried-in") << QVariantMap{
+            { QStringLiteral("2018-05"), pattern(alice, morning, "111", 28) },
+            { june, pattern(alice, morning, "11101") } }
+        << QStringList{ QStringLiteral("2018-06-03 morning Alice AtMostConsecutiveDays"),
+                        QStringLiteral("2018-06-05 morning Alice NoSingleDaysOff") };
+    QTest::newRow("carried-in-day-off") << QVariantMap{
+            { QStringLiteral("2018-05"), pattern(alice, morning, "10", 29) },
+            { june, pattern(alice, morning, "1") } }
+        << QStringList{ QStringLiteral("2018-06-01 morning Alice NoSingleDaysOff") };
+    QTest::newRow("gap") << QVariantMap{
+            { QStringLiteral("2018-04"), pattern(alice, morning, "111", 27) },
+            { june, pattern(alice, morning, "111") } }
+        << QStringList();
+    QTest::newRow("metadata") << QVariantMap{
+            { june, pattern(alice, morning, "111111") },
+            { QStringLiteral("created"), QStringLiteral("Sat Jun 30 12:00:00 2018") } }
+        << QStringList{ QStringLiteral("2018-06-06 morning Alice AtMostConsecutiveDays") };
+}
+
+void tst_RosterValidator::validate()
+{
+    QFETCH(QVariantMap, rosters);
+    QFETCH(QStringList, expected);
+
+    Cogent::RosterValidator validator = makeValidator();
+    QCOMPARE(toStringList(validator.validate(rosters)), expected);
+}
+
+void tst_RosterValidator::binary_data()
+{
+    validate_data();
+}
+
+void tst_RosterValidator::binary()
+{
+    QFETCH(QVariantMap, rosters);
+    QFETCH(QStringList, expected);
+
+    QFile file(dir.filePath(QString::fromLatin1(QTest::currentDataTag())));
+    QVERIFY(file.open(QFile::WriteOnly));
+    QVERIFY(Cogent::BinaryRoster::write(&file, rosters));
+    file.close();
+    Cogent::BinaryRoster binary;
+    QVERIFY(binary.open(file.fileName()));
+    Cogent::RosterValidator validator = makeValidator();
+    QCOMPARE(toStringList(validator.validate(binary)), expected);
+}
+
+void tst_RosterValidator::batch()
+{
+    const QString alice = QStringLiteral("Alice"), morning = QStringLiteral("morning");
+    const QVariantMap batch{
+        { QStringLiteral("ICU"), QVariantMap{
+            { QStringLiteral("2018-05"), pattern(alice, morning, "111", 28) },
+            { QStringLiteral("2018-06"), pattern(alice, morning, "111") } } },
+        { QStringLiteral("Maternity"), QVariantMap{
+            { QStringLiteral("2018-06"), pattern(alice, morning, "101") } } },
+    };
+    const QStringList expected{
+        QStringLiteral("ICU 2018-06-03 morning Alice AtMostConsecutiveDays"),
+        QStringLiteral("Maternity 2018-06-03 morning Alice NoSingleDaysOff"),
+    };
+
+    // Each ward is checked separately, even if the same nurses work in several wards.
+    Cogent::RosterValidator validator = makeValidator();
+    QCOMPARE(toStringList(validator.validate(batch)), expected);
+
+    QFile file(dir.filePath(QStringLiteral("batch")));
+    QVERIFY(file.open(QFile::WriteOnly));
+    QVERIFY(Cogent::BinaryRoster::write(&file, batch));
+    file.close();
+    Cogent::BinaryRoster binary;
+    QVERIFY(binary.open(file.fileName()));
+    QCOMPARE(toStringList(validator.validate(binary)), expected);
+
+    const Cogent::RosterValidator::Violation violation = validator.validate(batch).first();
+    QCOMPARE(violation.toVariantMap(), QVariantMap({
+        { QStringLiteral("ward"), QStringLiteral("ICU") },
+        { QStringLiteral("date"), QStringLiteral("2018-06-03") },
+        { QStringLiteral("shift"), morning },
+        { QStringLiteral("nurse"), alice },
+        { QStringLiteral("constraint"), QStringLiteral("AtMostConsecutiveDays") },
+    }));
+}
+
+void tst_RosterValidator::generated()
+{
+    const QStringList nurses = makeNurses(40, 1);
+    Cogent::RosterGenerator generator;
+    generator.addConstraint(new Cogent::AtMostConsecutiveDays(5));
+    generator.addConstraint(new Cogent::AtMostShiftsPerMonth(Cogent::Roster::NightShift, 5));
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+
+    // Generate consecutive months, each continuing on from the last, then check them all at once.
+    QVariantMap rosters;
+    Cogent::CarryIn carryIn;
+    for (int month = 1; month <= 3; ++month) {
+        const QVariantMap roster = generator.generate(2018, month, nurses, carryIn);
+        QVERIFY(!roster.isEmpty());
+        carryIn = Cogent::CarryIn::fromRoster(roster, carryIn);
+        const QString key = QStringLiteral("2018-%1").arg(month, 2, 10, QLatin1Char('0'));
+        rosters.insert(key, roster.value(key));
+    }
+    QCOMPARE(rosters.size(), 3);
+    Cogent::RosterValidator validator = makeValidator();
+    QCOMPARE(toStringList(validator.validate(rosters)), QStringList());
+
+    // But hand edits that break the rules are found.
+    QVariantList march = rosters.value(QStringLiteral("2018-03")).toList();
+    QVariantMap firstDay = march.first().toMap();
+    const QStringList night = firstDay.value(QStringLiteral("night")).toStringList();
+    firstDay.insert(QStringLiteral("morning"), QStringList(night.first()));
+    march.replace(0, firstDay);
+    rosters.insert(QStringLiteral("2018-03"), march);
+    QCOMPARE(toStringList(validator.validate(rosters)), QStringList(
+        QStringLiteral("2018-03-01 morning %1 AtMostOneShiftPerDay").arg(night.first())));
+}
+
+QTEST_APPLESS_MAIN(tst_RosterValidator)
+#include "tst_RosterValidator.moc"
@@ -0,0 +1,162 @@
+#include "../../src/Rules.h"
+#include "../TestNurses.h"
+
+#include <QTest>
+
+class tst_Rules : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void defaults();
+    void fromJson();
+    void demand();
+    void invalid_data();
+    void invalid();
+    void withoutConstraint();
+    void generate();
+};
+
+void tst_Rules::defaults()
+{
+    const Cogent::Rules rules = Cogent::Rules::defaults();
+    QVERIFY(rules.isValid());
+    QCOMPARE(rules.shiftNames(), Cogent::Roster::defaultShiftNames());
+    QCOMPARE(rules.nursesPerShift(), QVector<int>({ 5, 5, 5 }));
+    QCOMPARE(rules.constraintTypes(), QStringList({
+        QStringLiteral("AtMostConsecutiveDays"), QStringLiteral("AtMostShiftsPerMonth"),
+        QStringLiteral("AtMostOneShiftPerDay"),  QStringLiteral("NoSingleDaysOff") }));
+    QVERIFY(!Cogent::Rules().isValid());
+}
+
+void tst_Rules::fromJson()
+{
+    bool ok = false;
+    const Cogent::Rules rules = Cogent::Rules::fromJson(
+        "{ \"shifts\": [ { \"name\": \"day\",   \"nurses\": 4 },"
+        "              { \"name\": \"night\", \"nurses\": 2 } ],"
+        "  \"constraints\": ["
+        "    { \"type\": \"AtMostShiftsPerMonth\", \"shift\": \"night\", \"shifts\": 8 },"
+        "    { \"type\": \"AtMostConsecutiveDays\", \"days\": 4 } ] }", &ok);
+    QVERIFY(ok);
+    QVERIFY(rules.isValid());
+    QCOMPARE(rules.shiftNames(), QStringList({ QStringLiteral("day"), QStringLiteral("night") }));
+    QCOMPARE(rules.nursesPerShift(), QVector<int>({ 4, 2 }));
+    QCOMPARE(rules.constraintTypes(), QStringList({
+        QStringLiteral("AtMostShiftsPerMonth"), QStringLiteral("AtMostConsecutiveDays") }));
+}
+
+void tst_Rules::demand()
+{
+    bool ok = false;
+    const Cogent::Rules rules = Cogent::Rules::fromJson(
+        "{ \"shifts\": [ { \"name\": \"day\", \"nurses\": 4, \"weekdays\": { \"sunday\": 2 } },"
+        "              { \"name\": \"night\", \"nurses\": 2 } ],"
+        "  \"holidays\": { \"2018-12-25\": { \"day\": 1, \"night\": 0 } } }", &ok);
+    QVERIFY(ok);
+    QCOMPARE(rules.nursesPerShift(), QVector<int>({ 4, 2 }));
+
+    // 2018-12-24 was a Monday, 2018-12-25 a (Tuesday) holiday, and 2018-12-30 a Sunday.
+    const Cogent::Demand demand = rules.demand();
+    QCOMPARE(demand.headcounts(QDate(2018, 12, 24), 2), QVector<int>({ 4, 2,  1, 0 }));
+    QCOMPARE(demand.headcounts(QDate(2018, 12, 30), 1), QVector<int>({ 2, 2 }));
+}
+
+void tst_Rules::invalid_data()
+{
+    QTest::addColumn<QByteArray>("json");
+
+    QTest::newRow("not-json") << QByteArray("shifts: night");
+    QTest::newRow("not-object") << QByteArray("[]");
+    QTest::newRow("no-shifts") << QByteArray("{ \"constraints\": [] }");
+    QTest::newRow("unnamed-shift") << QByteArray("{ \"shifts\": [ { \"nurses\": 1 } ] }");
+    QTest::newRow("duplicate-shift") << QByteArray(
+        "{ \"shifts\": [ { \"name\": \"a\", \"nurses\": 1 },"
+        "              { \"name\": \"a\", \"nurses\": 1 } ] }");
+    QTest::newRow("zero-nurses") << QByteArray(
+        "{ \"shifts\": [ { \"name\": \"a\", \"nurses\": 0 } ] }");
+    QTest::newRow("fractional-nurses") << QByteArray(
+        "{ \"shifts\": [ { \"name\": \"a\", \"nurses\": 1.5 } ] }");
+    QTest::newRow("huge-nurses") << QByteArray(
+        "{ \"shifts\": [ { \"name\": \"a\", \"nurses\": 1e20 } ] }");
+    QTest::newRow("just-too-many-nurses") << QByteArray(
+        "{ \"shifts\": [ { \"name\": \"a\", \"nurses\": 2147483648 } ] }");
+    QTest::newRow("unknown-constraint") << QByteArray(
+        "{ \"shifts\": [ { \"name\": \"a\", \"nurses\": 1 } ],"
+        "  \"constraints\": [ { \"type\": \"AtMostFiveConsecutiveDays\" } ] }");
+    QTest::newRow("missing-days") << QByteArray(
+        "{ \"shifts\": [ { \"name\": \"a\", \"nurses\": 1 } ],"
+        "  \"constraints\": [ { \"type\": \"AtMostConsecutiveDays\" } ] }");
+    QTest::newRow("unknown-weekday") << QByteArray(
+        "{ \"shifts\": [ { \"name\": \"a\", \"nurses\": 1, \"weekdays\": { \"sun\": 1 } } ] }");
+    QTest::newRow("negative-weekday") << QByteArray(
+        "{ \"shifts\": [ { \"name\": \"a\", \"nurses\": 1, \"weekdays\": { \"sunday\": -1 } } ] }");
+    QTest::newRow("invalid-holiday") << QByteArray(
+        "{ \"shifts\": [ { \"name\": \"a\", \"nurses\": 1 } ],"
+        "  \"holidays\": { \"Christmas\": { \"a\": 0 } } }");
+    QTest::newRow("unknown-holiday-shift") << QByteArray(
+        "{ \"shifts\": [ { \"name\": \"a\", \"nurses\": 1 } ],"
+        "  \"holidays\": { \"2018-12-25\": { \"b\": 0 } } }");
+    QTest::newRow("unknown-shift") << QByteArray(
+        "{ \"shifts\": [ { \"name\": \"a\", \"nurses\": 1 } ],"
+        "  \"constraints\": ["
+        "    { \"type\": \"AtMostShiftsPerMonth\", \"shift\": \"b\", \"shifts\": 1 } ] }");
+}
+
+void tst_Rules::invalid()
+{
+    QFETCH(QByteArray, json);
+    bool ok = true;
+    QVERIFY(!Cogent::Rules::fromJson(json, &ok).isValid());
+    QVERIFY(!ok);
+}
+
+void tst_Rules::withoutConstraint()
+{
+    const Cogent::Rules rules = Cogent::Rules::defaults()
+        .withoutConstraint(QStringLiteral("AtMostShiftsPerMonth"))
+        .withoutConstraint(QStringLiteral("NoSuchConstraint"));
+    QCOMPARE(rules.constraintTypes(), QStringList({
+        QStringLiteral("AtMostConsecutiveDays"), QStringLiteral("AtMostOneShiftPerDay"),
+        QStringLiteral("NoSingleDaysOff") }));
+}
+
+void tst_Rules::generate()
+{
+    // Two shifts of differing headcounts, with tighter limits than the built-in rules.
+    const Cogent::Rules rules = Cogent::Rules::fromJson(
+        "{ \"shifts\": [ { \"name\": \"night\", \"nurses\": 2 },"
+        "              { \"name\": \"day\",   \"nurses\": 6 } ],"
+        "  \"constraints\": ["
+        "    { \"type\": \"AtMostConsecutiveDays\", \"days\": 3 },"
+        "    { \"type\": \"AtMostShiftsPerMonth\", \"shift\": \"night\", \"shifts\": 3 },"
+        "    { \"type\": \"AtMostOneShiftPerDay\" },"
+        "    { \"type\": \"NoSingleDaysOff\" } ] }");
+    QVERIFY(rules.isValid());
+    Cogent::RosterGenerator generator;
+    rules.configure(generator);
+    const QVariantMap roster = generator.generate(2018, 6, makeNurses(30));
+    const QVariantList days = roster.value(QStringLiteral("2018-06")).toList();
+    QCOMPARE(days.size(), 30);
+
+    QHash<QString, int> nights, streaks;
+    foreach (const QVariant &day, days) {
+        const QVariantMap shifts = day.toMap();
+        QCOMPARE(shifts.keys(), QStringList({ QStringLiteral("day"), QStringLiteral("night") }));
+        const QStringList dayNurses = shifts.value(QStringLiteral("day")).toStringList();
+        const QStringList nightNurses = shifts.value(QStringLiteral("night")).toStringList();
+        QCOMPARE(dayNurses.size(), 6);
+        QCOMPARE(nightNurses.size(), 2);
+        foreach (const QString &nurse, nightNurses) {
+            QVERIFY(++nights[nurse] <= 3);
+        }
+        foreach (const QString &nurse, makeNurses(30)) {
+            const bool worked = (dayNurses.contains(nurse)) || (nightNurses.contains(nurse));
+            streaks[nurse] = worked ? streaks.value(nurse) + 1 : 0;
+            QVERIFY(streaks.value(nurse) <= 3);
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(tst_Rules)
+#include "tst_Rules.moc"
@@ -0,0 +1,77 @@
+#include "../../src/ScratchPool.h"
+
+#include <QTest>
+
+class tst_ScratchPool : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void nurseSet();
+    void nurseList();
+    void markRelease();
+    void reset();
+};
+
+void tst_ScratchPool::nurseSet()
+{
+    Cogent::ScratchPool pool;
+    const Cogent::NurseSet all(100, true);
+    Cogent::NurseSet &first = pool.nurseSet(all);
+    QCOMPARE(first.count(), 100);
+
+    // Each set taken is distinct, and a copy of its source.
+    Cogent::NurseSet &second = pool.nurseSet(Cogent::NurseSet(200));
+    QVERIFY(&first != &second);
+    QCOMPARE(second.capacity(), 200);
+    QVERIFY(second.isEmpty());
+    first.remove(0);
+    QVERIFY(all.contains(0));
+    QCOMPARE(second.count(), 0);
+}
+
+void tst_ScratchPool::nurseList()
+{
+    Cogent::ScratchPool pool;
+    QVector<Cogent::NurseId> &first = pool.nurseList();
+    QVERIFY(first.isEmpty());
+    first.append(1);
+    QVector<Cogent::NurseId> &second = pool.nurseList();
+    QVERIFY(&first != &second);
+    QVERIFY(second.isEmpty());
+    QCOMPARE(first, QVector<Cogent::NurseId>{ 1 });
+}
+
+void tst_ScratchPool::markRelease()
+{
+    Cogent::ScratchPool pool;
+    Cogent::NurseSet &outer = pool.nurseSet(Cogent::NurseSet(10, true));
+    const Cogent::ScratchPool::Mark mark = pool.mark();
+    Cogent::NurseSet &inner = pool.nurseSet(Cogent::NurseSet(10));
+    QVector<Cogent::NurseId> &list = pool.nurseList();
+    list.append(7);
+
+    // Buffers taken before the mark are kept; those after are handed back, and taken again (in
+    // the same order) afresh.
+    pool.release(mark);
+    QCOMPARE(&pool.nurseSet(Cogent::NurseSet(10, true)), &inner);
+    QCOMPARE(inner.count(), 10);
+    QCOMPARE(&pool.nurseList(), &list);
+    QVERIFY(list.isEmpty());
+    QCOMPARE(outer.count(), 10);
+    QVERIFY(&pool.nurseSet(Cogent::NurseSet(10)) != &outer);
+}
+
+void tst_ScratchPool::reset()
+{
+    Cogent::ScratchPool pool;
+    Cogent::NurseSet &first = pool.nurseSet(Cogent::NurseSet(10));
+    QVector<Cogent::NurseId> &list = pool.nurseList();
+    pool.nurseSet(Cogent::NurseSet(10));
+    pool.reset();
+    QCOMPARE(&pool.nurseSet(Cogent::NurseSet(10)), &first);
+    QCOMPARE(&pool.nurseList(), &list);
+}
+
+QTEST_APPLESS_MAIN(tst_ScratchPool)
+#include "tst_ScratchPool.moc"
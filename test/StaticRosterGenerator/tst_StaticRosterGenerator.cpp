@@ -0,0 +1,133 @@
+#include "../../src/StaticRosterGenerator.h"
+#include "../TestNurses.h"
+
+#include <QTest>
+
+// Adds the standard constraints to \a generator, as StandardRosterGenerator has built in.
+void addStandardConstraints(Cogent::RosterGenerator &generator)
+{
+    generator.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    generator.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth());
+    generator.addConstraint(new Cogent::AtMostOneShiftPerDay());
+    generator.addConstraint(new Cogent::NoSingleDaysOff());
+}
+
+// Returns \a roster without its (time-dependent) metadata.
+QVariantMap withoutMetadata(QVariantMap roster)
+{
+    roster.remove(QStringLiteral("created"));
+    return roster;
+}
+
+class tst_StaticRosterGenerator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void generate_data();
+    void generate();
+    void carryIn();
+    void mixed();
+    void infeasible();
+    void repair();
+};
+
+void tst_StaticRosterGenerator::generate_data()
+{
+    QTest::addColumn<int>("year");
+    QTest::addColumn<int>("month");
+    QTest::addColumn<int>("nurseCount");
+    QTest::addColumn<bool>("backtrack");
+
+    QTest::newRow("28-days-40-nurses") << 2018 << 2 << 40 << false;
+    QTest::newRow("31-days-98-nurses") << 2018 << 5 << 98 << false;
+    QTest::newRow("30-days-30-nurses") << 2018 << 6 << 30 << false;
+    QTest::newRow("30-days-1000-nurses") << 2018 << 6 << 1000 << false;
+    QTest::newRow("30-days-30-nurses-backtracking") << 2018 << 6 << 30 << true;
+    QTest::newRow("31-days-40-nurses-backtracking") << 2018 << 5 << 40 << true;
+}
+
+void tst_StaticRosterGenerator::generate()
+{
+    QFETCH(int, year);
+    QFETCH(int, month);
+    QFETCH(int, nurseCount);
+    QFETCH(bool, backtrack);
+    const QStringList nurses = makeNurses(nurseCount);
+
+    // The static generator must make exactly the same choices as the dynamic one.
+    Cogent::RosterGenerator dynamic;
+    addStandardConstraints(dynamic);
+    Cogent::StandardRosterGenerator standard;
+    if (backtrack) {
+        dynamic.setEngine(Cogent::RosterGenerator::BacktrackingEngine);
+        standard.setEngine(Cogent::RosterGenerator::BacktrackingEngine);
+    }
+    const QVariantMap expected = withoutMetadata(dynamic.generate(year, month, nurses));
+    QVERIFY(!expected.isEmpty());
+    QCOMPARE(withoutMetadata(standard.generate(year, month, nurses)), expected);
+}
+
+void tst_StaticRosterGenerator::carryIn()
+{
+    const QStringList nurses = makeNurses(40);
+    Cogent::RosterGenerator dynamic;
+    addStandardConstraints(dynamic);
+    Cogent::StandardRosterGenerator standard;
+
+    Cogent::CarryIn carryIn;
+    for (int month = 1; month <= 6; ++month) {
+        const QVariantMap expected =
+            withoutMetadata(dynamic.generate(2018, month, nurses, carryIn));
+        QVERIFY(!expected.isEmpty());
+        QCOMPARE(withoutMetadata(standard.generate(2018, month, nurses, carryIn)), expected);
+        carryIn = Cogent::CarryIn::fromRoster(expected, carryIn);
+    }
+}
+
+void tst_StaticRosterGenerator::mixed()
+{
+    // Constraints added at runtime still apply, after the static ones.
+    const QStringList nurses = makeNurses(40);
+    Cogent::RosterGenerator dynamic;
+    addStandardConstraints(dynamic);
+    Cogent::StaticRosterGenerator<Cogent::AtMostOneShiftPerDay, Cogent::NoSingleDaysOff> mixed;
+    mixed.addConstraint(new Cogent::AtMostFiveConsecutiveDays());
+    mixed.addConstraint(new Cogent::AtMostFiveNightShiftsPerMonth());
+    const QVariantMap expected = withoutMetadata(dynamic.generate(2018, 6, nurses));
+    QCOMPARE(withoutMetadata(mixed.generate(2018, 6, nurses)), expected);
+
+    // With no static constraints at all, it's just a RosterGenerator.
+    Cogent::StaticRosterGenerator<> none;
+    addStandardConstraints(none);
+    QCOMPARE(withoutMetadata(none.generate(2018, 6, nurses)), expected);
+}
+
+void tst_StaticRosterGenerator::infeasible()
+{
+    // The static constraints' bounds reject months that cannot be filled, as for the dynamic ones.
+    Cogent::StandardRosterGenerator standard;
+    QCOMPARE(standard.generate(2018, 6, makeNurses(1)), QVariantMap());
+    QCOMPARE(standard.generate(2018, 6, makeNurses(20)), QVariantMap());
+}
+
+void tst_StaticRosterGenerator::repair()
+{
+    const QStringList nurses = makeNurses(40);
+    Cogent::RosterGenerator dynamic;
+    addStandardConstraints(dynamic);
+    Cogent::StandardRosterGenerator standard;
+
+    const QVariantList days = dynamic.generate(2018, 6, nurses).value(QStringLiteral("2018-06"))
+        .toList();
+    Cogent::RosterGenerator::Changes changes;
+    changes.blockedDays.append(qMakePair(
+        days.at(14).toMap().value(QStringLiteral("night")).toStringList().first(),
+        QDate(2018, 6, 15)));
+    const QVariantMap expected = withoutMetadata(dynamic.repair(2018, 6, days, nurses, changes));
+    QVERIFY(!expected.isEmpty());
+    QCOMPARE(withoutMetadata(standard.repair(2018, 6, days, nurses, changes)), expected);
+}
+
+QTEST_APPLESS_MAIN(tst_StaticRosterGenerator)
+#include "tst_StaticRosterGenerator.moc"
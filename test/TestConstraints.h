@@ -0,0 +1,51 @@
+#ifndef __TEST_CONSTRAINTS_H__
+#define __TEST_CONSTRAINTS_H__
+
+#include "../src/CarryIn.h"
+#include "../src/ConstraintInterface.h"
+#include "TestNurses.h"
+
+#include <QTest>
+
+// Adds the test data columns fetched by verifyCarryIn(): the days carried in from the previous
+// month, this month's days so far, the candidate nurses, and the nurses and count expected to
+// remain and be removed.
+inline void addCarryInColumns()
+{
+    QTest::addColumn<QVariantList>("previousDays");
+    QTest::addColumn<QVariantList>("days");
+    QTest::addColumn<QStringSet>("nurses");
+    QTest::addColumn<QStringSet>("expected");
+    QTest::addColumn<int>("removed");
+}
+
+// Verifies that \a constraint, replaying the current row's days continuing on from its previous
+// days, removes the expected nurses from \a shift; both directly, and after rewinding back from a
+// later, fully rostered day.
+inline void verifyCarryIn(Cogent::ConstraintInterface &constraint, const int shift)
+{
+    QFETCH(QVariantList, previousDays);
+    QFETCH(QVariantList, days);
+    QFETCH(QStringSet, nurses);
+    QFETCH(QStringSet, expected);
+    QFETCH(int, removed);
+
+    Cogent::NurseTable table;
+    const Cogent::Roster roster = Cogent::Roster::fromVariantList(days, table);
+    Cogent::NurseSet nurseIds = toNurseIds(nurses, table);
+    const QVector<Cogent::CarryIn::Streak> streaks =
+        Cogent::CarryIn().advanced(previousDays).streaks(table);
+
+    constraint.replay(roster, table.size(), streaks);
+    Cogent::NurseSet nurseIdsCopy = nurseIds;
+    QCOMPARE(constraint.constrain(nurseIdsCopy, shift, roster), removed);
+    QCOMPARE(toNames(nurseIdsCopy, table), expected);
+
+    const Cogent::Roster moreDays = withFullDay(roster, table.size());
+    constraint.replay(moreDays, table.size(), streaks);
+    constraint.rewind(moreDays, roster.size()-1);
+    QCOMPARE(constraint.constrain(nurseIds, shift, roster), removed);
+    QCOMPARE(toNames(nurseIds, table), expected);
+}
+
+#endif // __TEST_CONSTRAINTS_H__
@@ -0,0 +1,70 @@
+#ifndef __TEST_NURSES_H__
+#define __TEST_NURSES_H__
+
+#include "../src/NurseSet.h"
+#include "../src/NurseTable.h"
+#include "../src/Roster.h"
+
+#include <QSet>
+#include <QStringList>
+#include <QTest>
+
+typedef QSet<QString> QStringSet;
+
+// Let QTest know how to format QStringSet values (via QDebug, which already supports QSet).
+namespace QTest {
+    template<> inline char *toString(const QStringSet &value)
+    {
+        QString string;
+        QDebug debug(&string);
+        debug << value;
+        return qstrdup(string.toLocal8Bit().data());
+    }
+};
+
+// Returns \a count uniquely named nurses, numbered from \a first ("Nurse 0", "Nurse 1", ...), for
+// the tests and benchmarks to roster.
+inline QStringList makeNurses(const int count, const int first = 0)
+{
+    QStringList nurses;
+    nurses.reserve(count);
+    for (int index = first; index < first + count; ++index) {
+        nurses.append(QStringLiteral("Nurse %1").arg(index));
+    }
+    return nurses;
+}
+
+// Interns \a nurses into \a table, returning their corresponding IDs.
+inline Cogent::NurseSet toNurseIds(const QStringSet &nurses, Cogent::NurseTable &table)
+{
+    Cogent::NurseSet ids;
+    foreach (const QString &nurse, nurses) {
+        ids.insert(table.intern(nurse));
+    }
+    return ids;
+}
+
+// Returns the names of the \a nurses identified in \a table.
+inline QStringSet toNames(const Cogent::NurseSet &nurses, const Cogent::NurseTable &table)
+{
+    QStringSet names;
+    for (Cogent::NurseId nurse = nurses.first(); nurse >= 0; nurse = nurses.next(nurse)) {
+        names.insert(table.name(nurse));
+    }
+    return names;
+}
+
+// Returns a copy of \a roster with an extra day appended, with every nurse on every shift.
+inline Cogent::Roster withFullDay(const Cogent::Roster &roster, const int nurseCount)
+{
+    Cogent::Roster moreDays = roster;
+    moreDays.appendDay();
+    for (int shift = 0; shift < moreDays.shiftCount(); ++shift) {
+        for (Cogent::NurseId nurse = 0; nurse < nurseCount; ++nurse) {
+            moreDays.assign(moreDays.size()-1, shift, nurse);
+        }
+    }
+    return moreDays;
+}
+
+#endif // __TEST_NURSES_H__
@@ -8,7 +8,14 @@ CONFIG += warn_on
 win32-msvc*:QMAKE_CXXFLAGS_WARN_ON += /WX
 else:       QMAKE_CXXFLAGS_WARN_ON += -Werror
 
+# Use AVX2 instructions (such as in NurseSet's bulk operations), if configured with CONFIG+=avx2.
+avx2 {
+  win32-msvc*:QMAKE_CXXFLAGS += /arch:AVX2
+  else:       QMAKE_CXXFLAGS += -mavx2
+}
+
 SOURCES += $${TARGET}.cpp
+HEADERS += $$PWD/TestConstraints.h $$PWD/TestNurses.h
 
 $$(ENABLE_COVERAGE) {
   message(Enabling test coverage reporting [$$basename(_PRO_FILE_)])
@@ -1,9 +1,29 @@
 TEMPLATE = subdirs
 
 SUBDIRS += \
+  AtMostConsecutiveDays \
   AtMostFiveConsecutiveDays \
   AtMostFiveNightShiftsPerMonth \
   AtMostOneShiftPerDay \
+  AtMostShiftsPerMonth \
+  Availability \
+  BatchGenerator \
+  BinaryRoster \
+  CarryIn \
+  Demand \
+  FairScheduler \
+  GeneratorMetrics \
+  JsonWriter \
   LeastRecentScheduler \
   NoSingleDaysOff \
+  NurseListReader \
+  NurseRecord \
+  NurseSet \
+  RestartGenerator \
+  Roster \
   RosterGenerator \
+  RosterServer \
+  RosterValidator \
+  Rules \
+  ScratchPool \
+  StaticRosterGenerator \